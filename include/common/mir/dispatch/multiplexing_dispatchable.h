@@ -20,6 +20,8 @@
 #include "mir/dispatch/dispatchable.h"
 #include "mir/posix_rw_mutex.h"
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <list>
@@ -92,9 +94,27 @@ public:
      * \param [in] fd   File descriptor of watch to remove.
      */
     void remove_watch(Fd const& fd);
+
+    /// The most events set_max_events_per_dispatch() accepts
+    static constexpr int max_batch_size = 16;
+
+    /**
+     * \brief Set how many ready dispatchees a single dispatch() call may dispatch
+     *
+     * Taking a batch saves an epoll_wait() and a lock acquisition per event, but the whole batch
+     * is dispatched on the calling thread, so this suits adaptors that are dispatched from a
+     * single thread. The default is 1.
+     * \param [in] max_events  Clamped to [1, max_batch_size]
+     */
+    void set_max_events_per_dispatch(int max_events);
 private:
+    auto is_watched(Dispatchable const* dispatchee) -> bool;
+
     PosixRWMutex lifetime_mutex;
     std::list<std::pair<std::shared_ptr<Dispatchable>, bool>> dispatchee_holder;
+    /// Incremented by each removal, so a batch can tell if its dispatchees might have been removed
+    std::atomic<uint64_t> removals{0};
+    std::atomic<int> max_events_per_dispatch{1};
 
     Fd epoll_fd;
 };
@@ -190,6 +190,9 @@ EventUPtr make_touch_event(
 EventUPtr clone_event(MirEvent const& event);
 void set_window_id(MirEvent& event, int window_id);
 
+/// Share ownership of \p event without going to the heap for the shared_ptr's control block
+auto share_event(EventUPtr&& event) -> std::shared_ptr<MirEvent>;
+
 [[deprecated("Not meaningful: legacy of mirclient API")]]
 EventUPtr make_start_drag_and_drop_event(frontend::SurfaceId const& surface_id, std::vector<uint8_t> const& handle);
 [[deprecated("Not meaningful: legacy of mirclient API")]]
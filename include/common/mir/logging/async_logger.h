@@ -0,0 +1,67 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_LOGGING_ASYNC_LOGGER_H_
+#define MIR_LOGGING_ASYNC_LOGGER_H_
+
+#include "mir/logging/logger.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace mir
+{
+namespace logging
+{
+/**
+ * \brief Passes messages to another Logger from a background thread
+ *
+ * Each logging thread queues its messages in a bounded queue of its own, so logging neither
+ * contends with other threads nor waits on I/O. Each thread's messages reach the wrapped logger
+ * in the order that thread logged them; messages from different threads may be interleaved
+ * differently. Critical messages are written before log() returns. Any timestamp the wrapped
+ * logger adds is from when the message is written.
+ */
+class AsyncLogger : public mir::logging::Logger
+{
+public:
+    /// What to do with a message logged while the thread's queue is full
+    enum class WhenFull
+    {
+        drop,   ///< Discard the message; the number dropped is logged later
+        block   ///< Wait for the background thread to make room
+    };
+
+    AsyncLogger(std::shared_ptr<Logger> const& sink, WhenFull when_full, size_t queue_capacity = 256);
+    ~AsyncLogger();
+
+    /// Waits until everything logged so far has been passed to the wrapped logger
+    void flush();
+
+protected:
+    void log(mir::logging::Severity severity, std::string const& message, std::string const& component) override;
+    void log(char const* component, Severity severity, char const* format, ...) override
+        __attribute__ ((format (printf, 4, 5)));
+
+private:
+    class State;
+    std::unique_ptr<State> const state;
+};
+}
+}
+
+#endif // MIR_LOGGING_ASYNC_LOGGER_H_
@@ -151,6 +151,35 @@ protected:
     DisplaySink& operator=(DisplaySink const& c) = delete;
 };
 
+/**
+ * A DisplaySink that can say, before anything is rendered, whether overlay() could show a list
+ *
+ * Compositors that render the bottom of a frame themselves and overlay the rest use this to
+ * avoid rendering a frame that overlay() then refuses. Not every DisplaySink implements it.
+ */
+class OverlayQuery
+{
+public:
+    virtual ~OverlayQuery() = default;
+
+    /**
+     * Whether overlay() is expected to accept \p renderlist
+     *
+     * \param [in] renderlist
+     *      As for overlay(), except that the bottom element's buffer is null: it stands for a
+     *      framebuffer the caller has yet to render, covering the whole of view_area().
+     * \returns
+     *      False if overlay() would refuse the list. True is not a guarantee; overlay() can
+     *      still refuse the rendered frame.
+     */
+    virtual bool can_overlay(std::vector<DisplayElement> const& renderlist) = 0;
+
+protected:
+    OverlayQuery() = default;
+    OverlayQuery(OverlayQuery const&) = delete;
+    OverlayQuery& operator=(OverlayQuery const&) = delete;
+};
+
 }
 }
 
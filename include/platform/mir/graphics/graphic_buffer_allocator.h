@@ -18,10 +18,12 @@
 #define MIR_GRAPHICS_GRAPHIC_BUFFER_ALLOCATOR_H_
 
 #include "mir/graphics/buffer.h"
+#include "mir/geometry/rectangles.h"
 
 #include <vector>
 #include <memory>
 #include <functional>
+#include <optional>
 
 struct wl_display;
 struct wl_resource;
@@ -86,8 +88,22 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) = 0;
 
+    /**
+     * Import a wl_shm buffer
+     *
+     * \param shm_data [in]    The client's pixels
+     * \param previous [in]    The buffer this one replaces as the content of its surface, if any.
+     *                         Allocators may carry GPU resources (such as a texture) over from it.
+     * \param damage [in]      The region of shm_data (in buffer coordinates) that differs from
+     *                         previous, or std::nullopt if unknown. Only this region needs to be
+     *                         uploaded into resources carried over from previous.
+     * \param on_consumed [in] Called when the buffer's content has first been used
+     * \param on_release [in]  Called when the buffer is no longer needed
+     */
     virtual auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> shm_data,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> = 0;
 
@@ -19,6 +19,7 @@
 
 #include <optional>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
@@ -73,6 +74,25 @@ public:
 
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
 
+    /**
+     * The parts of screen_position() known to be drawn fully opaque, even if
+     * the renderable is shaped() (e.g. a client's wl_surface opaque region).
+     *
+     * Only meaningful when alpha() is 1.0. Used to cull renderables hidden
+     * behind others, so it is always safe to return an empty region.
+     */
+    virtual auto opaque_region() const -> geometry::Rectangles = 0;
+
+    /**
+     * The part of screen_position() whose content has changed since the
+     * compositor that generated this renderable last rendered it.
+     *
+     * An empty region means the content is unchanged. std::nullopt means the
+     * damage is unknown; the compositor should then treat the whole renderable
+     * as changed whenever its buffer() differs from the previous frame.
+     */
+    virtual auto damage() const -> std::optional<geometry::Rectangles> = 0;
+
     virtual auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> = 0;
 protected:
@@ -30,6 +30,7 @@ extern char const* const enable_input_opt;
 extern char const* const shared_library_prober_report_opt;
 extern char const* const shell_report_opt;
 extern char const* const compositor_report_opt;
+extern char const* const compositor_metrics_opt;
 extern char const* const display_report_opt;
 extern char const* const scene_report_opt;
 extern char const* const input_report_opt;
@@ -40,6 +41,8 @@ extern char const* const fatal_except_opt;
 extern char const* const debug_opt;
 extern char const* const composite_delay_opt;
 extern char const* const enable_key_repeat_opt;
+extern char const* const coalesce_pointer_motion_opt;
+extern char const* const async_logging_opt;
 extern char const* const x11_display_opt;
 extern char const* const x11_scale_opt;
 extern char const* const wayland_extensions_opt;
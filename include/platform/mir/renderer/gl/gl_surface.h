@@ -44,6 +44,14 @@ public:
     /// Size, in pixels, of the underlying surface
     virtual auto size() const -> mir::geometry::Size = 0;
 
+    /**
+     * Age of the contents of the buffer the next frame will be drawn into (cf: EGL_EXT_buffer_age)
+     *
+     * 0 means the contents are undefined; N means the buffer holds the frame committed N frames ago.
+     * Must be called with the surface current.
+     */
+    virtual auto buffer_age() const -> unsigned = 0;
+
     enum class Layout
     {
         TopRowFirst,            //< First row has y-coördinate 0, y increases with each row.
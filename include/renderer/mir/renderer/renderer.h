@@ -18,9 +18,11 @@
 #define MIR_RENDERER_RENDERER_H_
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/graphics/renderable.h"
 #include "mir_toolkit/common.h"
 #include <glm/glm.hpp>
+#include <optional>
 
 namespace mir
 {
@@ -42,6 +44,21 @@ public:
     virtual auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
+    /**
+     * Age of the contents of the buffer the next render() will draw into
+     *
+     * 0 means the contents are undefined and the whole viewport must be drawn;
+     * N means the buffer holds the frame rendered N frames ago.
+     */
+    virtual auto buffer_age() const -> unsigned = 0;
+
+    /**
+     * Limit subsequent render() calls to redrawing the given region of the viewport
+     *
+     * std::nullopt (the default) redraws the whole viewport.
+     */
+    virtual void set_damage(std::optional<geometry::Rectangles> const& damage) = 0;
+
 protected:
     Renderer() = default;
     Renderer(const Renderer&) = delete;
@@ -19,6 +19,7 @@
 #include "mir/posix_rw_mutex.h"
 
 #include <boost/throw_exception.hpp>
+#include <array>
 #include <shared_mutex>
 
 #include <sys/epoll.h>
@@ -102,43 +103,80 @@ bool md::MultiplexingDispatchable::dispatch(md::FdEvents events)
         return false;
     }
 
-    std::shared_ptr<md::Dispatchable> source;
-    bool rearm_source{false};
-    epoll_event event;
+    std::array<epoll_event, max_batch_size> ready;
+    std::array<std::shared_ptr<md::Dispatchable>, max_batch_size> sources;
+    std::array<bool, max_batch_size> rearm_source;
+    int ready_count;
+    uint64_t removals_before_dispatch;
 
     {
         std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
 
-        auto result = epoll_wait(epoll_fd, &event, 1, 0);
+        ready_count = epoll_wait(epoll_fd, ready.data(), max_events_per_dispatch.load(std::memory_order_relaxed), 0);
 
-        if (result < 0)
+        if (ready_count < 0)
         {
             BOOST_THROW_EXCEPTION((std::system_error{errno,
                                                      std::system_category(),
                                                      "Failed to wait on fds"}));
         }
 
-        if (result == 0)
+        // If there are no events some other thread must have stolen the event we
+        // were woken for; that's ok, there's nothing to do.
+        for (auto i = 0; i != ready_count; ++i)
         {
-            // Some other thread must have stolen the event we were woken for;
-            // that's ok, just return.
-            return true;
-        }
+            auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(ready[i].data.ptr);
 
-        auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(event.data.ptr);
+            sources[i] = event_source->first;
+            rearm_source[i] = event_source->second;
+        }
 
-        source = event_source->first;
-        rearm_source = event_source->second;
+        removals_before_dispatch = removals.load(std::memory_order_relaxed);
     }
 
-    if (!source->dispatch(epoll_to_fd_event(event)))
-    {
-        remove_watch(source);
-    }
-    else if (rearm_source)
+    auto const rearm = [this](std::shared_ptr<md::Dispatchable> const& source, epoll_event& event)
+        {
+            event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        };
+
+    for (auto i = 0; i != ready_count; ++i)
     {
-        event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
-        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        auto const& source = sources[i];
+
+        // The dispatchee may have been removed since the batch was taken (perhaps by an earlier one)
+        if (removals.load(std::memory_order_relaxed) != removals_before_dispatch &&
+            !is_watched(source.get()))
+        {
+            continue;
+        }
+
+        bool keep_source;
+        try
+        {
+            keep_source = source->dispatch(epoll_to_fd_event(ready[i]));
+        }
+        catch (...)
+        {
+            // Don't leave the rest of the batch disarmed
+            for (auto j = i + 1; j != ready_count; ++j)
+            {
+                if (rearm_source[j])
+                {
+                    rearm(sources[j], ready[j]);
+                }
+            }
+            throw;
+        }
+
+        if (!keep_source)
+        {
+            remove_watch(source);
+        }
+        else if (rearm_source[i])
+        {
+            rearm(source, ready[i]);
+        }
     }
 
     return true;
@@ -221,4 +259,19 @@ void md::MultiplexingDispatchable::remove_watch(Fd const& fd)
     {
         return candidate.first->watch_fd() == fd;
     });
+    removals.fetch_add(1, std::memory_order_relaxed);
+}
+
+void md::MultiplexingDispatchable::set_max_events_per_dispatch(int max_events)
+{
+    max_events_per_dispatch = std::clamp(max_events, 1, max_batch_size);
+}
+
+auto md::MultiplexingDispatchable::is_watched(Dispatchable const* dispatchee) -> bool
+{
+    std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+    return std::any_of(
+        dispatchee_holder.begin(),
+        dispatchee_holder.end(),
+        [dispatchee](auto const& candidate) { return candidate.first.get() == dispatchee; });
 }
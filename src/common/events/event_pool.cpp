@@ -0,0 +1,109 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/events/event_pool.h"
+#include "mir/events/event_builders.h"
+#include "mir/events/keyboard_event.h"
+#include "mir/events/pointer_event.h"
+#include "mir/events/touch_event.h"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace mev = mir::events;
+
+namespace
+{
+/// Every pooled block fits the largest input event
+std::size_t constexpr block_size = std::max({sizeof(MirKeyboardEvent), sizeof(MirPointerEvent), sizeof(MirTouchEvent)});
+/// Enough for bursts from several high-rate devices queued to slow clients; beyond this, give memory back
+std::size_t constexpr max_free_blocks = 512;
+
+class Pool
+{
+public:
+    auto allocate(std::size_t size) -> void*
+    {
+        if (size <= block_size)
+        {
+            std::lock_guard lock{mutex};
+            if (!free_blocks.empty())
+            {
+                auto const block = free_blocks.back();
+                free_blocks.pop_back();
+                return block;
+            }
+        }
+
+        return ::operator new(std::max(size, block_size));
+    }
+
+    void deallocate(void* block, std::size_t size) noexcept
+    {
+        if (size <= block_size)
+        {
+            std::lock_guard lock{mutex};
+            if (free_blocks.size() < max_free_blocks)
+            {
+                try
+                {
+                    free_blocks.push_back(block);
+                    return;
+                }
+                catch (std::bad_alloc const&)
+                {
+                }
+            }
+        }
+
+        ::operator delete(block);
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<void*> free_blocks;
+};
+
+auto pool() -> Pool&
+{
+    // Deliberately never destroyed: events may be released during static destruction
+    static auto const instance = new Pool;
+    return *instance;
+}
+}
+
+auto mev::allocate_input_event(std::size_t size) -> void*
+{
+    return pool().allocate(size);
+}
+
+void mev::deallocate_input_event(void* block, std::size_t size) noexcept
+{
+    pool().deallocate(block, size);
+}
+
+auto mev::share_event(EventUPtr&& event) -> std::shared_ptr<MirEvent>
+{
+    if (!event)
+    {
+        return {};
+    }
+
+    auto const deleter = event.get_deleter();
+    return {event.release(), deleter, InputEventAllocator<MirEvent>{}};
+}
@@ -15,6 +15,7 @@
  */
 
 #include "mir/events/event.h"
+#include "mir/events/event_pool.h"
 #include "mir/events/input_event.h"
 #include "mir/events/keyboard_event.h"
 #include "mir/events/pointer_event.h"
@@ -112,3 +113,13 @@ MirInputEvent::MirInputEvent(MirInputEventType input_type) :
     input_type_{input_type}
 {
 }
+
+auto MirInputEvent::operator new(std::size_t size) -> void*
+{
+    return mir::events::allocate_input_event(size);
+}
+
+void MirInputEvent::operator delete(void* block, std::size_t size) noexcept
+{
+    mir::events::deallocate_input_event(block, size);
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+#include "mir/thread_name.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace ml = mir::logging;
+
+namespace
+{
+struct Record
+{
+    uint64_t sequence;
+    ml::Severity severity;
+    std::string component;
+    std::string message;
+};
+
+/// A bounded queue of records, filled by one thread and emptied by another
+/// (the record strings keep their capacity, so once warmed up queuing doesn't allocate)
+class Ring
+{
+public:
+    explicit Ring(size_t capacity)
+        : slots(capacity)
+    {
+    }
+
+    /// The slot to fill with the next record, or nullptr if the ring is full
+    auto next_free() -> Record*
+    {
+        auto const t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size())
+        {
+            return nullptr;
+        }
+        return &slots[t % slots.size()];
+    }
+
+    /// Makes the slot returned by next_free() available to front()
+    void publish()
+    {
+        // Sequentially consistent, so the writer can't both miss this and be missed going idle (see wake_if_idle())
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+    }
+
+    /// The oldest record, or nullptr if the ring is empty
+    auto front() -> Record*
+    {
+        auto const h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &slots[h % slots.size()];
+    }
+
+    void pop()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    auto empty() const -> bool
+    {
+        return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_seq_cst);
+    }
+
+private:
+    std::vector<Record> slots;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+/// Messages logged by the writer thread (by the sink, say) go straight to the sink
+thread_local bool on_writer_thread{false};
+
+std::atomic<uint64_t> next_logger_id{1};
+}
+
+class ml::AsyncLogger::State
+{
+public:
+    State(std::shared_ptr<Logger> const& sink, WhenFull when_full, size_t queue_capacity)
+        : sink{sink},
+          when_full{when_full},
+          queue_capacity{std::max<size_t>(queue_capacity, 1)},
+          id{next_logger_id.fetch_add(1, std::memory_order_relaxed)},
+          writer{[this] { run(); }}
+    {
+    }
+
+    ~State()
+    {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+    }
+
+    void enqueue(Severity severity, std::string_view message, std::string_view component)
+    {
+        if (on_writer_thread)
+        {
+            sink->log(severity, std::string{message}, std::string{component});
+            return;
+        }
+
+        if (severity == Severity::critical)
+        {
+            // We may be about to abort, so write this (and everything before it) now
+            flush();
+            sink->log(severity, std::string{message}, std::string{component});
+            return;
+        }
+
+        auto& ring = ring_for_this_thread();
+        auto record = ring.next_free();
+        while (!record)
+        {
+            if (when_full == WhenFull::drop)
+            {
+                dropped.fetch_add(1, std::memory_order_seq_cst);
+                wake_if_idle();
+                return;
+            }
+
+            std::unique_lock lock{mutex};
+            wake_requested = true;
+            wake.notify_one();
+            written_cond.wait(lock, [&] { return (record = ring.next_free()) != nullptr; });
+        }
+
+        record->severity = severity;
+        record->component.assign(component);
+        record->message.assign(message);
+        record->sequence = next_sequence.fetch_add(1, std::memory_order_relaxed);
+        ring.publish();
+        wake_if_idle();
+    }
+
+    void flush()
+    {
+        if (on_writer_thread)
+        {
+            return;
+        }
+
+        auto const target = next_sequence.load(std::memory_order_relaxed);
+
+        std::unique_lock lock{mutex};
+        if (written < target)
+        {
+            wake_requested = true;
+            wake.notify_one();
+            written_cond.wait(lock, [&] { return written >= target; });
+        }
+    }
+
+private:
+    /// A busy writer checks for work again before it waits, so only an idle one needs waking. Publishing work and
+    /// the writer_idle accesses are sequentially consistent, so either we see writer_idle set or the writer sees
+    /// the work.
+    void wake_if_idle()
+    {
+        if (writer_idle.load(std::memory_order_seq_cst))
+        {
+            {
+                std::lock_guard lock{mutex};
+                wake_requested = true;
+            }
+            wake.notify_one();
+        }
+    }
+
+    /// If there is anything for the writer to do; called with mutex held
+    auto work_pending() const -> bool
+    {
+        return dropped.load(std::memory_order_seq_cst) ||
+               std::any_of(rings.begin(), rings.end(), [](auto const& ring) { return !ring->empty(); });
+    }
+
+    auto ring_for_this_thread() -> Ring&
+    {
+        // Threads rarely log to more than one AsyncLogger, so cache the ring of the last one used. A ring
+        // left behind is dropped by the writer once it's empty.
+        thread_local struct
+        {
+            uint64_t logger_id{0};
+            std::shared_ptr<Ring> ring;
+        } cached;
+
+        if (cached.logger_id != id)
+        {
+            auto ring = std::make_shared<Ring>(queue_capacity);
+            {
+                std::lock_guard lock{mutex};
+                rings.push_back(ring);
+            }
+            cached.ring = std::move(ring);
+            cached.logger_id = id;
+        }
+
+        return *cached.ring;
+    }
+
+    void run()
+    {
+        mir::set_thread_name("Mir/Logger");
+        on_writer_thread = true;
+
+        std::vector<std::shared_ptr<Ring>> current_rings;
+        for (auto stop = false; !stop;)
+        {
+            {
+                std::unique_lock lock{mutex};
+                writer_idle.store(true, std::memory_order_seq_cst);
+                wake.wait(lock, [this] { return wake_requested || stopping || work_pending(); });
+                writer_idle.store(false, std::memory_order_relaxed);
+                wake_requested = false;
+                stop = stopping;
+
+                // Only the registry holds a ring whose thread has exited (or moved to another logger)
+                std::erase_if(rings, [](auto const& ring) { return ring.use_count() == 1 && !ring->front(); });
+                current_rings = rings;
+            }
+
+            auto const count = write_all(current_rings);
+
+            if (auto const dropped_count = dropped.exchange(0, std::memory_order_relaxed))
+            {
+                sink->log(
+                    Severity::warning,
+                    std::to_string(dropped_count) + " log messages were dropped because the log queue was full",
+                    "AsyncLogger");
+            }
+
+            {
+                std::lock_guard lock{mutex};
+                written += count;
+            }
+            written_cond.notify_all();
+        }
+    }
+
+    /// Writes the queued records, oldest first; returns how many were written
+    auto write_all(std::vector<std::shared_ptr<Ring>> const& rings) -> uint64_t
+    {
+        uint64_t count{0};
+
+        for (;;)
+        {
+            Ring* oldest_ring{nullptr};
+            Record* oldest{nullptr};
+            for (auto const& ring : rings)
+            {
+                auto const record = ring->front();
+                if (record && (!oldest || record->sequence < oldest->sequence))
+                {
+                    oldest_ring = ring.get();
+                    oldest = record;
+                }
+            }
+
+            if (!oldest)
+            {
+                return count;
+            }
+
+            try
+            {
+                sink->log(oldest->severity, oldest->message, oldest->component);
+            }
+            catch (...)
+            {
+                // There's nowhere to report a failure to log
+            }
+
+            oldest_ring->pop();
+            ++count;
+        }
+    }
+
+    std::shared_ptr<Logger> const sink;
+    WhenFull const when_full;
+    size_t const queue_capacity;
+    uint64_t const id;
+
+    std::atomic<uint64_t> next_sequence{0};
+    std::atomic<uint64_t> dropped{0};
+    /// Set while the writer is waiting to be woken
+    std::atomic<bool> writer_idle{false};
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable written_cond;
+    std::vector<std::shared_ptr<Ring>> rings;
+    bool wake_requested{false};
+    bool stopping{false};
+    uint64_t written{0};
+
+    std::thread writer;
+};
+
+ml::AsyncLogger::AsyncLogger(std::shared_ptr<Logger> const& sink, WhenFull when_full, size_t queue_capacity)
+    : state{std::make_unique<State>(sink, when_full, queue_capacity)}
+{
+}
+
+ml::AsyncLogger::~AsyncLogger() = default;
+
+void ml::AsyncLogger::flush()
+{
+    state->flush();
+}
+
+void ml::AsyncLogger::log(Severity severity, std::string const& message, std::string const& component)
+{
+    state->enqueue(severity, message, component);
+}
+
+void ml::AsyncLogger::log(char const* component, Severity severity, char const* format, ...)
+{
+    auto const bufsize = 4096;
+    va_list va;
+    va_start(va, format);
+    char message[bufsize];
+    vsnprintf(message, bufsize, format, va);
+    va_end(va);
+
+    // Unlike the base class, this doesn't need to construct std::strings
+    state->enqueue(severity, message, component);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMMON_EVENT_POOL_H_
+#define MIR_COMMON_EVENT_POOL_H_
+
+#include <cstddef>
+
+namespace mir
+{
+namespace events
+{
+/**
+ * Storage for input events (and the bookkeeping that shares them), recycled so that
+ * steady-state input dispatch doesn't go to the heap
+ *
+ * MirInputEvent allocates through this, so every keyboard, pointer and touch event is
+ * pooled, as are the control blocks of events passed through share_event(). Blocks may be
+ * released on any thread.
+ */
+auto allocate_input_event(std::size_t size) -> void*;
+void deallocate_input_event(void* block, std::size_t size) noexcept;
+
+template<typename T>
+class InputEventAllocator
+{
+public:
+    using value_type = T;
+
+    InputEventAllocator() = default;
+    template<typename U>
+    InputEventAllocator(InputEventAllocator<U> const&) {}
+
+    auto allocate(std::size_t n) -> T*
+    {
+        return static_cast<T*>(allocate_input_event(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        deallocate_input_event(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    auto operator==(InputEventAllocator<U> const&) const -> bool { return true; }
+};
+
+}
+}
+
+#endif /* MIR_COMMON_EVENT_POOL_H_ */
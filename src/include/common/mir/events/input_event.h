@@ -44,6 +44,10 @@ struct MirInputEvent : MirEvent
     MirTouchEvent* to_touch();
     MirTouchEvent const* to_touch() const;
 
+    /// Input events are recycled through the pool in mir/events/event_pool.h
+    static auto operator new(std::size_t size) -> void*;
+    static void operator delete(void* block, std::size_t size) noexcept;
+
 protected:
     MirInputEvent(MirInputEventType input_type,
                   MirInputDeviceId dev,
@@ -19,12 +19,14 @@
 
 #include "mir/geometry/size.h"
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/frontend/buffer_stream.h"
 #include "mir/graphics/drm_formats.h"
 #include "mir_toolkit/common.h"
 #include "mir/graphics/buffer_id.h"
 
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -69,6 +71,14 @@ public:
          * Pixel format
          */
         virtual auto pixel_format() const -> graphics::DRMFormat = 0;
+
+        /**
+         * Region of the buffer, in buffer coördinates, that has changed since the
+         * compositor last claimed a buffer from this stream
+         *
+         * std::nullopt if the change is unknown and the whole buffer should be redrawn.
+         */
+        virtual auto damage() const -> std::optional<geometry::Rectangles> = 0;
     };
 };
 
@@ -29,10 +29,16 @@ class CompositorReport
 public:
     typedef const void* SubCompositorId;  // e.g. thread/display buffer ID
     virtual void added_display(int width, int height, int x, int y, SubCompositorId id) = 0;
+    /// The compositor is about to take the snapshot of the scene for its next frame
+    virtual void began_scene_snapshot(SubCompositorId id) = 0;
     virtual void began_frame(SubCompositorId id) = 0;
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
+    /// The frame was shown with \p overlays renderables scanned out directly
+    virtual void overlaid_frame(SubCompositorId id, size_t overlays) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// The frame has been posted to the display
+    virtual void posted_frame(SubCompositorId id) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
@@ -24,6 +24,7 @@
 
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <atomic>
 
 namespace mir
@@ -42,11 +43,22 @@ public:
         std::shared_ptr<graphics::Buffer> const& buffer,
         geometry::Size dest_size,
         geometry::RectangleD src_bounds) override;
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Size dest_size,
+        geometry::RectangleD src_bounds,
+        geometry::Rectangles const& damage) override;
     void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) override;
     auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission> override;
     bool has_submitted_buffer() const override;
 private:
+    void submit(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Size dest_size,
+        geometry::RectangleD src_bounds,
+        std::optional<geometry::Rectangles> const& damage);
+
     std::shared_ptr<MultiMonitorArbiter> const arbiter;
 
     std::atomic<bool> first_frame_posted;
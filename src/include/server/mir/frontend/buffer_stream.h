@@ -19,6 +19,7 @@
 
 #include <mir_toolkit/common.h>
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include <functional>
 #include <memory>
 
@@ -43,6 +44,18 @@ public:
         geometry::Size dest_size,
         geometry::RectangleD src_bounds) = 0;
 
+    /**
+     * Submit a buffer along with the region that changed since the previous submission
+     *
+     * \param [in] damage  The changed region, in buffer coördinates. Buffers submitted
+     *                      without damage are treated as entirely changed.
+     */
+    virtual void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Size dest_size,
+        geometry::RectangleD src_bounds,
+        geometry::Rectangles const& damage) = 0;
+
     virtual void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) = 0;
 protected:
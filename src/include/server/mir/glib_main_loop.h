@@ -165,8 +165,10 @@ private:
     std::atomic<bool> running_;
     detail::FdSources fd_sources;
     detail::SignalSources signal_sources;
+    detail::AlarmQueue alarms;
     std::mutex do_not_process_mutex;
     std::vector<void const*> do_not_process;
+    detail::ActionQueue actions;
     std::mutex run_on_halt_mutex;
     std::deque<ServerAction> run_on_halt_queue;
     std::function<void()> before_iteration_hook;
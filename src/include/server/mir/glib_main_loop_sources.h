@@ -18,9 +18,11 @@
 #define MIR_GLIB_MAIN_LOOP_SOURCES_H_
 
 #include "mir/time/clock.h"
+#include "mir/time/alarm_factory.h"
 #include "mir/thread_safe_list.h"
 #include "mir/fd.h"
 
+#include <atomic>
 #include <functional>
 #include <vector>
 #include <mutex>
@@ -65,12 +67,6 @@ private:
 void add_idle_gsource(
     GMainContext* main_context, int priority, std::function<void()> const& callback);
 
-void add_server_action_gsource(
-    GMainContext* main_context,
-    void const* owner,
-    std::function<void()> const& action,
-    std::function<bool(void const*)> const& should_dispatch);
-
 GSourceHandle add_timer_gsource(
     GMainContext* main_context,
     std::shared_ptr<time::Clock> const& clock,
@@ -78,6 +74,75 @@ GSourceHandle add_timer_gsource(
     std::function<void()> const& exception_handler,
     time::Timestamp target_time);
 
+/**
+ * Runs all the alarms of a main context from a single GSource.
+ *
+ * The pending alarms are kept in a heap ordered by when they are due, so scheduling, rescheduling and
+ * cancelling an alarm doesn't create, attach or destroy a GSource. Rescheduling a pending alarm for a later
+ * time (as happens when a timeout is pushed back on every input event) doesn't touch the heap at all: the alarm
+ * is moved to its new time when its old one comes round.
+ */
+class AlarmQueue : public time::AlarmFactory
+{
+public:
+    AlarmQueue(
+        GMainContext* main_context,
+        std::shared_ptr<time::Clock> const& clock,
+        std::function<void()> const& exception_handler);
+    ~AlarmQueue();
+
+    std::unique_ptr<time::Alarm> create_alarm(std::function<void()> const& callback) override;
+    std::unique_ptr<time::Alarm> create_alarm(std::unique_ptr<LockableCallback> callback) override;
+
+private:
+    struct Timer;
+    struct Timers;
+    struct TimerGSource;
+    class AlarmImpl;
+
+    std::shared_ptr<Timers> const timers;
+    GSourceHandle gsource;
+};
+
+/**
+ * Runs the actions queued for a main context from a single GSource.
+ *
+ * Actions are pushed onto a lock-free list, so queueing one doesn't create or attach a GSource, and everything
+ * queued by the time the source is dispatched is run in that one dispatch. Actions whose owner is paused stay queued,
+ * in order, until it is resumed.
+ */
+class ActionQueue
+{
+public:
+    ActionQueue(GMainContext* main_context, std::function<bool(void const*)> const& should_dispatch);
+    ~ActionQueue();
+
+    /// Queues an action that is held back while should_dispatch(owner) is false
+    void enqueue(void const* owner, std::function<void()> action);
+    /// Queues an action that is never held back
+    void spawn(std::function<void()> action);
+
+private:
+    struct Action;
+    struct ActionGSource;
+
+    void push(std::unique_ptr<Action> action);
+    void take_incoming();
+    auto can_dispatch(Action const& action) const -> bool;
+    auto ready() -> bool;
+    void dispatch();
+
+    GMainContext* const main_context;
+    std::function<bool(void const*)> const should_dispatch;
+    /// Actions queued since the last dispatch, most recent first
+    std::atomic<Action*> incoming{nullptr};
+    /// Actions taken from incoming but not yet run, oldest first. Only used by the main loop.
+    std::vector<std::unique_ptr<Action>> pending;
+    /// The actions being dispatched. Only used by the main loop, and kept to reuse its storage.
+    std::vector<std::unique_ptr<Action>> dispatching;
+    GSourceHandle gsource;
+};
+
 class FdSources
 {
 public:
@@ -21,6 +21,7 @@
 #include <functional>
 
 #include "mir/geometry/point.h"
+#include "mir/geometry/rectangles.h"
 
 namespace mir
 {
@@ -58,6 +59,10 @@ public:
     // TODO: How can something like SurfaceObserver be adapted to work with non surface renderables?
     virtual void emit_scene_changed() = 0;
 
+    /// Requests recomposition of only \p damage, for input visualizations that have moved or changed
+    /// without affecting anything else in the scene.
+    virtual void emit_scene_damaged(geometry::Rectangles const& damage) = 0;
+
     /// Returns if the screen is currently locked
     virtual auto screen_is_locked() const -> bool = 0;
 
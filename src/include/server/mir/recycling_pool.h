@@ -0,0 +1,92 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RECYCLING_POOL_H_
+#define MIR_RECYCLING_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+
+/**
+ * Recycles the storage of the short-lived objects a compositor makes each frame, so that
+ * steady-state frames don't go to the heap for them
+ *
+ * Objects are created with std::allocate_shared() and an Allocator from the pool; when the
+ * last reference goes the object is destroyed as usual, and its storage returns to the pool
+ * for the next frame. Storage is kept separately for each size allocated, so one pool can
+ * serve several types. Objects may be released on any thread.
+ */
+class RecyclingPool : public std::enable_shared_from_this<RecyclingPool>
+{
+public:
+    RecyclingPool() = default;
+    ~RecyclingPool();
+
+    RecyclingPool(RecyclingPool const&) = delete;
+    RecyclingPool& operator=(RecyclingPool const&) = delete;
+
+    auto allocate(std::size_t size) -> void*;
+    void deallocate(void* block, std::size_t size) noexcept;
+
+    template<typename T>
+    class Allocator
+    {
+    public:
+        using value_type = T;
+
+        explicit Allocator(std::shared_ptr<RecyclingPool> pool) : pool{std::move(pool)} {}
+        template<typename U>
+        Allocator(Allocator<U> const& other) : pool{other.pool} {}
+
+        auto allocate(std::size_t n) -> T*
+        {
+            return static_cast<T*>(pool->allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            pool->deallocate(p, n * sizeof(T));
+        }
+
+        template<typename U>
+        auto operator==(Allocator<U> const& other) const -> bool { return pool == other.pool; }
+
+    private:
+        template<typename U> friend class Allocator;
+        std::shared_ptr<RecyclingPool> pool;
+    };
+
+    template<typename T>
+    auto allocator() -> Allocator<T>
+    {
+        return Allocator<T>{shared_from_this()};
+    }
+
+private:
+    std::mutex mutex;
+    /// Free blocks, by size; there are only ever a few sizes
+    std::vector<std::pair<std::size_t, std::vector<void*>>> free_blocks;
+};
+
+}
+
+#endif /* MIR_RECYCLING_POOL_H_ */
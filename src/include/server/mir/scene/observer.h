@@ -22,6 +22,10 @@
 
 namespace mir
 {
+namespace geometry
+{
+class Rectangles;
+}
 namespace scene
 {
 class Surface;
@@ -49,6 +53,10 @@ public:
     /// and will require full recomposition.
     virtual void scene_changed() = 0;
 
+    /// Used to indicate something in the scene other than a surface (such as an input
+    /// visualization) has changed, and only \p damage needs to be recomposited.
+    virtual void scene_damaged(geometry::Rectangles const& damage) = 0;
+
     /// Called at observer registration to notify of already existing surfaces.
     virtual void surface_exists(std::shared_ptr<Surface> const& surface) = 0;
 
@@ -38,6 +38,8 @@ struct StreamInfo
 {
     std::shared_ptr<compositor::BufferStream> stream;
     geometry::Displacement displacement;
+    /// Parts of the stream (relative to its top-left) the client promises are fully opaque
+    std::vector<geometry::Rectangle> opaque_region{};
 };
 
 class SurfaceObserver;
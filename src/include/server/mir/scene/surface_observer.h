@@ -64,6 +64,8 @@ public:
     virtual void depth_layer_set_to(Surface const* surf, MirDepthLayer depth_layer) = 0;
     virtual void entered_output(Surface const* surf, graphics::DisplayConfigurationOutputId const& id) = 0;
     virtual void left_output(Surface const* surf, graphics::DisplayConfigurationOutputId const& id) = 0;
+    /// region is given in surface-local coordinates, and may reach outside the surface. Empty means the whole surface.
+    virtual void input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region) = 0;
 
 protected:
     SurfaceObserver() = default;
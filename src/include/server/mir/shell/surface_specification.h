@@ -22,11 +22,13 @@
 #include "mir/frontend/surface_id.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/buffer_properties.h"
 #include "mir/graphics/display_configuration.h"
 
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace mir
 {
@@ -47,6 +49,8 @@ struct StreamSpecification
 {
     std::weak_ptr<frontend::BufferStream> stream;
     geometry::Displacement displacement;
+    /// Parts of the stream (relative to its top-left) the client promises are fully opaque
+    std::vector<geometry::Rectangle> opaque_region{};
 };
 auto operator==(StreamSpecification const& lhs, StreamSpecification const& rhs) -> bool;
 
@@ -0,0 +1,328 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SNAPSHOT_OBSERVER_MULTIPLEXER_H_
+#define MIR_SNAPSHOT_OBSERVER_MULTIPLEXER_H_
+
+#include "mir/observer_registrar.h"
+#include "mir/executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace detail
+{
+/// The observers the current thread is part way through notifying. An observer appears once for each nested
+/// observation.
+inline thread_local std::vector<void const*> observations_in_progress;
+}
+
+/**
+ * A threadsafe mechanism for keeping track of a set of observers and distributing notifications to them, for
+ * observers that are notified much more often than they are added or removed.
+ *
+ * This gives the same guarantees as ObserverMultiplexer, but making an observation is cheaper:
+ *  - The observers are kept in an immutable snapshot that is replaced when an observer is added or removed, so
+ *    observations take no locks and don't copy the list of observers.
+ *  - Each observer counts its in-flight observations in an atomic, and the current thread's observations are noted
+ *    in a thread-local list. This is enough for unregister_interest() to wait for the observations on other threads
+ *    while still allowing an observer to be removed from within an observation.
+ *  - Observers that use the immediate_executor are called directly, rather than through Executor::spawn().
+ *
+ * A snapshot is freed once the last observation using it is over.
+ */
+template<class Observer>
+class SnapshotObserverMultiplexer : public ObserverRegistrar<Observer>, public Observer
+{
+public:
+    void register_interest(std::weak_ptr<Observer> const& observer) override;
+    void register_interest(
+        std::weak_ptr<Observer> const& observer,
+        Executor& executor) override;
+    void register_early_observer(
+        std::weak_ptr<Observer> const& observer,
+        Executor& executor) override;
+    void unregister_interest(Observer const& observer) override;
+
+    /// Returns true if there are no observers
+    auto empty() -> bool;
+
+protected:
+    /**
+     * \param [in] default_executor Executor that will be used as the execution environment
+     *                                  for any observer that does not specify its own.
+     * \note \p default_executor must outlive any observer.
+     */
+    explicit SnapshotObserverMultiplexer(Executor& default_executor)
+        : default_executor{default_executor}
+    {
+    }
+
+    /**
+     *  Invoke a member function of Observer on each registered observer.
+     *
+     * \tparam MemberFn Must be (Observer::*)(Args...)
+     * \tparam Args     Parameter pack of arguments of Observer member function.
+     * \param f         Pointer to Observer member function to invoke.
+     * \param args  Arguments for member function invocation.
+     */
+    template<typename MemberFn, typename... Args>
+    void for_each_observer(MemberFn f, Args&&... args);
+
+    /**
+     *  Invoke a member function of a specific Observer (if and only if it is registered).
+     *
+     * \tparam MemberFn Must be (Observer::*)(Args...)
+     * \tparam Args     Parameter pack of arguments of Observer member function.
+     * \param observer  Reference to the observer the function should be invoked for.
+     * \param f         Pointer to Observer member function to invoke.
+     * \param args      Arguments for member function invocation.
+     */
+    template<typename MemberFn, typename... Args>
+    void for_single_observer(Observer const& observer, MemberFn f, Args&&... args);
+
+private:
+    Executor& default_executor;
+
+    class WeakObserver
+    {
+    public:
+        WeakObserver(std::weak_ptr<Observer> observer, Executor& executor)
+            : observer{observer},
+              executor{&executor}
+        {
+        }
+
+        /// Makes the observation, unless the observer has been reset
+        template<typename MemberFn, typename... Args>
+        void invoke(MemberFn f, Args&&... args)
+        {
+            auto const live_observer = observer.lock();
+            if (!live_observer)
+            {
+                return;
+            }
+
+            InFlight const in_flight_observation{*this};
+            // Both this and reset() use sequentially consistent operations, so either this sees the reset or reset()
+            // sees this observation in flight
+            if (reset_requested.load())
+            {
+                return;
+            }
+            std::invoke(f, live_observer.get(), std::forward<Args>(args)...);
+        }
+
+        /// Stops new observations, and waits for those in flight on other threads to finish
+        void reset()
+        {
+            reset_requested.store(true);
+
+            auto const& in_progress_here = detail::observations_in_progress;
+            auto const in_flight_here = std::count(in_progress_here.begin(), in_progress_here.end(), this);
+            for (auto count = in_flight.load(); count > in_flight_here; count = in_flight.load())
+            {
+                in_flight.wait(count);
+            }
+        }
+
+        std::weak_ptr<Observer> const observer;
+
+        /// Only guaranteed to be alive while the observer is live. All observations should be run
+        /// through this executor.
+        Executor* const executor;
+
+    private:
+        class InFlight
+        {
+        public:
+            explicit InFlight(WeakObserver& owner)
+                : owner{owner}
+            {
+                owner.in_flight.fetch_add(1);
+                detail::observations_in_progress.push_back(&owner);
+            }
+
+            ~InFlight()
+            {
+                // Nested observations finish in the reverse order they started
+                detail::observations_in_progress.pop_back();
+                owner.in_flight.fetch_sub(1);
+                if (owner.reset_requested.load())
+                {
+                    owner.in_flight.notify_all();
+                }
+            }
+
+        private:
+            InFlight(InFlight const&) = delete;
+            InFlight& operator=(InFlight const&) = delete;
+
+            WeakObserver& owner;
+        };
+
+        std::atomic<bool> reset_requested{false};
+        std::atomic<long> in_flight{0};
+    };
+
+    using Observers = std::vector<std::shared_ptr<WeakObserver>>;
+
+    void add(std::shared_ptr<WeakObserver> const& observer, bool early);
+
+    /// Serializes changes to the snapshot
+    std::mutex mutex;
+    /// This is a two-partitioning of early observers and other observers.
+    /// Early observers are always partitioned before other observers.
+    std::atomic<std::shared_ptr<Observers const>> observers{std::make_shared<Observers const>()};
+};
+
+template<class Observer>
+void SnapshotObserverMultiplexer<Observer>::register_interest(std::weak_ptr<Observer> const& observer)
+{
+    register_interest(observer, default_executor);
+}
+
+template<class Observer>
+void SnapshotObserverMultiplexer<Observer>::register_interest(
+    std::weak_ptr<Observer> const& observer,
+    Executor& executor)
+{
+    add(std::make_shared<WeakObserver>(observer, executor), false);
+}
+
+template<class Observer>
+void SnapshotObserverMultiplexer<Observer>::register_early_observer(
+    std::weak_ptr<Observer> const& observer,
+    Executor& executor)
+{
+    add(std::make_shared<WeakObserver>(observer, executor), true);
+}
+
+template<class Observer>
+void SnapshotObserverMultiplexer<Observer>::add(std::shared_ptr<WeakObserver> const& observer, bool early)
+{
+    std::lock_guard lock{mutex};
+
+    auto updated = std::make_shared<Observers>(*observers.load());
+    updated->insert(early ? updated->begin() : updated->end(), observer);
+    observers.store(std::move(updated));
+}
+
+template<class Observer>
+void SnapshotObserverMultiplexer<Observer>::unregister_interest(Observer const& observer)
+{
+    Observers removed;
+
+    {
+        std::lock_guard lock{mutex};
+
+        auto updated = std::make_shared<Observers>();
+        for (auto const& candidate : *observers.load())
+        {
+            auto const live_candidate = candidate->observer.lock();
+            if (live_candidate.get() == &observer)
+            {
+                removed.push_back(candidate);
+            }
+            else if (live_candidate)
+            {
+                updated->push_back(candidate);
+            }
+        }
+        observers.store(std::move(updated));
+    }
+
+    // Observations that have already taken the old snapshot may still be starting, so wait for them here (without
+    // holding the lock, so they can add or remove observers themselves)
+    for (auto const& weak_observer : removed)
+    {
+        weak_observer->reset();
+    }
+}
+
+template<class Observer>
+auto SnapshotObserverMultiplexer<Observer>::empty() -> bool
+{
+    return observers.load()->empty();
+}
+
+template<class Observer>
+template<typename MemberFn, typename... Args>
+void SnapshotObserverMultiplexer<Observer>::for_each_observer(MemberFn f, Args&&... args)
+{
+    static_assert(
+        std::is_member_function_pointer<MemberFn>::value,
+        "f must be of type (Observer::*)(Args...), a pointer to an Observer member function.");
+    auto const snapshot = observers.load();
+    for (auto const& weak_observer : *snapshot)
+    {
+        if (weak_observer->executor == &immediate_executor)
+        {
+            weak_observer->invoke(f, args...);
+        }
+        // Executor only guaranteed to be alive as long as observer
+        else if (auto const live_observer = weak_observer->observer.lock())
+        {
+            weak_observer->executor->spawn(
+                [f, weak_observer, args...]() mutable
+                {
+                    weak_observer->invoke(f, std::forward<Args>(args)...);
+                });
+        }
+    }
+}
+
+template<class Observer>
+template<typename MemberFn, typename... Args>
+void SnapshotObserverMultiplexer<Observer>::for_single_observer(
+    Observer const& target_observer,
+    MemberFn f,
+    Args&&... args)
+{
+    static_assert(
+        std::is_member_function_pointer<MemberFn>::value,
+        "f must be of type (Observer::*)(Args...), a pointer to an Observer member function.");
+    auto const snapshot = observers.load();
+    for (auto const& weak_observer : *snapshot)
+    {
+        // Executor is only guaranteed to be live as long as observer
+        auto const live_observer = weak_observer->observer.lock();
+        if (live_observer.get() == &target_observer)
+        {
+            if (weak_observer->executor == &immediate_executor)
+            {
+                weak_observer->invoke(f, args...);
+            }
+            else
+            {
+                weak_observer->executor->spawn(
+                    [f, weak_observer, args...]() mutable
+                    {
+                        weak_observer->invoke(f, std::forward<Args>(args)...);
+                    });
+            }
+        }
+    }
+}
+}
+
+#endif // MIR_SNAPSHOT_OBSERVER_MULTIPLEXER_H_
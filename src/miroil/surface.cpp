@@ -59,6 +59,8 @@ public:
                          mir::geometry::Size const &window_size) override;
   void entered_output(mir::scene::Surface const* surf, mir::graphics::DisplayConfigurationOutputId const& id) override;
   void left_output(mir::scene::Surface const* surf, mir::graphics::DisplayConfigurationOutputId const& id) override;
+  void input_region_set_to(mir::scene::Surface const* /*surf*/,
+                           std::vector<mir::geometry::Rectangle> const& /*region*/) override{};
 
 private:
   std::shared_ptr<miroil::SurfaceObserver> listener;
@@ -416,10 +416,11 @@ auto export_egl_image(
 }
 
 /**
- * Reimport dmabufs into EGL
+ * Import dmabufs into EGL
  *
- * This is necessary to call each time the buffer is re-submitted by the client,
- * to ensure any state is properly synchronised.
+ * This is expensive (it involves the kernel), so WlDmaBufBuffer keeps the image it
+ * imported for the lifetime of the wl_buffer. Each submission still binds the image
+ * to a fresh texture, to ensure any state is properly synchronised.
  *
  * \return  An EGLImageKHR handle to the imported
  * \throws  A std::system_error containing the EGL error on failure.
@@ -530,6 +531,46 @@ BufferGLDescription const* descriptor_for_format_and_modifiers(
 
 }
 
+/**
+ * An EGLImage, destroyed along with its owner
+ */
+class OwnedEGLImage
+{
+public:
+    OwnedEGLImage(EGLDisplay dpy, std::shared_ptr<mg::EGLExtensions> extensions, EGLImage image)
+        : dpy{dpy},
+          extensions{std::move(extensions)},
+          image_{image}
+    {
+    }
+
+    ~OwnedEGLImage()
+    {
+        if (image_ != EGL_NO_IMAGE_KHR)
+        {
+            extensions->base(dpy).eglDestroyImageKHR(dpy, image_);
+        }
+    }
+
+    OwnedEGLImage(OwnedEGLImage const&) = delete;
+    OwnedEGLImage& operator=(OwnedEGLImage const&) = delete;
+
+    auto display() const -> EGLDisplay
+    {
+        return dpy;
+    }
+
+    auto image() const -> EGLImage
+    {
+        return image_;
+    }
+
+private:
+    EGLDisplay const dpy;
+    std::shared_ptr<mg::EGLExtensions> const extensions;
+    EGLImage const image_;
+};
+
 /**
  * Holds on to all imported dmabuf buffers, and allows looking up by wl_buffer
  *
@@ -594,12 +635,36 @@ public:
     {
         return planes_;
     }
+
+    /**
+     * The EGLImage of this buffer on \p dpy, if it has already been imported there
+     */
+    auto imported_image(EGLDisplay dpy) const -> std::optional<EGLImage>
+    {
+        if (image && image->display() == dpy)
+        {
+            return image->image();
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * Keep \p imported for as long as the client keeps this wl_buffer
+     *
+     * Clients cycle through the same few buffers, so this saves re-importing on every commit.
+     */
+    void keep_imported_image(std::unique_ptr<OwnedEGLImage> imported) const
+    {
+        image = std::move(imported);
+    }
 private:
     int32_t const width, height;
     mg::DRMFormat const format_;
     uint32_t const flags;
     std::optional<uint64_t> const modifier_;
     std::vector<PlaneInfo> const planes_;
+    /// Only touched on the Wayland thread, like the rest of this class
+    std::unique_ptr<OwnedEGLImage> mutable image;
 };
 
 class LinuxDmaBufParams : public mir::wayland::LinuxBufferParamsV1
@@ -786,8 +851,8 @@ private:
                 modifier.value(),
                 {planes.cbegin(), last_valid_plane}};
 
-            // We don't need to keep it around, but we do need to ensure that we *can* create a Buffer
-            // from this dma-buf
+            // We need to ensure that we *can* create a Buffer from this dma-buf; the import
+            // is then kept for the buffer's first submission
             provider->validate_import(*dma_buf);
             send_created_event(buffer_resource);
         }
@@ -829,8 +894,8 @@ private:
                 flags,
                 modifier.value(),
                 {planes.cbegin(), last_valid_plane}};
-            // We don't need to keep it around, but we do need to ensure that we *can* create a Buffer
-            // from this dma-buf
+            // We need to ensure that we *can* create a Buffer from this dma-buf; the import
+            // is then kept for the buffer's first submission
             provider->validate_import(*dma_buf);
         }
         catch (std::system_error const& err)
@@ -877,10 +942,6 @@ public:
           layout_{dma_buf.layout()},
           egl_delegate{std::move(egl_delegate)}
     {
-        eglBindAPI(EGL_OPENGL_ES_API);
-
-        auto const target = descriptor.target;
-
         EGLImage image = import_egl_image(
             dma_buf.size().width.as_int(),
             dma_buf.size().height.as_int(),
@@ -890,17 +951,29 @@ public:
             dpy,
             extensions);
 
-        glBindTexture(target, tex);
-        extensions.base(dpy).glEGLImageTargetTexture2DOES(target, image);
+        attach(dpy, extensions, image);
 
         // tex is now an EGLImage sibling, so we can free the EGLImage without
         // freeing the backing data.
         extensions.base(dpy).eglDestroyImageKHR(dpy, image);
+    }
 
-        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    /**
+     * Texture from an already-imported \p image, which remains owned by the caller
+     */
+    DMABufTex(
+        EGLDisplay dpy,
+        mg::EGLExtensions const& extensions,
+        EGLImage image,
+        Layout layout,
+        BufferGLDescription const& descriptor,
+        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
+        : tex{get_tex_id()},
+          desc{descriptor},
+          layout_{layout},
+          egl_delegate{std::move(egl_delegate)}
+    {
+        attach(dpy, extensions, image);
     }
 
     ~DMABufTex() override
@@ -938,6 +1011,21 @@ public:
     {
     }
 private:
+    void attach(EGLDisplay dpy, mg::EGLExtensions const& extensions, EGLImage image)
+    {
+        eglBindAPI(EGL_OPENGL_ES_API);
+
+        auto const target = desc.target;
+
+        glBindTexture(target, tex);
+        extensions.base(dpy).glEGLImageTargetTexture2DOES(target, image);
+
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
     GLuint const tex;
     BufferGLDescription const& desc;
     Layout const layout_;
@@ -949,18 +1037,19 @@ class DmabufTexBuffer :
     public mg::DMABufBuffer
 {
 public:
-    // Note: Must be called with a current EGL context
+    // Note: Must be called with a current EGL context. \p image remains owned by the caller.
     DmabufTexBuffer(
         EGLDisplay dpy,
         mg::EGLExtensions const& extensions,
         mg::DMABufBuffer const& dma_buf,
+        EGLImage image,
         BufferGLDescription const& descriptor,
         std::shared_ptr<mg::DMABufEGLProvider> provider,
         std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release)
         : dpy{dpy},
-          tex{dpy, extensions, dma_buf, descriptor, std::move(egl_delegate)},
+          tex{dpy, extensions, image, dma_buf.layout(), descriptor, std::move(egl_delegate)},
           provider_{std::move(provider)},
           on_consumed{std::move(on_consumed)},
           on_release{std::move(on_release)},
@@ -1164,30 +1253,62 @@ auto mg::DMABufEGLProvider::import_dma_buf(
         dma_buf.format(),
         dma_buf.modifier().value_or(DRM_FORMAT_MOD_INVALID),
         *this);
-    return std::make_shared<DmabufTexBuffer>(
+
+    // Steady state, clients resubmit buffers we have already imported
+    auto const wl_dma_buf = dynamic_cast<WlDmaBufBuffer const*>(&dma_buf);
+    auto image = wl_dma_buf ? wl_dma_buf->imported_image(dpy) : std::nullopt;
+
+    std::unique_ptr<OwnedEGLImage> imported;
+    if (!image)
+    {
+        imported = std::make_unique<OwnedEGLImage>(
+            dpy,
+            egl_extensions,
+            import_egl_image(
+                dma_buf.size().width.as_int(), dma_buf.size().height.as_int(),
+                dma_buf.format(),
+                dma_buf.modifier(),
+                dma_buf.planes(),
+                dpy,
+                *egl_extensions));
+        image = imported->image();
+    }
+
+    auto buffer = std::make_shared<DmabufTexBuffer>(
         dpy,
         *egl_extensions,
         dma_buf,
+        *image,
         *descriptor,
         shared_from_this(),
         egl_delegate,
         std::move(on_consumed),
         std::move(on_release));
+
+    if (wl_dma_buf && imported)
+    {
+        wl_dma_buf->keep_imported_image(std::move(imported));
+    }
+    return buffer;
 }
 
 void mg::DMABufEGLProvider::validate_import(DMABufBuffer const& dma_buf)
 {
-    auto image = import_egl_image(
-        dma_buf.size().width.as_int(), dma_buf.size().height.as_int(),
-        dma_buf.format(),
-        dma_buf.modifier(),
-        dma_buf.planes(),
+    auto image = std::make_unique<OwnedEGLImage>(
         dpy,
-        *egl_extensions);
-    if (image != EGL_NO_IMAGE_KHR)
+        egl_extensions,
+        import_egl_image(
+            dma_buf.size().width.as_int(), dma_buf.size().height.as_int(),
+            dma_buf.format(),
+            dma_buf.modifier(),
+            dma_buf.planes(),
+            dpy,
+            *egl_extensions));
+
+    // Rather than throwing the image away, keep it for the buffer's first submission
+    if (auto const wl_dma_buf = dynamic_cast<WlDmaBufBuffer const*>(&dma_buf))
     {
-        // We can throw this image away immediately
-        egl_extensions->base(dpy).eglDestroyImageKHR(dpy, image);
+        wl_dma_buf->keep_imported_image(std::move(image));
     }
 }
 
@@ -26,6 +26,7 @@ namespace mo = mir::options;
 char const* const mo::arw_server_socket_opt       = "arw-file";
 char const* const mo::enable_input_opt            = "enable-input,i";
 char const* const mo::compositor_report_opt       = "compositor-report";
+char const* const mo::compositor_metrics_opt      = "compositor-metrics";
 char const* const mo::display_report_opt          = "display-report";
 char const* const mo::scene_report_opt            = "scene-report";
 char const* const mo::input_report_opt            = "input-report";
@@ -38,6 +39,8 @@ char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
 char const* const mo::composite_delay_opt         = "composite-delay";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
+char const* const mo::coalesce_pointer_motion_opt = "coalesce-pointer-motion";
+char const* const mo::async_logging_opt           = "async-logging";
 char const* const mo::x11_display_opt             = "enable-x11";
 char const* const mo::x11_scale_opt               = "x11-scale";
 char const* const mo::wayland_extensions_opt      = "wayland-extensions";
@@ -152,6 +155,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Enable input.")
         (compositor_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "Compositor reporting [{log,lttng,off}]")
+        (compositor_metrics_opt, po::value<std::string>(),
+            "File to which the compositor's frame time percentiles for each output are "
+            "written every second, in OpenMetrics text format")
         (display_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the Display report. [{log,lttng,off}]")
         (input_report_opt, po::value<std::string>()->default_value(off_opt_value),
@@ -176,6 +182,12 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Cursor (mouse pointer) to use [{auto,null,software}]")
         (enable_key_repeat_opt, po::value<bool>()->default_value(true),
              "Enable server generated key repeat")
+        (coalesce_pointer_motion_opt, po::value<bool>()->default_value(false),
+             "Hold back pointer motion for a client that is waiting on a frame "
+             "callback, and send it merged when the frame callback is sent")
+        (async_logging_opt, po::value<std::string>()->default_value(off_opt_value),
+             "Write log messages from a background thread, and when the queue is full "
+             "either drop messages or wait [{off,drop,block}]")
         (idle_timeout_opt, po::value<int>()->default_value(0),
             "Time (in seconds) Mir will remain idle before turning off the display, "
             "or 0 to keep display on forever.")
@@ -266,6 +266,8 @@ mg::CPUAddressableFB::CPUAddressableFB(
     DRMFormat format,
     std::unique_ptr<Buffer> buffer)
     : drm_fd{std::move(drm_fd)},
+      drm_format_{format},
+      has_modifier{supports_modifiers},
       fb_id{fb_id_for_buffer(this->drm_fd, supports_modifiers, format, *buffer)},
       buffer{std::move(buffer)}
 {
@@ -296,6 +298,20 @@ mg::CPUAddressableFB::operator uint32_t() const
     return fb_id;
 }
 
+auto mg::CPUAddressableFB::drm_format() const -> DRMFormat
+{
+    return drm_format_;
+}
+
+auto mg::CPUAddressableFB::modifier() const -> std::optional<uint64_t>
+{
+    if (has_modifier)
+    {
+        return DRM_FORMAT_MOD_LINEAR;
+    }
+    return std::nullopt;
+}
+
 auto mg::CPUAddressableFB::fb_id_for_buffer(
     mir::Fd const &drm_fd,
     bool supports_modifiers,
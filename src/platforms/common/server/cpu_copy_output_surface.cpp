@@ -139,6 +139,7 @@ public:
     auto commit() -> std::unique_ptr<mg::Framebuffer>;
 
     auto size() const -> geom::Size;
+    auto buffer_age() const -> unsigned;
     auto layout() const -> Layout;
 
 private:
@@ -149,6 +150,8 @@ private:
     RenderbufferHandle const colour_buffer;
     std::shared_ptr<RenderbufferHandle> depth_stencil_buffer;
     FramebufferHandle const fbo;
+    // We render into the same renderbuffer every frame, so once we've committed a frame it is always current
+    bool has_committed{false};
 };
 
 mgc::CPUCopyOutputSurface::CPUCopyOutputSurface(
@@ -187,6 +190,11 @@ auto mgc::CPUCopyOutputSurface::size() const -> geom::Size
     return impl->size();
 }
 
+auto mgc::CPUCopyOutputSurface::buffer_age() const -> unsigned
+{
+    return impl->buffer_age();
+}
+
 auto mgc::CPUCopyOutputSurface::layout() const -> Layout
 {
     return impl->layout();
@@ -291,9 +299,13 @@ auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffe
         }
         auto mapping = fb->map_writeable();
         /*
-         * TODO: This introduces a pipeline stall; GL must wait for all previous rendering commands
-         * to complete before glReadPixels returns. We could instead do something fancy with
-         * pixel buffer objects to defer this cost.
+         * This introduces a pipeline stall; GL must wait for all previous rendering commands
+         * to complete before glReadPixels returns.
+         *
+         * A ring of pixel buffer objects can't defer this cost: the framebuffer is allocated by
+         * alloc_fb() for this frame only, and commit() must return it holding this frame (the
+         * sink presents it, and the screen shooter hands it to its client, as soon as we return).
+         * Deferring the readback would need the allocator to accept a frame after commit().
          */
         /*
          * TODO: We are assuming that the framebuffer pixel format is RGBX
@@ -303,6 +315,7 @@ auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffe
             fb->size().width.as_uint32_t(), fb->size().height.as_uint32_t(),
             pixel_layout, GL_UNSIGNED_BYTE, mapping->data());
     }
+    has_committed = true;
     return fb;
 }
 
@@ -311,6 +324,11 @@ auto mgc::CPUCopyOutputSurface::Impl::size() const -> geom::Size
     return allocator.output_size();
 }
 
+auto mgc::CPUCopyOutputSurface::Impl::buffer_age() const -> unsigned
+{
+    return has_committed ? 1 : 0;
+}
+
 auto mgc::CPUCopyOutputSurface::Impl::layout() const -> Layout
 {
     return Layout::TopRowFirst;
@@ -18,6 +18,10 @@
 #define MIR_GRAPHICS_GBM_KMS_FRAMEBUFFER_H_
 
 #include "mir/graphics/platform.h"
+#include "mir/graphics/drm_formats.h"
+
+#include <cstdint>
+#include <optional>
 
 namespace mir
 {
@@ -29,6 +33,12 @@ public:
     virtual ~FBHandle() = default;
 
     virtual operator uint32_t() const = 0;
+
+    /// The pixel format of the framebuffer, as KMS sees it
+    virtual auto drm_format() const -> DRMFormat = 0;
+
+    /// The modifier of the framebuffer, or std::nullopt if it was created with an implicit modifier
+    virtual auto modifier() const -> std::optional<uint64_t> = 0;
 };
 
 }
@@ -26,9 +26,12 @@
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+#include <deque>
 #include <string.h>
 #include <endian.h>
 
@@ -91,13 +94,166 @@ bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
     return mg::get_gl_pixel_format(mir_format, gl_format, gl_type);
 }
 
+/**
+ * The textures holding the content of the most recently uploaded of a sequence of ShmBuffers
+ *
+ * Each GL context (that is, each output) gets a texture of its own. The contexts share textures, but
+ * GL only orders updates and reads of a texture within one context; keeping them apart means an
+ * output can't sample a texture while another is part way through respecifying it, and no upload
+ * has to be synchronised with the other contexts.
+ */
+class mgc::ShmBuffer::SharedTexture
+{
+public:
+    struct ContextTexture
+    {
+        EGLContext context;
+        GLuint tex_id{0};
+        /// The generation whose content the texture holds, if any
+        std::optional<uint64_t> uploaded_generation;
+    };
+
+    explicit SharedTexture(std::shared_ptr<EGLContextExecutor> egl_delegate)
+        : egl_delegate{std::move(egl_delegate)}
+    {
+    }
+
+    ~SharedTexture()
+    {
+        for (auto const& texture : textures)
+        {
+            if (texture.tex_id != 0)
+            {
+                egl_delegate->spawn(
+                    [id = texture.tex_id]()
+                    {
+                        glDeleteTextures(1, &id);
+                    });
+            }
+        }
+    }
+
+    /// The texture used by context
+    /// \note mutex must be held
+    auto texture_for(EGLContext context) -> ContextTexture&
+    {
+        auto const existing = std::find_if(textures.begin(), textures.end(),
+            [context](auto const& texture) { return texture.context == context; });
+        if (existing != textures.end())
+        {
+            return *existing;
+        }
+        return textures.emplace_back(ContextTexture{context, 0, std::nullopt});
+    }
+
+    /// Record the damage of a new buffer relative to its predecessor, returning its generation
+    auto add_generation(std::optional<geom::Rectangles> const& damage) -> uint64_t
+    {
+        std::lock_guard lock{mutex};
+        damage_history.push_back(damage);
+        if (damage_history.size() > max_history)
+        {
+            // Nobody is uploading these buffers; don't keep their damage forever
+            damage_history.pop_front();
+            ++first_recorded_generation;
+        }
+        return next_generation++;
+    }
+
+    /// The region that must be uploaded to bring texture up to date with generation
+    /// \note mutex must be held
+    auto damage_to_upload(ContextTexture const& texture, uint64_t generation) const -> std::optional<geom::Rectangles>
+    {
+        auto const& uploaded_generation = texture.uploaded_generation;
+        if (!uploaded_generation || *uploaded_generation + 1 < first_recorded_generation)
+        {
+            return std::nullopt;
+        }
+
+        geom::Rectangles damage;
+        for (auto g = *uploaded_generation + 1; g <= generation; ++g)
+        {
+            auto const& generation_damage = damage_history[g - first_recorded_generation];
+            if (!generation_damage)
+            {
+                return std::nullopt;
+            }
+            for (auto const& rect : *generation_damage)
+            {
+                damage.add(rect);
+            }
+        }
+        return damage;
+    }
+
+    /// \note mutex must be held
+    void uploaded(ContextTexture& texture, uint64_t generation)
+    {
+        texture.uploaded_generation = generation;
+
+        // Only newer generations will be uploaded to these textures from now on; keep the damage any of
+        // them still needs
+        auto oldest_uploaded = generation;
+        for (auto const& other : textures)
+        {
+            if (other.uploaded_generation)
+            {
+                oldest_uploaded = std::min(oldest_uploaded, *other.uploaded_generation);
+            }
+        }
+        while (first_recorded_generation <= oldest_uploaded && !damage_history.empty())
+        {
+            damage_history.pop_front();
+            ++first_recorded_generation;
+        }
+    }
+
+    std::mutex mutex;
+
+private:
+    static size_t constexpr max_history{16};
+
+    std::shared_ptr<EGLContextExecutor> const egl_delegate;
+    uint64_t next_generation{0};
+    uint64_t first_recorded_generation{0};
+    /// The damage of each generation from first_recorded_generation onwards, relative to the one before
+    std::deque<std::optional<geom::Rectangles>> damage_history;
+    std::vector<ContextTexture> textures;
+};
+
+namespace
+{
+auto can_share_texture(
+    std::shared_ptr<mgc::ShmBuffer> const& previous,
+    geom::Size const& size,
+    MirPixelFormat format) -> bool
+{
+    return previous && previous->size() == size && previous->pixel_format() == format;
+}
+}
+
 mgc::ShmBuffer::ShmBuffer(
     geom::Size const& size,
     MirPixelFormat const& format,
     std::shared_ptr<EGLContextExecutor> egl_delegate)
+    : ShmBuffer(size, format, std::move(egl_delegate), nullptr, std::nullopt)
+{
+}
+
+mgc::ShmBuffer::ShmBuffer(
+    geom::Size const& size,
+    MirPixelFormat const& format,
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::shared_ptr<ShmBuffer> const& previous,
+    std::optional<geom::Rectangles> const& damage)
     : size_{size},
       pixel_format_{format},
-      egl_delegate{std::move(egl_delegate)}
+      egl_delegate{std::move(egl_delegate)},
+      texture{
+          can_share_texture(previous, size, format) ?
+              previous->texture :
+              std::make_shared<SharedTexture>(this->egl_delegate)},
+      generation{texture->add_generation(damage)}
 {
 }
 
@@ -113,7 +269,7 @@ mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
 
 mgc::ShmBuffer::~ShmBuffer() noexcept
 {
-    if (tex_id != 0)
+    for (auto const& [context, tex_id] : private_textures)
     {
         egl_delegate->spawn(
             [id = tex_id]()
@@ -133,14 +289,17 @@ MirPixelFormat mgc::ShmBuffer::pixel_format() const
     return pixel_format_;
 }
 
-void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& stride)
+void mgc::ShmBuffer::upload_to_texture(
+    void const* pixels,
+    geom::Stride const& stride,
+    std::optional<geom::Rectangles> const& region)
 {
     GLenum format, type;
 
     if (mg::get_gl_pixel_format(pixel_format_, format, type))
     {
-        auto const stride_in_px =
-            stride.as_int() / MIR_BYTES_PER_PIXEL(pixel_format());
+        auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format());
+        auto const stride_in_px = stride.as_int() / bytes_per_pixel;
         /*
          * We assume (as does Weston, AFAICT) that stride is
          * a multiple of whole pixels, but it need not be.
@@ -153,20 +312,52 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
         glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            format,
-            size().width.as_int(), size().height.as_int(),
-            0,
-            format,
-            type,
-            pixels);
+        if (region)
+        {
+            geom::Rectangle const buffer_rect{{0, 0}, size()};
+            for (auto const& damage : *region)
+            {
+                auto const rect = intersection_of(damage, buffer_rect);
+                if (rect.size.width == geom::Width{} || rect.size.height == geom::Height{})
+                {
+                    continue;
+                }
+
+                // Point GL at the first damaged pixel; GL_UNPACK_ROW_LENGTH_EXT takes care of the rest
+                auto const first_pixel =
+                    static_cast<unsigned char const*>(pixels) +
+                    rect.top().as_int() * stride.as_int() +
+                    rect.left().as_int() * bytes_per_pixel;
+
+                glTexSubImage2D(
+                    GL_TEXTURE_2D,
+                    0,
+                    rect.left().as_int(), rect.top().as_int(),
+                    rect.size.width.as_int(), rect.size.height.as_int(),
+                    format,
+                    type,
+                    first_pixel);
+            }
+        }
+        else
+        {
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                format,
+                size().width.as_int(), size().height.as_int(),
+                0,
+                format,
+                type,
+                pixels);
+        }
 
         // Be nice to other users of the GL context by reverting our changes to shared state
         glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
-        glFinish();
+
+        // The texture is only used by the current context, which orders this upload before any
+        // draw that samples it, so there's nothing to flush or wait for.
     }
     else
     {
@@ -182,9 +373,12 @@ mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
     return this;
 }
 
-void mgc::ShmBuffer::bind()
+namespace
+{
+/// Binds tex_id, generating and setting up the texture first if needed
+/// \return true if the texture was newly generated
+auto bind_texture(GLuint& tex_id) -> bool
 {
-    std::lock_guard lock{tex_id_mutex};
     bool const needs_initialisation = tex_id == 0;
     if (needs_initialisation)
     {
@@ -193,25 +387,58 @@ void mgc::ShmBuffer::bind()
     glBindTexture(GL_TEXTURE_2D, tex_id);
     if (needs_initialisation)
     {
-        // The ShmBuffer *should* be immutable, so we can just upload once.
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
+    return needs_initialisation;
+}
 }
 
-void mgc::MemoryBackedShmBuffer::bind()
+void mgc::ShmBuffer::bind()
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
+    std::lock_guard lock{texture->mutex};
+
+    auto const context = eglGetCurrentContext();
+    auto& context_texture = texture->texture_for(context);
+
+    if (context_texture.uploaded_generation > generation)
+    {
+        // A newer buffer already owns this context's texture (e.g. the buffer was held back
+        // for this output). The ShmBuffer *should* be immutable, so we can just upload once.
+        auto private_texture = std::find_if(private_textures.begin(), private_textures.end(),
+            [context](auto const& entry) { return entry.first == context; });
+        if (private_texture == private_textures.end())
+        {
+            private_texture = private_textures.insert(private_textures.end(), {context, 0});
+        }
+
+        if (bind_texture(private_texture->second))
+        {
+            auto const mapping = map_for_upload();
+            upload_to_texture(mapping->data(), mapping->stride(), std::nullopt);
+        }
+        return;
+    }
+
+    bind_texture(context_texture.tex_id);
+    if (context_texture.uploaded_generation != generation)
     {
-        upload_to_texture(pixels.get(), stride_);
-        uploaded = true;
+        auto const mapping = map_for_upload();
+        upload_to_texture(
+            mapping->data(),
+            mapping->stride(),
+            texture->damage_to_upload(context_texture, generation));
+        texture->uploaded(context_texture, generation);
     }
 }
 
+auto mgc::MemoryBackedShmBuffer::map_for_upload() -> std::unique_ptr<mrs::Mapping<unsigned char const>>
+{
+    return map_readable();
+}
+
 template<typename T>
 class mgc::MemoryBackedShmBuffer::Mapping : public mir::renderer::software::Mapping<T>
 {
@@ -295,6 +522,16 @@ mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
 {
 }
 
+mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
+    std::shared_ptr<mrs::RWMappableBuffer> data,
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::shared_ptr<ShmBuffer> const& previous,
+    std::optional<geom::Rectangles> const& damage)
+    : ShmBuffer(data->size(), data->format(), std::move(egl_delegate), previous, damage),
+      data{std::move(data)}
+{
+}
+
 auto mgc::MappableBackedShmBuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>>
 {
     return data->map_writeable();
@@ -310,16 +547,9 @@ auto mgc::MappableBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsi
     return data->map_rw();
 }
 
-void mgc::MappableBackedShmBuffer::bind()
+auto mgc::MappableBackedShmBuffer::map_for_upload() -> std::unique_ptr<mrs::Mapping<unsigned char const>>
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
-    {
-        auto mapping = data->map_readable();
-        upload_to_texture(mapping->data(), mapping->stride());
-        uploaded = true;
-    }
+    return data->map_readable();
 }
 
 auto mgc::MappableBackedShmBuffer::format() const -> MirPixelFormat
@@ -348,6 +578,19 @@ mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
 {
 }
 
+mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
+    std::shared_ptr<mrs::RWMappableBuffer> data,
+    std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+    std::shared_ptr<ShmBuffer> const& previous,
+    std::optional<geom::Rectangles> const& damage,
+    std::function<void()>&& on_consumed,
+    std::function<void()>&& on_release)
+    :  MappableBackedShmBuffer(std::move(data), std::move(egl_delegate), previous, damage),
+       on_consumed{std::move(on_consumed)},
+       on_release{std::move(on_release)}
+{
+}
+
 mgc::NotifyingMappableBackedShmBuffer::~NotifyingMappableBackedShmBuffer()
 {
     on_release();
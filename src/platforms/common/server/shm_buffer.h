@@ -20,14 +20,19 @@
 #include "mir/graphics/buffer_basic.h"
 #include "mir/geometry/dimensions.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include "mir_toolkit/common.h"
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/texture.h"
 
 #include <GLES2/gl2.h>
+#include <EGL/egl.h>
 
 #include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace mir
 {
@@ -63,14 +68,47 @@ protected:
         MirPixelFormat const& format,
         std::shared_ptr<EGLContextExecutor> egl_delegate);
 
-    /// \note This must be called with a current GL context
-    void upload_to_texture(void const* pixels, geometry::Stride const& stride);
+    /**
+     * Construct a buffer that replaces \a previous as the content of a surface
+     *
+     * If the buffers match in size and format they share a texture in each GL context, and
+     * binding this buffer only uploads the region that has changed since that context's
+     * texture was last updated.
+     *
+     * \param damage [in]  The region of this buffer (in buffer coordinates) that differs
+     *                     from \a previous, or std::nullopt if unknown.
+     */
+    ShmBuffer(
+        geometry::Size const& size,
+        MirPixelFormat const& format,
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::shared_ptr<ShmBuffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage);
+
+    /// The pixels to upload when this buffer is bound
+    virtual auto map_for_upload() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> = 0;
+
 private:
+    class SharedTexture;
+
+    /**
+     * Upload \a region of \a pixels (or all of them, if std::nullopt) to the bound texture
+     * \note This must be called with a current GL context
+     */
+    void upload_to_texture(
+        void const* pixels,
+        geometry::Stride const& stride,
+        std::optional<geometry::Rectangles> const& region);
+
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
     std::shared_ptr<EGLContextExecutor> const egl_delegate;
-    std::mutex tex_id_mutex;
-    GLuint tex_id{0};
+    std::shared_ptr<SharedTexture> const texture;
+    /// Position of this buffer in the sequence of buffers sharing texture
+    uint64_t const generation;
+    /// The texture used by each GL context that binds this buffer after a newer one has been
+    /// uploaded to that context's shared texture
+    std::vector<std::pair<EGLContext, GLuint>> private_textures;
 };
 
 class MemoryBackedShmBuffer :
@@ -88,14 +126,14 @@ public:
 
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override { return ShmBuffer::pixel_format(); }
     auto stride() const -> geometry::Stride override { return stride_; }
     auto size() const -> geometry::Size override { return ShmBuffer::size(); }
 
     MemoryBackedShmBuffer(MemoryBackedShmBuffer const&) = delete;
     MemoryBackedShmBuffer& operator=(MemoryBackedShmBuffer const&) = delete;
+protected:
+    auto map_for_upload() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
 private:
     template<typename T>
     class Mapping;
@@ -105,8 +143,6 @@ private:
 
     geometry::Stride const stride_;
     std::unique_ptr<unsigned char[]> const pixels;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class MappableBackedShmBuffer :
@@ -118,22 +154,27 @@ public:
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
         std::shared_ptr<EGLContextExecutor> egl_delegate);
 
+    /// \see ShmBuffer::ShmBuffer for the meaning of \a previous and \a damage
+    MappableBackedShmBuffer(
+        std::shared_ptr<renderer::software::RWMappableBuffer> data,
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::shared_ptr<ShmBuffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage);
+
     auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
     auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override;
     auto stride() const -> geometry::Stride override;
     auto size() const -> geometry::Size override;
 
     MappableBackedShmBuffer(MappableBackedShmBuffer const&) = delete;
     MappableBackedShmBuffer& operator=(MappableBackedShmBuffer const&) = delete;
+protected:
+    auto map_for_upload() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
 private:
     std::shared_ptr<renderer::software::RWMappableBuffer> const data;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class NotifyingMappableBackedShmBuffer : public MappableBackedShmBuffer
@@ -145,6 +186,15 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release);
 
+    /// \see ShmBuffer::ShmBuffer for the meaning of \a previous and \a damage
+    NotifyingMappableBackedShmBuffer(
+        std::shared_ptr<renderer::software::RWMappableBuffer> data,
+        std::shared_ptr<common::EGLContextExecutor> egl_delegate,
+        std::shared_ptr<ShmBuffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release);
+
     ~NotifyingMappableBackedShmBuffer() override;
 
     void bind() override;
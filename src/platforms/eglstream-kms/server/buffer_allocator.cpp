@@ -537,12 +537,16 @@ mir::graphics::eglstream::BufferAllocator::buffer_from_resource(
 
 auto mge::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geometry::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
+        std::dynamic_pointer_cast<mgc::ShmBuffer>(previous),
+        damage,
         std::move(on_consumed),
         std::move(on_release));
 }
@@ -676,6 +680,12 @@ public:
         return size_;
     }
 
+    auto buffer_age() const -> unsigned override
+    {
+        // The stream consumer owns the buffers; we can't know what they contain
+        return 0;
+    }
+
     auto layout() const -> Layout override
     {
         return Layout::GL;
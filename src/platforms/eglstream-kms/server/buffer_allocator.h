@@ -69,6 +69,8 @@ public:
 
     auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> shm_data,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
 
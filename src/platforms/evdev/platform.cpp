@@ -135,6 +135,7 @@ mie::Platform::Platform(
     console{console},
     platform_dispatchable{std::make_shared<md::MultiplexingDispatchable>()}
 {
+    platform_dispatchable->set_max_events_per_dispatch(md::MultiplexingDispatchable::max_batch_size);
 }
 
 std::shared_ptr<mir::dispatch::Dispatchable> mie::Platform::dispatchable()
@@ -365,9 +366,11 @@ void mie::Platform::start()
             }
         });
 
-    platform_dispatchable->add_watch(udev_dispatchable);
-    platform_dispatchable->add_watch(libinput_dispatchable);
-    platform_dispatchable->add_watch(action_queue);
+    // The platform is only dispatched from the input thread, so there is no concurrent dispatch for
+    // one-shot monitoring to prevent, and it would cost a syscall to re-arm after each event
+    platform_dispatchable->add_watch(udev_dispatchable, md::DispatchReentrancy::reentrant);
+    platform_dispatchable->add_watch(libinput_dispatchable, md::DispatchReentrancy::reentrant);
+    platform_dispatchable->add_watch(action_queue, md::DispatchReentrancy::reentrant);
     process_input_events();
 }
 
@@ -38,6 +38,7 @@
 #include "mir/graphics/egl_error.h"
 #include "cpu_copy_output_surface.h"
 #include "surfaceless_egl_context.h"
+#include "kms_framebuffer.h"
 
 #include <boost/throw_exception.hpp>
 #include <boost/exception/errinfo_errno.hpp>
@@ -46,12 +47,15 @@
 #include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <gbm.h>
 
+#include <map>
 #include <optional>
 #include <stdexcept>
 #include <cassert>
 #include <fcntl.h>
 #include <xf86drm.h>
+#include <xf86drmMode.h>
 #include <drm_fourcc.h>
 
 #define MIR_LOG_COMPONENT "gbm-kms-buffer-allocator"
@@ -221,12 +225,16 @@ std::shared_ptr<mg::Buffer> mgg::BufferAllocator::buffer_from_resource(
 
 auto mgg::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geometry::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
+        std::dynamic_pointer_cast<mgc::ShmBuffer>(previous),
+        damage,
         std::move(on_consumed),
         std::move(on_release));
 }
@@ -319,6 +327,16 @@ public:
         return geom::Size{width, height};
     }
 
+    auto buffer_age() const -> unsigned override
+    {
+        EGLint age;
+        if (!supports_buffer_age || eglQuerySurface(dpy, egl_surf, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        {
+            return 0;
+        }
+        return static_cast<unsigned>(age);
+    }
+
     auto layout() const -> Layout override
     {
         return Layout::GL;
@@ -462,7 +480,8 @@ private:
         : surface{std::move(std::get<0>(renderables))},
           egl_surf{std::get<2>(renderables)},
           dpy{dpy},
-          ctx{std::get<1>(renderables)}
+          ctx{std::get<1>(renderables)},
+          supports_buffer_age{mg::has_egl_extension(dpy, "EGL_EXT_buffer_age")}
     {
     }
 
@@ -470,6 +489,7 @@ private:
     EGLSurface const egl_surf;
     EGLDisplay const dpy;
     EGLContext const ctx;
+    bool const supports_buffer_age;
 };
 }
 
@@ -537,10 +557,162 @@ auto mgg::GLRenderingProvider::surface_for_sink(
         config);
 }
 
-auto mgg::GLRenderingProvider::make_framebuffer_provider(DisplaySink& /*sink*/)
+namespace
+{
+/// A client's dma-buf, imported to scan out directly
+class DMABufFramebuffer : public mg::FBHandle
+{
+public:
+    static auto create_if_scanout_capable(
+        int drm_fd,
+        gbm_device* gbm,
+        std::shared_ptr<mg::Buffer> buffer,
+        mg::DMABufBuffer const& dmabuf) -> std::unique_ptr<DMABufFramebuffer>
+    {
+        // Scanout can't flip the image for us
+        if (dmabuf.layout() != mg::gl::Texture::Layout::TopRowFirst || dmabuf.planes().size() > 4)
+        {
+            return nullptr;
+        }
+
+        gbm_import_fd_modifier_data import_data{};
+        import_data.width = dmabuf.size().width.as_uint32_t();
+        import_data.height = dmabuf.size().height.as_uint32_t();
+        import_data.format = dmabuf.format();
+        import_data.num_fds = dmabuf.planes().size();
+        import_data.modifier = dmabuf.modifier().value_or(DRM_FORMAT_MOD_INVALID);
+        for (auto i = 0u; i != dmabuf.planes().size(); ++i)
+        {
+            import_data.fds[i] = dmabuf.planes()[i].dma_buf;
+            import_data.strides[i] = dmabuf.planes()[i].stride;
+            import_data.offsets[i] = dmabuf.planes()[i].offset;
+        }
+
+        std::unique_ptr<gbm_bo, void(*)(gbm_bo*)> bo{
+            gbm_bo_import(gbm, GBM_BO_IMPORT_FD_MODIFIER, &import_data, GBM_BO_USE_SCANOUT),
+            &gbm_bo_destroy};
+        if (!bo)
+        {
+            return nullptr;
+        }
+
+        uint32_t handles[4] = {0, 0, 0, 0};
+        uint32_t strides[4] = {0, 0, 0, 0};
+        uint32_t offsets[4] = {0, 0, 0, 0};
+        uint64_t modifiers[4] = {0, 0, 0, 0};
+        for (auto i = 0u; i != dmabuf.planes().size(); ++i)
+        {
+            handles[i] = gbm_bo_get_handle_for_plane(bo.get(), i).u32;
+            strides[i] = import_data.strides[i];
+            offsets[i] = import_data.offsets[i];
+            modifiers[i] = import_data.modifier;
+        }
+
+        auto const explicit_modifier = import_data.modifier != DRM_FORMAT_MOD_INVALID;
+        uint32_t fb_id{0};
+        if (drmModeAddFB2WithModifiers(
+                drm_fd,
+                import_data.width, import_data.height, import_data.format,
+                handles, strides, offsets,
+                explicit_modifier ? modifiers : nullptr,
+                &fb_id,
+                explicit_modifier ? DRM_MODE_FB_MODIFIERS : 0))
+        {
+            return nullptr;
+        }
+
+        return std::unique_ptr<DMABufFramebuffer>{
+            new DMABufFramebuffer{drm_fd, std::move(bo), fb_id, std::move(buffer), dmabuf}};
+    }
+
+    ~DMABufFramebuffer()
+    {
+        drmModeRmFB(drm_fd, fb_id);
+    }
+
+    operator uint32_t() const override
+    {
+        return fb_id;
+    }
+
+    auto drm_format() const -> mg::DRMFormat override
+    {
+        return format;
+    }
+
+    auto modifier() const -> std::optional<uint64_t> override
+    {
+        return modifier_;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+private:
+    DMABufFramebuffer(
+        int drm_fd,
+        std::unique_ptr<gbm_bo, void(*)(gbm_bo*)> bo,
+        uint32_t fb_id,
+        std::shared_ptr<mg::Buffer> buffer,
+        mg::DMABufBuffer const& dmabuf)
+        : drm_fd{drm_fd},
+          bo{std::move(bo)},
+          fb_id{fb_id},
+          buffer{std::move(buffer)},
+          format{dmabuf.format()},
+          modifier_{dmabuf.modifier()},
+          size_{dmabuf.size()}
+    {
+    }
+
+    int const drm_fd;
+    std::unique_ptr<gbm_bo, void(*)(gbm_bo*)> const bo;
+    uint32_t const fb_id;
+    std::shared_ptr<mg::Buffer> const buffer;   ///< KMS doesn't keep the client's buffer alive; we must
+    mg::DRMFormat const format;
+    std::optional<uint64_t> const modifier_;
+    geom::Size const size_;
+};
+
+/// A handle on a DMABufFramebuffer that may also be showing the same buffer in other frames
+class SharedDMABufFramebuffer : public mg::FBHandle
+{
+public:
+    explicit SharedDMABufFramebuffer(std::shared_ptr<DMABufFramebuffer const> fb)
+        : fb{std::move(fb)}
+    {
+    }
+
+    operator uint32_t() const override
+    {
+        return *fb;
+    }
+
+    auto drm_format() const -> mg::DRMFormat override
+    {
+        return fb->drm_format();
+    }
+
+    auto modifier() const -> std::optional<uint64_t> override
+    {
+        return fb->modifier();
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return fb->size();
+    }
+
+private:
+    std::shared_ptr<DMABufFramebuffer const> const fb;
+};
+}
+
+auto mgg::GLRenderingProvider::make_framebuffer_provider(DisplaySink& sink)
     -> std::unique_ptr<FramebufferProvider>
 {
-    // TODO: Make this not a null implementation, so bypass/overlays can work again
     class NullFramebufferProvider : public FramebufferProvider
     {
     public:
@@ -551,7 +723,68 @@ auto mgg::GLRenderingProvider::make_framebuffer_provider(DisplaySink& /*sink*/)
             return {};
         }
     };
-    return std::make_unique<NullFramebufferProvider>();
+
+    /* We can only scan out client buffers on the device they were allocated on;
+     * only try if that's the device driving this sink.
+     */
+    if (!bound_display || !bound_display->on_this_sink(sink))
+    {
+        return std::make_unique<NullFramebufferProvider>();
+    }
+
+    class DMABufFramebufferProvider : public FramebufferProvider
+    {
+    public:
+        DMABufFramebufferProvider(
+            std::shared_ptr<struct gbm_device> gbm,
+            std::shared_ptr<DMABufEGLProvider> dmabuf_provider)
+            : gbm{std::move(gbm)},
+              drm_fd{gbm_device_get_fd(this->gbm.get())},
+              dmabuf_provider{std::move(dmabuf_provider)}
+        {
+        }
+
+        auto buffer_to_framebuffer(std::shared_ptr<Buffer> buffer) -> std::unique_ptr<Framebuffer> override
+        {
+            auto const dmabuf = dynamic_cast<DMABufBuffer const*>(buffer->native_buffer_base());
+            if (!dmabuf)
+            {
+                return {};
+            }
+
+            // Forget framebuffers nothing is showing any more
+            std::erase_if(framebuffers, [](auto const& entry) { return entry.second.expired(); });
+
+            /* Importing and adding a framebuffer each involve the kernel; a buffer shown for
+             * several frames (which is most of them) reuses the framebuffer still on the display.
+             */
+            auto fb = framebuffers[buffer->id()].lock();
+            if (!fb)
+            {
+                fb = DMABufFramebuffer::create_if_scanout_capable(drm_fd, gbm.get(), buffer, *dmabuf);
+                if (!fb)
+                {
+                    framebuffers.erase(buffer->id());
+                    return {};
+                }
+                framebuffers[buffer->id()] = fb;
+            }
+
+            /* We're being naughty here and using the fact that `as_texture()` has a side-effect
+             * of invoking the buffer's `on_consumed()` callback; the client needs its frame event.
+             */
+            dmabuf_provider->as_texture(std::move(buffer));
+            return std::make_unique<SharedDMABufFramebuffer>(std::move(fb));
+        }
+
+    private:
+        std::shared_ptr<struct gbm_device> const gbm;
+        int const drm_fd;
+        std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
+        /// The framebuffers we have handed out, which live (holding their buffer) while they're in use
+        std::map<BufferID, std::weak_ptr<DMABufFramebuffer const>> framebuffers;
+    };
+    return std::make_unique<DMABufFramebufferProvider>(bound_display->gbm_device(), dmabuf_provider);
 }
 
 mgg::GLRenderingProvider::GLRenderingProvider(
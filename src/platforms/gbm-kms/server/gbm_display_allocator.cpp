@@ -93,6 +93,17 @@ public:
         return *fb_id;
     }
 
+    auto drm_format() const -> mg::DRMFormat override
+    {
+        return mg::DRMFormat{gbm_bo_get_format(bo.get())};
+    }
+
+    auto modifier() const -> std::optional<uint64_t> override
+    {
+        // We add the framebuffer without explicit modifiers
+        return std::nullopt;
+    }
+
     auto size() const -> geom::Size override
     {
         return
@@ -0,0 +1,116 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_request.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <xf86drm.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+
+namespace mgg = mir::graphics::gbm;
+namespace mgk = mir::graphics::kms;
+
+mgg::AtomicRequest::AtomicRequest()
+    : request{drmModeAtomicAlloc(), &drmModeAtomicFree}
+{
+    if (!request)
+    {
+        BOOST_THROW_EXCEPTION(std::bad_alloc{});
+    }
+}
+
+void mgg::AtomicRequest::add_property(
+    uint32_t object_id,
+    mgk::ObjectProperties const& props,
+    char const* property,
+    uint64_t value)
+{
+    auto const result = drmModeAtomicAddProperty(request.get(), object_id, props.id_for(property), value);
+    if (result < 0)
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{-result, std::system_category(), "Failed to add property to atomic request"}));
+    }
+}
+
+void mgg::AtomicRequest::add_target(uint32_t crtc_id, uint32_t connector_id)
+{
+    targets_.push_back(Target{crtc_id, connector_id});
+}
+
+auto mgg::AtomicRequest::targets() const -> std::vector<Target> const&
+{
+    return targets_;
+}
+
+auto mgg::AtomicRequest::get() const -> drmModeAtomicReq*
+{
+    return request.get();
+}
+
+mgg::PropertyBlob::PropertyBlob(int drm_fd, void const* data, size_t size)
+    : drm_fd{drm_fd}
+{
+    if (auto const result = drmModeCreatePropertyBlob(drm_fd, data, size, &id_))
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{-result, std::system_category(), "Failed to create DRM property blob"}));
+    }
+}
+
+mgg::PropertyBlob::~PropertyBlob()
+{
+    drmModeDestroyPropertyBlob(drm_fd, id_);
+}
+
+auto mgg::PropertyBlob::id() const -> uint32_t
+{
+    return id_;
+}
+
+auto mgg::enable_atomic_modesetting(int drm_fd) -> bool
+{
+    if (getenv("MIR_GBM_KMS_DISABLE_ATOMIC") != nullptr)
+    {
+        mir::log_info("MIR_GBM_KMS_DISABLE_ATOMIC is set; using legacy modesetting");
+        return false;
+    }
+
+    /* A single commit can flip several CRTCs, each of which sends its own event;
+     * we need the kernel to tell us which CRTC each event is for.
+     */
+    uint64_t crtc_in_event{0};
+    if (drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, &crtc_in_event) || !crtc_in_event)
+    {
+        mir::log_debug("Kernel does not report the CRTC of vblank events; using legacy modesetting");
+        return false;
+    }
+
+    if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+    {
+        mir::log_debug("Driver does not support atomic modesetting (%s); using legacy modesetting", strerror(errno));
+        return false;
+    }
+
+    mir::log_info("Using atomic modesetting");
+    return true;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_ATOMIC_REQUEST_H_
+#define MIR_GRAPHICS_GBM_ATOMIC_REQUEST_H_
+
+#include "kms-utils/drm_mode_resources.h"
+
+#include <xf86drmMode.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+/**
+ * The property changes making up a single atomic KMS commit
+ *
+ * A request may span several CRTCs (for example, a group of cloned outputs); it keeps track
+ * of them so that a page flip can be waited for on each.
+ */
+class AtomicRequest
+{
+public:
+    /// A CRTC updated by the request, and the connector it drives
+    struct Target
+    {
+        uint32_t crtc_id;
+        uint32_t connector_id;
+    };
+
+    AtomicRequest();
+
+    /**
+     * Set \p property of the KMS object \p object_id to \p value
+     *
+     * \param [in] props    The properties of \p object_id
+     * \throws std::out_of_range if the object has no such property
+     */
+    void add_property(
+        uint32_t object_id,
+        kms::ObjectProperties const& props,
+        char const* property,
+        uint64_t value);
+
+    /// Note that the request updates the CRTC \p crtc_id, which drives \p connector_id
+    void add_target(uint32_t crtc_id, uint32_t connector_id);
+    auto targets() const -> std::vector<Target> const&;
+
+    auto get() const -> drmModeAtomicReq*;
+
+private:
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)> const request;
+    std::vector<Target> targets_;
+};
+
+/// A KMS property blob (such as a mode or gamma LUT), destroyed along with this
+class PropertyBlob
+{
+public:
+    /// \throws std::system_error if the kernel rejects the blob
+    PropertyBlob(int drm_fd, void const* data, size_t size);
+    ~PropertyBlob();
+
+    PropertyBlob(PropertyBlob const&) = delete;
+    PropertyBlob& operator=(PropertyBlob const&) = delete;
+
+    auto id() const -> uint32_t;
+
+private:
+    int const drm_fd;
+    uint32_t id_;
+};
+
+/**
+ * Try to switch \p drm_fd to atomic modesetting
+ *
+ * This fails if the kernel or driver lacks support, or if the MIR_GBM_KMS_DISABLE_ATOMIC
+ * environment variable is set; legacy modesetting calls continue to work either way.
+ *
+ * \returns true if atomic commits can be used on \p drm_fd
+ */
+auto enable_atomic_modesetting(int drm_fd) -> bool;
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_ATOMIC_REQUEST_H_ */
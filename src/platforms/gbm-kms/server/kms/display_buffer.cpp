@@ -17,6 +17,8 @@
 #include "display_sink.h"
 #include "kms_cpu_addressable_display_provider.h"
 #include "kms_output.h"
+#include "atomic_request.h"
+#include "plane_assignment.h"
 #include "cpu_addressable_fb.h"
 #include "gbm_display_allocator.h"
 #include "mir/fd.h"
@@ -48,6 +50,19 @@ namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
 namespace geom = mir::geometry;
 
+namespace
+{
+auto plane_ids_of(std::vector<mgg::OverlayPlane> const& overlays) -> std::vector<uint32_t>
+{
+    std::vector<uint32_t> ids;
+    for (auto const& overlay : overlays)
+    {
+        ids.push_back(overlay.plane_id);
+    }
+    return ids;
+}
+}
+
 mgg::DisplaySink::DisplaySink(
     mir::Fd drm_fd,
     std::shared_ptr<struct gbm_device> gbm,
@@ -59,6 +74,10 @@ mgg::DisplaySink::DisplaySink(
     : gbm{std::move(gbm)},
       listener(listener),
       outputs(outputs),
+      use_atomic{std::all_of(
+          outputs.begin(),
+          outputs.end(),
+          [](auto const& output) { return output->supports_atomic(); })},
       area(area),
       transform{transformation},
       needs_set_crtc{false},
@@ -118,6 +137,16 @@ void mgg::DisplaySink::set_transformation(glm::mat2 const& t, geometry::Rectangl
 
 bool mgg::DisplaySink::overlay(std::vector<DisplayElement> const& renderable_list)
 {
+    /* With a single output we know which planes are available, and can check
+     * that the hardware can show the buffers; planes can't be shared between
+     * CRTCs, though, and (without atomic modesetting) we can't ask whether they
+     * can rotate.
+     */
+    if (outputs.size() == 1 && transform == glm::mat2{1})
+    {
+        return overlay_on_planes(renderable_list);
+    }
+
     // TODO: implement more than the most basic case.
     if (renderable_list.size() != 1)
     {
@@ -139,18 +168,114 @@ bool mgg::DisplaySink::overlay(std::vector<DisplayElement> const& renderable_lis
     if (auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(renderable_list[0].buffer))
     {
         next_swap = std::move(fb);
+        next_overlays.clear();
         return true;
     }
     return false;
 }
 
+bool mgg::DisplaySink::overlay_on_planes(std::vector<DisplayElement> const& renderable_list)
+{
+    if (renderable_list.empty())
+    {
+        return false;
+    }
+
+    auto primary = std::dynamic_pointer_cast<graphics::FBHandle>(renderable_list.front().buffer);
+    if (!primary)
+    {
+        return false;
+    }
+
+    auto overlays = overlays_for(renderable_list, *primary);
+    if (!overlays)
+    {
+        return false;
+    }
+
+    next_swap = std::move(primary);
+    next_overlays = std::move(*overlays);
+    return true;
+}
+
+bool mgg::DisplaySink::can_overlay(std::vector<DisplayElement> const& renderable_list)
+{
+    if (outputs.size() != 1 || transform != glm::mat2{1} || renderable_list.empty())
+    {
+        return false;
+    }
+
+    /* The frame the caller would render isn't drawn yet; check with the last one we showed,
+     * which was allocated for us in the same way. Without one there's nothing to check with,
+     * so leave it to overlay().
+     */
+    auto const stand_in = scheduled_fb ? scheduled_fb : visible_fb;
+    if (!stand_in)
+    {
+        return renderable_list.size() == 1 || !overlay_planes_failed;
+    }
+
+    auto with_stand_in = renderable_list;
+    with_stand_in.front().buffer = std::const_pointer_cast<FBHandle>(stand_in);
+    return overlays_for(with_stand_in, *stand_in).has_value();
+}
+
+auto mgg::DisplaySink::overlays_for(
+    std::vector<DisplayElement> const& renderable_list,
+    FBHandle const& primary) -> std::optional<std::vector<OverlayPlane>>
+{
+    if (renderable_list.size() > 1 && overlay_planes_failed)
+    {
+        return std::nullopt;
+    }
+
+    auto const& planes = outputs.front()->planes();
+    // Only with atomic modesetting can we ask the hardware whether it can scale
+    auto const assignment = assign_planes(renderable_list, planes, view_area(), use_atomic);
+    if (!assignment)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<OverlayPlane> overlays;
+    for (auto i = 1u; i != renderable_list.size(); ++i)
+    {
+        auto const& element = renderable_list[i];
+        overlays.push_back(
+            OverlayPlane{
+                (*assignment)[i]->id,
+                std::dynamic_pointer_cast<graphics::FBHandle>(element.buffer),
+                geom::Rectangle{
+                    element.screen_positon.top_left - as_displacement(view_area().top_left),
+                    element.screen_positon.size},
+                element.source_position});
+    }
+
+    /* Bandwidth, scaler and other limits aren't advertised; the only way to know whether
+     * the hardware can show this is to ask.
+     */
+    if (use_atomic && !commit_atomic(primary, overlays, DRM_MODE_ATOMIC_TEST_ONLY))
+    {
+        return std::nullopt;
+    }
+
+    return overlays;
+}
+
 void mgg::DisplaySink::for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f)
 {
     f(*this);
 }
 
-void mgg::DisplaySink::set_crtc(FBHandle const& forced_frame)
+void mgg::DisplaySink::set_crtc(FBHandle const& forced_frame, std::vector<OverlayPlane> const& overlays)
 {
+    if (commit_atomic(forced_frame, overlays, DRM_MODE_ATOMIC_ALLOW_MODESET))
+    {
+        // The overlay planes were updated in the same commit
+        active_overlay_planes = plane_ids_of(overlays);
+        return;
+    }
+
     for (auto& output : outputs)
     {
         /*
@@ -165,10 +290,37 @@ void mgg::DisplaySink::set_crtc(FBHandle const& forced_frame)
                 "Screen contents may be incomplete. "
                 "Try plugging the monitor in again.");
     }
+    update_overlay_planes(overlays);
+}
+
+bool mgg::DisplaySink::commit_atomic(
+    FBHandle const& fb,
+    std::vector<OverlayPlane> const& overlays,
+    uint32_t flags)
+{
+    if (!use_atomic)
+    {
+        return false;
+    }
+
+    // One request for all our outputs, so that clones update on the same vblank
+    AtomicRequest request;
+    bool const modeset = flags & DRM_MODE_ATOMIC_ALLOW_MODESET;
+    for (auto& output : outputs)
+    {
+        if (!output->add_to_request(request, fb, overlays, modeset))
+        {
+            return false;
+        }
+    }
+    return outputs.front()->commit(request, flags);
 }
 
 void mgg::DisplaySink::post()
 {
+    auto const post_start = mir::time::PosixTimestamp::now(
+        expected_wake ? expected_wake->clock_id : last_flip.ust.clock_id);
+
     /*
      * We might not have waited for the previous frame to page flip yet.
      * This is good because it maximizes the time available to spend rendering
@@ -176,6 +328,7 @@ void mgg::DisplaySink::post()
      * point before the next schedule_page_flip().
      */
     wait_for_page_flip();
+    auto const previous_flip = last_flip;
 
     if (!next_swap)
     {
@@ -188,12 +341,14 @@ void mgg::DisplaySink::post()
      */
     scheduled_fb = std::move(next_swap);
     next_swap = nullptr;
+    scheduled_overlays = std::move(next_overlays);
+    next_overlays.clear();
 
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
      * [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb))
+    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb, scheduled_overlays))
         needs_set_crtc = true;
 
     /*
@@ -202,18 +357,20 @@ void mgg::DisplaySink::post()
      */
     if (needs_set_crtc)
     {
-        set_crtc(*scheduled_fb);
+        set_crtc(*scheduled_fb, scheduled_overlays);
         // SetCrtc is immediate, so the FB is now visible and we have nothing pending
         visible_fb = std::move(scheduled_fb);
         scheduled_fb = nullptr;
+        visible_overlays = std::move(scheduled_overlays);
+        scheduled_overlays.clear();
 
         needs_set_crtc = false;
     }
 
     using namespace std::chrono_literals;  // For operator""ms()
 
-    // Predicted worst case render time for the next frame...
-    auto predicted_render_time = 50ms;
+    // Worst case render time for the next frame, until we've measured some...
+    std::chrono::nanoseconds fallback_render_time = 50ms;
 
     if (holding_client_buffers)
     {
@@ -230,7 +387,7 @@ void mgg::DisplaySink::post()
 
         // It's very likely the next frame will be bypassed like this one so
         // we only need time for kernel page flip scheduling...
-        predicted_render_time = 5ms;
+        fallback_render_time = 5ms;
     }
     else
     {
@@ -241,24 +398,82 @@ void mgg::DisplaySink::post()
          */
         if (outputs.size() == 1)
             wait_for_page_flip();
-
-        /*
-         * TODO: If you're optimistic about your GPU performance and/or
-         *       measure it carefully you may wish to set predicted_render_time
-         *       to a lower value here for lower latency.
-         *
-         *predicted_render_time = 9ms; // e.g. about the same as Weston
-         */
     }
 
     recommend_sleep = 0ms;
-    if (outputs.size() == 1)
+    if (outputs.size() != 1)
+    {
+        // Our outputs flip independently, so there's no one vblank to aim for
+        expected_wake.reset();
+        return;
+    }
+
+    auto const& output = outputs.front();
+    auto const frame_interval = output->frame_interval();
+    bool const flipped = last_flip.msc != previous_flip.msc;
+
+    /*
+     * If the compositor went straight from sleeping to this frame, we know how long it took.
+     * (Otherwise it was idle for a while, and we don't.)
+     */
+    if (expected_wake && post_start - *expected_wake < frame_interval)
+    {
+        if (flipped && previous_flip.msc && last_flip.msc > previous_flip.msc + 1)
+        {
+            // We missed the vblank we aimed for; however long it took, it was too long
+            render_time.record(frame_interval);
+        }
+        else
+        {
+            render_time.record(std::max(post_start - *expected_wake, std::chrono::nanoseconds::zero()));
+        }
+    }
+
+    auto const predicted_render_time = render_time.estimate().value_or(fallback_render_time);
+    auto const now = mir::time::PosixTimestamp::now(last_flip.ust.clock_id);
+
+    // Wake the compositor just in time to finish the next frame before the following vblank
+    auto const next_vblank = (flipped ? last_flip.ust : now) + frame_interval;
+    auto const wake = next_vblank - predicted_render_time;
+    if (wake > now)
+    {
+        // Round down: better to wake a little early than to miss the vblank
+        recommend_sleep = std::chrono::duration_cast<std::chrono::milliseconds>(wake - now);
+    }
+    expected_wake = now + recommend_sleep;
+}
+
+void mgg::DisplaySink::update_overlay_planes(std::vector<OverlayPlane> const& overlays)
+{
+    if (overlays.empty() && active_overlay_planes.empty())
     {
-        auto const& output = outputs.front();
-        auto const min_frame_interval = 1000ms / output->max_refresh_rate();
-        if (predicted_render_time < min_frame_interval)
-            recommend_sleep = min_frame_interval - predicted_render_time;
+        return;
     }
+
+    auto const& output = outputs.front();
+    std::vector<uint32_t> now_active;
+    for (auto const& overlay : overlays)
+    {
+        if (!output->set_plane(overlay.plane_id, *overlay.fb, overlay.dest, overlay.source))
+        {
+            /* We've already committed to a primary plane without this element, so this frame
+             * will be missing it. Don't risk that again.
+             */
+            mir::log_warning("Failed to set overlay plane; disabling multi-plane composition on this output");
+            overlay_planes_failed = true;
+            continue;
+        }
+        now_active.push_back(overlay.plane_id);
+    }
+
+    for (auto const plane_id : active_overlay_planes)
+    {
+        if (std::find(now_active.begin(), now_active.end(), plane_id) == now_active.end())
+        {
+            output->clear_plane(plane_id);
+        }
+    }
+    active_overlay_planes = std::move(now_active);
 }
 
 std::chrono::milliseconds mgg::DisplaySink::recommended_sleep() const
@@ -266,18 +481,35 @@ std::chrono::milliseconds mgg::DisplaySink::recommended_sleep() const
     return recommend_sleep;
 }
 
-bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj)
+bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj, std::vector<OverlayPlane> const& overlays)
 {
     /*
      * Schedule the current front buffer object for display. Note that
      * the page flip is asynchronous and synchronized with vertical refresh.
      */
+    if (commit_atomic(bufobj, overlays, 0))
+    {
+        // The commit disabled any overlay planes it didn't use
+        active_overlay_planes = plane_ids_of(overlays);
+        page_flips_pending = true;
+        return true;
+    }
+
     for (auto& output : outputs)
     {
         if (output->schedule_page_flip(bufobj))
             page_flips_pending = true;
     }
 
+    if (page_flips_pending)
+    {
+        /*
+         * Legacy plane updates aren't tied to the page flip; they usually land on the
+         * same vblank, but may be a frame early or late.
+         */
+        update_overlay_planes(overlays);
+    }
+
     return page_flips_pending;
 }
 
@@ -286,11 +518,16 @@ void mgg::DisplaySink::wait_for_page_flip()
     if (page_flips_pending)
     {
         for (auto& output : outputs)
-            output->wait_for_page_flip();
+        {
+            if (auto const frame = output->wait_for_page_flip(); frame.msc)
+                last_flip = frame;
+        }
 
         // The previously-scheduled FB has been page-flipped, and is now visible
         visible_fb = std::move(scheduled_fb);
         scheduled_fb = nullptr;
+        visible_overlays = std::move(scheduled_overlays);
+        scheduled_overlays.clear();
 
         page_flips_pending = false;
     }
@@ -313,20 +550,17 @@ auto mgg::DisplaySink::gbm_device() const -> std::shared_ptr<struct gbm_device>
 
 void mir::graphics::gbm::DisplaySink::set_next_image(std::unique_ptr<Framebuffer> content)
 {
-    std::vector<DisplayElement> const single_buffer = {
-        DisplayElement {
-            view_area(),
-            geom::RectangleF{
-                {0, 0},
-                {view_area().size.width.as_value(), view_area().size.height.as_value()}},
-            std::move(content)
-        }
-    };
-    if (!overlay(single_buffer))
+    /* This is what we've rendered for this output, in a format we picked for it;
+     * it doesn't need overlay()'s checks.
+     */
+    if (auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(std::shared_ptr<Framebuffer>{std::move(content)}))
     {
-        // Oh, oh! We should be *guaranteed* to “overlay” a single Framebuffer; this is likely a programming error
-        BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to post buffer to display"}));
+        next_swap = std::move(fb);
+        next_overlays.clear();
+        return;
     }
+    // Oh, oh! We should be *guaranteed* to be able to display a Framebuffer we allocated; this is likely a programming error
+    BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to post buffer to display"}));
 }
 
 auto mgg::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_tag)
@@ -24,10 +24,14 @@
 #include "mir/graphics/platform.h"
 #include "platform_common.h"
 #include "kms_framebuffer.h"
+#include "kms_output.h"
+#include "render_time_estimator.h"
+#include "mir/time/posix_timestamp.h"
 
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <optional>
 
 namespace mir
 {
@@ -41,10 +45,10 @@ namespace gbm
 {
 
 class Platform;
-class KMSOutput;
 
 class DisplaySink : public graphics::DisplaySink,
-                      public graphics::DisplaySyncGroup
+                      public graphics::DisplaySyncGroup,
+                      public graphics::OverlayQuery
 {
 public:
     DisplaySink(
@@ -62,6 +66,7 @@ public:
     void set_next_image(std::unique_ptr<Framebuffer> content) override;
 
     bool overlay(std::vector<DisplayElement> const& renderlist) override;
+    bool can_overlay(std::vector<DisplayElement> const& renderlist) override;
 
     void for_each_display_sink(
         std::function<void(graphics::DisplaySink&)> const& f) override;
@@ -82,8 +87,27 @@ protected:
     auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
 
 private:
-    bool schedule_page_flip(FBHandle const& bufobj);
-    void set_crtc(FBHandle const&);
+    bool schedule_page_flip(FBHandle const& bufobj, std::vector<OverlayPlane> const& overlays);
+    void set_crtc(FBHandle const&, std::vector<OverlayPlane> const& overlays);
+    bool overlay_on_planes(std::vector<DisplayElement> const& renderlist);
+    /**
+     * Place \p renderlist on our planes, with its bottom element's buffer as \p primary
+     *
+     * \returns The overlay planes to show above \p primary, or std::nullopt if the hardware can't show them
+     */
+    auto overlays_for(
+        std::vector<DisplayElement> const& renderlist,
+        FBHandle const& primary) -> std::optional<std::vector<OverlayPlane>>;
+
+    /**
+     * Commit \p fb and \p overlays to all our outputs in a single atomic request
+     *
+     * \param [in] flags    As for KMSOutput::commit()
+     * \returns false if the commit failed, or atomic modesetting can't be used
+     */
+    bool commit_atomic(FBHandle const& fb, std::vector<OverlayPlane> const& overlays, uint32_t flags);
+    /// Show \p overlays on their planes with legacy calls, and clear any others we had used
+    void update_overlay_planes(std::vector<OverlayPlane> const& overlays);
 
     std::shared_ptr<struct gbm_device> const gbm;
     bool holding_client_buffers{false};
@@ -101,11 +125,24 @@ private:
     std::shared_ptr<FBHandle const> next_swap{nullptr};    //< Next frame to submit to the hardware
     std::shared_ptr<FBHandle const> scheduled_fb{nullptr}; //< Frame currently submitted to the hardware, not yet on-screen
     std::shared_ptr<FBHandle const> visible_fb{nullptr};   //< Frame currently onscreen
+    // ...and the same for the overlay planes accompanying each frame
+    std::vector<OverlayPlane> next_overlays;
+    std::vector<OverlayPlane> scheduled_overlays;
+    std::vector<OverlayPlane> visible_overlays;
+    std::vector<uint32_t> active_overlay_planes;    //< Planes we have last set a framebuffer on
+    bool overlay_planes_failed{false};
+    /// Whether all our outputs are driven with atomic modesetting, so frames can be committed atomically
+    bool const use_atomic;
 
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
+    /// How long the compositor recently took from waking to post(), to decide when to wake it next
+    RenderTimeEstimator render_time;
+    /// When we expect the compositor to start on its next frame, if it goes straight on to one
+    std::optional<mir::time::PosixTimestamp> expected_wake;
+    Frame last_flip;    ///< The vblank our most recent page flip landed on
     bool page_flips_pending;
 };
 
@@ -25,9 +25,14 @@
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir_toolkit/common.h"
 #include "kms-utils/drm_mode_resources.h"
+#include "plane_assignment.h"
 
 #include <gbm.h>
 
+#include <chrono>
+#include <memory>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -37,6 +42,16 @@ class FBHandle;
 
 namespace gbm
 {
+class AtomicRequest;
+
+/// A framebuffer shown on an overlay plane, above the primary
+struct OverlayPlane
+{
+    uint32_t plane_id;
+    std::shared_ptr<FBHandle const> fb;
+    geometry::Rectangle dest;       ///< Output-relative
+    geometry::RectangleF source;
+};
 
 class KMSOutput
 {
@@ -61,6 +76,15 @@ public:
      */
     virtual int max_refresh_rate() const = 0;
 
+    /**
+     * The time from one vblank to the next in the current mode
+     *
+     * This is calculated from the mode's pixel clock, so (unlike max_refresh_rate())
+     * isn't rounded to a whole number of Hz; on a 59.94Hz mode the difference adds up
+     * to a frame every 17 seconds.
+     */
+    virtual auto frame_interval() const -> std::chrono::nanoseconds = 0;
+
     virtual bool set_crtc(FBHandle const& fb) = 0;
 
     /**
@@ -70,7 +94,62 @@ public:
     virtual bool has_crtc_mismatch() = 0;
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
-    virtual void wait_for_page_flip() = 0;
+    /**
+     * Wait for the scheduled page flip to complete
+     *
+     * \returns    The vblank the flip landed on, or a default-constructed Frame (with msc 0)
+     *              if there was nothing to wait for
+     */
+    virtual auto wait_for_page_flip() -> Frame = 0;
+
+    /**
+     * The planes usable with this output's current CRTC, in stacking order (bottom first)
+     *
+     * \note   The primary plane is driven by set_crtc() and schedule_page_flip(), not set_plane().
+     */
+    virtual auto planes() -> std::vector<PlaneInfo> const& = 0;
+    /**
+     * Show (part of) a framebuffer on an overlay plane, until it is cleared or replaced
+     *
+     * \param [in] dest     The area of the output to cover, in output-relative coordinates
+     * \param [in] source   The region of the framebuffer to show
+     * \returns             false if the hardware rejected the configuration
+     */
+    virtual bool set_plane(
+        uint32_t plane_id,
+        FBHandle const& fb,
+        geometry::Rectangle const& dest,
+        geometry::RectangleF const& source) = 0;
+    virtual void clear_plane(uint32_t plane_id) = 0;
+
+    /**
+     * Whether this output is driven with atomic modesetting
+     *
+     * If not, add_to_request() and commit() always fail and the legacy calls above must be used.
+     */
+    virtual bool supports_atomic() const = 0;
+    /**
+     * Add everything needed to show \p fb on the primary plane, and \p overlays above it, to \p request
+     *
+     * Any other overlay planes of this output are disabled.
+     *
+     * \param [in] modeset  Also set the mode and connect the CRTC, for a commit with
+     *                      DRM_MODE_ATOMIC_ALLOW_MODESET
+     * \returns             false if this output can't be driven with atomic modesetting
+     */
+    virtual bool add_to_request(
+        AtomicRequest& request,
+        FBHandle const& fb,
+        std::vector<OverlayPlane> const& overlays,
+        bool modeset) = 0;
+    /**
+     * Commit \p request, which may include other outputs on the same device
+     *
+     * \param [in] flags    DRM_MODE_ATOMIC_TEST_ONLY to just check whether the hardware would accept
+     *                      \p request, DRM_MODE_ATOMIC_ALLOW_MODESET to modeset (and wait for it), or
+     *                      0 to schedule a page flip on each output in \p request
+     */
+    virtual bool commit(AtomicRequest const& request, uint32_t flags) = 0;
 
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
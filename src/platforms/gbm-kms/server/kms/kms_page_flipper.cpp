@@ -15,6 +15,7 @@
  */
 
 #include "kms_page_flipper.h"
+#include "atomic_request.h"
 #include "mir/graphics/display_report.h"
 
 #include <stdexcept>
@@ -34,11 +35,12 @@ namespace
 
 void page_flip_handler(int /*fd*/, unsigned int seq,
                        unsigned int sec, unsigned int usec,
-                       void* data)
+                       unsigned int crtc_id, void* data)
 {
     auto page_flip_data = static_cast<mgg::PageFlipEventData*>(data);
     std::chrono::nanoseconds ns{sec*1000000000LL + usec*1000LL};
-    page_flip_data->flipper->notify_page_flip(page_flip_data->crtc_id,
+    // Older kernels don't report the CRTC, but then we only do legacy flips, which record it
+    page_flip_data->flipper->notify_page_flip(crtc_id ? crtc_id : page_flip_data->crtc_id,
                                               seq, ns);
 }
 
@@ -49,7 +51,9 @@ mgg::KMSPageFlipper::KMSPageFlipper(
     std::shared_ptr<DisplayReport> const& report) :
     drm_fd{drm_fd},
     report{report},
+    atomic{enable_atomic_modesetting(drm_fd)},
     pending_page_flips(),
+    atomic_event_data{0, 0, this},
     worker_tid()
 {
     uint64_t mono = 0;
@@ -86,12 +90,47 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
     return (ret == 0);
 }
 
+bool mgg::KMSPageFlipper::supports_atomic() const
+{
+    return atomic;
+}
+
+bool mgg::KMSPageFlipper::schedule_atomic_flip(AtomicRequest const& request)
+{
+    if (!atomic)
+        return false;
+
+    std::unique_lock lock{pf_mutex};
+
+    for (auto const& target : request.targets())
+    {
+        if (pending_page_flips.find(target.crtc_id) != pending_page_flips.end())
+            BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+    }
+
+    for (auto const& target : request.targets())
+        pending_page_flips[target.crtc_id] = PageFlipEventData{target.crtc_id, target.connector_id, this};
+
+    // Every CRTC in the request flips on the same commit, and sends its own event
+    auto ret = drmModeAtomicCommit(drm_fd, request.get(),
+                                   DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT,
+                                   &atomic_event_data);
+
+    if (ret)
+    {
+        for (auto const& target : request.targets())
+            pending_page_flips.erase(target.crtc_id);
+    }
+
+    return (ret == 0);
+}
+
 mg::Frame mgg::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 {
     drmEventContext evctx;
     memset(&evctx, 0, sizeof evctx);
-    evctx.version = 2;  // We only support the old v2 page_flip_handler
-    evctx.page_flip_handler = &page_flip_handler;
+    evctx.version = 3;
+    evctx.page_flip_handler2 = &page_flip_handler;
 
     static std::thread::id const invalid_tid;
 
@@ -53,6 +53,9 @@ public:
     bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
     Frame wait_for_flip(uint32_t crtc_id) override;
 
+    bool supports_atomic() const override;
+    bool schedule_atomic_flip(AtomicRequest const& request) override;
+
     std::thread::id debug_get_worker_tid();
 
     void notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust);
@@ -61,7 +64,10 @@ private:
 
     int const drm_fd;
     std::shared_ptr<DisplayReport> const report;
+    bool const atomic;
     std::unordered_map<uint32_t,PageFlipEventData> pending_page_flips;
+    /// Event data for atomic commits; the kernel tells us the CRTC of each of their events
+    PageFlipEventData atomic_event_data;
     std::unordered_map<uint32_t,Frame> completed_page_flips;
     std::mutex pf_mutex;
     std::condition_variable pf_cv;
@@ -26,6 +26,7 @@ namespace graphics
 {
 namespace gbm
 {
+class AtomicRequest;
 
 class PageFlipper
 {
@@ -35,6 +36,15 @@ public:
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
+    /// Whether the device is driven with atomic modesetting, so schedule_atomic_flip() can be used
+    virtual bool supports_atomic() const = 0;
+    /**
+     * Commit \p request without blocking, scheduling a page flip on each of its targets
+     *
+     * Each target's flip is then waited for with wait_for_flip(), as for schedule_flip().
+     */
+    virtual bool schedule_atomic_flip(AtomicRequest const& request) = 0;
+
 protected:
     PageFlipper() = default;
     PageFlipper(PageFlipper const&) = delete;
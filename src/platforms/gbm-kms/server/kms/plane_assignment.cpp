@@ -0,0 +1,288 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plane_assignment.h"
+#include "kms_framebuffer.h"
+#include "kms-utils/drm_mode_resources.h"
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm_fourcc.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace mgk = mir::graphics::kms;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto plane_type_from(mgk::ObjectProperties const& props) -> mgg::PlaneInfo::Type
+{
+    if (props.has_property("type"))
+    {
+        switch (props["type"])
+        {
+        case DRM_PLANE_TYPE_PRIMARY:
+            return mgg::PlaneInfo::Type::primary;
+        case DRM_PLANE_TYPE_CURSOR:
+            return mgg::PlaneInfo::Type::cursor;
+        }
+    }
+    return mgg::PlaneInfo::Type::overlay;
+}
+
+/// Fill in the per-format modifier lists from the plane's IN_FORMATS blob
+void add_modifiers_from(int drm_fd, uint32_t blob_id, mgg::PlaneInfo& plane)
+{
+    std::unique_ptr<drmModePropertyBlobRes, void(*)(drmModePropertyBlobPtr)> const blob{
+        drmModeGetPropertyBlob(drm_fd, blob_id),
+        &drmModeFreePropertyBlob};
+
+    if (!blob || blob->length < sizeof(drm_format_modifier_blob))
+    {
+        return;
+    }
+
+    auto const data = static_cast<char const*>(blob->data);
+    auto const header = reinterpret_cast<drm_format_modifier_blob const*>(data);
+    auto const formats = reinterpret_cast<uint32_t const*>(data + header->formats_offset);
+    auto const modifiers = reinterpret_cast<drm_format_modifier const*>(data + header->modifiers_offset);
+
+    for (auto i = 0u; i != header->count_modifiers; ++i)
+    {
+        // Each entry applies its modifier to up to 64 formats, as a bitmask from an offset
+        for (auto bit = 0u; bit != 64; ++bit)
+        {
+            auto const format_index = modifiers[i].offset + bit;
+            if ((modifiers[i].formats & (uint64_t{1} << bit)) && format_index < header->count_formats)
+            {
+                plane.formats[formats[format_index]].push_back(modifiers[i].modifier);
+            }
+        }
+    }
+}
+
+auto default_zpos_for(mgg::PlaneInfo::Type type, uint64_t overlay_index) -> uint64_t
+{
+    switch (type)
+    {
+    case mgg::PlaneInfo::Type::primary:
+        return 0;
+    case mgg::PlaneInfo::Type::overlay:
+        return overlay_index + 1;
+    case mgg::PlaneInfo::Type::cursor:
+        break;
+    }
+    return std::numeric_limits<uint64_t>::max();
+}
+
+auto supports_buffer(mgg::PlaneInfo const& plane, mg::FBHandle const& fb) -> bool
+{
+    auto const format = plane.formats.find(fb.drm_format());
+    if (format == plane.formats.end())
+    {
+        return false;
+    }
+
+    auto const modifier = fb.modifier();
+    if (!modifier || *modifier == DRM_FORMAT_MOD_INVALID)
+    {
+        // Implicit modifiers are whatever the driver allocated for scanout
+        return true;
+    }
+    if (format->second.empty())
+    {
+        return *modifier == DRM_FORMAT_MOD_LINEAR;
+    }
+    return std::find(format->second.begin(), format->second.end(), *modifier) != format->second.end();
+}
+
+/// Whether the element's source rectangle (in buffer pixels) is the same size as where it's shown
+auto is_unscaled(mg::DisplayElement const& element) -> bool
+{
+    return element.source_position.size.width.as_value() == element.screen_positon.size.width.as_int() &&
+           element.source_position.size.height.as_value() == element.screen_positon.size.height.as_int();
+}
+
+/// Whether the element samples only from within its buffer
+auto source_within(mg::DisplayElement const& element, mg::FBHandle const& fb) -> bool
+{
+    auto const& source = element.source_position;
+    return source.top_left.x.as_value() >= 0 &&
+           source.top_left.y.as_value() >= 0 &&
+           source.size.width.as_value() > 0 &&
+           source.size.height.as_value() > 0 &&
+           source.top_left.x.as_value() + source.size.width.as_value() <= fb.size().width.as_int() &&
+           source.top_left.y.as_value() + source.size.height.as_value() <= fb.size().height.as_int();
+}
+
+auto can_place(
+    mgg::PlaneInfo const& plane,
+    mg::DisplayElement const& element,
+    mg::FBHandle const& fb,
+    geom::Rectangle const& view_area,
+    bool allow_scaling) -> bool
+{
+    if (!supports_buffer(plane, fb) || !source_within(element, fb))
+    {
+        return false;
+    }
+
+    switch (plane.type)
+    {
+    case mgg::PlaneInfo::Type::primary:
+        // Page flipping shows the whole buffer, unscaled, on the whole CRTC
+        return is_unscaled(element) &&
+               element.screen_positon == view_area &&
+               element.source_position.top_left == geom::PointF{0, 0} &&
+               fb.size() == view_area.size;
+
+    case mgg::PlaneInfo::Type::overlay:
+        return (allow_scaling || is_unscaled(element)) && view_area.contains(element.screen_positon);
+
+    case mgg::PlaneInfo::Type::cursor:
+        // These belong to the hardware cursor
+        break;
+    }
+    return false;
+}
+}
+
+auto mgg::planes_for_crtc(int drm_fd, int crtc_index) -> std::vector<PlaneInfo>
+{
+    // Without this the kernel only lists overlay planes; failure just means we get fewer planes
+    drmSetClientCap(drm_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+
+    std::vector<PlaneInfo> planes;
+    uint64_t overlay_count{0};
+
+    mgk::PlaneResources resources{drm_fd};
+    for (auto const& plane : resources.planes())
+    {
+        if (!(plane->possible_crtcs & (1u << crtc_index)))
+        {
+            continue;
+        }
+
+        mgk::ObjectProperties const props{drm_fd, plane};
+        auto const type = plane_type_from(props);
+
+        // A plane shared between CRTCs could be claimed by another output at any time
+        if (type == PlaneInfo::Type::overlay && (plane->possible_crtcs & (plane->possible_crtcs - 1)))
+        {
+            continue;
+        }
+
+        PlaneInfo info{
+            plane->plane_id,
+            type,
+            props.has_property("zpos") ? props["zpos"] : default_zpos_for(type, overlay_count),
+            {}};
+        if (type == PlaneInfo::Type::overlay)
+        {
+            ++overlay_count;
+        }
+
+        for (auto i = 0u; i != plane->count_formats; ++i)
+        {
+            info.formats[plane->formats[i]];
+        }
+        if (props.has_property("IN_FORMATS"))
+        {
+            add_modifiers_from(drm_fd, props["IN_FORMATS"], info);
+        }
+
+        planes.push_back(std::move(info));
+    }
+
+    auto const has_primary = std::any_of(
+        planes.begin(),
+        planes.end(),
+        [](auto const& plane) { return plane.type == PlaneInfo::Type::primary; });
+    if (!has_primary)
+    {
+        // The CRTC still has one; we just can't see it. We only ever draw ?RGB8888 to it.
+        planes.push_back(
+            PlaneInfo{
+                0,
+                PlaneInfo::Type::primary,
+                0,
+                {{DRM_FORMAT_XRGB8888, {}}, {DRM_FORMAT_ARGB8888, {}}}});
+    }
+
+    std::stable_sort(
+        planes.begin(),
+        planes.end(),
+        [](auto const& a, auto const& b) { return a.zpos < b.zpos; });
+
+    return planes;
+}
+
+auto mgg::assign_planes(
+    std::vector<DisplayElement> const& elements,
+    std::vector<PlaneInfo> const& planes,
+    geom::Rectangle const& view_area,
+    bool allow_scaling) -> std::optional<std::vector<PlaneInfo const*>>
+{
+    if (elements.empty())
+    {
+        return std::nullopt;
+    }
+
+    auto const primary = std::find_if(
+        planes.begin(),
+        planes.end(),
+        [](auto const& plane) { return plane.type == PlaneInfo::Type::primary; });
+    if (primary == planes.end())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<PlaneInfo const*> assignment;
+    assignment.reserve(elements.size());
+
+    /* Each element must be above the last, so must go on a later plane. Taking the first
+     * plane that fits leaves as many planes as possible for the elements above.
+     */
+    auto next_plane = primary;
+    for (auto const& element : elements)
+    {
+        auto const fb = dynamic_cast<FBHandle const*>(element.buffer.get());
+        if (!fb)
+        {
+            return std::nullopt;
+        }
+
+        // The bottom element has to go on the primary plane, as the CRTC needs something there
+        auto const last_candidate = assignment.empty() ? primary + 1 : planes.end();
+        auto const plane = std::find_if(
+            next_plane,
+            last_candidate,
+            [&](auto const& plane) { return can_place(plane, element, *fb, view_area, allow_scaling); });
+
+        if (plane == last_candidate)
+        {
+            return std::nullopt;
+        }
+        assignment.push_back(&*plane);
+        next_plane = plane + 1;
+    }
+
+    return assignment;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_PLANE_ASSIGNMENT_H_
+#define MIR_GRAPHICS_GBM_PLANE_ASSIGNMENT_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/graphics/display_sink.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+/// What we need to know about a KMS plane to decide whether it can scan out a framebuffer
+struct PlaneInfo
+{
+    enum class Type
+    {
+        primary,
+        overlay,
+        cursor
+    };
+
+    /// KMS object ID; 0 for a primary plane only reachable through the legacy CRTC API
+    uint32_t id;
+    Type type;
+    /// Position in the stacking order; planes with higher zpos are shown above those with lower
+    uint64_t zpos;
+    /**
+     * The formats the plane can scan out, mapped to the modifiers it supports for each
+     *
+     * An empty modifier list means the plane did not advertise any (no IN_FORMATS property),
+     * in which case only linear or implicit-modifier buffers are assumed to work.
+     */
+    std::unordered_map<uint32_t, std::vector<uint64_t>> formats;
+};
+
+/**
+ * Enumerate the planes usable with the CRTC at \p crtc_index, in stacking order (bottom first)
+ *
+ * This always includes a primary plane, even where the kernel doesn't expose universal planes.
+ * Overlay planes that could also be used by other CRTCs are left out.
+ */
+auto planes_for_crtc(int drm_fd, int crtc_index) -> std::vector<PlaneInfo>;
+
+/**
+ * Assign each of \p elements (bottom first) to a plane from \p planes (as from planes_for_crtc())
+ *
+ * Elements must be backed by KMS framebuffers, and are matched to planes by format, modifier,
+ * scaling and stacking order. The bottom element must go on the primary plane, which must be
+ * covered exactly. Cursor planes are left for the hardware cursor.
+ *
+ * \param [in] allow_scaling    Whether overlay planes may scale; only pass true if the result
+ *                              will be checked with the hardware (by an atomic TEST_ONLY commit)
+ * \returns The plane chosen for each element, or std::nullopt if they cannot all be placed
+ */
+auto assign_planes(
+    std::vector<DisplayElement> const& elements,
+    std::vector<PlaneInfo> const& planes,
+    geometry::Rectangle const& view_area,
+    bool allow_scaling) -> std::optional<std::vector<PlaneInfo const*>>;
+}
+}
+}
+
+#endif // MIR_GRAPHICS_GBM_PLANE_ASSIGNMENT_H_
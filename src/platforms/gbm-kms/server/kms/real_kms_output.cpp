@@ -15,6 +15,7 @@
  */
 
 #include "real_kms_output.h"
+#include "atomic_request.h"
 #include "kms_framebuffer.h"
 #include "mir/graphics/display_configuration.h"
 #include "page_flipper.h"
@@ -24,9 +25,11 @@
 #include <string.h> // strcmp
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <system_error>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
+#include <drm_fourcc.h>
 
 namespace mg = mir::graphics;
 namespace mgg = mg::gbm;
@@ -49,6 +52,34 @@ bool kms_modes_are_equal(drmModeModeInfo const& info1, drmModeModeInfo const& in
             info1.vsync_end == info2.vsync_end &&
             info1.vtotal == info2.vtotal);
 }
+
+// KMS plane source coordinates are 16.16 fixed point
+auto to_fixed_point(float value) -> uint32_t
+{
+    return static_cast<uint32_t>(value * 65536);
+}
+
+void add_plane_to(
+    mgg::AtomicRequest& request,
+    uint32_t plane_id,
+    mgk::ObjectProperties const& props,
+    uint32_t crtc_id,
+    uint32_t fb_id,
+    geom::Rectangle const& dest,
+    geom::RectangleF const& source)
+{
+    request.add_property(plane_id, props, "FB_ID", fb_id);
+    request.add_property(plane_id, props, "CRTC_ID", crtc_id);
+    request.add_property(plane_id, props, "SRC_X", to_fixed_point(source.top_left.x.as_value()));
+    request.add_property(plane_id, props, "SRC_Y", to_fixed_point(source.top_left.y.as_value()));
+    request.add_property(plane_id, props, "SRC_W", to_fixed_point(source.size.width.as_value()));
+    request.add_property(plane_id, props, "SRC_H", to_fixed_point(source.size.height.as_value()));
+    // The destination position is signed; the property takes it as a (64-bit) two's complement value
+    request.add_property(plane_id, props, "CRTC_X", static_cast<uint64_t>(int64_t{dest.top_left.x.as_int()}));
+    request.add_property(plane_id, props, "CRTC_Y", static_cast<uint64_t>(int64_t{dest.top_left.y.as_int()}));
+    request.add_property(plane_id, props, "CRTC_W", dest.size.width.as_uint32_t());
+    request.add_property(plane_id, props, "CRTC_H", dest.size.height.as_uint32_t());
+}
 }
 
 mgg::RealKMSOutput::RealKMSOutput(
@@ -63,6 +94,8 @@ mgg::RealKMSOutput::RealKMSOutput(
       saved_crtc(),
       using_saved_crtc{true},
       has_cursor_{false},
+      planes_crtc_id{0},
+      mode_blob_index{0},
       power_mode(mir_power_mode_on)
 {
     reset();
@@ -140,6 +173,32 @@ int mgg::RealKMSOutput::max_refresh_rate() const
     return current_mode.vrefresh;
 }
 
+auto mgg::RealKMSOutput::frame_interval() const -> std::chrono::nanoseconds
+{
+    using namespace std::chrono_literals;
+
+    if (connector->connection == DRM_MODE_DISCONNECTED)
+        return 1s;
+
+    drmModeModeInfo const& current_mode = connector->modes[mode_index];
+    if (current_mode.clock == 0 || current_mode.htotal == 0 || current_mode.vtotal == 0)
+    {
+        return std::chrono::nanoseconds{1s} / std::max(current_mode.vrefresh, 1u);
+    }
+
+    // As the kernel's drm_mode_vrefresh(), but without rounding; the clock is in kHz
+    int64_t pixels_per_frame = int64_t{current_mode.htotal} * current_mode.vtotal;
+    if (current_mode.flags & DRM_MODE_FLAG_DBLSCAN)
+        pixels_per_frame *= 2;
+    if (current_mode.vscan > 1)
+        pixels_per_frame *= current_mode.vscan;
+    // An interlaced mode scans out a field, half a frame, each vblank
+    if (current_mode.flags & DRM_MODE_FLAG_INTERLACE)
+        pixels_per_frame /= 2;
+
+    return std::chrono::nanoseconds{pixels_per_frame * 1'000'000 / current_mode.clock};
+}
+
 void mgg::RealKMSOutput::configure(geom::Displacement offset, size_t kms_mode_index)
 {
     fb_offset = offset;
@@ -243,17 +302,222 @@ bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
         connector->connector_id);
 }
 
-void mgg::RealKMSOutput::wait_for_page_flip()
+auto mgg::RealKMSOutput::wait_for_page_flip() -> Frame
 {
     std::unique_lock lg(power_mutex);
     if (power_mode != mir_power_mode_on)
-        return;
+        return {};
     if (!current_crtc)
     {
         fatal_error("Output %s has no associated CRTC to wait on",
                    mgk::connector_name(connector).c_str());
     }
-    page_flipper->wait_for_flip(current_crtc->crtc_id);
+    return page_flipper->wait_for_flip(current_crtc->crtc_id);
+}
+
+auto mgg::RealKMSOutput::planes() -> std::vector<PlaneInfo> const&
+{
+    auto const crtc_id = current_crtc ? current_crtc->crtc_id : 0;
+    if (planes_ && planes_crtc_id == crtc_id)
+    {
+        return *planes_;
+    }
+
+    planes_crtc_id = crtc_id;
+    planes_.emplace();
+
+    if (current_crtc)
+    {
+        try
+        {
+            kms::DRMModeResources resources{drm_fd_};
+            int crtc_index{0};
+            for (auto& crtc : resources.crtcs())
+            {
+                if (crtc->crtc_id == crtc_id)
+                {
+                    planes_ = planes_for_crtc(drm_fd_, crtc_index);
+                    return *planes_;
+                }
+                ++crtc_index;
+            }
+        }
+        catch (std::exception const& e)
+        {
+            mir::log_debug(
+                "Failed to enumerate planes for output %s: %s",
+                mgk::connector_name(connector).c_str(),
+                e.what());
+        }
+    }
+
+    // We can always page-flip, even if we can't find out anything else
+    planes_->push_back(
+        PlaneInfo{
+            0,
+            PlaneInfo::Type::primary,
+            0,
+            {{DRM_FORMAT_XRGB8888, {}}, {DRM_FORMAT_ARGB8888, {}}}});
+    return *planes_;
+}
+
+bool mgg::RealKMSOutput::set_plane(
+    uint32_t plane_id,
+    FBHandle const& fb,
+    geom::Rectangle const& dest,
+    geom::RectangleF const& source)
+{
+    if (!current_crtc)
+    {
+        return false;
+    }
+
+    auto const result = drmModeSetPlane(
+        drm_fd_,
+        plane_id,
+        current_crtc->crtc_id,
+        fb,
+        0,
+        dest.top_left.x.as_int(), dest.top_left.y.as_int(),
+        dest.size.width.as_uint32_t(), dest.size.height.as_uint32_t(),
+        to_fixed_point(source.top_left.x.as_value()), to_fixed_point(source.top_left.y.as_value()),
+        to_fixed_point(source.size.width.as_value()), to_fixed_point(source.size.height.as_value()));
+    if (result)
+    {
+        mir::log_debug("set_plane: drmModeSetPlane failed (%s)", strerror(-result));
+    }
+    return !result;
+}
+
+void mgg::RealKMSOutput::clear_plane(uint32_t plane_id)
+{
+    if (current_crtc)
+    {
+        if (auto result = drmModeSetPlane(drm_fd_, plane_id, current_crtc->crtc_id, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0))
+        {
+            mir::log_warning("clear_plane: drmModeSetPlane failed (%s)", strerror(-result));
+        }
+    }
+}
+
+bool mgg::RealKMSOutput::supports_atomic() const
+{
+    return page_flipper->supports_atomic();
+}
+
+bool mgg::RealKMSOutput::add_to_request(
+    AtomicRequest& request,
+    FBHandle const& fb,
+    std::vector<OverlayPlane> const& overlays,
+    bool modeset)
+{
+    if (!page_flipper->supports_atomic())
+        return false;
+
+    {
+        // The CRTC of a powered-down output is inactive, and can't flip
+        std::lock_guard lg(power_mutex);
+        if (power_mode != mir_power_mode_on)
+            return false;
+    }
+
+    if (modeset ? !ensure_crtc() : !current_crtc)
+        return false;
+
+    auto const& planes = this->planes();
+    auto const primary = std::find_if(
+        planes.begin(),
+        planes.end(),
+        [](auto const& plane) { return plane.type == PlaneInfo::Type::primary; });
+    if (primary == planes.end() || primary->id == 0)
+        return false;
+
+    auto const crtc_id = current_crtc->crtc_id;
+    auto const& mode = connector->modes[mode_index];
+    try
+    {
+        if (modeset)
+        {
+            if (!mode_blob || mode_blob_index != mode_index)
+            {
+                mode_blob = std::make_unique<PropertyBlob>(drm_fd_, &mode, sizeof(mode));
+                mode_blob_index = mode_index;
+            }
+
+            auto const& crtc_props = properties_for(crtc_id, DRM_MODE_OBJECT_CRTC);
+            request.add_property(crtc_id, crtc_props, "MODE_ID", mode_blob->id());
+            request.add_property(crtc_id, crtc_props, "ACTIVE", 1);
+            request.add_property(
+                connector->connector_id,
+                properties_for(connector->connector_id, DRM_MODE_OBJECT_CONNECTOR),
+                "CRTC_ID",
+                crtc_id);
+        }
+
+        add_plane_to(
+            request,
+            primary->id,
+            properties_for(primary->id, DRM_MODE_OBJECT_PLANE),
+            crtc_id,
+            fb,
+            {{0, 0}, {mode.hdisplay, mode.vdisplay}},
+            {{fb_offset.dx.as_int(), fb_offset.dy.as_int()}, {mode.hdisplay, mode.vdisplay}});
+
+        for (auto const& plane : planes)
+        {
+            if (plane.type != PlaneInfo::Type::overlay)
+                continue;
+
+            auto const& plane_props = properties_for(plane.id, DRM_MODE_OBJECT_PLANE);
+            auto const overlay = std::find_if(
+                overlays.begin(),
+                overlays.end(),
+                [&](auto const& overlay) { return overlay.plane_id == plane.id; });
+            if (overlay != overlays.end())
+            {
+                add_plane_to(request, plane.id, plane_props, crtc_id, *overlay->fb, overlay->dest, overlay->source);
+            }
+            else
+            {
+                request.add_property(plane.id, plane_props, "FB_ID", 0);
+                request.add_property(plane.id, plane_props, "CRTC_ID", 0);
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_debug(
+            "Output %s can't be driven with atomic modesetting: %s",
+            mgk::connector_name(connector).c_str(),
+            e.what());
+        return false;
+    }
+
+    if (modeset)
+    {
+        // We can't tell here whether the modeset will succeed; restoring the saved CRTC is harmless if not
+        using_saved_crtc = false;
+    }
+    request.add_target(crtc_id, connector->connector_id);
+    return true;
+}
+
+bool mgg::RealKMSOutput::commit(AtomicRequest const& request, uint32_t flags)
+{
+    if (!page_flipper->supports_atomic())
+        return false;
+
+    if (flags & (DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET))
+    {
+        auto const result = drmModeAtomicCommit(drm_fd_, request.get(), flags, nullptr);
+        if (result && !(flags & DRM_MODE_ATOMIC_TEST_ONLY))
+        {
+            mir::log_error("Failed to commit atomic modeset: %s (%i)", strerror(-result), -result);
+        }
+        return !result;
+    }
+
+    return page_flipper->schedule_atomic_flip(request);
 }
 
 bool mgg::RealKMSOutput::set_cursor(gbm_bo* buffer)
@@ -380,6 +644,9 @@ void mgg::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
             std::invalid_argument("set_gamma: mismatch gamma LUT sizes"));
     }
 
+    if (set_gamma_atomic(gamma))
+        return;
+
     int ret = drmModeCrtcSetGamma(
         drm_fd_,
         current_crtc->crtc_id,
@@ -395,6 +662,56 @@ void mgg::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
     // TODO: return bool in future? Then do what with it?
 }
 
+bool mgg::RealKMSOutput::set_gamma_atomic(GammaCurves const& gamma)
+{
+    if (!page_flipper->supports_atomic())
+        return false;
+
+    try
+    {
+        auto const& crtc_props = properties_for(current_crtc->crtc_id, DRM_MODE_OBJECT_CRTC);
+        if (!crtc_props.has_property("GAMMA_LUT"))
+            return false;
+
+        std::vector<drm_color_lut> lut(gamma.red.size());
+        for (auto i = 0u; i != lut.size(); ++i)
+        {
+            lut[i] = drm_color_lut{gamma.red[i], gamma.green[i], gamma.blue[i], 0};
+        }
+
+        // The kernel keeps its own reference to the blob for as long as the CRTC uses it
+        PropertyBlob const blob{drm_fd_, lut.data(), lut.size() * sizeof(drm_color_lut)};
+        AtomicRequest request;
+        request.add_property(current_crtc->crtc_id, crtc_props, "GAMMA_LUT", blob.id());
+
+        /* Not part of a frame's commit: gamma changes are rare, and nothing guarantees
+         * another frame will follow to carry this one.
+         */
+        if (auto const result = drmModeAtomicCommit(drm_fd_, request.get(), 0, nullptr))
+        {
+            mir::log_debug("Failed to set GAMMA_LUT (%s); falling back to legacy gamma", strerror(-result));
+            return false;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_debug("Failed to set GAMMA_LUT (%s); falling back to legacy gamma", e.what());
+        return false;
+    }
+    return true;
+}
+
+auto mgg::RealKMSOutput::properties_for(uint32_t object_id, uint32_t object_type) -> kms::ObjectProperties const&
+{
+    auto existing = object_properties.find(object_id);
+    if (existing == object_properties.end())
+    {
+        // KMS object IDs are unique across object types
+        existing = object_properties.try_emplace(object_id, drm_fd_, object_id, object_type).first;
+    }
+    return existing->second;
+}
+
 void mgg::RealKMSOutput::refresh_hardware_state()
 {
     connector = kms::get_connector(drm_fd_, connector->connector_id);
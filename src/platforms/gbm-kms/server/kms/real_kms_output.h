@@ -22,6 +22,9 @@
 
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace mir
 {
@@ -31,6 +34,7 @@ namespace gbm
 {
 
 class PageFlipper;
+class PropertyBlob;
 
 class RealKMSOutput : public KMSOutput
 {
@@ -47,12 +51,29 @@ public:
     void configure(geometry::Displacement fb_offset, size_t kms_mode_index) override;
     geometry::Size size() const override;
     int max_refresh_rate() const override;
+    auto frame_interval() const -> std::chrono::nanoseconds override;
 
     bool set_crtc(FBHandle const& fb) override;
     bool has_crtc_mismatch() override;
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
-    void wait_for_page_flip() override;
+    auto wait_for_page_flip() -> Frame override;
+
+    auto planes() -> std::vector<PlaneInfo> const& override;
+    bool set_plane(
+        uint32_t plane_id,
+        FBHandle const& fb,
+        geometry::Rectangle const& dest,
+        geometry::RectangleF const& source) override;
+    void clear_plane(uint32_t plane_id) override;
+
+    bool supports_atomic() const override;
+    bool add_to_request(
+        AtomicRequest& request,
+        FBHandle const& fb,
+        std::vector<OverlayPlane> const& overlays,
+        bool modeset) override;
+    bool commit(AtomicRequest const& request, uint32_t flags) override;
 
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
@@ -70,6 +91,8 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    auto properties_for(uint32_t object_id, uint32_t object_type) -> kms::ObjectProperties const&;
+    bool set_gamma_atomic(GammaCurves const& gamma);
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
@@ -81,6 +104,14 @@ private:
     drmModeCrtc saved_crtc;
     bool using_saved_crtc;
     bool has_cursor_;
+    /// The planes of the CRTC with ID planes_crtc_id; enumerated on first use
+    std::optional<std::vector<PlaneInfo>> planes_;
+    uint32_t planes_crtc_id;
+    /// KMS object properties, for atomic requests; only their IDs are used, which don't change
+    std::unordered_map<uint32_t, kms::ObjectProperties> object_properties;
+    /// The mode with index mode_blob_index, for atomic modesets
+    std::unique_ptr<PropertyBlob> mode_blob;
+    size_t mode_blob_index;
 
     MirPowerMode power_mode;
     int dpms_enum_id;
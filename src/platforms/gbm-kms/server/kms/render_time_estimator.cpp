@@ -0,0 +1,50 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_time_estimator.h"
+
+#include <algorithm>
+
+namespace mgg = mir::graphics::gbm;
+
+namespace
+{
+// Allow for all but the slowest ~5% of recent frames...
+auto constexpr percentile = 95;
+// ...and for scheduling jitter in waking the compositor and committing the frame
+auto constexpr margin = std::chrono::microseconds{1500};
+}
+
+void mgg::RenderTimeEstimator::record(std::chrono::nanoseconds render_time)
+{
+    samples[next_sample] = render_time;
+    next_sample = (next_sample + 1) % max_samples;
+    sample_count = std::min(sample_count + 1, max_samples);
+}
+
+auto mgg::RenderTimeEstimator::estimate() const -> std::optional<std::chrono::nanoseconds>
+{
+    if (sample_count < min_samples)
+    {
+        return std::nullopt;
+    }
+
+    auto sorted = samples;
+    auto const end = sorted.begin() + sample_count;
+    auto const nth = sorted.begin() + (sample_count - 1) * percentile / 100;
+    std::nth_element(sorted.begin(), nth, end);
+    return *nth + margin;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_RENDER_TIME_ESTIMATOR_H_
+#define MIR_GRAPHICS_GBM_RENDER_TIME_ESTIMATOR_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+/**
+ * Predicts how long the next frame will take to produce, from how long recent frames took
+ *
+ * The prediction is a high percentile of the recent samples plus a safety margin, so that an
+ * occasional slow frame doesn't push every following frame back by a vblank, but a run of them
+ * does.
+ */
+class RenderTimeEstimator
+{
+public:
+    void record(std::chrono::nanoseconds render_time);
+
+    /**
+     * The time to allow for the next frame
+     *
+     * \returns nullopt until enough frames have been recorded to make a prediction
+     */
+    auto estimate() const -> std::optional<std::chrono::nanoseconds>;
+
+private:
+    static size_t constexpr max_samples = 64;
+    static size_t constexpr min_samples = 8;
+
+    std::array<std::chrono::nanoseconds, max_samples> samples{};
+    size_t next_sample{0};
+    size_t sample_count{0};
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_RENDER_TIME_ESTIMATOR_H_ */
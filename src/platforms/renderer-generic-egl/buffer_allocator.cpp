@@ -315,12 +315,16 @@ std::shared_ptr<mg::Buffer> mge::BufferAllocator::buffer_from_resource(
 
 auto mge::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geometry::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
+        std::dynamic_pointer_cast<mgc::ShmBuffer>(previous),
+        damage,
         std::move(on_consumed),
         std::move(on_release));
 }
@@ -379,6 +383,13 @@ public:
         return fb->size();
     }
 
+    auto buffer_age() const -> unsigned override
+    {
+        // The host EGL surface is hidden behind EGLFramebuffer, so we can't know what the back buffer
+        // holds; an age of 0 means "unknown contents", and every frame is redrawn in full
+        return 0;
+    }
+
     auto layout() const -> Layout override
     {
         return Layout::GL;
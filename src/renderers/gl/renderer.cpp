@@ -38,6 +38,7 @@
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
 #include <cmath>
+#include <cstddef>
 #include <sstream>
 #include <mutex>
 
@@ -342,6 +343,13 @@ mrg::Renderer::Renderer(
 
 mrg::Renderer::~Renderer()
 {
+    // Our GL objects (including those of program_factory, destroyed after this) live in our context
+    output_surface->make_current();
+
+    if (vertex_buffer)
+    {
+        glDeleteBuffers(1, &vertex_buffer);
+    }
 }
 
 void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
@@ -358,13 +366,39 @@ auto mrg::Renderer::render(mg::RenderableList const& renderables) const -> std::
 
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
+    batch(renderables);
+    if (damage && can_draw_partially())
     {
-        draw(*r);
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& area : areas_to_redraw())
+        {
+            redraw_area = area;
+            scissor_to(area);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            for (auto const& r : renderables)
+            {
+                // Transformed renderables can draw outside their screen_position()
+                if (r->screen_position().overlaps(area) || r->transformation() != glm::mat4{1})
+                {
+                    draw(*r);
+                }
+            }
+        }
+        redraw_area = std::nullopt;
+        glDisable(GL_SCISSOR_TEST);
     }
+    else
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (auto const& r : renderables)
+        {
+            draw(*r);
+        }
+    }
+    end_batch();
 
     auto output = output_surface->commit();
 
@@ -379,7 +413,17 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
 {
     auto const texture = gl_interface->as_texture(renderable.buffer());
     auto const clip_area = renderable.clip_area();
-    if (clip_area)
+    if (redraw_area)
+    {
+        // GL_SCISSOR_TEST is already enabled by render()
+        auto const scissor = clip_area ? intersection_of(*redraw_area, *clip_area) : *redraw_area;
+        if (scissor.size.width == geom::Width{0} || scissor.size.height == geom::Height{0})
+        {
+            return;
+        }
+        scissor_to(scissor);
+    }
+    else if (clip_area)
     {
         glEnable(GL_SCISSOR_TEST);
         auto clip_x = clip_area.value().top_left.x.as_int();
@@ -412,23 +456,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
                 return &family.opaque;
         }(renderable.alpha() < 1.0f);
 
-    glUseProgram(prog->id);
-    if (prog->last_used_frameno != frameno)
-    {   // Avoid reloading the screen-global uniforms on every renderable
-        // TODO: We actually only need to bind these *once*, right? Not once per frame?
-        prog->last_used_frameno = frameno;
-        for (auto i = 0u; i < prog->tex_uniforms.size(); ++i)
-        {
-            if (prog->tex_uniforms[i] != -1)
-            {
-                glUniform1i(prog->tex_uniforms[i], i);
-            }
-        }
-        glUniformMatrix4fv(prog->display_transform_uniform, 1, GL_FALSE,
-                           glm::value_ptr(display_transform));
-        glUniformMatrix4fv(prog->screen_to_gl_coords_uniform, 1, GL_FALSE,
-                           glm::value_ptr(screen_to_gl_coords));
-    }
+    use_program(*prog);
 
     glActiveTexture(GL_TEXTURE0);
 
@@ -458,68 +486,37 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     if (prog->alpha_uniform >= 0)
         glUniform1f(prog->alpha_uniform, renderable.alpha());
 
-    glEnableVertexAttribArray(prog->position_attr);
-    glEnableVertexAttribArray(prog->texcoord_attr);
-
-    primitives.clear();
-    tessellate(primitives, renderable);
+    auto const& batch = batched(renderable);
 
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
     {
-        typedef struct  // Represents parameters of glBlendFuncSeparate()
-        {
-            GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
-        } BlendSeparate;
-
-        BlendSeparate client_blend;
-
         // These renderable method names could be better (see LP: #1236224)
         if (renderable.shaped())  // Client is RGBA:
         {
-            client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
-                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
+            set_blend({GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                       GL_ONE, GL_ONE_MINUS_SRC_ALPHA, 0.0f});
         }
         else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
         {
-            client_blend = {GL_ONE,  GL_ZERO,
-                            GL_ZERO, GL_ONE};  // Avoid using src_alpha!
+            set_blend({GL_ONE,  GL_ZERO,
+                       GL_ZERO, GL_ONE, 0.0f});  // Avoid using src_alpha!
         }
         else
         {   // Client is RGBX but we also have window translucency.
             // The texture alpha channel is possibly uninitialized so we must be
             // careful and avoid using SRC_ALPHA (LP: #1423462).
-            client_blend = {GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
-                            GL_ZERO, GL_ONE};
-            glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
+            set_blend({GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
+                       GL_ZERO, GL_ONE, renderable.alpha()});
         }
 
-        for (auto const& p : primitives)
+        for (auto i = batch.begin; i != batch.end; ++i)
         {
-            BlendSeparate blend;
+            auto const& p = batch_primitives[i];
 
-            blend = client_blend;
             texture->bind();
 
-            glVertexAttribPointer(prog->position_attr, 3, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].position);
-            glVertexAttribPointer(prog->texcoord_attr, 2, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].texcoord);
-
-            if (blend.dst_rgb == GL_ZERO)
-            {
-                glDisable(GL_BLEND);
-            }
-            else
-            {
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
-                                    blend.src_alpha, blend.dst_alpha);
-            }
-
-            glDrawArrays(p.type, 0, p.nvertices);
+            glDrawArrays(p.type, p.first, p.count);
 
             // We're done with the texture for now
             texture->add_syncpoint();
@@ -530,14 +527,229 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         report_exception();
     }
 
-    glDisableVertexAttribArray(prog->texcoord_attr);
-    glDisableVertexAttribArray(prog->position_attr);
-    if (renderable.clip_area())
+    if (renderable.clip_area() && !redraw_area)
     {
         glDisable(GL_SCISSOR_TEST);
     }
 }
 
+void mrg::Renderer::batch(mg::RenderableList const& renderables) const
+{
+    batch_vertices.clear();
+    batch_primitives.clear();
+    batch_renderables.clear();
+    batch_cursor = 0;
+
+    for (auto const& renderable : renderables)
+    {
+        add_to_batch(*renderable);
+    }
+    upload_batch();
+
+    // Whatever happened outside render() may have changed these
+    current_program = nullptr;
+    current_blend = std::nullopt;
+}
+
+void mrg::Renderer::add_to_batch(mg::Renderable const& renderable) const
+{
+    primitives.clear();
+    tessellate(primitives, renderable);
+
+    auto const begin = batch_primitives.size();
+    for (auto const& p : primitives)
+    {
+        batch_primitives.push_back(
+            BatchedPrimitive{
+                p.type,
+                static_cast<GLint>(batch_vertices.size()),
+                static_cast<GLsizei>(p.nvertices)});
+        batch_vertices.insert(batch_vertices.end(), p.vertices, p.vertices + p.nvertices);
+    }
+    batch_renderables.push_back(BatchedRenderable{&renderable, begin, batch_primitives.size()});
+}
+
+void mrg::Renderer::upload_batch() const
+{
+    if (!vertex_buffer)
+    {
+        glGenBuffers(1, &vertex_buffer);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    if (!batch_vertices.empty())
+    {
+        // Respecifying the whole store lets the driver hand us fresh memory rather than
+        // waiting for the GPU to finish with the last frame's vertices
+        glBufferData(
+            GL_ARRAY_BUFFER,
+            batch_vertices.size() * sizeof(mgl::Vertex),
+            batch_vertices.data(),
+            GL_STREAM_DRAW);
+    }
+}
+
+auto mrg::Renderer::batched(mg::Renderable const& renderable) const -> BatchedRenderable const&
+{
+    // Renderables are drawn in the order they were batched, so this is usually the first we look at
+    for (auto n = 0u; n != batch_renderables.size(); ++n)
+    {
+        auto const i = (batch_cursor + n) % batch_renderables.size();
+        if (batch_renderables[i].renderable == &renderable)
+        {
+            batch_cursor = i + 1;
+            return batch_renderables[i];
+        }
+    }
+
+    // Not in this frame's batch (a subclass drawing something extra?); add it
+    add_to_batch(renderable);
+    // Attribute pointers are offsets into the buffer, so survive it being respecified
+    upload_batch();
+    return batch_renderables.back();
+}
+
+void mrg::Renderer::end_batch() const
+{
+    if (current_program)
+    {
+        glDisableVertexAttribArray(current_program->texcoord_attr);
+        glDisableVertexAttribArray(current_program->position_attr);
+        current_program = nullptr;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void mrg::Renderer::use_program(Program const& prog) const
+{
+    if (current_program == &prog)
+    {
+        return;
+    }
+
+    if (current_program)
+    {
+        glDisableVertexAttribArray(current_program->texcoord_attr);
+        glDisableVertexAttribArray(current_program->position_attr);
+    }
+
+    glUseProgram(prog.id);
+    current_program = &prog;
+    if (prog.last_used_frameno != frameno)
+    {   // Avoid reloading the screen-global uniforms on every renderable
+        // TODO: We actually only need to bind these *once*, right? Not once per frame?
+        prog.last_used_frameno = frameno;
+        for (auto i = 0u; i < prog.tex_uniforms.size(); ++i)
+        {
+            if (prog.tex_uniforms[i] != -1)
+            {
+                glUniform1i(prog.tex_uniforms[i], i);
+            }
+        }
+        glUniformMatrix4fv(prog.display_transform_uniform, 1, GL_FALSE,
+                           glm::value_ptr(display_transform));
+        glUniformMatrix4fv(prog.screen_to_gl_coords_uniform, 1, GL_FALSE,
+                           glm::value_ptr(screen_to_gl_coords));
+    }
+
+    // Every renderable's vertices are in the one buffer, so these only change with the program
+    glEnableVertexAttribArray(prog.position_attr);
+    glEnableVertexAttribArray(prog.texcoord_attr);
+    glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT, GL_FALSE, sizeof(mgl::Vertex),
+                          reinterpret_cast<void const*>(offsetof(mgl::Vertex, position)));
+    glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT, GL_FALSE, sizeof(mgl::Vertex),
+                          reinterpret_cast<void const*>(offsetof(mgl::Vertex, texcoord)));
+}
+
+void mrg::Renderer::set_blend(BlendState const& blend) const
+{
+    if (current_blend == blend)
+    {
+        return;
+    }
+
+    if (blend.dst_rgb == GL_ZERO)
+    {
+        glDisable(GL_BLEND);
+    }
+    else
+    {
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
+                            blend.src_alpha, blend.dst_alpha);
+        if (blend.dst_rgb == GL_ONE_MINUS_CONSTANT_ALPHA)
+        {
+            glBlendColor(0.0f, 0.0f, 0.0f, blend.constant_alpha);
+        }
+    }
+    current_blend = blend;
+}
+
+auto mrg::Renderer::buffer_age() const -> unsigned
+{
+    output_surface->make_current();
+    return output_surface->buffer_age();
+}
+
+void mrg::Renderer::set_damage(std::optional<geometry::Rectangles> const& damage)
+{
+    this->damage = damage;
+}
+
+auto mrg::Renderer::can_draw_partially() const -> bool
+{
+    return output_transform == glm::mat2{1} && output_surface->size() == viewport.size;
+}
+
+auto mrg::Renderer::areas_to_redraw() const -> std::vector<geom::Rectangle>
+{
+    // Each area costs a pass over the renderables, so past a handful we just redraw their bounds
+    size_t const max_areas = 4;
+
+    std::vector<geom::Rectangle> areas;
+    for (auto const& rect : *damage)
+    {
+        auto const area = intersection_of(rect, viewport);
+        if (area.size.width > geom::Width{0} && area.size.height > geom::Height{0})
+        {
+            areas.push_back(area);
+        }
+    }
+
+    if (areas.size() > max_areas)
+    {
+        geom::Rectangles all;
+        for (auto const& area : areas)
+        {
+            all.add(area);
+        }
+        return {all.bounding_rectangle()};
+    }
+    return areas;
+}
+
+void mrg::Renderer::scissor_to(geom::Rectangle const& area) const
+{
+    auto const x = area.left().as_int() - viewport.left().as_int();
+    auto const y = area.top().as_int() - viewport.top().as_int();
+
+    switch (output_surface->layout())
+    {
+    case graphics::gl::OutputSurface::Layout::GL:
+        // GL's y-coördinate is relative to the bottom of the framebuffer
+        glScissor(
+            x,
+            viewport.size.height.as_int() - y - area.size.height.as_int(),
+            area.size.width.as_int(),
+            area.size.height.as_int());
+        break;
+    case graphics::gl::OutputSurface::Layout::TopRowFirst:
+        // ...but we render these upside down, so the rows match the screen
+        glScissor(x, y, area.size.width.as_int(), area.size.height.as_int());
+        break;
+    }
+}
+
 void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
 {
     if (rect == viewport)
@@ -617,6 +829,7 @@ void mrg::Renderer::update_gl_viewport()
 
 void mrg::Renderer::set_output_transform(glm::mat2 const& t)
 {
+    output_transform = t;
     auto new_display_transform = glm::mat4(t);
 
     switch (output_surface->layout())
@@ -19,6 +19,7 @@
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
@@ -47,6 +48,8 @@ public:
     void set_viewport(geometry::Rectangle const& rect) override;
     void set_output_transform(glm::mat2 const&) override;
     auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> override;
+    auto buffer_age() const -> unsigned override;
+    void set_damage(std::optional<geometry::Rectangles> const& damage) override;
 
     // This is called _without_ a GL context:
     void suspend() override;
@@ -101,13 +104,69 @@ protected:
 
 private:
     void update_gl_viewport();
+    /// Whether screen coördinates map 1:1 onto the output, so we can scissor to the damaged region
+    auto can_draw_partially() const -> bool;
+    auto areas_to_redraw() const -> std::vector<geometry::Rectangle>;
+    void scissor_to(geometry::Rectangle const& area) const;
+
+    /// A primitive's vertices in vertex_buffer
+    struct BatchedPrimitive
+    {
+        GLenum type;
+        GLint first;
+        GLsizei count;
+    };
+    /// The primitives [begin, end) of batch_primitives, which draw a renderable
+    struct BatchedRenderable
+    {
+        graphics::Renderable const* renderable;
+        size_t begin;
+        size_t end;
+    };
+    /// Parameters of glBlendFuncSeparate() and glBlendColor(); blending is disabled if dst_rgb is GL_ZERO
+    struct BlendState
+    {
+        GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+        GLfloat constant_alpha;
+
+        auto operator==(BlendState const&) const -> bool = default;
+    };
+
+    /**
+     * Tessellate all of \p renderables and upload their vertices to vertex_buffer at once,
+     * rather than passing client-side arrays to each draw call
+     */
+    void batch(graphics::RenderableList const& renderables) const;
+    void add_to_batch(graphics::Renderable const& renderable) const;
+    void upload_batch() const;
+    auto batched(graphics::Renderable const& renderable) const -> BatchedRenderable const&;
+    /// Restore the GL state batch() and draw() leave behind
+    void end_batch() const;
+
+    // These only call into GL if the state differs from that set by the previous draw()
+    void use_program(Program const& prog) const;
+    void set_blend(BlendState const& blend) const;
 
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
+    glm::mat2 output_transform{1};
+    std::optional<geometry::Rectangles> damage;
+    /// The area currently being redrawn, if render() is only redrawing damage
+    std::optional<geometry::Rectangle> mutable redraw_area;
     std::vector<mir::gl::Primitive> mutable primitives;
+
+    GLuint mutable vertex_buffer{0};
+    std::vector<mir::gl::Vertex> mutable batch_vertices;
+    std::vector<BatchedPrimitive> mutable batch_primitives;
+    std::vector<BatchedRenderable> mutable batch_renderables;
+    /// Where in batch_renderables to start looking for the next renderable drawn
+    size_t mutable batch_cursor{0};
+    /// GL state set by the last draw(), or nullptr/nullopt if unknown
+    mutable Program const* current_program{nullptr};
+    std::optional<BlendState> mutable current_blend;
     std::shared_ptr<graphics::GLRenderingProvider> const gl_interface;
 };
 
@@ -27,8 +27,72 @@
 #include "mir/renderer/renderer.h"
 #include "occlusion.h"
 
+#include <algorithm>
+
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// How many frames of damage to remember; older buffers are redrawn completely
+size_t const max_tracked_buffer_age = 4;
+
+auto visible_area_of(mg::Renderable const& renderable) -> geom::Rectangle
+{
+    if (auto const clip = renderable.clip_area())
+    {
+        return intersection_of(renderable.screen_position(), *clip);
+    }
+    return renderable.screen_position();
+}
+
+auto display_element_for(mg::Renderable const& renderable, std::shared_ptr<mg::Framebuffer> fb) -> mg::DisplayElement
+{
+    // The whole buffer is stretched over screen_position(), which is in logical pixels
+    auto const& dest = renderable.screen_position();
+    auto const clipped_dest = visible_area_of(renderable);
+    auto const x_scale = fb->size().width.as_value() / static_cast<float>(dest.size.width.as_value());
+    auto const y_scale = fb->size().height.as_value() / static_cast<float>(dest.size.height.as_value());
+
+    geom::PointF const source_origin{
+        (clipped_dest.top_left.x.as_value() - dest.top_left.x.as_value()) * x_scale,
+        (clipped_dest.top_left.y.as_value() - dest.top_left.y.as_value()) * y_scale};
+    geom::SizeF const source_size{
+        clipped_dest.size.width.as_value() * x_scale,
+        clipped_dest.size.height.as_value() * y_scale};
+
+    return mg::DisplayElement{
+        clipped_dest,
+        geom::RectangleF{source_origin, source_size},
+        std::move(fb)
+    };
+}
+
+/// Whether the display hardware could show a renderable as it is drawn
+auto could_scan_out(mg::Renderable const& renderable) -> bool
+{
+    // Planes can't blend with a global alpha, or transform what they show
+    return renderable.alpha() >= 1.0f && renderable.transformation() == glm::mat4{1};
+}
+
+void add_damage(std::optional<geom::Rectangles>& damage, std::optional<geom::Rectangles> const& more)
+{
+    if (!damage)
+    {
+        return;
+    }
+    if (!more)
+    {
+        damage = std::nullopt;
+        return;
+    }
+    for (auto const& rect : *more)
+    {
+        damage->add(rect);
+    }
+}
+}
 
 mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     mg::DisplaySink& display_sink,
@@ -38,7 +102,9 @@ mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     display_sink(display_sink),
     renderer(renderer),
     fb_adaptor{gl_provider.make_framebuffer_provider(display_sink)},
-    report(report)
+    overlay_query{dynamic_cast<mg::OverlayQuery*>(&display_sink)},
+    report(report),
+    undrawn_damage{geom::Rectangles{}}
 {
 }
 
@@ -51,6 +117,7 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     report->began_frame(this);
 
     auto const& view_area = display_sink.view_area();
+    auto const transformation = display_sink.transformation();
     auto const& occlusions = mc::filter_occlusions_from(scene_elements, view_area);
 
     for (auto const& element : occlusions)
@@ -74,69 +141,287 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      */
     scene_elements.clear();  // Those in use are still in renderable_list
 
+    // Find how many of the topmost renderables could be scanned out directly...
     std::vector<mg::DisplayElement> framebuffers;
     framebuffers.reserve(renderable_list.size());
-
-    for (auto const& renderable : renderable_list)
+    for (auto renderable = renderable_list.rbegin(); renderable != renderable_list.rend(); ++renderable)
     {
-        auto fb = fb_adaptor->buffer_to_framebuffer(renderable->buffer());
+        if (!could_scan_out(**renderable))
+        {
+            break;
+        }
+        auto fb = fb_adaptor->buffer_to_framebuffer((*renderable)->buffer());
         if (!fb)
         {
             break;
         }
-        geometry::Rectangle clipped_dest;
-        if (renderable->clip_area())
+        framebuffers.push_back(display_element_for(**renderable, std::move(fb)));
+    }
+    // ...bottom first, as the DisplaySink expects
+    std::reverse(framebuffers.begin(), framebuffers.end());
+
+    if (framebuffers.size() == renderable_list.size())
+    {
+        auto const frame_damage = damage_since_last_frame(renderable_list, view_area, transformation);
+        if (display_sink.overlay(framebuffers))
         {
-            clipped_dest = intersection_of(renderable->screen_position(), *renderable->clip_area());
+            // The renderer's buffers missed this frame, so will need these changes next time they're drawn
+            add_damage(undrawn_damage, frame_damage);
+
+            report->renderables_in_frame(this, renderable_list);
+            report->overlaid_frame(this, framebuffers.size());
+            renderer->suspend();
         }
         else
         {
-            clipped_dest = renderable->screen_position();
+            render_and_post(renderable_list, view_area, transformation, frame_damage);
         }
-        geometry::SizeF const source_size{
-            clipped_dest.size.width.as_value(),
-            clipped_dest.size.height.as_value()};
-        geometry::PointF const source_origin{
-            clipped_dest.top_left.x.as_value() - renderable->screen_position().top_left.x.as_value(),
-            clipped_dest.top_left.y.as_value() - renderable->screen_position().top_left.y.as_value()
-        };
-
-        framebuffers.emplace_back(mg::DisplayElement{
-            renderable->screen_position(),
-            geometry::RectangleF{source_origin, source_size},
-            std::move(fb)
-        });
     }
-
-    if (framebuffers.size() == renderable_list.size() && display_sink.overlay(framebuffers))
+    else if (!framebuffers.empty() && overlay_query && transformation == glm::mat2{1} &&
+             !was_rejected(renderable_list, framebuffers))
     {
-        report->renderables_in_frame(this, renderable_list);
-        renderer->suspend();
+        auto const overlay_count = framebuffers.size();
+        mg::RenderableList const composited{
+            renderable_list.begin(),
+            renderable_list.end() - overlay_count};
+
+        // The renderer's frame goes underneath the overlay candidates; check that can work before drawing it
+        framebuffers.insert(
+            framebuffers.begin(),
+            mg::DisplayElement{
+                view_area,
+                geom::RectangleF{{0, 0}, {view_area.size.width.as_value(), view_area.size.height.as_value()}},
+                nullptr});
+
+        if (overlay_query->can_overlay(framebuffers))
+        {
+            /*
+             * Draw everything below the overlay candidates, and show that underneath them.
+             * The candidates are left out of the damage calculation, so a video on an overlay
+             * doesn't cause the renderer to redraw its area every frame.
+             */
+            auto const frame_damage = damage_since_last_frame(composited, view_area, transformation);
+
+            renderer->set_output_transform(transformation);
+            renderer->set_viewport(view_area);
+            renderer->set_damage(damage_to_redraw(frame_damage));
+
+            framebuffers.front().buffer = renderer->render(composited);
+
+            if (display_sink.overlay(framebuffers))
+            {
+                rejected_overlays.clear();
+                report->renderables_in_frame(this, renderable_list);
+                report->rendered_frame(this);
+                report->overlaid_frame(this, overlay_count);
+            }
+            else
+            {
+                // Only the finished frame could tell; this is rare, and remembered
+                reject_overlays(renderable_list, overlay_count);
+
+                // The renderer's last frame was incomplete, so needs redrawing in full
+                damage_since_last_frame(renderable_list, view_area, transformation);
+                render_and_post(renderable_list, view_area, transformation, std::nullopt);
+            }
+        }
+        else
+        {
+            // Remember this, so we don't ask every frame while nothing changes
+            reject_overlays(renderable_list, overlay_count);
+
+            auto const frame_damage = damage_since_last_frame(renderable_list, view_area, transformation);
+            render_and_post(renderable_list, view_area, transformation, frame_damage);
+        }
     }
     else
     {
-        renderer->set_output_transform(display_sink.transformation());
-        renderer->set_viewport(view_area);
+        auto const frame_damage = damage_since_last_frame(renderable_list, view_area, transformation);
+        render_and_post(renderable_list, view_area, transformation, frame_damage);
+    }
 
-        display_sink.set_next_image(renderer->render(renderable_list));
+    report->finished_frame(this);
+    return true;
+}
 
-        report->renderables_in_frame(this, renderable_list);
-        report->rendered_frame(this);
+void mc::DefaultDisplayBufferCompositor::render_and_post(
+    mg::RenderableList& renderable_list,
+    geom::Rectangle const& view_area,
+    glm::mat2 const& transformation,
+    std::optional<geom::Rectangles> const& frame_damage)
+{
+    renderer->set_output_transform(transformation);
+    renderer->set_viewport(view_area);
+    renderer->set_damage(damage_to_redraw(frame_damage));
 
-        /*
-         * This is used for the 'early release' optimization to release buffers
-         * we did use back to clients before starting on the potentially slow
-         * post() call.
-         * FIXME: This clear() call is blocking a little because we drive IPC
-         *        here (LP: #1395421). However if the early release
-         *        optimization is disabled or absent (LP: #1561418) then this
-         *        clear() doesn't contribute anything. In that case the
-         *        problematic IPC (LP: #1395421) will instead occur in buffer
-         *        acquisition calls when we composite the next frame.
-         */
-        renderable_list.clear();
+    display_sink.set_next_image(renderer->render(renderable_list));
+
+    report->renderables_in_frame(this, renderable_list);
+    report->rendered_frame(this);
+
+    /*
+     * This is used for the 'early release' optimization to release buffers
+     * we did use back to clients before starting on the potentially slow
+     * post() call.
+     * FIXME: This clear() call is blocking a little because we drive IPC
+     *        here (LP: #1395421). However if the early release
+     *        optimization is disabled or absent (LP: #1561418) then this
+     *        clear() doesn't contribute anything. In that case the
+     *        problematic IPC (LP: #1395421) will instead occur in buffer
+     *        acquisition calls when we composite the next frame.
+     */
+    renderable_list.clear();
+}
+
+void mc::DefaultDisplayBufferCompositor::reject_overlays(
+    mg::RenderableList const& renderables,
+    size_t overlay_count)
+{
+    rejected_overlays.clear();
+    for (auto i = renderables.size() - overlay_count; i != renderables.size(); ++i)
+    {
+        rejected_overlays.emplace_back(renderables[i]->id(), renderables[i]->screen_position());
     }
+}
 
-    report->finished_frame(this);
+auto mc::DefaultDisplayBufferCompositor::was_rejected(
+    mg::RenderableList const& renderables,
+    std::vector<mg::DisplayElement> const& overlays) const -> bool
+{
+    if (rejected_overlays.size() != overlays.size())
+    {
+        return false;
+    }
+
+    auto const first_overlay = renderables.size() - overlays.size();
+    for (auto i = 0u; i != rejected_overlays.size(); ++i)
+    {
+        auto const& renderable = renderables[first_overlay + i];
+        if (rejected_overlays[i] != std::make_pair(renderable->id(), renderable->screen_position()))
+        {
+            return false;
+        }
+    }
     return true;
 }
+
+auto mc::DefaultDisplayBufferCompositor::damage_since_last_frame(
+    mg::RenderableList const& renderables,
+    geom::Rectangle const& view_area,
+    glm::mat2 const& transformation) -> std::optional<geom::Rectangles>
+{
+    std::vector<CompositedRenderable> this_frame;
+    this_frame.reserve(renderables.size());
+    bool transformed{false};
+    for (auto const& renderable : renderables)
+    {
+        // Note: this also claims every buffer we composite, whether or not it is redrawn
+        auto const buffer = renderable->buffer();
+        this_frame.push_back(CompositedRenderable{
+            renderable->id(),
+            visible_area_of(*renderable),
+            renderable->alpha(),
+            buffer ? buffer->id() : mg::BufferID{}});
+
+        // We don't know where a transformed renderable ends up on screen
+        transformed = transformed || renderable->transformation() != glm::mat4{1};
+    }
+
+    auto const previous_frame = std::exchange(last_frame, std::move(this_frame));
+    bool const output_changed = last_view_area != view_area || last_transformation != transformation;
+    last_view_area = view_area;
+    last_transformation = transformation;
+
+    if (output_changed || transformed)
+    {
+        return std::nullopt;
+    }
+
+    geom::Rectangles damage;
+    auto const find_previous = [&previous_frame](mg::Renderable::ID id)
+        {
+            return std::find_if(
+                previous_frame.begin(),
+                previous_frame.end(),
+                [id](auto const& composited) { return composited.id == id; });
+        };
+
+    auto last_previous_index = previous_frame.begin();
+    for (auto i = 0u; i != renderables.size(); ++i)
+    {
+        auto const& current = last_frame[i];
+        auto const previous = find_previous(current.id);
+
+        if (previous == previous_frame.end())
+        {
+            damage.add(current.area);
+            continue;
+        }
+
+        if (previous < last_previous_index)
+        {
+            // The stacking order has changed; don't try to work out what that exposes
+            return std::nullopt;
+        }
+        last_previous_index = previous + 1;
+
+        if (previous->area != current.area || previous->alpha != current.alpha)
+        {
+            damage.add(previous->area);
+            damage.add(current.area);
+        }
+        else if (auto const content_damage = renderables[i]->damage())
+        {
+            for (auto const& rect : *content_damage)
+            {
+                damage.add(intersection_of(rect, current.area));
+            }
+        }
+        else if (previous->buffer != current.buffer)
+        {
+            damage.add(current.area);
+        }
+    }
+
+    for (auto const& previous : previous_frame)
+    {
+        auto const still_composited = std::any_of(
+            last_frame.begin(),
+            last_frame.end(),
+            [&previous](auto const& current) { return current.id == previous.id; });
+
+        if (!still_composited)
+        {
+            damage.add(previous.area);
+        }
+    }
+
+    return damage;
+}
+
+auto mc::DefaultDisplayBufferCompositor::damage_to_redraw(std::optional<geom::Rectangles> const& frame_damage)
+    -> std::optional<geom::Rectangles>
+{
+    auto damage = std::exchange(undrawn_damage, geom::Rectangles{});
+    add_damage(damage, frame_damage);
+
+    damage_history.push_front(damage);
+    if (damage_history.size() > max_tracked_buffer_age)
+    {
+        damage_history.pop_back();
+    }
+
+    auto const age = renderer->buffer_age();
+    if (age == 0 || age > damage_history.size())
+    {
+        return std::nullopt;
+    }
+
+    // A buffer of age N last held the frame N frames ago, so needs the damage of every frame since
+    std::optional<geom::Rectangles> to_redraw{geom::Rectangles{}};
+    for (auto i = 0u; i != age; ++i)
+    {
+        add_damage(to_redraw, damage_history[i]);
+    }
+    return to_redraw;
+}
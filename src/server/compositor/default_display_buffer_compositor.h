@@ -19,7 +19,17 @@
 
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/graphics/platform.h"
+#include "mir/graphics/display_sink.h"
+#include "mir/graphics/renderable.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/geometry/rectangles.h"
+
+#include <glm/glm.hpp>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace mir
 {
@@ -27,10 +37,6 @@ namespace compositor
 {
 class CompositorReport;
 }
-namespace graphics
-{
-class DisplaySink;
-}
 namespace renderer
 {
 class Renderer;
@@ -52,11 +58,56 @@ public:
     bool composite(SceneElementSequence&& scene_sequence) override;
 
 private:
+    /// What was composited of a renderable, so we can tell what has changed in the next frame
+    struct CompositedRenderable
+    {
+        graphics::Renderable::ID id;
+        geometry::Rectangle area;
+        float alpha;
+        graphics::BufferID buffer;
+    };
+
+    /// The region of the output that has changed since the last composite(), or std::nullopt for all of it
+    auto damage_since_last_frame(
+        graphics::RenderableList const& renderables,
+        geometry::Rectangle const& view_area,
+        glm::mat2 const& transformation) -> std::optional<geometry::Rectangles>;
+
+    /// Draw everything with the renderer, and post the result to the display
+    void render_and_post(
+        graphics::RenderableList& renderable_list,
+        geometry::Rectangle const& view_area,
+        glm::mat2 const& transformation,
+        std::optional<geometry::Rectangles> const& frame_damage);
+
+    /// Whether the display sink has already refused the topmost renderables as overlays, where they are
+    auto was_rejected(
+        graphics::RenderableList const& renderables,
+        std::vector<graphics::DisplayElement> const& overlays) const -> bool;
+
+    /// Remember that the display sink refused the topmost \p overlay_count renderables as overlays
+    void reject_overlays(graphics::RenderableList const& renderables, size_t overlay_count);
+
+    /// The region the renderer needs to redraw, given the age of the buffer it is about to draw into
+    auto damage_to_redraw(std::optional<geometry::Rectangles> const& frame_damage) -> std::optional<geometry::Rectangles>;
+
     graphics::DisplaySink& display_sink;
     std::shared_ptr<renderer::Renderer> const renderer;
     std::unique_ptr<graphics::RenderingProvider::FramebufferProvider> const fb_adaptor;
+    /// How to ask display_sink whether it can show overlays above a frame before it's rendered, if it can
+    graphics::OverlayQuery* const overlay_query;
     std::shared_ptr<compositor::CompositorReport> const report;
     bool completed_first_render = false;
+
+    std::vector<CompositedRenderable> last_frame;
+    std::optional<geometry::Rectangle> last_view_area;
+    glm::mat2 last_transformation{1};
+    /// Changes since the renderer last drew a frame (frames composited entirely with overlays don't draw)
+    std::optional<geometry::Rectangles> undrawn_damage;
+    /// Damage of the frames the renderer has drawn, most recent first
+    std::deque<std::optional<geometry::Rectangles>> damage_history;
+    /// The overlays (bottom first) the display sink last refused to show above the renderer's output
+    std::vector<std::pair<graphics::Renderable::ID, geometry::Rectangle>> rejected_overlays;
 };
 
 }
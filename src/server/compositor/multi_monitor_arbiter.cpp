@@ -20,6 +20,7 @@
 #include "mir/graphics/buffer.h"
 #include "mir/frontend/event_sink.h"
 #include "mir/graphics/drm_formats.h"
+#include "mir/recycling_pool.h"
 #include "multi_threaded_compositor.h"
 #include <boost/throw_exception.hpp>
 #include <algorithm>
@@ -35,24 +36,34 @@ struct mc::MultiMonitorArbiter::Submission
     std::shared_ptr<mg::Buffer> buffer;
     geom::Size output_size;
     geom::RectangleD source_sample;
+    std::optional<geom::Rectangles> damage;
 };
 
-namespace
-{
-class TrackingSubmission : public mc::BufferStream::Submission
+class mc::MultiMonitorArbiter::TrackingSubmission : public mc::BufferStream::Submission
 {
 public:
     TrackingSubmission(
-        std::shared_ptr<mc::MultiMonitorArbiter::Submission> submission,
-        std::function<void()> on_claimed)
-        : submission{std::move(submission)},
-          on_claimed{std::move(on_claimed)}
+        std::shared_ptr<MultiMonitorArbiter> arbiter,
+        std::shared_ptr<MultiMonitorArbiter::Submission> submission,
+        std::optional<geom::Rectangles> damage,
+        CompositorID id)
+        : arbiter{std::move(arbiter)},
+          submission{std::move(submission)},
+          damage_{std::move(damage)},
+          id{id}
     {
     }
 
     auto claim_buffer() -> std::shared_ptr<mg::Buffer> override
     {
-        on_claimed();
+        auto state = arbiter->state.lock();
+        // Ensure we still have the same state
+        if (state->current_submission == submission)
+        {
+            // The compositor is now a user of the current buffer
+            // This means we will try to give it a new buffer next time it asks
+            add_current_buffer_user(*state, id);
+        }
         return submission->buffer;
     }
 
@@ -70,10 +81,26 @@ public:
     {
         return mg::DRMFormat::from_mir_format(submission->buffer->pixel_format());
     }
+
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        return damage_;
+    }
 private:
-    std::shared_ptr<mc::MultiMonitorArbiter::Submission> submission;
-    std::function<void()> on_claimed;
+    std::shared_ptr<MultiMonitorArbiter> const arbiter;
+    std::shared_ptr<MultiMonitorArbiter::Submission> const submission;
+    std::optional<geom::Rectangles> const damage_;
+    CompositorID const id;
 };
+
+namespace
+{
+/// The storage for submissions handed out on this thread; each compositor has its own thread
+auto submission_pool() -> std::shared_ptr<mir::RecyclingPool> const&
+{
+    thread_local auto const pool = std::make_shared<mir::RecyclingPool>();
+    return pool;
+}
 }
 
 mc::MultiMonitorArbiter::MultiMonitorArbiter()
@@ -100,6 +127,7 @@ auto mc::MultiMonitorArbiter::compositor_acquire(compositor::CompositorID id)
             // Advance the current buffer
             current_state->current_submission = std::move(current_state->next_submission);
             current_state->next_submission = nullptr;
+            current_state->previous_buffer_users = current_state->current_buffer_users;
             clear_current_users(*current_state);
         }
         // Otherwise leave the current buffer alone
@@ -109,26 +137,41 @@ auto mc::MultiMonitorArbiter::compositor_acquire(compositor::CompositorID id)
     if (!current_state->current_submission)
         BOOST_THROW_EXCEPTION(std::logic_error("no buffer to give to compositor"));
 
-    return std::make_shared<TrackingSubmission>(
+    return std::allocate_shared<TrackingSubmission>(
+        submission_pool()->allocator<TrackingSubmission>(),
+        shared_from_this(),
         current_state->current_submission,
-        [me = shared_from_this(), submission = current_state->current_submission, id]()
-        {
-            auto state = me->state.lock();
-            // Ensure we still have the same state
-            if (state->current_submission != submission)
-                return;
-            // The compositor is now a user of the current buffer
-            // This means we will try to give it a new buffer next time it asks
-            add_current_buffer_user(*state, id);
-        });
+        damage_for(*current_state, id),
+        id);
 }
 
 void mc::MultiMonitorArbiter::submit_buffer(
     std::shared_ptr<mg::Buffer> buffer,
     geom::Size output_size,
-    geom::RectangleD source)
+    geom::RectangleD source,
+    std::optional<geom::Rectangles> damage)
 {
-    state.lock()->next_submission = std::make_shared<Submission>(std::move(buffer), output_size, source);
+    auto current_state = state.lock();
+
+    // A scheduled buffer that no compositor has seen is being replaced, so
+    // its changes need to be carried forward into the new submission.
+    if (auto const& replaced = current_state->next_submission; replaced && damage)
+    {
+        if (replaced->damage)
+        {
+            for (auto const& rect : *replaced->damage)
+            {
+                damage->add(rect);
+            }
+        }
+        else
+        {
+            damage = std::nullopt;
+        }
+    }
+
+    current_state->next_submission =
+        std::make_shared<Submission>(std::move(buffer), output_size, source, std::move(damage));
 }
 
 bool mc::MultiMonitorArbiter::buffer_ready_for(mc::CompositorID id)
@@ -179,6 +222,36 @@ bool mc::MultiMonitorArbiter::is_user_of_current_buffer(State& state, mir::compo
         });
 }
 
+bool mc::MultiMonitorArbiter::was_user_of_previous_buffer(State& state, mir::compositor::CompositorID id)
+{
+    return std::any_of(
+        state.previous_buffer_users.begin(),
+        state.previous_buffer_users.end(),
+        [id](auto const& slot)
+        {
+            if (slot)
+            {
+                return *slot == id;
+            }
+            return false;
+        });
+}
+
+auto mc::MultiMonitorArbiter::damage_for(State& state, mc::CompositorID id) -> std::optional<geom::Rectangles>
+{
+    if (is_user_of_current_buffer(state, id))
+    {
+        // This compositor has already claimed this buffer; nothing has changed for it
+        return geom::Rectangles{};
+    }
+    if (was_user_of_previous_buffer(state, id))
+    {
+        return state.current_submission->damage;
+    }
+    // This compositor has missed at least one submission, so we can't say what has changed
+    return std::nullopt;
+}
+
 void mc::MultiMonitorArbiter::clear_current_users(State& state)
 {
     for (auto& slot : state.current_buffer_users)
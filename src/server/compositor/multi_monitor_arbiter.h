@@ -21,6 +21,7 @@
 #include "mir/compositor/compositor_id.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/geometry/forward.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/synchronised.h"
 #include <memory>
 #include <vector>
@@ -42,16 +43,26 @@ public:
     auto compositor_acquire(compositor::CompositorID id) -> std::shared_ptr<BufferStream::Submission>;
     bool buffer_ready_for(compositor::CompositorID id);
 
+    /**
+     * \param [in] damage  Region of the buffer that changed since the previous submission,
+     *                      or std::nullopt if the whole buffer has changed
+     */
     void submit_buffer(
         std::shared_ptr<graphics::Buffer> buffer,
         geometry::Size output_size,
-        geometry::RectangleD source_sample);
+        geometry::RectangleD source_sample,
+        std::optional<geometry::Rectangles> damage = std::nullopt);
 
     struct Submission;
 private:
+    class TrackingSubmission;
+
     struct State
     {
         std::vector<std::optional<compositor::CompositorID>> current_buffer_users;
+        /// Compositors that had claimed the submission replaced by current_submission;
+        /// the damage of current_submission is only meaningful to these.
+        std::vector<std::optional<compositor::CompositorID>> previous_buffer_users;
         std::shared_ptr<Submission> current_submission;
         std::shared_ptr<Submission> next_submission;
     };
@@ -59,6 +70,8 @@ private:
 
     static void add_current_buffer_user(State& state, compositor::CompositorID id);
     static bool is_user_of_current_buffer(State& state, compositor::CompositorID id);
+    static bool was_user_of_previous_buffer(State& state, compositor::CompositorID id);
+    static auto damage_for(State& state, compositor::CompositorID id) -> std::optional<geometry::Rectangles>;
     static void clear_current_users(State& state);
 };
 
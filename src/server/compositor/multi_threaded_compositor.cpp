@@ -115,6 +115,9 @@ public:
 
         started.set_value();
 
+        std::vector<CompositorReport::SubCompositorId> composited;
+        composited.reserve(compositors.size());
+
         try
         {
             while (running)
@@ -128,18 +131,24 @@ public:
                  */
                 if (running)
                 {
-                    bool needs_post = false;
+                    composited.clear();
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
+                        report->began_scene_snapshot(compositor.get());
                         if (compositor->composite(scene->scene_elements_for(compositor.get())))
-                            needs_post = true;
+                            composited.push_back(compositor.get());
                     }
 
                     // We can skip the post if none of the compositors ended up compositing
-                    if (needs_post)
+                    if (!composited.empty())
+                    {
                         group.post();
 
+                        for (auto const id : composited)
+                            report->posted_frame(id);
+                    }
+
                     /*
                      * "Predictive bypass" optimization: If the last frame was
                      * bypassed/overlayed or you simply have a fast GPU, it is
@@ -15,6 +15,7 @@
  */
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "occlusion.h"
@@ -27,37 +28,114 @@ using namespace mir::compositor;
 
 namespace
 {
+bool is_empty(Rectangle const& rect)
+{
+    return rect.size.width <= Width{0} || rect.size.height <= Height{0};
+}
+
+/// Appends the parts of \a rect not covered by \a hole to \a result
+void subtract(Rectangle const& rect, Rectangle const& hole, std::vector<Rectangle>& result)
+{
+    auto const overlap = intersection_of(rect, hole);
+    if (is_empty(overlap))
+    {
+        result.push_back(rect);
+        return;
+    }
+
+    Rectangle const above{rect.top_left, {rect.size.width, as_height(overlap.top() - rect.top())}};
+    Rectangle const below{
+        {rect.left(), overlap.bottom()},
+        {rect.size.width, as_height(rect.bottom() - overlap.bottom())}};
+    Rectangle const left{{rect.left(), overlap.top()}, {as_width(overlap.left() - rect.left()), overlap.size.height}};
+    Rectangle const right{
+        {overlap.right(), overlap.top()},
+        {as_width(rect.right() - overlap.right()), overlap.size.height}};
+
+    for (auto const& piece : {above, below, left, right})
+    {
+        if (!is_empty(piece))
+            result.push_back(piece);
+    }
+}
+
+/// The union of a set of rectangles, stored as non-overlapping pieces
+class Region
+{
+public:
+    void add(Rectangle const& rect)
+    {
+        for (auto const& piece : uncovered_parts_of(rect))
+            pieces.add(piece);
+    }
+
+    bool contains(Rectangle const& rect) const
+    {
+        return uncovered_parts_of(rect).empty();
+    }
+
+private:
+    std::vector<Rectangle> uncovered_parts_of(Rectangle const& rect) const
+    {
+        std::vector<Rectangle> uncovered{rect};
+        std::vector<Rectangle> remainder;
+
+        for (auto const& piece : pieces)
+        {
+            if (uncovered.empty())
+                break;
+
+            remainder.clear();
+            for (auto const& r : uncovered)
+                subtract(r, piece, remainder);
+            uncovered.swap(remainder);
+        }
+
+        return uncovered;
+    }
+
+    Rectangles pieces;
+};
+
 bool renderable_is_occluded(
     Renderable const& renderable, 
     Rectangle const& area,
-    std::vector<Rectangle>& coverage)
+    Region& coverage)
 {
     static glm::mat4 const identity(1);
-    static Rectangle const empty{};
 
     if (renderable.transformation() != identity)
         return false;  // Weirdly transformed. Assume never occluded.
 
     auto const& window = renderable.screen_position();
-    auto const& clipped_window = intersection_of(window, area);
+    auto visible_area = intersection_of(window, area);
+    if (auto const clip = renderable.clip_area())
+        visible_area = intersection_of(visible_area, clip.value());
 
-    if (clipped_window == empty)
+    if (is_empty(visible_area))
         return true;  // Not in the area; definitely occluded.
 
-    bool occluded = false;
-    for (auto const& r : coverage)
+    if (coverage.contains(visible_area))
+        return true;
+
+    if (renderable.alpha() == 1.0f)
     {
-        if (r.contains(clipped_window))
+        if (!renderable.shaped())
+        {
+            coverage.add(visible_area);
+        }
+        else
         {
-            occluded = true;
-            break;
+            for (auto const& opaque : renderable.opaque_region())
+            {
+                auto const visible_opaque = intersection_of(opaque, visible_area);
+                if (!is_empty(visible_opaque))
+                    coverage.add(visible_opaque);
+            }
         }
     }
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
-
-    return occluded;
+    return false;
 }
 }
 
@@ -66,7 +144,7 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
     Rectangle const& area)
 {
     SceneElementSequence occluded;
-    std::vector<Rectangle> coverage;
+    Region coverage;
 
     auto it = elements.rbegin();
     while (it != elements.rend())
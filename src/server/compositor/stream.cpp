@@ -40,11 +40,29 @@ void mc::Stream::submit_buffer(
     std::shared_ptr<mg::Buffer> const& buffer,
     geom::Size dst_size,
     geom::RectangleD src_bounds)
+{
+    submit(buffer, dst_size, src_bounds, std::nullopt);
+}
+
+void mc::Stream::submit_buffer(
+    std::shared_ptr<mg::Buffer> const& buffer,
+    geom::Size dst_size,
+    geom::RectangleD src_bounds,
+    geom::Rectangles const& damage)
+{
+    submit(buffer, dst_size, src_bounds, damage);
+}
+
+void mc::Stream::submit(
+    std::shared_ptr<mg::Buffer> const& buffer,
+    geom::Size dst_size,
+    geom::RectangleD src_bounds,
+    std::optional<geom::Rectangles> const& damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
 
-    arbiter->submit_buffer(buffer, dst_size, src_bounds);
+    arbiter->submit_buffer(buffer, dst_size, src_bounds, damage);
     first_frame_posted = true;
     {
         (*frame_callback.lock())(buffer->size());
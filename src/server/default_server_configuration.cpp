@@ -23,6 +23,8 @@
 #include "mir/frontend/wayland.h"
 
 #include "mir/logging/dumb_console_logger.h"
+#include "mir/logging/async_logger.h"
+#include "mir/abnormal_exit.h"
 #include "mir/options/program_option.h"
 #include "mir/frontend/session_credentials.h"
 #include "mir/frontend/session_authorizer.h"
@@ -194,9 +196,28 @@ auto mir::DefaultServerConfiguration::the_logger()
     -> std::shared_ptr<ml::Logger>
 {
     return logger(
-        []() -> std::shared_ptr<ml::Logger>
-        {
-            return std::make_shared<ml::DumbConsoleLogger>();
+        [this]() -> std::shared_ptr<ml::Logger>
+        {
+            auto const console_logger = std::make_shared<ml::DumbConsoleLogger>();
+
+            auto const async_logging = the_options()->get<std::string>(options::async_logging_opt);
+            if (async_logging == options::off_opt_value)
+            {
+                return console_logger;
+            }
+            else if (async_logging == "drop")
+            {
+                return std::make_shared<ml::AsyncLogger>(console_logger, ml::AsyncLogger::WhenFull::drop);
+            }
+            else if (async_logging == "block")
+            {
+                return std::make_shared<ml::AsyncLogger>(console_logger, ml::AsyncLogger::WhenFull::block);
+            }
+            else
+            {
+                throw AbnormalExit(std::string("Invalid ") + options::async_logging_opt + " option: " +
+                    async_logging + " (valid options are: \"" + options::off_opt_value + "\", \"drop\" and \"block\")");
+            }
         });
 }
 
@@ -0,0 +1,122 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pointer_motion_coalescer.h"
+
+#include "mir/executor.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
+#include "mir/events/pointer_event.h"
+
+#include <optional>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+template<typename Tag>
+auto has_scroll(mir::events::ScrollAxis<Tag> const& axis) -> bool
+{
+    return axis.precise.as_value() || axis.discrete.as_value() || axis.value120.as_value() || axis.stop;
+}
+}
+
+struct mf::PointerMotionCoalescer::State
+{
+    State(std::function<void(Motion const&)>&& send)
+        : send{std::move(send)}
+    {
+    }
+
+    void flush()
+    {
+        if (pending)
+        {
+            auto const motion = pending.value();
+            pending.reset();
+            send(motion);
+        }
+    }
+
+    std::function<void(Motion const&)> const send;
+    std::optional<Motion> pending;
+};
+
+mf::PointerMotionCoalescer::PointerMotionCoalescer(
+    time::AlarmFactory& alarm_factory,
+    Executor& wayland_executor,
+    std::chrono::milliseconds deadline,
+    std::function<void(Motion const&)>&& send)
+    : state{std::make_shared<State>(std::move(send))},
+      deadline_alarm{alarm_factory.create_alarm(
+          [weak_state = std::weak_ptr<State>{state}, &wayland_executor]()
+          {
+              // The alarm fires on the main loop, but held-back motion is only touched on the Wayland thread
+              wayland_executor.spawn([weak_state]()
+                  {
+                      if (auto const state = weak_state.lock())
+                      {
+                          state->flush();
+                      }
+                  });
+          })},
+      deadline{deadline}
+{
+}
+
+mf::PointerMotionCoalescer::~PointerMotionCoalescer() = default;
+
+auto mf::PointerMotionCoalescer::can_hold(MirPointerEvent const& event) -> bool
+{
+    return mir_pointer_event_action(&event) == mir_pointer_action_motion &&
+           !has_scroll(event.h_scroll()) &&
+           !has_scroll(event.v_scroll());
+}
+
+void mf::PointerMotionCoalescer::hold_position(uint32_t timestamp)
+{
+    hold(timestamp).absolute = true;
+}
+
+void mf::PointerMotionCoalescer::hold_relative(uint32_t timestamp, double dx, double dy)
+{
+    auto& motion = hold(timestamp);
+    motion.relative_x += dx;
+    motion.relative_y += dy;
+}
+
+auto mf::PointerMotionCoalescer::holding() const -> bool
+{
+    return state->pending.has_value();
+}
+
+void mf::PointerMotionCoalescer::flush()
+{
+    deadline_alarm->cancel();
+    state->flush();
+}
+
+auto mf::PointerMotionCoalescer::hold(uint32_t timestamp) -> Motion&
+{
+    if (!state->pending)
+    {
+        // The deadline runs from the oldest motion held back, so a steady stream of motion can't starve the client
+        state->pending = Motion{};
+        deadline_alarm->reschedule_in(deadline);
+    }
+    state->pending->timestamp = timestamp;
+    return state->pending.value();
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_POINTER_MOTION_COALESCER_H
+#define MIR_FRONTEND_POINTER_MOTION_COALESCER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+struct MirPointerEvent;
+
+namespace mir
+{
+class Executor;
+
+namespace time
+{
+class Alarm;
+class AlarmFactory;
+}
+
+namespace frontend
+{
+/// Merges pointer motion that is held back from a client into a single update. Held-back motion is sent when flush()
+/// is called, or on the Wayland thread once the deadline passes, whichever comes first.
+class PointerMotionCoalescer
+{
+public:
+    /// Motion held back since the last flush
+    struct Motion
+    {
+        uint32_t timestamp{0};
+        bool absolute{false}; ///< The pointer position has changed and not been sent
+        double relative_x{0};
+        double relative_y{0};
+    };
+
+    /// send is only ever called on the Wayland thread, and never after this is destroyed
+    PointerMotionCoalescer(
+        time::AlarmFactory& alarm_factory,
+        Executor& wayland_executor,
+        std::chrono::milliseconds deadline,
+        std::function<void(Motion const&)>&& send);
+    ~PointerMotionCoalescer();
+
+    /// If the event is plain motion that may be held back. Anything else (buttons, scrolling, enter, leave) must not
+    /// overtake the motion before it, so flush() has to be called first.
+    static auto can_hold(MirPointerEvent const& event) -> bool;
+
+    /// Hold back a change of absolute position
+    void hold_position(uint32_t timestamp);
+    /// Hold back relative motion, adding it to any already held back
+    void hold_relative(uint32_t timestamp, double dx, double dy);
+    auto holding() const -> bool;
+    /// Sends any held-back motion now
+    void flush();
+
+private:
+    struct State;
+
+    auto hold(uint32_t timestamp) -> Motion&;
+
+    std::shared_ptr<State> const state; ///< shared_ptr so the deadline can check it still exists
+    std::unique_ptr<time::Alarm> const deadline_alarm;
+    std::chrono::milliseconds const deadline;
+};
+}
+}
+
+#endif // MIR_FRONTEND_POINTER_MOTION_COALESCER_H
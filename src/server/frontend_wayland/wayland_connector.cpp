@@ -239,6 +239,7 @@ mf::WaylandConnector::WaylandConnector(
     std::unique_ptr<WaylandExtensions> extensions_,
     WaylandProtocolExtensionFilter const& extension_filter,
     bool enable_key_repeat,
+    bool coalesce_pointer_motion,
     std::shared_ptr<scene::SessionLock> const& session_lock,
     std::shared_ptr<mir::DecorationStrategy> const& decoration_strategy)
     : extension_filter{extension_filter},
@@ -289,10 +290,12 @@ mf::WaylandConnector::WaylandConnector(
         display.get(),
         *executor,
         clock,
+        main_loop,
         input_hub,
         keyboard_observer_registrar,
         seat,
-        enable_key_repeat);
+        enable_key_repeat,
+        coalesce_pointer_motion);
     output_manager = std::make_unique<mf::OutputManager>(
         display.get(),
         executor,
@@ -163,6 +163,7 @@ public:
         std::unique_ptr<WaylandExtensions> extensions,
         WaylandProtocolExtensionFilter const& extension_filter,
         bool enable_key_repeat,
+        bool coalesce_pointer_motion,
         std::shared_ptr<scene::SessionLock> const& session_lock,
         std::shared_ptr<DecorationStrategy> const& decoration_strategy);
 
@@ -347,6 +347,7 @@ std::shared_ptr<mf::Connector>
                 enabled_wayland_extensions.end()};
 
             auto const enable_repeat = options->get<bool>(options::enable_key_repeat_opt);
+            auto const coalesce_motion = options->get<bool>(options::coalesce_pointer_motion_opt);
             auto const x11_enabled = options->is_set(mo::x11_display_opt) && options->get<bool>(mo::x11_display_opt);
 
             return std::make_shared<mf::WaylandConnector>(
@@ -376,6 +377,7 @@ std::shared_ptr<mf::Connector>
                     wayland_extension_hooks),
                 wayland_extension_filter,
                 enable_repeat,
+                coalesce_motion,
                 the_session_lock(),
                 the_decoration_strategy());
         });
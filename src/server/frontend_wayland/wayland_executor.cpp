@@ -19,13 +19,17 @@
 #include "mir/fd.h"
 #include "mir/log.h"
 
+#include "wayland_frontend.tp.h"
+
 #include <sys/eventfd.h>
 
 #include <boost/throw_exception.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <cstring>
-#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <system_error>
 
@@ -53,6 +57,17 @@ private:
         TerminationRequested,
         Stopped
     };
+
+    using Clock = std::chrono::steady_clock;
+
+    /// A node of the incoming work list. Nodes are recycled rather than freed once their work has run.
+    struct Task
+    {
+        std::function<void()> work;
+        Clock::time_point queued_at;
+        Task* next{nullptr};
+    };
+
 public:
     explicit State(wl_event_loop* loop)
         : loop{loop}
@@ -64,21 +79,56 @@ public:
             });
     }
 
-    void enqueue(std::function<void()>&& work)
+    ~State()
+    {
+        discard(take_all());
+        delete_all(spare);
+    }
+
+    /// Returns false if the event loop has already been notified of pending work
+    auto enqueue(std::function<void()>&& work) -> bool
     {
         if (on_wayland_thread)
         {
             work();
-            return;
+            return true;
         }
 
-        std::lock_guard lock{mutex};
-        if (state == ExecutionState::Running)
-        {
-            workqueue.emplace_back(std::move(work));
-        }
         // If we've been terminated then drop the work on the floor, letting the
         // std::function destructor clean up any necessary state.
+        if (state.load(std::memory_order_acquire) != ExecutionState::Running)
+        {
+            return false;
+        }
+
+        auto const task = make_task(std::move(work));
+
+        auto const depth = queue_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+        auto max_depth = max_queue_depth.load(std::memory_order_relaxed);
+        while (depth > max_depth &&
+               !max_queue_depth.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed))
+        {
+        }
+
+        // Sequentially consistent, along with the state change and take_all() in drain(), so that either drain()
+        // takes this work or we see it has stopped
+        task->next = incoming.load(std::memory_order_relaxed);
+        while (!incoming.compare_exchange_weak(task->next, task, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+        }
+
+        if (state.load() == ExecutionState::Stopped)
+        {
+            // drain() may already have discarded the queue, in which case nothing would run or drop this work until
+            // ~State. Drop it (and anything else pushed since) now, as if we'd seen the state before pushing.
+            std::lock_guard lock{mutex};
+            discard(take_all());
+            return false;
+        }
+
+        // Only the push that makes the list non-empty needs to wake the event loop: the
+        // wakeup that handles it takes everything pushed on top of it.
+        return task->next == nullptr;
     }
 
     void enqueue_termination(std::function<void()>&& terminator)
@@ -86,34 +136,69 @@ public:
         std::lock_guard lock{mutex};
         if (state == ExecutionState::Running)
         {
-            workqueue.emplace_front(std::move(terminator));
+            this->terminator = std::move(terminator);
             on_wayland_thread = false;
             state = ExecutionState::TerminationRequested;
         }
     }
 
-    std::function<void()> get_work()
+    /// Runs all the queued work, including any queued while doing so
+    void run_work()
     {
-        std::lock_guard lock{mutex};
-        if (!workqueue.empty())
+        while (auto batch = take_all())
         {
-            auto const work = std::move(workqueue.front());
-            workqueue.pop_front();
-            return work;
+            auto const oldest_wait = Clock::now() - batch->queued_at;
+            auto const first = batch;
+            int batch_size{0};
+
+            for (; batch; ++batch_size)
+            {
+                // A termination request jumps the queue
+                run_termination_if_requested();
+
+                auto const task = batch;
+                batch = task->next;
+                queue_depth.fetch_sub(1, std::memory_order_relaxed);
+                record_latency(Clock::now() - task->queued_at);
+
+                try
+                {
+                    task->work();
+                }
+                catch (...)
+                {
+                    mir::log(
+                        mir::logging::Severity::critical,
+                        MIR_LOG_COMPONENT,
+                        std::current_exception(),
+                        "Exception processing Wayland event loop work item");
+                }
+
+                // Release whatever the work captured now, rather than when the node is next used
+                task->work = nullptr;
+            }
+
+            recycle(first);
+
+            tracepoint(
+                mir_server_wayland,
+                executor_batch_drained,
+                batch_size,
+                std::chrono::duration_cast<std::chrono::microseconds>(oldest_wait).count());
         }
-        return {};
+
+        run_termination_if_requested();
     }
 
     auto drain()
     {
         std::unique_lock lock{mutex};
 
-        if (state == ExecutionState::TerminationRequested)
+        if (state == ExecutionState::TerminationRequested && terminator)
         {
-            // If we've been asked to terminate then the front of the workqueue
-            // will contain the termination request.
             {
-                std::function<void()> const work = std::move(workqueue.front());
+                std::function<void()> const work = std::move(terminator);
+                terminator = nullptr;
                 lock.unlock();
 
                 work();
@@ -123,18 +208,152 @@ public:
 
         on_wayland_thread = false;
         state = ExecutionState::Stopped;
-        workqueue.clear();
+        discard(take_all());
 
         return lock;
     }
 
+    auto statistics() const -> Statistics
+    {
+        return Statistics{
+            queue_depth.load(std::memory_order_relaxed),
+            max_queue_depth.load(std::memory_order_relaxed),
+            tasks_run.load(std::memory_order_relaxed),
+            std::chrono::nanoseconds{total_latency_ns.load(std::memory_order_relaxed)},
+            std::chrono::nanoseconds{max_latency_ns.load(std::memory_order_relaxed)}};
+    }
+
     static int on_notify(int fd, uint32_t, void* data);
 private:
+    /// Reuses a spare node if there is one, so that spawning doesn't allocate once the queue has been this deep before
+    auto make_task(std::function<void()>&& work) -> Task*
+    {
+        Task* task{nullptr};
+        {
+            std::lock_guard lock{spare_mutex};
+            if (spare)
+            {
+                task = spare;
+                spare = task->next;
+                --spare_count;
+            }
+        }
+
+        if (!task)
+        {
+            task = new Task;
+        }
+
+        task->work = std::move(work);
+        task->queued_at = Clock::now();
+        task->next = nullptr;
+        return task;
+    }
+
+    /// Keeps the run nodes (linked through next) for spawning to reuse, up to max_spare_tasks, and frees the rest
+    void recycle(Task* task)
+    {
+        {
+            std::lock_guard lock{spare_mutex};
+            while (task && spare_count < max_spare_tasks)
+            {
+                auto const next = task->next;
+                task->next = spare;
+                spare = task;
+                ++spare_count;
+                task = next;
+            }
+        }
+        delete_all(task);
+    }
+
+    static void delete_all(Task* task)
+    {
+        while (task)
+        {
+            std::unique_ptr<Task> const deleted{task};
+            task = task->next;
+        }
+    }
+
+    /// Takes everything from the incoming list, returning it in the order it was enqueued
+    auto take_all() -> Task*
+    {
+        auto task = incoming.exchange(nullptr);
+
+        Task* in_order{nullptr};
+        while (task)
+        {
+            auto const next = task->next;
+            task->next = in_order;
+            in_order = task;
+            task = next;
+        }
+        return in_order;
+    }
+
+    void discard(Task* task)
+    {
+        while (task)
+        {
+            std::unique_ptr<Task> const discarded{task};
+            task = task->next;
+            queue_depth.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void run_termination_if_requested()
+    {
+        if (state.load(std::memory_order_acquire) != ExecutionState::TerminationRequested)
+        {
+            return;
+        }
+
+        std::function<void()> work;
+        {
+            std::lock_guard lock{mutex};
+            work = std::move(terminator);
+            terminator = nullptr;
+        }
+
+        if (work)
+        {
+            work();
+        }
+    }
+
+    void record_latency(Clock::duration latency)
+    {
+        // Only the Wayland thread records latency, so these need not be read-modify-write
+        auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+        tasks_run.store(tasks_run.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total_latency_ns.store(total_latency_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if (ns > max_latency_ns.load(std::memory_order_relaxed))
+        {
+            max_latency_ns.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    /// Enough to cover a burst of spawns without allocating, without holding on to the memory of a rare deep queue
+    static size_t const max_spare_tasks{256};
+
     static thread_local bool on_wayland_thread;
-    std::mutex mutex;
-    ExecutionState state{ExecutionState::Running};
+    std::mutex mutex; ///< Guards terminator and changes to state
+    std::atomic<ExecutionState> state{ExecutionState::Running};
+    std::function<void()> terminator;
     wl_event_loop* const loop;
-    std::deque<std::function<void()>> workqueue;
+    /// Work spawned but not yet taken by the Wayland thread, most recent first
+    std::atomic<Task*> incoming{nullptr};
+    std::mutex spare_mutex; ///< Guards spare and spare_count
+    /// Nodes whose work has run, for spawning to reuse
+    Task* spare{nullptr};
+    size_t spare_count{0};
+
+    std::atomic<size_t> queue_depth{0};
+    std::atomic<size_t> max_queue_depth{0};
+    std::atomic<uint64_t> tasks_run{0};
+    std::atomic<int64_t> total_latency_ns{0};
+    std::atomic<int64_t> max_latency_ns{0};
 };
 
 thread_local bool mf::WaylandExecutor::State::on_wayland_thread{false};
@@ -231,21 +450,8 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
             err);
     }
 
-    while (auto work = state->get_work())
-    {
-        try
-        {
-            work();
-        }
-        catch (...)
-        {
-            mir::log(
-                mir::logging::Severity::critical,
-                MIR_LOG_COMPONENT,
-                std::current_exception(),
-                "Exception processing Wayland event loop work item");
-        }
-    }
+    state->run_work();
+
     if (state->state != ExecutionState::Running)
     {
         EventLoopDestroyedHandler::remove_destruction_handler_for_loop(state->loop);
@@ -258,7 +464,7 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
 
 mf::WaylandExecutor::WaylandExecutor(wl_event_loop* loop)
     : state{std::make_shared<State>(loop)},
-      notify_fd{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE | EFD_NONBLOCK)},
+      notify_fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)},
       source{wl_event_loop_add_fd(
           loop,
           notify_fd,
@@ -324,7 +530,10 @@ mf::WaylandExecutor::~WaylandExecutor()
 
 void mf::WaylandExecutor::spawn (std::function<void()>&& work)
 {
-    state->enqueue(std::move(work));
+    if (!state->enqueue(std::move(work)))
+    {
+        return;
+    }
 
     if (auto err = eventfd_write(notify_fd, 1))
     {
@@ -333,3 +542,7 @@ void mf::WaylandExecutor::spawn (std::function<void()>&& work)
     }
 }
 
+auto mf::WaylandExecutor::statistics() const -> Statistics
+{
+    return state->statistics();
+}
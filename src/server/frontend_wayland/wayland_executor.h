@@ -22,9 +22,9 @@
 
 #include <wayland-server-core.h>
 
-#include <mutex>
+#include <chrono>
+#include <cstdint>
 #include <memory>
-#include <deque>
 
 namespace mir
 {
@@ -38,6 +38,18 @@ public:
 
     void spawn(std::function<void()>&& work) override;
 
+    /// Counters for diagnosing queueing delay on the Wayland thread
+    struct Statistics
+    {
+        size_t queue_depth;             ///< Work spawned but not yet run
+        size_t max_queue_depth;         ///< The highest queue_depth seen
+        uint64_t tasks_run;             ///< Work run from the queue (work spawned on the Wayland thread runs inline)
+        std::chrono::nanoseconds total_latency; ///< Summed delay between spawn() and the work starting
+        std::chrono::nanoseconds max_latency;
+    };
+
+    auto statistics() const -> Statistics;
+
     class State;
 private:
     std::shared_ptr<State> state;
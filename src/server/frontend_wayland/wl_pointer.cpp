@@ -114,6 +114,9 @@ auto timestamp_of(std::shared_ptr<MirPointerEvent const> const& event) -> uint32
     return mir_input_event_get_wayland_timestamp(mir_pointer_event_input_event(event.get()));
 }
 
+/// How long motion may be held back for a client that is slow to draw; about one refresh period
+auto const held_motion_deadline = std::chrono::milliseconds{16};
+
 auto wayland_axis_source(MirPointerAxisSource mir_source) -> std::optional<uint32_t>
 {
     switch (mir_source)
@@ -174,9 +177,23 @@ auto mf::WlPointer::linux_button_to_mir_button(int linux_button) -> std::optiona
     return std::nullopt;
 }
 
-mf::WlPointer::WlPointer(wl_resource* new_resource)
+mf::WlPointer::WlPointer(
+    wl_resource* new_resource,
+    Executor& wayland_executor,
+    time::AlarmFactory& alarm_factory,
+    bool coalesce_motion)
     : Pointer(new_resource, Version<8>()),
-      cursor{std::make_unique<NullCursor>()}
+      cursor{std::make_unique<NullCursor>()},
+      motion_coalescer{coalesce_motion ?
+          std::make_unique<PointerMotionCoalescer>(
+              alarm_factory,
+              wayland_executor,
+              held_motion_deadline,
+              [this](PointerMotionCoalescer::Motion const& motion)
+              {
+                  send_held_motion(motion);
+              }) :
+          nullptr}
 {
 }
 
@@ -193,7 +210,19 @@ void mir::frontend::WlPointer::set_relative_pointer(mir::wayland::RelativePointe
 
 void mir::frontend::WlPointer::event(std::shared_ptr<MirPointerEvent const> const& event, WlSurface& root_surface)
 {
-    switch(mir_pointer_event_action(event.get()))
+    auto const action = mir_pointer_event_action(event.get());
+
+    defer_motion =
+        motion_coalescer &&
+        PointerMotionCoalescer::can_hold(*event) &&
+        root_surface.awaiting_frame();
+
+    if (!defer_motion)
+    {
+        flush_motion();
+    }
+
+    switch(action)
     {
         case mir_pointer_action_button_down:
         case mir_pointer_action_button_up:
@@ -216,6 +245,26 @@ void mir::frontend::WlPointer::event(std::shared_ptr<MirPointerEvent const> cons
             break;
     }
 
+    if (motion_coalescer &&
+        motion_coalescer->holding() &&
+        (!flush_on_frame_of || &flush_on_frame_of.value() != &root_surface))
+    {
+        flush_on_frame_of = mw::make_weak(&root_surface);
+        root_surface.on_next_frame([weak_self = mw::make_weak(this), surface = &root_surface]()
+            {
+                if (weak_self)
+                {
+                    auto& self = weak_self.value();
+                    if (self.flush_on_frame_of && &self.flush_on_frame_of.value() == surface)
+                    {
+                        self.flush_on_frame_of = {};
+                    }
+                    self.flush_motion();
+                }
+            });
+    }
+
+    defer_motion = false;
     maybe_frame();
 }
 
@@ -223,6 +272,7 @@ void mf::WlPointer::leave(std::optional<std::shared_ptr<MirPointerEvent const>>
 {
     if (!surface_under_cursor)
         return;
+    flush_motion();
     surface_under_cursor.value().remove_destroy_listener(destroy_listener_id);
     auto const serial = client->next_serial(event.value_or(nullptr));
     send_leave_event(
@@ -366,12 +416,19 @@ void mf::WlPointer::enter_or_motion(std::shared_ptr<MirPointerEvent const> const
             break;
 
         default:
-            send_motion_event(
-                timestamp_of(event),
-                position_on_target.x.as_value(),
-                position_on_target.y.as_value());
             current_position = position_on_target;
-            needs_frame = true;
+            if (defer_motion)
+            {
+                motion_coalescer->hold_position(timestamp_of(event));
+            }
+            else
+            {
+                send_motion_event(
+                    timestamp_of(event),
+                    position_on_target.x.as_value(),
+                    position_on_target.y.as_value());
+                needs_frame = true;
+            }
         }
     }
 }
@@ -385,7 +442,16 @@ void mf::WlPointer::relative_motion(std::shared_ptr<MirPointerEvent const> const
     auto const motion = std::make_pair(
         mir_pointer_event_axis_value(event.get(), mir_pointer_axis_relative_x),
         mir_pointer_event_axis_value(event.get(), mir_pointer_axis_relative_y));
-    if (motion.first || motion.second)
+    if (!(motion.first || motion.second))
+    {
+        return;
+    }
+
+    if (defer_motion)
+    {
+        motion_coalescer->hold_relative(timestamp_of(event), motion.first, motion.second);
+    }
+    else
     {
         auto const timestamp = timestamp_of(event);
         relative_pointer.value().send_relative_motion_event(
@@ -405,6 +471,37 @@ void mf::WlPointer::maybe_frame()
     needs_frame = false;
 }
 
+void mf::WlPointer::flush_motion()
+{
+    if (motion_coalescer)
+    {
+        motion_coalescer->flush();
+    }
+}
+
+void mf::WlPointer::send_held_motion(PointerMotionCoalescer::Motion const& motion)
+{
+    if (motion.absolute && current_position && surface_under_cursor)
+    {
+        send_motion_event(
+            motion.timestamp,
+            current_position->x.as_value(),
+            current_position->y.as_value());
+        needs_frame = true;
+    }
+
+    if (relative_pointer && (motion.relative_x || motion.relative_y))
+    {
+        relative_pointer.value().send_relative_motion_event(
+            motion.timestamp, motion.timestamp,
+            motion.relative_x, motion.relative_y,
+            motion.relative_x, motion.relative_y);
+        needs_frame = true;
+    }
+
+    maybe_frame();
+}
+
 namespace
 {
 struct CursorSurfaceRole : mf::NullWlSurfaceRole
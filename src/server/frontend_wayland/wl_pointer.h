@@ -19,6 +19,7 @@
 
 
 #include "wayland_wrapper.h"
+#include "pointer_motion_coalescer.h"
 #include "mir/wayland/weak.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
@@ -44,6 +45,11 @@ class Client;
 
 class Executor;
 
+namespace time
+{
+class AlarmFactory;
+}
+
 namespace frontend
 {
 class WlSurface;
@@ -65,7 +71,14 @@ class WlPointer : public wayland::Pointer, private CommitHandler
 public:
     static auto linux_button_to_mir_button(int linux_button) -> std::optional<MirPointerButtons>;
 
-    WlPointer(wl_resource* new_resource);
+    /// If coalesce_motion is set, motion over a surface that is waiting on a frame callback is held back and sent,
+    /// merged, just before the frame callback (or any other pointer event) is sent, or after about one refresh period
+    /// if the client is slow to draw
+    WlPointer(
+        wl_resource* new_resource,
+        Executor& wayland_executor,
+        time::AlarmFactory& alarm_factory,
+        bool coalesce_motion);
 
     ~WlPointer();
 
@@ -93,6 +106,10 @@ private:
     void relative_motion(std::shared_ptr<MirPointerEvent const> const& event);
     /// Sends a frame event only if needed, leaves needs_frame false
     void maybe_frame();
+    /// Sends any motion held back by coalescing, followed by a frame event
+    void flush_motion();
+    /// Sends motion that motion_coalescer held back
+    void send_held_motion(PointerMotionCoalescer::Motion const& motion);
     /// The cursor surface has committed
     void on_commit(WlSurface* surface) override;
 
@@ -114,6 +131,13 @@ private:
     std::unique_ptr<Cursor> cursor;
     wayland::Weak<wayland::RelativePointerV1> relative_pointer;
     geometry::Displacement cursor_hotspot;
+
+    /// Null unless motion is coalesced
+    std::unique_ptr<PointerMotionCoalescer> const motion_coalescer;
+    /// Set while handling a motion event that may be held back
+    bool defer_motion{false};
+    /// The surface whose next frame will flush held-back motion
+    wayland::Weak<WlSurface> flush_on_frame_of;
 };
 
 }
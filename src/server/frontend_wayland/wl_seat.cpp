@@ -191,10 +191,12 @@ mf::WlSeat::WlSeat(
     wl_display* display,
     Executor& wayland_executor,
     std::shared_ptr<time::Clock> const& clock,
+    std::shared_ptr<time::AlarmFactory> const& alarm_factory,
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
     std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
     std::shared_ptr<mi::Seat> const& seat,
-    bool enable_key_repeat)
+    bool enable_key_repeat,
+    bool coalesce_pointer_motion)
     :   Global(display, Version<8>()),
         keymap{std::make_shared<input::ParameterKeymap>()},
         config_observer{
@@ -210,10 +212,13 @@ mf::WlSeat::WlSeat(
         pointer_listeners{std::make_shared<ListenerList<PointerEventDispatcher>>()},
         keyboard_listeners{std::make_shared<ListenerList<WlKeyboard>>()},
         touch_listeners{std::make_shared<ListenerList<WlTouch>>()},
+        wayland_executor{wayland_executor},
         clock{clock},
+        alarm_factory{alarm_factory},
         input_hub{input_hub},
         seat{seat},
-        enable_key_repeat{enable_key_repeat}
+        enable_key_repeat{enable_key_repeat},
+        coalesce_pointer_motion{coalesce_pointer_motion}
 {
     input_hub->add_observer(config_observer);
     keyboard_observer_registrar->register_interest(keyboard_observer, wayland_executor);
@@ -313,7 +318,11 @@ mf::WlSeat::Instance::Instance(wl_resource* new_resource, mf::WlSeat* seat)
 
 void mf::WlSeat::Instance::get_pointer(wl_resource* new_pointer)
 {
-    auto const pointer = new WlPointer{new_pointer};
+    auto const pointer = new WlPointer{
+        new_pointer,
+        seat->wayland_executor,
+        *seat->alarm_factory,
+        seat->coalesce_pointer_motion};
     auto dispatcher = std::make_shared<PointerEventDispatcher>(pointer);
 
     seat->pointer_listeners->register_listener(client, dispatcher.get());
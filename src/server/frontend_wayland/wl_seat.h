@@ -41,6 +41,7 @@ class KeyboardObserver;
 namespace time
 {
 class Clock;
+class AlarmFactory;
 }
 namespace frontend
 {
@@ -73,10 +74,12 @@ public:
         wl_display* display,
         Executor& wayland_executor,
         std::shared_ptr<time::Clock> const& clock,
+        std::shared_ptr<time::AlarmFactory> const& alarm_factory,
         std::shared_ptr<mir::input::InputDeviceHub> const& input_hub,
         std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
         std::shared_ptr<mir::input::Seat> const& seat,
-        bool enable_key_repeat);
+        bool enable_key_repeat,
+        bool coalesce_pointer_motion);
 
     ~WlSeat();
 
@@ -130,10 +133,13 @@ private:
     std::shared_ptr<ListenerList<WlKeyboard>> const keyboard_listeners;
     std::shared_ptr<ListenerList<WlTouch>> const touch_listeners;
 
+    Executor& wayland_executor;
     std::shared_ptr<time::Clock> const clock;
+    std::shared_ptr<time::AlarmFactory> const alarm_factory;
     std::shared_ptr<input::InputDeviceHub> const input_hub;
     std::shared_ptr<input::Seat> const seat;
     bool const enable_key_repeat;
+    bool const coalesce_pointer_motion;
 
     void bind(wl_resource* new_wl_seat) override;
 };
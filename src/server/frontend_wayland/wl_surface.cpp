@@ -41,6 +41,7 @@
 #include "mir/log.h"
 
 #include <chrono>
+#include <cstdint>
 #include <boost/throw_exception.hpp>
 #include <wayland-server-protocol.h>
 
@@ -49,6 +50,76 @@ namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
 
+namespace
+{
+/// Clients commonly damage with INT32_MAX sized rectangles to mean "everything", so we
+/// need to be careful of overflow when clipping damage to the buffer
+auto clipped_damage(int64_t x, int64_t y, int64_t width, int64_t height, geom::Size const& bounds)
+    -> std::optional<geom::Rectangle>
+{
+    auto const left = std::max<int64_t>(x, 0);
+    auto const top = std::max<int64_t>(y, 0);
+    auto const right = std::min<int64_t>(x + width, bounds.width.as_int());
+    auto const bottom = std::min<int64_t>(y + height, bounds.height.as_int());
+
+    if (left >= right || top >= bottom)
+    {
+        return std::nullopt;
+    }
+    return geom::Rectangle{
+        {static_cast<int>(left), static_cast<int>(top)},
+        {static_cast<int>(right - left), static_cast<int>(bottom - top)}};
+}
+
+/// Combines the damage requested by the client into buffer coordinates, or std::nullopt if
+/// the client did not say what changed (so the whole buffer must be considered damaged)
+auto buffer_damage_from(mf::WlSurfaceState const& state, geom::Size const& buffer_size, int scale)
+    -> std::optional<geom::Rectangles>
+{
+    if (state.surface_damage.empty() && state.buffer_damage.empty())
+    {
+        return std::nullopt;
+    }
+
+    geom::Rectangles damage;
+    for (auto const& rect : state.surface_damage)
+    {
+        auto const clipped = clipped_damage(
+            int64_t{rect.left().as_int()} * scale,
+            int64_t{rect.top().as_int()} * scale,
+            int64_t{rect.size.width.as_int()} * scale,
+            int64_t{rect.size.height.as_int()} * scale,
+            buffer_size);
+
+        if (clipped)
+        {
+            damage.add(*clipped);
+        }
+    }
+    for (auto const& rect : state.buffer_damage)
+    {
+        auto const clipped = clipped_damage(
+            rect.left().as_int(),
+            rect.top().as_int(),
+            rect.size.width.as_int(),
+            rect.size.height.as_int(),
+            buffer_size);
+
+        if (clipped)
+        {
+            damage.add(*clipped);
+        }
+    }
+
+    if (damage.size() == 0)
+    {
+        // The new buffer still needs drawing, or the client will never get its frame callbacks
+        return std::nullopt;
+    }
+    return damage;
+}
+}
+
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()}
 {
@@ -68,10 +139,16 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    surface_damage.insert(end(surface_damage), begin(source.surface_damage), end(source.surface_damage));
+    buffer_damage.insert(end(buffer_damage), begin(source.buffer_damage), end(source.buffer_damage));
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -80,6 +157,7 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 {
     return offset ||
            input_shape ||
+           opaque_region ||
            surface_data_invalidated;
 }
 
@@ -210,8 +288,16 @@ void mf::WlSurface::populate_surface_data(std::vector<shell::StreamSpecification
 {
     geometry::Displacement offset = parent_offset + offset_;
 
-    buffer_streams.push_back(msh::StreamSpecification{stream, offset});
     geom::Rectangle surface_rect = {geom::Point{} + offset, buffer_size_.value_or(geom::Size{})};
+    std::vector<geom::Rectangle> stream_opaque_region;
+    for (auto const& rect : opaque_region)
+    {
+        // The opaque region is in surface coordinates, as is the stream
+        auto const clipped = intersection_of(rect, {{}, surface_rect.size});
+        if (clipped.size.width > geom::Width{} && clipped.size.height > geom::Height{})
+            stream_opaque_region.push_back(clipped);
+    }
+    buffer_streams.push_back(msh::StreamSpecification{stream, offset, std::move(stream_opaque_region)});
     if (input_shape)
     {
         for (auto rect : input_shape.value())
@@ -247,8 +333,21 @@ mf::WlSurface* mf::WlSurface::from(wl_resource* resource)
     return static_cast<WlSurface*>(static_cast<wayland::Surface*>(raw_surface));
 }
 
+void mf::WlSurface::on_next_frame(std::function<void()>&& callback)
+{
+    next_frame_callbacks.push_back(std::move(callback));
+}
+
 void mf::WlSurface::send_frame_callbacks()
 {
+    // Swap out the list first, so callbacks are free to register for the following frame
+    std::vector<std::function<void()>> callbacks;
+    callbacks.swap(next_frame_callbacks);
+    for (auto const& callback : callbacks)
+    {
+        callback();
+    }
+
     for (auto const& frame : frame_callbacks)
     {
         if (frame)
@@ -274,20 +373,18 @@ void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x,
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    if (width > 0 && height > 0)
+    {
+        pending.surface_damage.push_back({{x, y}, {width, height}});
+    }
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    if (width > 0 && height > 0)
+    {
+        pending.buffer_damage.push_back({{x, y}, {width, height}});
+    }
 }
 
 void mf::WlSurface::frame(wl_resource* new_callback)
@@ -298,8 +395,11 @@ void mf::WlSurface::frame(wl_resource* new_callback)
 
 void mf::WlSurface::set_opaque_region(std::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    // A null region means no part of the surface is known to be opaque
+    if (region)
+        pending.opaque_region = WlRegion::from(region.value())->rectangle_vector();
+    else
+        pending.opaque_region = std::vector<geom::Rectangle>{};
 }
 
 void mf::WlSurface::set_input_region(std::optional<wl_resource*> const& region)
@@ -330,8 +430,14 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    if (state.opaque_region)
+        opaque_region = state.opaque_region.value();
+
     if (state.scale)
-        inv_scale = 1.0f / state.scale.value();
+    {
+        buffer_scale = state.scale.value();
+        inv_scale = 1.0f / buffer_scale;
+    }
 
     auto const executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
         {
@@ -370,8 +476,12 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
 
             if (auto const shm_buffer = ShmBuffer::from(weak_buffer.value()))
             {
+                auto shm_data = shm_buffer->data();
+                auto const damage = buffer_damage_from(state, shm_data->size(), buffer_scale);
                 mir_buffer = allocator->buffer_from_shm(
-                    shm_buffer->data(),
+                    std::move(shm_data),
+                    previous_buffer.lock(),
+                    damage,
                     std::move(executor_send_frame_callbacks),
                     std::move(release_buffer));
                 tracepoint(
@@ -393,8 +503,21 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     mir_buffer->id().as_value());
             }
 
-            stream->submit_buffer(mir_buffer, mir_buffer->size() * inv_scale, {{0, 0}, geom::SizeD{mir_buffer->size()}});
             auto const new_buffer_size = mir_buffer->size() * inv_scale;
+            geom::RectangleD const src_bounds{{0, 0}, geom::SizeD{mir_buffer->size()}};
+
+            // A resized buffer has changed everywhere, regardless of what the client says
+            auto const damage =
+                new_buffer_size == buffer_size_ ? buffer_damage_from(state, mir_buffer->size(), buffer_scale) : std::nullopt;
+
+            if (damage)
+            {
+                stream->submit_buffer(mir_buffer, new_buffer_size, src_bounds, *damage);
+            }
+            else
+            {
+                stream->submit_buffer(mir_buffer, new_buffer_size, src_bounds);
+            }
 
             if (std::make_optional(new_buffer_size) != buffer_size_)
             {
@@ -402,6 +525,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             }
 
             buffer_size_ = new_buffer_size;
+            previous_buffer = mir_buffer;
         }
     }
     else
@@ -426,6 +550,9 @@ void mf::WlSurface::commit()
     if (pending.input_shape && *pending.input_shape == input_shape)
         pending.input_shape = std::nullopt;
 
+    if (pending.opaque_region && *pending.opaque_region == opaque_region)
+        pending.opaque_region = std::nullopt;
+
     // order is important
     auto const state = std::move(pending);
     pending = WlSurfaceState();
@@ -39,6 +39,7 @@ class Executor;
 namespace graphics
 {
 class GraphicBufferAllocator;
+class Buffer;
 }
 namespace scene
 {
@@ -82,7 +83,10 @@ struct WlSurfaceState
     std::optional<int> scale;
     std::optional<geometry::Displacement> offset;
     std::optional<std::optional<std::vector<geometry::Rectangle>>> input_shape;
+    std::optional<std::vector<geometry::Rectangle>> opaque_region; ///< An empty region means nothing is opaque
     std::vector<wayland::Weak<Callback>> frame_callbacks;
+    std::vector<geometry::Rectangle> surface_damage; ///< From wl_surface.damage, in surface coordinates
+    std::vector<geometry::Rectangle> buffer_damage;  ///< From wl_surface.damage_buffer, in buffer coordinates
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -127,6 +131,11 @@ public:
     /// Callback is called immediately if the surface already has a scene::Surface, or else on the first commit where
     /// one exists
     void on_scene_surface_created(SceneSurfaceCreatedCallback&& callback);
+    /// If the client has committed frame callbacks that have not yet been sent
+    auto awaiting_frame() const -> bool { return !frame_callbacks.empty(); }
+    /// Callback is called the next time frame callbacks are sent, just before they are. It is never called if the
+    /// surface is destroyed first
+    void on_next_frame(std::function<void()>&& callback);
 
     void update_surface_spec(shell::SurfaceSpecification const& spec);
     void set_role(WlSurfaceRole* role_);
@@ -159,10 +168,15 @@ private:
     WlSurfaceState pending;
     geometry::Displacement offset_;
     float inv_scale{1.0f};
+    int buffer_scale{1};
     std::optional<geometry::Size> buffer_size_;
+    /// The most recently submitted buffer; its successor may reuse its GPU resources
+    std::weak_ptr<graphics::Buffer> previous_buffer;
     std::vector<wayland::Weak<WlSurfaceState::Callback>> frame_callbacks;
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
+    std::vector<mir::geometry::Rectangle> opaque_region;
     std::vector<SceneSurfaceCreatedCallback> scene_surface_created_callbacks;
+    std::vector<std::function<void()>> next_frame_callbacks;
 
     void send_frame_callbacks();
 
@@ -35,6 +35,16 @@ void mf::ScaledBufferStream::submit_buffer(
     inner->submit_buffer(buffer, dest_size * scale, src_bounds);
 }
 
+void mf::ScaledBufferStream::submit_buffer(
+    std::shared_ptr<graphics::Buffer> const& buffer,
+    geom::Size dest_size,
+    geom::RectangleD src_bounds,
+    geom::Rectangles const& damage)
+{
+    // Damage is in buffer coördinates, so is unaffected by scaling the destination
+    inner->submit_buffer(buffer, dest_size * scale, src_bounds, damage);
+}
+
 void mf::ScaledBufferStream::set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback)
 {
     // Does this need to be scaled? I don't ? think ? so? compositor::Stream seems to leave it unscaled.
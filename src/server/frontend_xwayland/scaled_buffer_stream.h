@@ -39,6 +39,11 @@ public:
         std::shared_ptr<graphics::Buffer> const& buffer,
         geometry::Size dst_size,
         geometry::RectangleD src_bounds);
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Size dst_size,
+        geometry::RectangleD src_bounds,
+        geometry::Rectangles const& damage);
     void set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback);
     /// @}
 
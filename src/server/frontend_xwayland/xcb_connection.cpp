@@ -23,7 +23,12 @@
 #include "mir/c_memory.h"
 
 #include "boost/throw_exception.hpp"
+#include <xcb/xcbext.h>
+#include <sys/eventfd.h>
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <system_error>
 
 namespace mf = mir::frontend;
 namespace geom = mir::geometry;
@@ -156,40 +161,40 @@ auto vector_handler(
 }
 
 mf::XCBConnection::Atom::Atom(std::string const& name, XCBConnection* connection)
-    : connection{connection},
-      name_{name},
+    : name_{name},
       cookie{xcb_intern_atom(*connection, 0, name_.size(), name_.c_str())}
 {
+    connection->interned_atoms.push_back(this);
 }
 
-mf::XCBConnection::Atom::operator xcb_atom_t() const
+mf::XCBConnection::XCBConnection(Fd const& fd)
+    : fd{fd},
+      xcb_connection{connect_to_fd(fd)},
+      xcb_screen{xcb_setup_roots_iterator(xcb_get_setup(xcb_connection)).data},
+      atom_name_cache{{XCB_ATOM_NONE, "None/Any"}},
+      events_pending_notify_fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)}
 {
-    if (atom == XCB_ATOM_NONE)
+    if (events_pending_notify_fd == Fd::invalid)
     {
-        std::lock_guard lock{mutex};
+        xcb_disconnect(xcb_connection);
+        BOOST_THROW_EXCEPTION((std::system_error{
+            errno,
+            std::system_category(),
+            "Failed to create XCB events pending eventfd"}));
+    }
 
-        // The initial atomic check is faster, but we need to check again once we've got the lock
-        if (atom == XCB_ATOM_NONE)
+    // Every atom was requested as it was constructed, so this only waits for one round trip
+    for (auto const atom : interned_atoms)
+    {
+        auto const reply = make_unique_cptr(xcb_intern_atom_reply(xcb_connection, atom->cookie, nullptr));
+        if (!reply)
         {
-            auto const reply = make_unique_cptr(xcb_intern_atom_reply(*connection, cookie, nullptr));
-            if (!reply)
-                BOOST_THROW_EXCEPTION(std::runtime_error("Failed to look up atom " + name_));
-            atom = reply->atom;
-
-            std::lock_guard lock{connection->atom_name_cache_mutex};
-            connection->atom_name_cache[atom] = name_;
+            xcb_disconnect(xcb_connection);
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to look up atom " + atom->name_));
         }
+        atom->atom = reply->atom;
+        atom_name_cache[reply->atom] = atom->name_;
     }
-
-    return atom;
-}
-
-mf::XCBConnection::XCBConnection(Fd const& fd)
-    : fd{fd},
-      xcb_connection{connect_to_fd(fd)},
-      xcb_screen{xcb_setup_roots_iterator(xcb_get_setup(xcb_connection)).data},
-      atom_name_cache{{XCB_ATOM_NONE, "None/Any"}}
-{
 }
 
 mf::XCBConnection::~XCBConnection()
@@ -208,34 +213,31 @@ void mf::XCBConnection::verify_not_in_error_state() const
 auto mf::XCBConnection::query_name(xcb_atom_t atom) const -> std::string
 {
     std::lock_guard lock{atom_name_cache_mutex};
-    auto const iter = atom_name_cache.find(atom);
-
-    if (iter == atom_name_cache.end())
+    if (auto const iter = atom_name_cache.find(atom); iter != atom_name_cache.end())
     {
-        xcb_get_atom_name_cookie_t const cookie = xcb_get_atom_name(xcb_connection, atom);
-        auto const reply = make_unique_cptr(xcb_get_atom_name_reply(xcb_connection, cookie, nullptr));
+        return iter->second;
+    }
 
-        std::string name;
+    // Caching the placeholder means the name is only requested once
+    auto const placeholder = "Atom " + std::to_string(atom);
+    atom_name_cache[atom] = placeholder;
 
-        if (reply)
-        {
-            name = std::string{
-                xcb_get_atom_name_name(reply.get()),
-                static_cast<size_t>(xcb_get_atom_name_name_length(reply.get()))};
-        }
-        else
+    expect_reply(
+        xcb_get_atom_name(xcb_connection, atom).sequence,
+        [this, atom](void* raw_reply, xcb_generic_error_t* error)
         {
-            name = "Atom " + std::to_string(atom);
-        }
-
-        atom_name_cache[atom] = name;
+            free(error);
+            auto const reply = make_unique_cptr(static_cast<xcb_get_atom_name_reply_t*>(raw_reply));
+            if (reply)
+            {
+                std::lock_guard lock{atom_name_cache_mutex};
+                atom_name_cache[atom] = std::string{
+                    xcb_get_atom_name_name(reply.get()),
+                    static_cast<size_t>(xcb_get_atom_name_name_length(reply.get()))};
+            }
+        });
 
-        return name;
-    }
-    else
-    {
-        return iter->second;
-    }
+    return placeholder;
 }
 
 auto mf::XCBConnection::reply_contains_string_data(xcb_get_property_reply_t const* reply) const -> bool
@@ -267,6 +269,138 @@ bool mf::XCBConnection::is_ours(uint32_t id) const
     return (id & ~setup->resource_id_mask) == setup->resource_id_base;
 }
 
+auto mf::XCBConnection::process_replies() const -> bool
+{
+    std::lock_guard handling{reply_handling_mutex};
+    bool handled{false};
+
+    while (true)
+    {
+        void* reply{nullptr};
+        xcb_generic_error_t* error{nullptr};
+        std::function<void(void*, xcb_generic_error_t*)> complete;
+
+        {
+            std::lock_guard lock{pending_replies_mutex};
+
+            // Replies arrive in request order, so if the first isn't here yet neither are the rest
+            if (pending_replies.empty() ||
+                !xcb_poll_for_reply(xcb_connection, pending_replies.front().sequence, &reply, &error))
+            {
+                return handled;
+            }
+
+            complete = std::move(pending_replies.front().complete);
+            pending_replies.pop_front();
+        }
+
+        try
+        {
+            complete(reply, error);
+        }
+        catch (...)
+        {
+            log(
+                logging::Severity::warning,
+                MIR_LOG_COMPONENT,
+                std::current_exception(),
+                "Error processing XCB reply");
+        }
+        handled = true;
+    }
+}
+
+void mf::XCBConnection::clear_events_pending() const
+{
+    if (events_pending_notified.exchange(false))
+    {
+        eventfd_t unused;
+        if (eventfd_read(events_pending_notify_fd, &unused) && errno != EAGAIN)
+        {
+            log_error(
+                "eventfd_read failed to consume events pending notification: %s (%i)",
+                strerror(errno),
+                errno);
+        }
+    }
+}
+
+void mf::XCBConnection::after_replies(std::function<void()>&& action) const
+{
+    // The reply to this trivial request arrives after the replies to all the requests made before it
+    expect_reply(
+        xcb_get_input_focus(xcb_connection).sequence,
+        [action = std::move(action)](void* reply, xcb_generic_error_t* error)
+        {
+            free(reply);
+            free(error);
+            action();
+        });
+}
+
+void mf::XCBConnection::discard_pending_replies() const
+{
+    std::deque<PendingReply> discarded;
+    {
+        std::lock_guard lock{pending_replies_mutex};
+        discarded = std::move(pending_replies);
+        pending_replies.clear();
+    }
+    // The handlers are destroyed here, without the lock held
+}
+
+auto mf::XCBConnection::expect_reply(
+    unsigned int sequence,
+    std::function<void(void* reply, xcb_generic_error_t* error)>&& complete) const -> std::function<void()>
+{
+    {
+        std::lock_guard lock{pending_replies_mutex};
+        pending_replies.push_back({sequence, std::move(complete)});
+    }
+
+    return [this, sequence]()
+        {
+            wait_for_reply(sequence);
+        };
+}
+
+void mf::XCBConnection::wait_for_reply(unsigned int sequence) const
+{
+    std::unique_lock lock{pending_replies_mutex};
+    auto const pending = std::find_if(
+        pending_replies.begin(),
+        pending_replies.end(),
+        [sequence](PendingReply const& pending) { return pending.sequence == sequence; });
+
+    if (pending == pending_replies.end())
+    {
+        // Either already handled, or being handled by process_replies() on another thread. In that case wait for
+        // it to finish, so the handler has run by the time we return.
+        lock.unlock();
+        std::lock_guard handling{reply_handling_mutex};
+        return;
+    }
+
+    auto const complete = std::move(pending->complete);
+    pending_replies.erase(pending);
+    lock.unlock();
+
+    xcb_generic_error_t* error{nullptr};
+    auto const reply = xcb_wait_for_reply(xcb_connection, sequence, &error);
+
+    // Waiting may have read events and other replies, which the connection's FD won't announce
+    events_pending_notified = true;
+    if (eventfd_write(events_pending_notify_fd, 1))
+    {
+        log_error(
+            "eventfd_write failed to notify of pending events: %s (%i)",
+            strerror(errno),
+            errno);
+    }
+
+    complete(reply, error);
+}
+
 auto mf::XCBConnection::read_property(
     xcb_window_t window,
     xcb_atom_t prop,
@@ -283,12 +417,16 @@ auto mf::XCBConnection::read_property(
         0, // no offset
         max_length);
 
-    return [this, cookie, handler=std::move(handler), window, prop]()
+    return expect_reply(
+        cookie.sequence,
+        [this, handler=std::move(handler), window, prop](void* raw_reply, xcb_generic_error_t* raw_error)
         {
+            Error error;
+            error.ptr = raw_error;
+            auto const reply = make_unique_cptr(static_cast<xcb_get_property_reply_t*>(raw_reply));
+
             try
             {
-                Error error;
-                auto const reply = make_unique_cptr(xcb_get_property_reply(xcb_connection, cookie, &error.ptr));
                 if (reply && reply->type != XCB_ATOM_NONE)
                 {
                     handler.on_success(reply.get());
@@ -320,7 +458,7 @@ auto mf::XCBConnection::read_property(
                     "Exception thrown processing reply for property " +
                     window_debug_string(window) + "." + query_name(prop));
             }
-        };
+        });
 }
 
 auto mf::XCBConnection::read_property(
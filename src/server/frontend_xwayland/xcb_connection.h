@@ -32,6 +32,7 @@
 #include <functional>
 #include <mutex>
 #include <atomic>
+#include <deque>
 #include <optional>
 
 namespace mir
@@ -67,6 +68,9 @@ template<> struct NativeXCBType<XCBType::INCR>          { typedef int32_t type;
 
 class XCBConnection
 {
+public:
+    class Atom;
+
 private:
     Fd const fd;
     xcb_connection_t* const xcb_connection;
@@ -75,26 +79,49 @@ private:
     std::mutex mutable atom_name_cache_mutex;
     std::unordered_map<xcb_atom_t, std::string> mutable atom_name_cache;
 
+    /// The atoms declared below, in the order they were requested
+    std::vector<Atom*> interned_atoms;
+
+    /// A request whose reply has not been handled yet
+    struct PendingReply
+    {
+        unsigned int sequence;
+        /// Takes ownership of the reply and error, either of which may be null
+        std::function<void(void* reply, xcb_generic_error_t* error)> complete;
+    };
+
+    /// Held while handling replies, so waiting for a reply that is being handled on another thread
+    /// can wait for it to finish
+    std::recursive_mutex mutable reply_handling_mutex;
+    std::mutex mutable pending_replies_mutex;
+    /// The completion table, in request order
+    std::deque<PendingReply> mutable pending_replies;
+
+    /// Written to when a reply is waited for (see events_pending_fd())
+    Fd const events_pending_notify_fd;
+    /// If events_pending_notify_fd may have been written to since it was last read
+    std::atomic<bool> mutable events_pending_notified{false};
+
 public:
     class Atom
     {
     public:
-        /// Context should outlive the atom
+        /// Context should outlive the atom. The atom is looked up by the context's constructor, along with all the
+        /// other atoms it declares.
         Atom(std::string const& name, XCBConnection* connection);
-        operator xcb_atom_t() const;
+        operator xcb_atom_t() const { return atom; }
 
     private:
+        friend class XCBConnection;
+
         Atom(Atom&) = delete;
         Atom& operator=(Atom&) = delete;
 
-        XCBConnection* const connection;
         std::string const name_;
         xcb_intern_atom_cookie_t const cookie;
-        std::mutex mutable mutex;
 
-        /// Accessed locklessly, but only set under lock
-        /// Once set to a value other than XCB_ATOM_NONE, not changed again
-        std::atomic<xcb_atom_t> mutable atom{XCB_ATOM_NONE};
+        /// Set by the XCBConnection constructor and not changed after
+        xcb_atom_t atom{XCB_ATOM_NONE};
     };
 
     struct Error
@@ -148,7 +175,8 @@ public:
     auto screen() const -> xcb_screen_t* { return xcb_screen; }
     auto root_window() const -> xcb_window_t { return xcb_screen->root; }
 
-    /// Looks up an atom's name, or requests it from the X server if it is not already cached
+    /// Looks up an atom's name. If it is not already cached it is requested from the X server, and a placeholder is
+    /// returned until the reply has been handled.
     auto query_name(xcb_atom_t atom) const -> std::string;
     auto reply_contains_string_data(xcb_get_property_reply_t const* reply) const -> bool;
     auto string_from(xcb_get_property_reply_t const* reply) const -> std::string;
@@ -156,8 +184,26 @@ public:
     /// If the window was created by us
     auto is_ours(xcb_window_t window) const -> bool;
 
+    /// Handles the replies that have arrived, in the order they were requested. Does not block, but may read the
+    /// connection and so queue events. Returns if any replies were handled.
+    auto process_replies() const -> bool;
+
+    /// Becomes readable when a reply is waited for. Waiting reads the connection, which can queue events and replies
+    /// without the connection's own FD becoming readable, so they need handling when this is readable too.
+    auto events_pending_fd() const -> Fd const& { return events_pending_notify_fd; }
+    /// Resets events_pending_fd(). Should be called before handling the queued events and replies.
+    void clear_events_pending() const;
+
+    /// Calls \p action from process_replies() once the replies to all the requests made so far have been handled
+    void after_replies(std::function<void()>&& action) const;
+
+    /// Drops the handlers of all the replies that have not been handled yet
+    void discard_pending_replies() const;
+
     /// Read a single property of various types from the window
-    /// Returns a function that will wait on the reply before calling action()
+    /// The handler is called by process_replies() once the reply arrives. Returns a function that can be called
+    /// instead to wait for the reply and handle it immediately (it does nothing if the reply has already been
+    /// handled).
     /// @{
     auto read_property(
         xcb_window_t window,
@@ -325,6 +371,13 @@ private:
 
     auto xcb_type_atom(XCBType type) const -> xcb_atom_t;
 
+    /// Adds \p complete to the completion table
+    /// Returns a function that waits for the reply and calls \p complete if process_replies() hasn't already
+    auto expect_reply(
+        unsigned int sequence,
+        std::function<void(void* reply, xcb_generic_error_t* error)>&& complete) const -> std::function<void()>;
+    void wait_for_reply(unsigned int sequence) const;
+
     template<XCBType type>
     static inline constexpr uint8_t xcb_type_format()
     {
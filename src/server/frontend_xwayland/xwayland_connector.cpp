@@ -165,15 +165,16 @@ void mf::XWaylandConnector::spawn()
             *spawner,
             xwayland_path,
             scale);
-        auto const wm_dispatcher = std::make_shared<md::MultiplexingDispatchable>();
-        wm_dispatcher->add_watch(std::make_shared<md::ReadableFd>(server->x11_wm_fd(), [this]()
+        auto const handle_wm_events = [this]()
             {
                 std::lock_guard lock{mutex};
                 if (wm)
                 {
                     wm->handle_events();
                 }
-            }));
+            };
+        auto const wm_dispatcher = std::make_shared<md::MultiplexingDispatchable>();
+        wm_dispatcher->add_watch(std::make_shared<md::ReadableFd>(server->x11_wm_fd(), handle_wm_events));
         wm_event_thread = std::make_unique<mir::dispatch::ThreadedDispatcher>(
             "Mir/X11 WM Reader",
             wm_dispatcher,
@@ -205,6 +206,7 @@ void mf::XWaylandConnector::spawn()
             server->x11_wm_fd(),
             wm_dispatcher,
             scale);
+        wm_dispatcher->add_watch(std::make_shared<md::ReadableFd>(wm->events_pending_fd(), handle_wm_events));
         mir::log_info("XWayland is running");
     }
     catch (...)
@@ -680,10 +680,13 @@ void mf::XWaylandSurface::property_notify(xcb_atom_t property)
     auto const handler = property_handlers.find(property);
     if (handler != property_handlers.end())
     {
-        auto completion = handler->second();
-        completion();
+        // Rather than wait on the reply here, let XCBConnection::process_replies() handle it when it arrives
+        handler->second();
 
-        apply_any_mods_to_scene_surface();
+        connection->after_replies([self = shared_from_this()]()
+            {
+                self->apply_any_mods_to_scene_surface();
+            });
     }
 }
 
@@ -30,6 +30,7 @@
 
 #include <xcb/xcb.h>
 
+#include <memory>
 #include <mutex>
 #include <chrono>
 #include <set>
@@ -66,7 +67,8 @@ enum class NetWmStateAction: uint32_t
 
 class XWaylandSurface
     : public XWaylandSurfaceRoleSurface,
-      public XWaylandSurfaceObserverSurface
+      public XWaylandSurfaceObserverSurface,
+      public std::enable_shared_from_this<XWaylandSurface>
 {
 public:
     XWaylandSurface(
@@ -26,6 +26,9 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace mf = mir::frontend;
 namespace mc = mir::compositor;
 namespace geom = mir::geometry;
@@ -81,6 +84,18 @@ void mf::XWaylandSurfaceRole::populate_surface_data_scaled(
                 keep_alive_until_spec_is_used.push_back(std::move(scaled));
             }
             stream.displacement = stream.displacement * inv_scale;
+
+            // Scaling could round outward, so only keep the whole pixels that remain inside the opaque area
+            for (auto& rect : stream.opaque_region)
+            {
+                auto const left = std::ceil(rect.left().as_int() * inv_scale);
+                auto const top = std::ceil(rect.top().as_int() * inv_scale);
+                auto const right = std::floor(rect.right().as_int() * inv_scale);
+                auto const bottom = std::floor(rect.bottom().as_int() * inv_scale);
+                rect = geom::Rectangle{
+                    {static_cast<int>(left), static_cast<int>(top)},
+                    {std::max(0, static_cast<int>(right - left)), std::max(0, static_cast<int>(bottom - top))}};
+            }
         }
 
         for (auto& rect : spec.input_shape.value())
@@ -264,6 +264,9 @@ mf::XWaylandWM::~XWaylandWM()
 
     local_surfaces.clear();
 
+    // Pending reply handlers may be keeping surfaces (and so the connection) alive
+    connection->discard_pending_replies();
+
     if (verbose_xwayland_logging_enabled())
         log_debug("...done closing surfaces");
 
@@ -274,29 +277,50 @@ mf::XWaylandWM::~XWaylandWM()
 
 void mf::XWaylandWM::handle_events()
 {
-    bool got_events = false;
+    bool handled_any = false;
 
     connection->verify_not_in_error_state();
+    connection->clear_events_pending();
+
+    auto const handle = [&](xcb_generic_event_t* event)
+        {
+            try
+            {
+                handle_event(event);
+            }
+            catch (...)
+            {
+                log(
+                    logging::Severity::warning,
+                    MIR_LOG_COMPONENT,
+                    std::current_exception(),
+                    "Error processing XCB event");
+            }
+            free(event);
+            handled_any = true;
+        };
 
     while (xcb_generic_event_t* const event = xcb_poll_for_event(*connection))
     {
-        try
-        {
-            handle_event(event);
-        }
-        catch (...)
+        handle(event);
+    }
+
+    // Polling for replies can read events off the connection, and nothing wakes us again for events already read. So
+    // carry on until neither turns up anything new.
+    for (bool progress = true; progress;)
+    {
+        progress = connection->process_replies();
+        handled_any = handled_any || progress;
+
+        while (xcb_generic_event_t* const event = xcb_poll_for_queued_event(*connection))
         {
-            log(
-                logging::Severity::warning,
-                MIR_LOG_COMPONENT,
-                std::current_exception(),
-                "Error processing XCB event");
+            handle(event);
+            progress = true;
         }
-        free(event);
-        got_events = true;
     }
 
-    if (got_events)
+    // Handling events and replies may have made requests
+    if (handled_any)
     {
         connection->flush();
     }
@@ -460,7 +484,6 @@ void mf::XWaylandWM::manage_window(xcb_window_t window, geom::Rectangle const& g
         auto const props_reply = xcb_list_properties_reply(*connection, props_cookie, nullptr);
         if (props_reply)
         {
-            std::vector<std::function<void()>> functions;
             int const prop_count = xcb_list_properties_atoms_length(props_reply);
             for (int i = 0; i < prop_count; i++)
             {
@@ -475,7 +498,8 @@ void mf::XWaylandWM::manage_window(xcb_window_t window, geom::Rectangle const& g
                             value.c_str());
                     };
 
-                functions.push_back(connection->read_property(
+                // Logged by process_replies() as the replies arrive
+                connection->read_property(
                     window,
                     atom,
                     {
@@ -488,13 +512,11 @@ void mf::XWaylandWM::manage_window(xcb_window_t window, geom::Rectangle const& g
                         {
                             log_prop("error getting value: " + message);
                         }
-                    }));
+                    });
             }
             free(props_reply);
 
             log_debug("%s has %d initial propertie(s):", connection->window_debug_string(window).c_str(), prop_count);
-            for (auto const& f : functions)
-                f();
         }
         else
         {
@@ -634,17 +656,19 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
         }
         else
         {
-            auto const log_prop = [this, event](std::string const& value)
+            // The event is freed before the reply arrives
+            auto const log_prop = [this, window = event->window, atom = event->atom](std::string const& value)
                 {
-                    auto const prop_name = connection->query_name(event->atom);
+                    auto const prop_name = connection->query_name(atom);
                     log_debug(
                         "XCB_PROPERTY_NOTIFY (%s).%s: %s",
-                        connection->window_debug_string(event->window).c_str(),
+                        connection->window_debug_string(window).c_str(),
                         prop_name.c_str(),
                         value.c_str());
                 };
 
-            auto const reply_function = connection->read_property(
+            // Logged by process_replies() when the reply arrives
+            connection->read_property(
                 event->window,
                 event->atom,
                 {
@@ -658,8 +682,6 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
                         log_prop("error getting value: " + message);
                     }
                 });
-
-            reply_function();
         }
     }
 
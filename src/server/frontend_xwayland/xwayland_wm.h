@@ -72,6 +72,8 @@ public:
 
     /// Called by the XWayland connector when there may be new events
     void handle_events();
+    /// Becomes readable when there may be new events that the X11 connection's FD does not announce
+    auto events_pending_fd() const -> Fd const& { return connection->events_pending_fd(); }
 
     auto get_wm_surface(xcb_window_t xcb_window) -> std::optional<std::shared_ptr<XWaylandSurface>>;
     auto get_focused_window() -> std::optional<xcb_window_t>;
@@ -15,8 +15,7 @@
  */
 
 #include "mir/glib_main_loop.h"
-#include "mir/lockable_callback_wrapper.h"
-#include "mir/basic_callback.h"
+#include "mir/lockable_callback.h"
 
 #include <stdexcept>
 #include <condition_variable>
@@ -24,84 +23,6 @@
 #include <boost/throw_exception.hpp>
 #include <future>
 
-namespace
-{
-
-class AlarmImpl : public mir::time::Alarm
-{
-public:
-    AlarmImpl(
-        GMainContext* main_context,
-        std::shared_ptr<mir::time::Clock> const& clock,
-        std::unique_ptr<mir::LockableCallback>&& callback,
-        std::function<void()> const& exception_handler)
-        : main_context{g_main_context_ref(main_context)},
-          clock{clock},
-          state_{State::cancelled},
-          exception_handler{exception_handler},
-          wrapped_callback{std::make_shared<mir::LockableCallbackWrapper>(
-              std::move(callback), [this] { state_ = State::triggered; })}
-    {
-    }
-
-    ~AlarmImpl() override
-    {
-        gsource.ensure_no_further_dispatch();
-        g_main_context_unref(main_context);
-    }
-
-    bool cancel() override
-    {
-        std::lock_guard lock{alarm_mutex};
-
-        gsource.ensure_no_further_dispatch();
-        if (state_ ==  State::pending)
-        {
-            gsource = mir::detail::GSourceHandle{};
-            state_ = State::cancelled;
-        }
-        return state_ == State::cancelled;
-    }
-
-    State state() const override
-    {
-        std::lock_guard lock{alarm_mutex};
-        return state_;
-    }
-
-    bool reschedule_in(std::chrono::milliseconds delay) override
-    {
-        return reschedule_for(clock->now() + delay);
-    }
-
-    bool reschedule_for(mir::time::Timestamp time_point) override
-    {
-        std::lock_guard lock{alarm_mutex};
-
-        auto old_state = state_;
-        state_ = State::pending;
-        gsource = mir::detail::add_timer_gsource(
-            main_context,
-            clock,
-            wrapped_callback,
-            exception_handler,
-            time_point);
-
-        return old_state == State::pending;
-    }
-
-private:
-    mutable std::mutex alarm_mutex;
-    GMainContext* main_context;
-    std::shared_ptr<mir::time::Clock> const clock;
-    State state_;
-    std::function<void()> exception_handler;
-    std::shared_ptr<mir::LockableCallback> wrapped_callback;
-    mir::detail::GSourceHandle gsource;
-};
-
-}
-
 mir::detail::GMainContextHandle::GMainContextHandle()
     : main_context{g_main_context_new()}
 {
@@ -127,6 +48,8 @@ mir::GLibMainLoop::GLibMainLoop(
       running_{false},
       fd_sources{main_context},
       signal_sources{fd_sources},
+      alarms{main_context, clock, [this] { handle_exception(std::current_exception()); }},
+      actions{main_context, [this] (void const* owner) { return should_process_actions_for(owner); }},
       before_iteration_hook{[]{}}
 {
 }
@@ -252,12 +175,7 @@ void mir::GLibMainLoop::enqueue(void const* owner, ServerAction const& action)
             catch (...) { handle_exception(std::current_exception()); }
         };
 
-    detail::add_server_action_gsource(main_context, owner,
-        action_with_exception_handling,
-        [this] (void const* owner)
-        {
-            return should_process_actions_for(owner);
-        });
+    actions.enqueue(owner, action_with_exception_handling);
 }
 
 
@@ -334,20 +252,13 @@ bool mir::GLibMainLoop::should_process_actions_for(void const* owner)
 std::unique_ptr<mir::time::Alarm> mir::GLibMainLoop::create_alarm(
     std::function<void()> const& callback)
 {
-    return create_alarm(std::make_unique<BasicCallback>(callback));
+    return alarms.create_alarm(callback);
 }
 
 std::unique_ptr<mir::time::Alarm> mir::GLibMainLoop::create_alarm(
     std::unique_ptr<LockableCallback> callback)
 {
-    auto const exception_hander =
-        [this]
-        {
-            handle_exception(std::current_exception());
-        };
-
-    return std::make_unique<AlarmImpl>(
-        main_context, clock, std::move(callback), exception_hander);
+    return alarms.create_alarm(std::move(callback));
 }
 
 void mir::GLibMainLoop::reprocess_all_sources()
@@ -458,9 +369,5 @@ void mir::GLibMainLoop::spawn(std::function<void()>&& work)
             catch (...) { handle_exception(std::current_exception()); }
         };
 
-    detail::add_server_action_gsource(
-        main_context,
-        nullptr,
-        action_with_exception_handling,
-        [](auto) { return true; });
+    actions.spawn(action_with_exception_handling);
 }
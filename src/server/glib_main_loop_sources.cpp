@@ -16,11 +16,13 @@
 
 #include "mir/glib_main_loop_sources.h"
 #include "mir/lockable_callback.h"
+#include "mir/basic_callback.h"
 #include "mir/raii.h"
 #include <mir/log.h>
 
 #include <algorithm>
 #include <atomic>
+#include <optional>
 #include <system_error>
 #include <sstream>
 
@@ -177,80 +179,6 @@ void md::add_idle_gsource(
     g_source_attach(gsource, main_context);
 }
 
-void md::add_server_action_gsource(
-    GMainContext* main_context,
-    void const* owner,
-    std::function<void()> const& action,
-    std::function<bool(void const*)> const& should_dispatch)
-{
-    struct ServerActionContext
-    {
-        void const* const owner;
-        std::function<void(void)> const action;
-        std::function<bool(void const*)> const should_dispatch;
-
-        // If we come to finalize() before dispatch() we have already
-        // torn down most of Mir and even unloaded some shared libraries.
-        // That means the action could refer to  stuff that is no longer
-        // in the address space.
-        // We will just leak any resources instead of crashing.
-        bool mutable dispatched{false};
-    };
-
-    struct ServerActionGSource
-    {
-        GSource gsource;
-        ServerActionContext ctx;
-        bool ctx_constructed;
-
-        static gboolean prepare(GSource* source, gint *timeout)
-        {
-            *timeout = -1;
-            auto const& ctx = reinterpret_cast<ServerActionGSource*>(source)->ctx;
-            return ctx.should_dispatch(ctx.owner);
-        }
-
-        static gboolean check(GSource* source)
-        {
-            auto const& ctx = reinterpret_cast<ServerActionGSource*>(source)->ctx;
-            return ctx.should_dispatch(ctx.owner);
-        }
-
-        static gboolean dispatch(GSource* source, GSourceFunc, gpointer)
-        {
-            auto const& ctx = reinterpret_cast<ServerActionGSource*>(source)->ctx;
-            ctx.action();
-            ctx.dispatched = true;
-            return FALSE;
-        }
-
-        static void finalize(GSource* source)
-        {
-            auto const sa_gsource = reinterpret_cast<ServerActionGSource*>(source);
-            if (sa_gsource->ctx_constructed && sa_gsource->ctx.dispatched)
-                sa_gsource->ctx.~ServerActionContext();
-        }
-    };
-
-    static GSourceFuncs gsource_funcs{
-        ServerActionGSource::prepare,
-        ServerActionGSource::check,
-        ServerActionGSource::dispatch,
-        ServerActionGSource::finalize,
-        nullptr,
-        nullptr
-    };
-
-    GSourceRef gsource{g_source_new(&gsource_funcs, sizeof(ServerActionGSource))};
-    auto const sa_gsource = reinterpret_cast<ServerActionGSource*>(static_cast<GSource*>(gsource));
-
-    sa_gsource->ctx_constructed = false;
-    new (&sa_gsource->ctx) decltype(sa_gsource->ctx){owner, action, should_dispatch};
-    sa_gsource->ctx_constructed = true;
-
-    g_source_attach(gsource, main_context);
-}
-
 md::GSourceHandle md::add_timer_gsource(
     GMainContext* main_context,
     std::shared_ptr<time::Clock> const& clock,
@@ -365,6 +293,513 @@ md::GSourceHandle md::add_timer_gsource(
     return gsource;
 }
 
+/**************
+ * AlarmQueue *
+ **************/
+
+struct md::AlarmQueue::Timer
+{
+    explicit Timer(std::shared_ptr<LockableCallback> callback)
+        : callback{std::move(callback)}
+    {
+    }
+
+    std::shared_ptr<LockableCallback> const callback;
+
+    /// Held while the callback runs, so that cancelling the alarm can wait for it to finish
+    std::recursive_mutex dispatch_mutex;
+
+    // The remaining members are guarded by Timers::mutex
+    time::Alarm::State state{time::Alarm::cancelled};
+    time::Timestamp deadline;
+    /// Changed whenever the timer's entry in the queue is superseded, so the stale entry is ignored
+    uint64_t generation{0};
+    /// When the timer's current entry in the queue is due, if it has one. This is never after the deadline.
+    std::optional<time::Timestamp> queued_for;
+};
+
+struct md::AlarmQueue::Timers
+{
+    struct Entry
+    {
+        time::Timestamp due;
+        std::shared_ptr<Timer> timer;
+        uint64_t generation;
+
+        auto is_current() const -> bool
+        {
+            return generation == timer->generation;
+        }
+
+        /// Heap ordering that puts the earliest entry at the front
+        static auto later(Entry const& lhs, Entry const& rhs) -> bool
+        {
+            return lhs.due > rhs.due;
+        }
+    };
+
+    Timers(
+        GMainContext* main_context,
+        std::shared_ptr<time::Clock> const& clock,
+        std::function<void()> const& exception_handler)
+        : main_context{g_main_context_ref(main_context)},
+          clock{clock},
+          exception_handler{exception_handler}
+    {
+    }
+
+    ~Timers()
+    {
+        g_main_context_unref(main_context);
+    }
+
+    /// \return true if this supersedes a pending schedule
+    auto schedule(std::shared_ptr<Timer> const& timer, time::Timestamp deadline) -> bool
+    {
+        bool superseded;
+        bool due_first;
+        {
+            std::lock_guard lock{mutex};
+
+            superseded = timer->state == time::Alarm::pending;
+            timer->state = time::Alarm::pending;
+            timer->deadline = deadline;
+
+            if (timer->queued_for && *timer->queued_for <= deadline)
+            {
+                // The current entry comes round first, and the timer is requeued for its deadline then
+                return superseded;
+            }
+
+            supersede_entry(*timer);
+            timer->queued_for = deadline;
+            push({deadline, timer, timer->generation});
+            due_first = queue.front().timer == timer;
+        }
+
+        if (due_first)
+        {
+            // The main loop may be waiting for a later alarm
+            g_main_context_wakeup(main_context);
+        }
+        return superseded;
+    }
+
+    /// \return true if the timer is now cancelled
+    auto cancel(Timer& timer) -> bool
+    {
+        std::lock_guard lock{mutex};
+
+        if (timer.state == time::Alarm::pending)
+        {
+            timer.state = time::Alarm::cancelled;
+            supersede_entry(timer);
+        }
+        return timer.state == time::Alarm::cancelled;
+    }
+
+    auto state(Timer const& timer) -> time::Alarm::State
+    {
+        std::lock_guard lock{mutex};
+        return timer.state;
+    }
+
+    /// When the earliest current entry is due, discarding any stale entries ahead of it
+    auto next_due() -> std::optional<time::Timestamp>
+    {
+        std::lock_guard lock{mutex};
+
+        while (!queue.empty() && !queue.front().is_current())
+        {
+            pop();
+            --stale_entries;
+        }
+
+        if (queue.empty())
+        {
+            return std::nullopt;
+        }
+        return queue.front().due;
+    }
+
+    /// Moves the entries of the timers that are due by \p now into \p due
+    void take_due(time::Timestamp now, std::vector<Entry>& due)
+    {
+        std::lock_guard lock{mutex};
+
+        while (!queue.empty() && queue.front().due <= now)
+        {
+            auto entry = pop();
+            auto& timer = *entry.timer;
+
+            if (!entry.is_current())
+            {
+                --stale_entries;
+            }
+            else if (timer.deadline > now)
+            {
+                // The timer has been rescheduled for later since this entry was queued
+                entry.due = timer.deadline;
+                timer.queued_for = timer.deadline;
+                push(std::move(entry));
+            }
+            else
+            {
+                timer.queued_for.reset();
+                due.push_back(std::move(entry));
+            }
+        }
+    }
+
+    /// Calls the callback for \p entry, unless it has been cancelled or rescheduled since it was taken
+    void fire(Entry const& entry)
+    {
+        auto& timer = *entry.timer;
+
+        // Attempt to preserve locking order during callback dispatching
+        // so we acquire the caller's lock before our own.
+        auto& callback = *timer.callback;
+        std::lock_guard callback_lock{callback};
+        std::lock_guard dispatch_lock{timer.dispatch_mutex};
+        {
+            std::lock_guard lock{mutex};
+
+            if (!entry.is_current() || timer.state != time::Alarm::pending)
+            {
+                return;
+            }
+            timer.state = time::Alarm::triggered;
+        }
+        callback();
+    }
+
+    GMainContext* const main_context;
+    std::shared_ptr<time::Clock> const clock;
+    std::function<void()> const exception_handler;
+
+    /// The entries being dispatched. Only used by the main loop, and kept to reuse its storage.
+    std::vector<Entry> dispatching;
+
+private:
+    /// Must be called with mutex held
+    void supersede_entry(Timer& timer)
+    {
+        ++timer.generation;
+
+        if (timer.queued_for)
+        {
+            timer.queued_for.reset();
+            ++stale_entries;
+
+            // Stale entries are normally dropped as they reach the front; this keeps an alarm that is
+            // repeatedly cancelled or brought forward from growing the queue
+            if (stale_entries > 32 && stale_entries > queue.size() / 2)
+            {
+                std::erase_if(queue, [](Entry const& entry) { return !entry.is_current(); });
+                std::make_heap(queue.begin(), queue.end(), &Entry::later);
+                stale_entries = 0;
+            }
+        }
+    }
+
+    /// Must be called with mutex held
+    void push(Entry entry)
+    {
+        queue.push_back(std::move(entry));
+        std::push_heap(queue.begin(), queue.end(), &Entry::later);
+    }
+
+    /// Must be called with mutex held
+    auto pop() -> Entry
+    {
+        std::pop_heap(queue.begin(), queue.end(), &Entry::later);
+        auto entry = std::move(queue.back());
+        queue.pop_back();
+        return entry;
+    }
+
+    std::mutex mutex;
+    std::vector<Entry> queue;
+    size_t stale_entries{0};
+};
+
+struct md::AlarmQueue::TimerGSource
+{
+    GSource gsource;
+    Timers* timers;
+
+    static gboolean prepare(GSource* source, gint *timeout)
+    {
+        auto& timers = *reinterpret_cast<TimerGSource*>(source)->timers;
+
+        auto const due = timers.next_due();
+        bool const ready = due && (timers.clock->now() >= *due);
+        if (ready || !due)
+            *timeout = -1;
+        else
+            *timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+                timers.clock->min_wait_until(*due)).count();
+
+        return ready;
+    }
+
+    static gboolean check(GSource* source)
+    {
+        auto& timers = *reinterpret_cast<TimerGSource*>(source)->timers;
+
+        auto const due = timers.next_due();
+        return due && (timers.clock->now() >= *due);
+    }
+
+    static gboolean dispatch(GSource* source, GSourceFunc, gpointer)
+    {
+        auto& timers = *reinterpret_cast<TimerGSource*>(source)->timers;
+
+        auto& due = timers.dispatching;
+        timers.take_due(timers.clock->now(), due);
+        for (auto const& entry : due)
+        {
+            try
+            {
+                timers.fire(entry);
+            }
+            catch(...)
+            {
+                timers.exception_handler();
+            }
+        }
+        due.clear();
+
+        return G_SOURCE_CONTINUE;
+    }
+};
+
+class md::AlarmQueue::AlarmImpl : public time::Alarm
+{
+public:
+    AlarmImpl(std::shared_ptr<Timers> const& timers, std::unique_ptr<LockableCallback> callback)
+        : timers{timers},
+          timer{std::make_shared<Timer>(std::move(callback))}
+    {
+    }
+
+    ~AlarmImpl() override
+    {
+        cancel();
+    }
+
+    bool cancel() override
+    {
+        // Waits for the callback, if it is running on another thread
+        std::lock_guard dispatch_lock{timer->dispatch_mutex};
+        return timers->cancel(*timer);
+    }
+
+    State state() const override
+    {
+        return timers->state(*timer);
+    }
+
+    bool reschedule_in(std::chrono::milliseconds delay) override
+    {
+        return reschedule_for(timers->clock->now() + delay);
+    }
+
+    bool reschedule_for(time::Timestamp time_point) override
+    {
+        return timers->schedule(timer, time_point);
+    }
+
+private:
+    std::shared_ptr<Timers> const timers;
+    std::shared_ptr<Timer> const timer;
+};
+
+md::AlarmQueue::AlarmQueue(
+    GMainContext* main_context,
+    std::shared_ptr<time::Clock> const& clock,
+    std::function<void()> const& exception_handler)
+    : timers{std::make_shared<Timers>(main_context, clock, exception_handler)}
+{
+    static GSourceFuncs gsource_funcs{
+        TimerGSource::prepare,
+        TimerGSource::check,
+        TimerGSource::dispatch,
+        nullptr,
+        nullptr,
+        nullptr
+    };
+
+    gsource = GSourceHandle{
+        g_source_new(&gsource_funcs, sizeof(TimerGSource)),
+        [](GSource*) {}};
+    reinterpret_cast<TimerGSource*>(static_cast<GSource*>(gsource))->timers = timers.get();
+
+    g_source_attach(gsource, main_context);
+}
+
+md::AlarmQueue::~AlarmQueue() = default;
+
+std::unique_ptr<mir::time::Alarm> md::AlarmQueue::create_alarm(std::function<void()> const& callback)
+{
+    return create_alarm(std::make_unique<BasicCallback>(callback));
+}
+
+std::unique_ptr<mir::time::Alarm> md::AlarmQueue::create_alarm(std::unique_ptr<LockableCallback> callback)
+{
+    return std::make_unique<AlarmImpl>(timers, std::move(callback));
+}
+
+/***************
+ * ActionQueue *
+ ***************/
+
+struct md::ActionQueue::Action
+{
+    void const* const owner;
+    bool const pausable;
+    std::function<void()> const action;
+    Action* next;
+};
+
+struct md::ActionQueue::ActionGSource
+{
+    GSource gsource;
+    ActionQueue* queue;
+
+    static gboolean prepare(GSource* source, gint *timeout)
+    {
+        *timeout = -1;
+        return reinterpret_cast<ActionGSource*>(source)->queue->ready();
+    }
+
+    static gboolean check(GSource* source)
+    {
+        return reinterpret_cast<ActionGSource*>(source)->queue->ready();
+    }
+
+    static gboolean dispatch(GSource* source, GSourceFunc, gpointer)
+    {
+        reinterpret_cast<ActionGSource*>(source)->queue->dispatch();
+        return G_SOURCE_CONTINUE;
+    }
+};
+
+md::ActionQueue::ActionQueue(GMainContext* main_context, std::function<bool(void const*)> const& should_dispatch)
+    : main_context{main_context},
+      should_dispatch{should_dispatch}
+{
+    static GSourceFuncs gsource_funcs{
+        ActionGSource::prepare,
+        ActionGSource::check,
+        ActionGSource::dispatch,
+        nullptr,
+        nullptr,
+        nullptr
+    };
+
+    gsource = GSourceHandle{
+        g_source_new(&gsource_funcs, sizeof(ActionGSource)),
+        [](GSource*) {}};
+    reinterpret_cast<ActionGSource*>(static_cast<GSource*>(gsource))->queue = this;
+
+    g_source_attach(gsource, main_context);
+}
+
+md::ActionQueue::~ActionQueue()
+{
+    gsource = GSourceHandle{};
+
+    // If we come to this before dispatching an action we have already
+    // torn down most of Mir and even unloaded some shared libraries.
+    // That means the action could refer to stuff that is no longer
+    // in the address space.
+    // We will just leak any resources instead of crashing.
+    for (auto& action : pending)
+    {
+        action.release();
+    }
+}
+
+void md::ActionQueue::enqueue(void const* owner, std::function<void()> action)
+{
+    push(std::unique_ptr<Action>{new Action{owner, true, std::move(action), nullptr}});
+}
+
+void md::ActionQueue::spawn(std::function<void()> action)
+{
+    push(std::unique_ptr<Action>{new Action{nullptr, false, std::move(action), nullptr}});
+}
+
+void md::ActionQueue::push(std::unique_ptr<Action> action)
+{
+    auto const pushed = action.release();
+    auto previous = incoming.load(std::memory_order_relaxed);
+    do
+    {
+        pushed->next = previous;
+    }
+    while (!incoming.compare_exchange_weak(previous, pushed, std::memory_order_release, std::memory_order_relaxed));
+
+    // The main loop may have taken (and run) the action already, so don't look at it again. If there were actions
+    // waiting before it the main loop has already been woken for them.
+    if (!previous)
+    {
+        g_main_context_wakeup(main_context);
+    }
+}
+
+void md::ActionQueue::take_incoming()
+{
+    auto const first = pending.size();
+    for (auto action = incoming.exchange(nullptr, std::memory_order_acquire); action; action = action->next)
+    {
+        pending.emplace_back(action);
+    }
+    std::reverse(pending.begin() + first, pending.end());
+}
+
+auto md::ActionQueue::can_dispatch(Action const& action) const -> bool
+{
+    return !action.pausable || should_dispatch(action.owner);
+}
+
+auto md::ActionQueue::ready() -> bool
+{
+    take_incoming();
+    return std::any_of(
+        pending.begin(), pending.end(),
+        [this](auto const& action) { return can_dispatch(*action); });
+}
+
+void md::ActionQueue::dispatch()
+{
+    take_incoming();
+    std::swap(dispatching, pending);
+
+    // Once an owner's action is held back its later actions are too, so they stay in order
+    std::vector<void const*> held_back;
+    for (auto& action : dispatching)
+    {
+        auto const owner_held_back =
+            action->pausable && std::find(held_back.begin(), held_back.end(), action->owner) != held_back.end();
+
+        if (owner_held_back || !can_dispatch(*action))
+        {
+            if (!owner_held_back)
+            {
+                held_back.push_back(action->owner);
+            }
+            pending.push_back(std::move(action));
+        }
+        else
+        {
+            action->action();
+        }
+    }
+    dispatching.clear();
+}
+
 /*************
  * FdSources *
  *************/
@@ -23,10 +23,15 @@
 #include "mir/input/scene.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/executor.h"
+#include "mir/geometry/rectangles.h"
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
+#include <cstring>
+#include <optional>
 #include <stdexcept>
 #include <mutex>
+#include <string_view>
 
 namespace mg = mir::graphics;
 namespace mi = mir::input;
@@ -35,6 +40,8 @@ namespace mrs = mir::renderer::software;
 
 namespace
 {
+/// Enough for the frames of an animated cursor, and the few static cursors in use at any time
+std::size_t const max_cached_buffers = 32;
 
 MirPixelFormat get_8888_format(std::vector<MirPixelFormat> const& formats)
 {
@@ -71,12 +78,13 @@ public:
 
     std::shared_ptr<mg::Buffer> buffer() const override
     {
+        std::lock_guard lock{mutex};
         return buffer_;
     }
 
     geom::Rectangle screen_position() const override
     {
-        std::lock_guard lock{position_mutex};
+        std::lock_guard lock{mutex};
         return {position, buffer_->size()};
     }
 
@@ -100,6 +108,16 @@ public:
         return true;
     }
 
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        return std::nullopt;
+    }
+
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        return {};
+    }
+
     auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> override
     {
@@ -108,13 +126,27 @@ public:
 
     void move_to(geom::Point new_position)
     {
-        std::lock_guard lock{position_mutex};
+        std::lock_guard lock{mutex};
+        position = new_position;
+    }
+
+    /// Changes the image of a renderable that may already be in the scene.
+    ///
+    /// The compositor reads buffer() and screen_position() separately, so a frame composited while this runs can pair
+    /// one image with the other's position (and size). For that one frame the hotspot is off by the difference
+    /// between the images' hotspots, and the image is stretched if their sizes differ. Swapping in a new renderable
+    /// would avoid this, but adding and removing a renderable is a scene change that wakes every compositor, which is
+    /// too much for each frame of an animated cursor.
+    void replace(std::shared_ptr<mg::Buffer> const& new_buffer, geom::Point new_position)
+    {
+        std::lock_guard lock{mutex};
+        buffer_ = new_buffer;
         position = new_position;
     }
 
 private:
-    std::shared_ptr<mg::Buffer> const buffer_;
-    mutable std::mutex position_mutex;
+    mutable std::mutex mutex;
+    std::shared_ptr<mg::Buffer> buffer_;
     geom::Point position;
 };
 
@@ -138,49 +170,87 @@ mg::SoftwareCursor::~SoftwareCursor()
 
 void mg::SoftwareCursor::show(CursorImage const& cursor_image)
 {
-    std::lock_guard lg{guard};
+    std::optional<geom::Rectangles> damage;
 
-    auto const to_remove = visible ? renderable : nullptr;
+    {
+        std::lock_guard lg{guard};
 
-    geom::Point position{0,0};
-    if (renderable)
-        position = renderable->screen_position().top_left;
+        auto const buffer = buffer_for(cursor_image);
 
-    renderable = create_renderable_for(cursor_image, position);
-    hotspot = cursor_image.hotspot();
-    visible = true;
+        geom::Point position{0,0};
+        if (renderable)
+            position = renderable->screen_position().top_left;
+        position = position + hotspot - cursor_image.hotspot();
+        hotspot = cursor_image.hotspot();
 
-    scene_executor->spawn([scene = scene, to_remove = to_remove, to_add = renderable]()
+        if (!renderable)
         {
-            // Add the new renderable first, then remove the old one to avoid visual glitches
-            scene->add_input_visualization(to_add);
+            renderable = std::make_shared<detail::CursorRenderable>(buffer, position);
+        }
+        else
+        {
+            auto const old_area = renderable->screen_position();
+            auto const old_buffer = renderable->buffer();
+            renderable->replace(buffer, position);
 
-            if (to_remove)
-            {
-                scene->remove_input_visualization(to_remove);
-            }
-        });
+            // The renderable is already in the scene, so only the area it covered and now covers needs redrawing
+            if (visible && (buffer != old_buffer || old_area != renderable->screen_position()))
+                damage = geom::Rectangles{old_area, renderable->screen_position()};
+        }
+
+        if (!visible)
+        {
+            visible = true;
+            scene_executor->spawn([scene = scene, to_add = renderable]()
+                {
+                    scene->add_input_visualization(to_add);
+                });
+        }
+    }
+
+    if (damage)
+        scene->emit_scene_damaged(*damage);
 }
 
-std::shared_ptr<mg::detail::CursorRenderable>
-mg::SoftwareCursor::create_renderable_for(CursorImage const& cursor_image, geom::Point position)
+auto mg::SoftwareCursor::buffer_for(CursorImage const& cursor_image) -> std::shared_ptr<Buffer>
 {
-    if (cursor_image.size().width.as_uint32_t() == 0 || cursor_image.size().height.as_uint32_t() == 0)
+    auto const size = cursor_image.size();
+    if (size.width.as_uint32_t() == 0 || size.height.as_uint32_t() == 0)
         BOOST_THROW_EXCEPTION(std::logic_error("zero sized software cursor image is invalid"));
 
+    auto const stride = size.width.as_uint32_t() * MIR_BYTES_PER_PIXEL(mir_pixel_format_argb_8888);
+    auto const pixels = static_cast<unsigned char const*>(cursor_image.as_argb_8888());
+    std::size_t const byte_count = stride * size.height.as_uint32_t();
+    auto const hash = std::hash<std::string_view>{}({reinterpret_cast<char const*>(pixels), byte_count});
+
+    auto const cached = std::find_if(buffer_cache.begin(), buffer_cache.end(),
+        [&](CachedBuffer const& entry)
+        {
+            return entry.hash == hash &&
+                   entry.size == size &&
+                   std::memcmp(entry.pixels.data(), pixels, byte_count) == 0;
+        });
+
+    if (cached != buffer_cache.end())
+    {
+        std::rotate(buffer_cache.begin(), cached, cached + 1);
+        return buffer_cache.front().buffer;
+    }
+
     auto buffer = mrs::alloc_buffer_with_content(
         *allocator,
-        static_cast<unsigned char const*>(cursor_image.as_argb_8888()),
-        cursor_image.size(),
-        geom::Stride{
-            cursor_image.size().width.as_uint32_t() * MIR_BYTES_PER_PIXEL(mir_pixel_format_argb_8888)},
+        pixels,
+        size,
+        geom::Stride{stride},
         mir_pixel_format_argb_8888);
 
-    auto new_renderable = std::make_shared<detail::CursorRenderable>(
-        std::move(buffer),
-        position + hotspot - cursor_image.hotspot());
+    if (buffer_cache.size() == max_cached_buffers)
+        buffer_cache.pop_back();
+    buffer_cache.insert(
+        buffer_cache.begin(),
+        CachedBuffer{hash, size, std::vector<unsigned char>(pixels, pixels + byte_count), buffer});
 
-    return new_renderable;
+    return buffer;
 }
 
 void mg::SoftwareCursor::hide()
@@ -200,15 +270,23 @@ void mg::SoftwareCursor::hide()
 
 void mg::SoftwareCursor::move_to(geometry::Point position)
 {
+    geom::Rectangles damage;
+
     {
         std::lock_guard lg{guard};
 
         if (!renderable)
             return;
 
+        auto const old_area = renderable->screen_position();
         renderable->move_to(position - hotspot);
+
+        if (!visible || old_area.top_left == position - hotspot)
+            return;
+
+        damage = {old_area, renderable->screen_position()};
     }
 
     // This doesn't need to be called in a specific order with other potential calls, so it doesn't go on the executor
-    scene->emit_scene_changed();
+    scene->emit_scene_damaged(damage);
 }
@@ -20,7 +20,10 @@
 #include "mir/graphics/cursor.h"
 #include "mir_toolkit/client_types.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/size.h"
+
 #include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -28,6 +31,7 @@ class Executor;
 namespace input { class Scene; }
 namespace graphics
 {
+class Buffer;
 class GraphicBufferAllocator;
 class Renderable;
 
@@ -50,8 +54,18 @@ public:
     void move_to(geometry::Point position) override;
 
 private:
-    std::shared_ptr<detail::CursorRenderable> create_renderable_for(
-        CursorImage const& cursor_image, geometry::Point position);
+    /// A buffer holding a cursor image that has been shown, so showing the same image again (as animated cursors do
+    /// on every frame) doesn't allocate a new buffer
+    struct CachedBuffer
+    {
+        std::size_t hash;
+        geometry::Size size;
+        std::vector<unsigned char> pixels;
+        std::shared_ptr<Buffer> buffer;
+    };
+
+    /// Returns a buffer with the content of \p cursor_image, from the cache if it has been shown recently
+    auto buffer_for(CursorImage const& cursor_image) -> std::shared_ptr<Buffer>;
 
     std::shared_ptr<GraphicBufferAllocator> const allocator;
     std::shared_ptr<input::Scene> const scene;
@@ -65,6 +79,8 @@ private:
     std::shared_ptr<detail::CursorRenderable> renderable;
     bool visible;
     geometry::Displacement hotspot;
+    /// Most recently used first. Buffers are never written after they are created, so can be shared between showings.
+    std::vector<CachedBuffer> buffer_cache;
 };
 
 }
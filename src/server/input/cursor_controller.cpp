@@ -151,6 +151,12 @@ struct UpdateCursorOnSceneChanges : ms::Observer
         cursor_controller->update_cursor_image();
     }
 
+    void scene_damaged(geom::Rectangles const&) override
+    {
+        // Only input visualizations (such as the cursor itself) damage the scene, so the surface
+        // under the cursor is unchanged
+    }
+
     void surface_exists(std::shared_ptr<ms::Surface> const& surface) override
     {
         add_surface_observer(surface.get());
@@ -265,7 +265,10 @@ mir::DefaultServerConfiguration::the_input_reading_multiplexer()
     return input_reading_multiplexer(
         []() -> std::shared_ptr<mir::dispatch::MultiplexingDispatchable>
         {
-            return std::make_shared<mir::dispatch::MultiplexingDispatchable>();
+            // Only the "Mir/Input Reader" thread dispatches this, so it can take events in batches
+            auto const multiplexer = std::make_shared<mir::dispatch::MultiplexingDispatchable>();
+            multiplexer->set_max_events_per_dispatch(mir::dispatch::MultiplexingDispatchable::max_batch_size);
+            return multiplexer;
         }
     );
 }
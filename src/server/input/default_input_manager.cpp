@@ -154,7 +154,8 @@ void mi::DefaultInputManager::stop()
 void mi::DefaultInputManager::start_platforms()
 {
     platform->start();
-    multiplexer->add_watch(platform->dispatchable());
+    // Only the input thread dispatches the multiplexer, so one-shot monitoring isn't needed
+    multiplexer->add_watch(platform->dispatchable(), dispatch::DispatchReentrancy::reentrant);
 }
 
 void mi::DefaultInputManager::stop_platforms()
@@ -83,6 +83,16 @@ public:
         return true;
     }
 
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        return std::nullopt;
+    }
+
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        return {};
+    }
+
     auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> override
     {
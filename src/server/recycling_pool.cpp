@@ -0,0 +1,84 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/recycling_pool.h"
+
+#include <algorithm>
+
+namespace
+{
+// More than enough of each size for any plausible scene; beyond this, give memory back
+std::size_t constexpr max_free_blocks = 1024;
+}
+
+mir::RecyclingPool::~RecyclingPool()
+{
+    for (auto const& [size, blocks] : free_blocks)
+    {
+        for (auto const block : blocks)
+        {
+            ::operator delete(block);
+        }
+    }
+}
+
+auto mir::RecyclingPool::allocate(std::size_t size) -> void*
+{
+    {
+        std::lock_guard lock{mutex};
+        auto const blocks = std::find_if(
+            free_blocks.begin(),
+            free_blocks.end(),
+            [size](auto const& entry) { return entry.first == size; });
+
+        if (blocks != free_blocks.end() && !blocks->second.empty())
+        {
+            auto const block = blocks->second.back();
+            blocks->second.pop_back();
+            return block;
+        }
+    }
+
+    return ::operator new(size);
+}
+
+void mir::RecyclingPool::deallocate(void* block, std::size_t size) noexcept
+{
+    std::lock_guard lock{mutex};
+    try
+    {
+        auto blocks = std::find_if(
+            free_blocks.begin(),
+            free_blocks.end(),
+            [size](auto const& entry) { return entry.first == size; });
+
+        if (blocks == free_blocks.end())
+        {
+            blocks = free_blocks.emplace(free_blocks.end(), size, std::vector<void*>{});
+        }
+
+        if (blocks->second.size() < max_free_blocks)
+        {
+            blocks->second.push_back(block);
+            return;
+        }
+    }
+    catch (std::bad_alloc const&)
+    {
+    }
+
+    ::operator delete(block);
+}
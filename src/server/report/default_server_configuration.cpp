@@ -21,6 +21,7 @@
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
+#include "metrics/compositor_report.h"
 
 #include "mir/abnormal_exit.h"
 
@@ -64,7 +65,17 @@ auto mir::DefaultServerConfiguration::the_compositor_report() -> std::shared_ptr
     return compositor_report(
         [this]()->std::shared_ptr<mc::CompositorReport>
         {
-            return report_factory(options::compositor_report_opt)->create_compositor_report();
+            auto report = report_factory(options::compositor_report_opt)->create_compositor_report();
+
+            if (the_options()->is_set(options::compositor_metrics_opt))
+            {
+                report = std::make_shared<report::metrics::CompositorReport>(
+                    report,
+                    the_clock(),
+                    the_options()->get<std::string>(options::compositor_metrics_opt));
+            }
+
+            return report;
         });
 }
 
@@ -49,6 +49,10 @@ void mrl::CompositorReport::added_display(int width, int height, int x, int y, S
     logger->log(ml::Severity::informational, msg, component);
 }
 
+void mrl::CompositorReport::began_scene_snapshot(SubCompositorId)
+{
+}
+
 void mrl::CompositorReport::began_frame(SubCompositorId id)
 {
     std::lock_guard lock(mutex);
@@ -72,6 +76,10 @@ void mrl::CompositorReport::rendered_frame(SubCompositorId id)
     inst.bypassed = false;
 }
 
+void mrl::CompositorReport::overlaid_frame(SubCompositorId, size_t)
+{
+}
+
 void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id)
 {
     // The first report is a valid sample, but don't log anything because
@@ -164,6 +172,10 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::posted_frame(SubCompositorId)
+{
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
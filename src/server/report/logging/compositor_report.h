@@ -41,10 +41,13 @@ public:
     CompositorReport(std::shared_ptr<mir::logging::Logger> const& logger,
                      std::shared_ptr<time::Clock> const& clock);
     void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_scene_snapshot(SubCompositorId id) override;
     void began_frame(SubCompositorId id) override;
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
+    void overlaid_frame(SubCompositorId id, size_t overlays) override;
     void finished_frame(SubCompositorId id) override;
+    void posted_frame(SubCompositorId id) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
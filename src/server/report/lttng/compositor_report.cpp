@@ -36,6 +36,11 @@ void mir::report::lttng::CompositorReport::added_display(int width, int height,
     mir_tracepoint(mir_server_compositor, added_display, width, height, x, y, id);
 }
 
+void mir::report::lttng::CompositorReport::began_scene_snapshot(SubCompositorId id)
+{
+    mir_tracepoint(mir_server_compositor, began_scene_snapshot, id);
+}
+
 void mir::report::lttng::CompositorReport::began_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, began_frame, id);
@@ -56,7 +61,17 @@ void mir::report::lttng::CompositorReport::rendered_frame(SubCompositorId id)
     mir_tracepoint(mir_server_compositor, rendered_frame, id);
 }
 
+void mir::report::lttng::CompositorReport::overlaid_frame(SubCompositorId id, size_t overlays)
+{
+    mir_tracepoint(mir_server_compositor, overlaid_frame, id, overlays);
+}
+
 void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::posted_frame(SubCompositorId id)
+{
+    mir_tracepoint(mir_server_compositor, posted_frame, id);
+}
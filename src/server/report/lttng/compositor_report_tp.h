@@ -57,6 +57,13 @@ TRACEPOINT_EVENT_CLASS(
     )
 )
 
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_compositor,
+    subcompositor_event,
+    began_scene_snapshot,
+    TP_ARGS(void const*, id)
+)
+
 TRACEPOINT_EVENT_INSTANCE(
     mir_server_compositor,
     subcompositor_event,
@@ -78,6 +85,23 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(void const*, id)
 )
 
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_compositor,
+    subcompositor_event,
+    posted_frame,
+    TP_ARGS(void const*, id)
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    overlaid_frame,
+    TP_ARGS(void const*, id, size_t, overlays),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(size_t, overlays, overlays)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
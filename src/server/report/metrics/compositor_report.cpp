@@ -0,0 +1,427 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compositor_report.h"
+#include "mir/thread_name.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <vector>
+
+namespace mrm = mir::report::metrics;
+namespace chrono = std::chrono;
+
+namespace
+{
+/// Each power of two is split into 2^sub_bucket_bits buckets
+auto const sub_bucket_bits = 3;
+auto const sub_buckets = 1u << sub_bucket_bits;
+
+struct
+{
+    double value;
+    char const* label;
+} const quantiles[] = {{0.5, "0.5"}, {0.95, "0.95"}, {0.99, "0.99"}};
+
+auto quantile_us(mrm::Histogram::Sample const& sample, double q) -> std::optional<uint64_t>
+{
+    if (sample.count == 0)
+    {
+        return std::nullopt;
+    }
+
+    auto const rank = std::max<uint64_t>(1, std::ceil(q * sample.count));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket != mrm::Histogram::bucket_count; ++bucket)
+    {
+        seen += sample.counts[bucket];
+        if (seen >= rank)
+        {
+            auto const limit = mrm::Histogram::bucket_limit(bucket);
+            return sample.max_us ? std::min(limit, sample.max_us) : limit;
+        }
+    }
+    return sample.max_us;
+}
+
+void write_seconds(std::ostream& out, std::optional<uint64_t> us)
+{
+    if (us)
+    {
+        out << std::fixed << std::setprecision(6) << *us / 1e6 << '\n';
+    }
+    else
+    {
+        out << "NaN\n";
+    }
+}
+}
+
+void mrm::Histogram::record(chrono::microseconds duration)
+{
+    uint64_t const us = std::max<chrono::microseconds::rep>(duration.count(), 0);
+
+    // Only one thread records, so there's no need for atomic read-modify-writes...
+    auto& count = counts[bucket_for(us)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    total_count.store(total_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    total_us.store(total_us.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
+
+    // ...except for the maximum, which sample() resets
+    auto max = max_us.load(std::memory_order_relaxed);
+    while (us > max && !max_us.compare_exchange_weak(max, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+void mrm::Histogram::sample(Sample& sample)
+{
+    sample.count = 0;
+    for (size_t bucket = 0; bucket != bucket_count; ++bucket)
+    {
+        auto const count = counts[bucket].load(std::memory_order_relaxed);
+        sample.counts[bucket] = count - sampled[bucket];
+        sample.count += sample.counts[bucket];
+        sampled[bucket] = count;
+    }
+    sample.max_us = max_us.exchange(0, std::memory_order_relaxed);
+    sample.total_count = total_count.load(std::memory_order_relaxed);
+    sample.total_us = total_us.load(std::memory_order_relaxed);
+}
+
+void mrm::Histogram::reset()
+{
+    for (auto& count : counts)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+    max_us.store(0, std::memory_order_relaxed);
+    total_count.store(0, std::memory_order_relaxed);
+    total_us.store(0, std::memory_order_relaxed);
+    sampled.fill(0);
+}
+
+auto mrm::Histogram::bucket_for(uint64_t us) -> size_t
+{
+    if (us < sub_buckets)
+    {
+        return us;
+    }
+
+    auto const exponent = std::bit_width(us) - 1;
+    auto const shift = exponent - sub_bucket_bits;
+    auto const bucket = (shift + 1) * sub_buckets + ((us >> shift) & (sub_buckets - 1));
+    return std::min<size_t>(bucket, bucket_count - 1);
+}
+
+auto mrm::Histogram::bucket_limit(size_t bucket) -> uint64_t
+{
+    if (bucket < sub_buckets)
+    {
+        return bucket;
+    }
+
+    auto const shift = bucket / sub_buckets - 1;
+    auto const lower = (sub_buckets + bucket % sub_buckets) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+mrm::CompositorReport::CompositorReport(
+    std::shared_ptr<mir::compositor::CompositorReport> const& next,
+    std::shared_ptr<time::Clock> const& clock,
+    std::filesystem::path const& metrics_file,
+    chrono::milliseconds write_interval)
+    : next{next},
+      clock{clock},
+      metrics_file{metrics_file},
+      write_interval{write_interval},
+      writer{[this]
+          {
+              mir::set_thread_name("Mir/Metrics");
+
+              std::unique_lock lock{writer_mutex};
+              while (!stop_requested.wait_for(lock, this->write_interval, [this] { return stopping; }))
+              {
+                  lock.unlock();
+                  write_metrics_file();
+                  lock.lock();
+              }
+          }}
+{
+}
+
+mrm::CompositorReport::~CompositorReport()
+{
+    {
+        std::lock_guard lock{writer_mutex};
+        stopping = true;
+    }
+    stop_requested.notify_one();
+    writer.join();
+}
+
+auto mrm::CompositorReport::output_for(SubCompositorId id) -> Output*
+{
+    auto const count = output_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (outputs[i].id.load(std::memory_order_relaxed) == id)
+        {
+            return &outputs[i];
+        }
+    }
+    return nullptr;
+}
+
+void mrm::CompositorReport::added_display(int width, int height, int x, int y, SubCompositorId id)
+{
+    next->added_display(width, height, x, y, id);
+
+    std::lock_guard lock{mutex};
+    auto const count = output_count.load(std::memory_order_relaxed);
+    if (output_for(id) || count == max_outputs)
+    {
+        return;
+    }
+
+    auto& output = outputs[count];
+    output.id.store(id, std::memory_order_relaxed);
+    output.width.store(width, std::memory_order_relaxed);
+    output.height.store(height, std::memory_order_relaxed);
+    output.x.store(x, std::memory_order_relaxed);
+    output.y.store(y, std::memory_order_relaxed);
+
+    // The slot may have measured an output before the compositor last stopped
+    output.scene_snapshot_time.reset();
+    output.render_time.reset();
+    output.post_wait.reset();
+    output.latency.reset();
+    output.frames.store(0, std::memory_order_relaxed);
+    output.bypassed_frames.store(0, std::memory_order_relaxed);
+    output.overlaid_frames.store(0, std::memory_order_relaxed);
+    output.snapshot_start = TimePoint{};
+    output_count.store(count + 1, std::memory_order_release);
+}
+
+void mrm::CompositorReport::began_scene_snapshot(SubCompositorId id)
+{
+    next->began_scene_snapshot(id);
+
+    if (auto const output = output_for(id))
+    {
+        // Only frames that were asked for have a latency
+        auto const scheduled = last_scheduled.load(std::memory_order_relaxed);
+        output->latency_start = scheduled > output->snapshot_start ? scheduled : TimePoint{};
+        output->snapshot_start = clock->now();
+    }
+}
+
+void mrm::CompositorReport::began_frame(SubCompositorId id)
+{
+    next->began_frame(id);
+
+    if (auto const output = output_for(id))
+    {
+        output->frame_start = clock->now();
+        output->rendered = false;
+        output->overlays = 0;
+        output->scene_snapshot_time.record(
+            chrono::duration_cast<chrono::microseconds>(output->frame_start - output->snapshot_start));
+    }
+}
+
+void mrm::CompositorReport::renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables)
+{
+    next->renderables_in_frame(id, renderables);
+}
+
+void mrm::CompositorReport::rendered_frame(SubCompositorId id)
+{
+    next->rendered_frame(id);
+
+    if (auto const output = output_for(id))
+    {
+        output->rendered = true;
+        output->render_time.record(
+            chrono::duration_cast<chrono::microseconds>(clock->now() - output->frame_start));
+    }
+}
+
+void mrm::CompositorReport::overlaid_frame(SubCompositorId id, size_t overlays)
+{
+    next->overlaid_frame(id, overlays);
+
+    if (auto const output = output_for(id))
+    {
+        output->overlays = overlays;
+    }
+}
+
+void mrm::CompositorReport::finished_frame(SubCompositorId id)
+{
+    next->finished_frame(id);
+
+    if (auto const output = output_for(id))
+    {
+        output->frame_end = clock->now();
+        output->frames.fetch_add(1, std::memory_order_relaxed);
+        if (!output->rendered)
+        {
+            output->bypassed_frames.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (output->overlays)
+        {
+            output->overlaid_frames.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void mrm::CompositorReport::posted_frame(SubCompositorId id)
+{
+    next->posted_frame(id);
+
+    if (auto const output = output_for(id))
+    {
+        auto const now = clock->now();
+        output->post_wait.record(chrono::duration_cast<chrono::microseconds>(now - output->frame_end));
+        if (output->latency_start != TimePoint{})
+        {
+            output->latency.record(chrono::duration_cast<chrono::microseconds>(now - output->latency_start));
+        }
+    }
+}
+
+void mrm::CompositorReport::started()
+{
+    next->started();
+}
+
+void mrm::CompositorReport::stopped()
+{
+    next->stopped();
+
+    // The compositor threads have gone; their replacements will add their outputs again
+    std::lock_guard lock{mutex};
+    output_count.store(0, std::memory_order_release);
+}
+
+void mrm::CompositorReport::scheduled()
+{
+    next->scheduled();
+
+    last_scheduled.store(clock->now(), std::memory_order_relaxed);
+}
+
+void mrm::CompositorReport::write_metrics(std::ostream& out)
+{
+    std::lock_guard lock{mutex};
+    auto const count = output_count.load(std::memory_order_relaxed);
+
+    auto const write_labels = [&out](Output const& output)
+        {
+            out << "{output=\"" << output.id.load(std::memory_order_relaxed) << "\",geometry=\""
+                << output.width.load(std::memory_order_relaxed) << 'x'
+                << output.height.load(std::memory_order_relaxed)
+                << std::showpos << output.x.load(std::memory_order_relaxed)
+                << output.y.load(std::memory_order_relaxed) << std::noshowpos << '"';
+        };
+
+    auto const write_counter = [&](char const* name, char const* help, std::atomic<uint64_t> Output::* counter)
+        {
+            out << "# TYPE mir_compositor_" << name << " counter\n"
+                << "# HELP mir_compositor_" << name << ' ' << help << '\n';
+            for (size_t i = 0; i != count; ++i)
+            {
+                out << "mir_compositor_" << name << "_total";
+                write_labels(outputs[i]);
+                out << "} " << (outputs[i].*counter).load(std::memory_order_relaxed) << '\n';
+            }
+        };
+
+    auto const write_histogram = [&](char const* name, char const* help, Histogram Output::* histogram)
+        {
+            std::vector<Histogram::Sample> samples(count);
+            for (size_t i = 0; i != count; ++i)
+            {
+                (outputs[i].*histogram).sample(samples[i]);
+            }
+
+            out << "# TYPE mir_compositor_" << name << "_seconds summary\n"
+                << "# UNIT mir_compositor_" << name << "_seconds seconds\n"
+                << "# HELP mir_compositor_" << name << "_seconds Distribution of " << help
+                << " (quantiles are of the frames since the last update)\n";
+            for (size_t i = 0; i != count; ++i)
+            {
+                for (auto const q : quantiles)
+                {
+                    out << "mir_compositor_" << name << "_seconds";
+                    write_labels(outputs[i]);
+                    out << ",quantile=\"" << q.label << "\"} ";
+                    write_seconds(out, quantile_us(samples[i], q.value));
+                }
+                out << "mir_compositor_" << name << "_seconds_sum";
+                write_labels(outputs[i]);
+                out << "} ";
+                write_seconds(out, samples[i].total_us);
+                out << "mir_compositor_" << name << "_seconds_count";
+                write_labels(outputs[i]);
+                out << "} " << samples[i].total_count << '\n';
+            }
+
+            out << "# TYPE mir_compositor_" << name << "_max_seconds gauge\n"
+                << "# UNIT mir_compositor_" << name << "_max_seconds seconds\n"
+                << "# HELP mir_compositor_" << name << "_max_seconds Longest " << help
+                << " since the last update\n";
+            for (size_t i = 0; i != count; ++i)
+            {
+                out << "mir_compositor_" << name << "_max_seconds";
+                write_labels(outputs[i]);
+                out << "} ";
+                write_seconds(out, samples[i].count ? std::optional{samples[i].max_us} : std::nullopt);
+            }
+        };
+
+    write_counter("frames", "Frames composited", &Output::frames);
+    write_counter("bypassed_frames", "Frames shown without rendering", &Output::bypassed_frames);
+    write_counter("overlaid_frames", "Rendered frames shown with overlays", &Output::overlaid_frames);
+    write_histogram("scene_snapshot_time", "time taken to snapshot the scene", &Output::scene_snapshot_time);
+    write_histogram("render_time", "time taken to render a frame", &Output::render_time);
+    write_histogram("post_wait", "time from finishing a frame to it being posted", &Output::post_wait);
+    write_histogram("latency", "time from compositing being scheduled to the frame being posted", &Output::latency);
+    out << "# EOF\n";
+}
+
+void mrm::CompositorReport::write_metrics_file()
+{
+    // Write a new file and replace the old one, so readers never see a partial update
+    auto temporary = metrics_file;
+    temporary += ".tmp";
+    {
+        std::ofstream out{temporary};
+        write_metrics(out);
+        if (!out)
+        {
+            return;
+        }
+    }
+
+    std::error_code ignored;
+    std::filesystem::rename(temporary, metrics_file, ignored);
+}
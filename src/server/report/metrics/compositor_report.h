@@ -0,0 +1,163 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
+#define MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
+
+#include "mir/compositor/compositor_report.h"
+#include "mir/time/clock.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+namespace mir
+{
+namespace report
+{
+namespace metrics
+{
+/// A histogram of durations, with buckets no wider than an eighth of their lower bound
+///
+/// One thread may record() while another takes samples.
+class Histogram
+{
+public:
+    static size_t const bucket_count = 312;
+
+    struct Sample
+    {
+        std::array<uint64_t, bucket_count> counts;  ///< Since the last sample
+        uint64_t count;                             ///< Since the last sample
+        uint64_t max_us;                            ///< Since the last sample
+        uint64_t total_count;
+        uint64_t total_us;
+    };
+
+    void record(std::chrono::microseconds duration);
+
+    /// The durations recorded since the last sample
+    void sample(Sample& sample);
+
+    /// Forgets everything recorded, while nothing is recording or sampling
+    void reset();
+
+    /// The smallest bucket that includes \p us
+    static auto bucket_for(uint64_t us) -> size_t;
+    /// The largest duration (in microseconds) counted in \p bucket
+    static auto bucket_limit(size_t bucket) -> uint64_t;
+
+private:
+    std::array<std::atomic<uint64_t>, bucket_count> counts{};
+    std::atomic<uint64_t> max_us{0};
+    std::atomic<uint64_t> total_count{0};
+    std::atomic<uint64_t> total_us{0};
+
+    /// The counts at the last sample
+    std::array<uint64_t, bucket_count> sampled{};
+};
+
+/**
+ * Records the distribution of frame timings for each output, and periodically writes their
+ * percentiles to a file in OpenMetrics text format. Each report is also passed on to \p next.
+ *
+ * The compositor threads' reports don't take any locks.
+ */
+class CompositorReport : public mir::compositor::CompositorReport
+{
+public:
+    CompositorReport(
+        std::shared_ptr<mir::compositor::CompositorReport> const& next,
+        std::shared_ptr<time::Clock> const& clock,
+        std::filesystem::path const& metrics_file,
+        std::chrono::milliseconds write_interval = std::chrono::seconds{1});
+    ~CompositorReport();
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_scene_snapshot(SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void overlaid_frame(SubCompositorId id, size_t overlays) override;
+    void finished_frame(SubCompositorId id) override;
+    void posted_frame(SubCompositorId id) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+
+    /// Writes the metrics for the frames since the last call
+    void write_metrics(std::ostream& out);
+
+    /// Outputs beyond this many are not measured
+    static size_t const max_outputs = 16;
+
+private:
+    using TimePoint = time::Timestamp;
+
+    struct alignas(64) Output
+    {
+        std::atomic<SubCompositorId> id{nullptr};
+        std::atomic<int> width{0}, height{0}, x{0}, y{0};
+
+        Histogram scene_snapshot_time;
+        Histogram render_time;
+        Histogram post_wait;
+        Histogram latency;
+
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> bypassed_frames{0};
+        std::atomic<uint64_t> overlaid_frames{0};
+
+        // Only used by the output's compositor thread
+        TimePoint snapshot_start;
+        TimePoint frame_start;
+        TimePoint frame_end;
+        TimePoint latency_start;    ///< Or TimePoint{} if compositing wasn't scheduled since the last frame
+        bool rendered{false};
+        size_t overlays{0};
+    };
+
+    auto output_for(SubCompositorId id) -> Output*;
+    void write_metrics_file();
+
+    std::shared_ptr<mir::compositor::CompositorReport> const next;
+    std::shared_ptr<time::Clock> const clock;
+    std::filesystem::path const metrics_file;
+    std::chrono::milliseconds const write_interval;
+
+    std::array<Output, max_outputs> outputs;
+    std::atomic<size_t> output_count{0};
+    std::atomic<TimePoint> last_scheduled;
+
+    std::mutex mutex;   // Serializes adding and removing outputs, and writing metrics
+
+    std::mutex writer_mutex;
+    std::condition_variable stop_requested;
+    bool stopping{false};
+    std::thread writer;
+};
+}
+}
+}
+
+#endif // MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
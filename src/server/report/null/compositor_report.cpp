@@ -22,6 +22,10 @@ void mrn::CompositorReport::added_display(int, int, int, int, SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::began_scene_snapshot(SubCompositorId)
+{
+}
+
 void mrn::CompositorReport::began_frame(SubCompositorId)
 {
 }
@@ -34,10 +38,18 @@ void mrn::CompositorReport::rendered_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::overlaid_frame(SubCompositorId, size_t)
+{
+}
+
 void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::posted_frame(SubCompositorId)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
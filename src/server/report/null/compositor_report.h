@@ -30,10 +30,13 @@ class CompositorReport : public compositor::CompositorReport
 {
 public:
     void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_scene_snapshot(SubCompositorId id) override;
     void began_frame(SubCompositorId id) override;
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
+    void overlaid_frame(SubCompositorId id, size_t overlays) override;
     void finished_frame(SubCompositorId id) override;
+    void posted_frame(SubCompositorId id) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -140,6 +140,21 @@ ms::BasicIdleHub::~BasicIdleHub()
 
 void ms::BasicIdleHub::poke()
 {
+    // Only ever raise the time, as a concurrent poke that read the clock earlier may store after this one. If a later
+    // time is already there, it covers this poke.
+    auto const now = clock->now();
+    auto coalesced = coalesced_poke_time.load();
+    while (coalesced < now && !coalesced_poke_time.compare_exchange_weak(coalesced, now))
+    {
+    }
+
+    // This and take_coalesced_pokes() use sequentially consistent operations, so either this sees that pokes can no
+    // longer skip the lock or take_coalesced_pokes() sees this poke
+    if (coalesce_pokes.load())
+    {
+        return;
+    }
+
     poke_locked(*synchronised_state.lock());
 }
 
@@ -162,6 +177,7 @@ void ms::BasicIdleHub::register_interest(
     }
 
     auto state = synchronised_state.lock();
+    take_coalesced_pokes(*state);
     auto const iter = state->timeouts.find(timeout);
     std::shared_ptr<Multiplexer> multiplexer;
     if (iter == state->timeouts.end())
@@ -195,6 +211,7 @@ void ms::BasicIdleHub::register_interest(
         multiplexer = iter->second;
     }
 
+    update_coalescing(*state);
     multiplexer->register_and_send_initial_state(observer, executor);
 }
 
@@ -232,6 +249,7 @@ void ms::BasicIdleHub::poke_locked(State& state)
             multiplexer->active();
         }
     }
+    update_coalescing(state);
 }
 
 void ms::BasicIdleHub::alarm_fired(State& state)
@@ -241,6 +259,13 @@ void ms::BasicIdleHub::alarm_fired(State& state)
         // Possible if the alarm is fired but fails to get the lock until after it's been canceled
         return;
     }
+    if (take_coalesced_pokes(state))
+    {
+        // We've been poked since the alarm was scheduled, so nothing is idle yet
+        schedule_alarm(state, state.poke_time);
+        update_coalescing(state);
+        return;
+    }
     auto const iter = state.timeouts.find(state.alarm_timeout.value());
     if (iter != state.timeouts.end())
     {
@@ -248,6 +273,26 @@ void ms::BasicIdleHub::alarm_fired(State& state)
         state.idle_multiplexers.push_back(iter->second);
     }
     schedule_alarm(state, state.poke_time + state.alarm_timeout.value());
+    update_coalescing(state);
+}
+
+auto ms::BasicIdleHub::take_coalesced_pokes(State& state) -> bool
+{
+    coalesce_pokes.store(false);
+    auto const coalesced = coalesced_poke_time.load();
+    if (coalesced > state.poke_time)
+    {
+        state.poke_time = coalesced;
+        return true;
+    }
+    return false;
+}
+
+void ms::BasicIdleHub::update_coalescing(State& state)
+{
+    // A poke has to take the lock if it needs to make an idle observer active, or if idle is inhibited (in which case
+    // the alarm isn't scheduled, and so can't catch up with the poke)
+    coalesce_pokes.store(state.idle_multiplexers.empty() && state.wake_lock.expired());
 }
 
 void ms::BasicIdleHub::schedule_alarm(State& state, time::Timestamp current_time)
@@ -310,6 +355,7 @@ auto ms::BasicIdleHub::inhibit_idle() -> std::shared_ptr<WakeLock>
         auto result = std::make_shared<WakeLock>(shared_from_this());
         alarm->cancel();
         state->wake_lock = result;
+        update_coalescing(*state);
         return result;
     }
 }
@@ -22,6 +22,7 @@
 #include "mir/time/types.h"
 #include "mir/synchronised.h"
 
+#include <atomic>
 #include <mutex>
 #include <map>
 
@@ -40,6 +41,10 @@ namespace scene
 /// when the alarm fires it notifies the observer it is is now idle. When this class gets poked (generally by an input
 /// event), Mir is no longer considered to be idle and any idle observers get notified. After each poke the alarm gets
 /// rescheduled based on the first timeout.
+///
+/// While nothing is idle and idle is not inhibited a poke only needs to push the alarm back, so it just records the poke
+/// time without taking the lock. The alarm then fires at the time due from an earlier poke, notices the later one and
+/// reschedules itself.
 class BasicIdleHub : public IdleHub, public std::enable_shared_from_this<BasicIdleHub>
 {
 public:
@@ -87,10 +92,19 @@ private:
     void poke_locked(State& state);
     void alarm_fired(State& state);
     void schedule_alarm(State& state, time::Timestamp current_time);
+    /// Stops pokes skipping the lock, and brings state.poke_time up to date with any that did
+    /// \returns true if there were any
+    auto take_coalesced_pokes(State& state) -> bool;
+    /// Lets pokes skip the lock if they only need to push the alarm back
+    void update_coalescing(State& state);
 
     std::shared_ptr<time::Clock> const clock;
     std::unique_ptr<time::Alarm> const alarm;
     mir::Synchronised<State> synchronised_state;
+    /// The time of the last poke that didn't take the lock
+    std::atomic<time::Timestamp> coalesced_poke_time{};
+    /// If pokes can skip the lock. Only set while the lock is held.
+    std::atomic<bool> coalesce_pokes{false};
 };
 }
 }
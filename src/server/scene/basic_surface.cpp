@@ -22,7 +22,8 @@
 #include "mir/graphics/null_display_configuration_observer.h"
 #include "mir/geometry/displacement.h"
 #include "mir/renderer/sw/pixel_source.h"
-#include "mir/observer_multiplexer.h"
+#include "mir/snapshot_observer_multiplexer.h"
+#include "mir/recycling_pool.h"
 #include "mir/scene/surface_observer.h"
 
 #include "mir/scene/scene_report.h"
@@ -30,6 +31,7 @@
 #include <boost/throw_exception.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <latch>
 #include <stdexcept>
@@ -62,11 +64,11 @@ private:
     BasicSurface* surface;
 };
 
-class ms::BasicSurface::Multiplexer : public ObserverMultiplexer<SurfaceObserver>
+class ms::BasicSurface::Multiplexer : public SnapshotObserverMultiplexer<SurfaceObserver>
 {
 public:
     Multiplexer()
-        : ObserverMultiplexer{linearising_executor}
+        : SnapshotObserverMultiplexer{linearising_executor}
     {
     }
 
@@ -169,6 +171,11 @@ public:
     {
         for_each_observer(&SurfaceObserver::left_output, surf, id);
     }
+
+    void input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region) override
+    {
+        for_each_observer(&SurfaceObserver::input_region_set_to, surf, region);
+    }
 };
 
 namespace
@@ -319,6 +326,7 @@ std::shared_ptr<mf::BufferStream> ms::BasicSurface::primary_buffer_stream() cons
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
 {
     synchronised_state.lock()->custom_input_rectangles = input_rectangles;
+    observers->input_region_set_to(this, input_rectangles);
 }
 
 std::vector<geom::Rectangle> ms::BasicSurface::get_input_region() const
@@ -695,6 +703,7 @@ public:
         std::optional<geom::Rectangle> const& clip_area,
         glm::mat4 const& transform,
         float alpha,
+        std::vector<geom::Rectangle> const& opaque_region,
         mg::Renderable::ID id,
         ms::Surface const* surface)
     : entry{std::move(buffer)},
@@ -705,6 +714,13 @@ public:
       id_{id},
       surface{surface}
     {
+        for (auto rect : opaque_region)
+        {
+            rect.top_left = rect.top_left + as_displacement(top_left);
+            rect = intersection_of(rect, screen_position_);
+            if (rect.size.width > geom::Width{} && rect.size.height > geom::Height{})
+                opaque_region_.add(rect);
+        }
     }
 
     ~SurfaceSnapshot()
@@ -731,6 +747,48 @@ public:
     bool shaped() const override
     { return entry->pixel_format().has_alpha(); }
 
+    auto opaque_region() const -> geom::Rectangles override
+    { return opaque_region_; }
+
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        auto const buffer_damage = entry->damage();
+        if (!buffer_damage)
+        {
+            return std::nullopt;
+        }
+
+        // Map the damage from the sampled region of the buffer onto the screen
+        auto const source = entry->source_rect();
+        if (source.size.width.as_value() <= 0 || source.size.height.as_value() <= 0)
+        {
+            return std::nullopt;
+        }
+        auto const x_scale = screen_position_.size.width.as_value() / source.size.width.as_value();
+        auto const y_scale = screen_position_.size.height.as_value() / source.size.height.as_value();
+
+        geom::Rectangles result;
+        for (auto const& rect : *buffer_damage)
+        {
+            auto const left = static_cast<int>(std::floor((rect.left().as_value() - source.left().as_value()) * x_scale));
+            auto const top = static_cast<int>(std::floor((rect.top().as_value() - source.top().as_value()) * y_scale));
+            auto const right = static_cast<int>(std::ceil((rect.right().as_value() - source.left().as_value()) * x_scale));
+            auto const bottom = static_cast<int>(std::ceil((rect.bottom().as_value() - source.top().as_value()) * y_scale));
+
+            auto const on_screen = intersection_of(
+                geom::Rectangle{
+                    screen_position_.top_left + geom::Displacement{left, top},
+                    geom::Size{right - left, bottom - top}},
+                screen_position_);
+
+            if (on_screen.size.width > geom::Width{0} && on_screen.size.height > geom::Height{0})
+            {
+                result.add(on_screen);
+            }
+        }
+        return result;
+    }
+
     mg::Renderable::ID id() const override
     { return id_; }
 
@@ -744,6 +802,7 @@ private:
     geom::Rectangle const screen_position_;
     std::optional<geom::Rectangle> const clip_area_;
     glm::mat4 const transformation_;
+    geom::Rectangles opaque_region_;
     mg::Renderable::ID const id_;
     ms::Surface const* surface;
 };
@@ -780,6 +839,21 @@ void ms::BasicSurface::set_streams(std::list<scene::StreamInfo> const& s)
     observers->moved_to(this, surface_top_left);
 }
 
+namespace
+{
+/**
+ * The storage for snapshots taken on this thread
+ *
+ * Each compositor runs on its own thread, so this recycles one compositor's snapshots
+ * from frame to frame without contention.
+ */
+auto snapshot_pool() -> std::shared_ptr<mir::RecyclingPool> const&
+{
+    thread_local auto const pool = std::make_shared<mir::RecyclingPool>();
+    return pool;
+}
+}
+
 mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) const
 {
     auto state = synchronised_state.lock();
@@ -797,12 +871,14 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
     {
         if (info.stream->has_submitted_buffer())
         {
-            list.emplace_back(std::make_shared<SurfaceSnapshot>(
+            list.emplace_back(std::allocate_shared<SurfaceSnapshot>(
+                snapshot_pool()->allocator<SurfaceSnapshot>(),
                 info.stream->next_submission_for_compositor(id),
                 content_top_left_ + info.displacement,
                 state->clip_area,
                 state->transformation_matrix,
                 state->surface_alpha,
+                info.opaque_region,
                 info.stream.get(),
                 this));
         }
@@ -39,3 +39,4 @@ void ms::NullSurfaceObserver::depth_layer_set_to(Surface const*, MirDepthLayer)
 void ms::NullSurfaceObserver::application_id_set_to(Surface const*, std::string const&) {}
 void ms::NullSurfaceObserver::entered_output(Surface const*, graphics::DisplayConfigurationOutputId const&) {};
 void ms::NullSurfaceObserver::left_output(Surface const*, graphics::DisplayConfigurationOutputId const&) {};
+void ms::NullSurfaceObserver::input_region_set_to(Surface const*, std::vector<geometry::Rectangle> const&) {}
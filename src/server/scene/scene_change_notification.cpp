@@ -19,6 +19,7 @@
 #include "mir/scene/scene_change_notification.h"
 #include "mir/scene/surface.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangles.h"
 
 #include <boost/throw_exception.hpp>
 
@@ -94,6 +95,12 @@ void ms::SceneChangeNotification::scene_changed()
     scene_notify_change();
 }
 
+void ms::SceneChangeNotification::scene_damaged(geom::Rectangles const& damage)
+{
+    for (auto const& rect : damage)
+        damage_notify_change(rect);
+}
+
 void ms::SceneChangeNotification::end_observation()
 {
     std::unique_lock lg(surface_observers_guard);
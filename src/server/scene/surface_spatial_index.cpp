@@ -0,0 +1,165 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_spatial_index.h"
+
+#include <algorithm>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Cells are cell_size × cell_size pixels
+int const cell_shift = 8;
+/// Surfaces overlapping more cells than this (e.g. fullscreen surfaces) aren't worth indexing
+int64_t const max_cells_per_surface = 64;
+
+auto cell_of(int coordinate) -> int32_t
+{
+    // Arithmetic shift rounds towards -∞, which is what we want for negative coordinates
+    return coordinate >> cell_shift;
+}
+}
+
+void ms::SurfaceSpatialIndex::clear()
+{
+    cells.clear();
+    unindexed.clear();
+    entries.clear();
+}
+
+void ms::SurfaceSpatialIndex::insert(
+    std::shared_ptr<Surface> const& surface,
+    geom::Rectangle const& bounds,
+    uint64_t z)
+{
+    auto& entry = entries[surface.get()];
+    if (entry)
+    {
+        remove_from_cells(*entry);
+        entry->bounds = bounds;
+        entry->z = z;
+    }
+    else
+    {
+        entry = std::make_unique<Entry>(Entry{surface, bounds, z});
+    }
+    add_to_cells(*entry);
+}
+
+void ms::SurfaceSpatialIndex::update(Surface const* surface, geom::Rectangle const& bounds)
+{
+    auto const found = entries.find(surface);
+    if (found == entries.end() || found->second->bounds == bounds)
+        return;
+
+    auto& entry = *found->second;
+    remove_from_cells(entry);
+    entry.bounds = bounds;
+    add_to_cells(entry);
+}
+
+auto ms::SurfaceSpatialIndex::find_at(
+    geom::Point point,
+    std::function<bool(std::shared_ptr<Surface> const&)> const& f) const -> std::shared_ptr<Surface>
+{
+    static std::vector<Entry const*> const no_entries;
+    auto const cell = cells.find(cell_key(cell_of(point.x.as_int()), cell_of(point.y.as_int())));
+    auto const& in_cell = cell != cells.end() ? cell->second : no_entries;
+
+    // Both lists are topmost first, so merge them to visit candidates in stacking order
+    auto i = in_cell.begin();
+    auto j = unindexed.begin();
+    while (i != in_cell.end() || j != unindexed.end())
+    {
+        Entry const* candidate;
+        if (j == unindexed.end() || (i != in_cell.end() && (*i)->z > (*j)->z))
+            candidate = *i++;
+        else
+            candidate = *j++;
+
+        if (candidate->bounds.contains(point) && f(candidate->surface))
+            return candidate->surface;
+    }
+
+    return {};
+}
+
+auto ms::SurfaceSpatialIndex::cell_key(int32_t column, int32_t row) -> CellKey
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(column)) << 32) | static_cast<uint32_t>(row);
+}
+
+bool ms::SurfaceSpatialIndex::for_each_cell(geom::Rectangle const& bounds, std::function<void(CellKey)> const& f)
+{
+    if (bounds.size.width.as_int() <= 0 || bounds.size.height.as_int() <= 0)
+        return true;
+
+    auto const left = cell_of(bounds.left().as_int());
+    auto const top = cell_of(bounds.top().as_int());
+    auto const right = cell_of(bounds.right().as_int() - 1);
+    auto const bottom = cell_of(bounds.bottom().as_int() - 1);
+
+    if (int64_t{right - left + 1} * int64_t{bottom - top + 1} > max_cells_per_surface)
+        return false;
+
+    for (auto row = top; row <= bottom; ++row)
+    {
+        for (auto column = left; column <= right; ++column)
+        {
+            f(cell_key(column, row));
+        }
+    }
+    return true;
+}
+
+void ms::SurfaceSpatialIndex::add_to_cells(Entry const& entry)
+{
+    auto const indexed = for_each_cell(
+        entry.bounds,
+        [&](CellKey key) { insert_sorted(cells[key], &entry); });
+
+    if (!indexed)
+        insert_sorted(unindexed, &entry);
+}
+
+void ms::SurfaceSpatialIndex::remove_from_cells(Entry const& entry)
+{
+    auto const indexed = for_each_cell(
+        entry.bounds,
+        [&](CellKey key)
+        {
+            auto const cell = cells.find(key);
+            if (cell == cells.end())
+                return;
+
+            std::erase(cell->second, &entry);
+            if (cell->second.empty())
+                cells.erase(cell);
+        });
+
+    if (!indexed)
+        std::erase(unindexed, &entry);
+}
+
+void ms::SurfaceSpatialIndex::insert_sorted(std::vector<Entry const*>& list, Entry const* entry)
+{
+    auto const position = std::upper_bound(
+        list.begin(), list.end(), entry,
+        [](Entry const* a, Entry const* b) { return a->z > b->z; });
+    list.insert(position, entry);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
+#define MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+class Surface;
+
+/**
+ * Buckets surfaces into a grid by their input bounds, so that hit-testing only considers
+ * surfaces near the point being tested
+ *
+ * The index only knows each surface's bounds and position in the stacking order; whether a
+ * surface really accepts input at a point is left to the caller. Not thread safe.
+ */
+class SurfaceSpatialIndex
+{
+public:
+    /// Remove all surfaces
+    void clear();
+
+    /**
+     * Add \p surface, or update its bounds if already present
+     *
+     * \param [in] z    Position in the stacking order; higher is nearer the top
+     */
+    void insert(std::shared_ptr<Surface> const& surface, geometry::Rectangle const& bounds, uint64_t z);
+
+    /// Update the bounds of \p surface, if present
+    void update(Surface const* surface, geometry::Rectangle const& bounds);
+
+    /**
+     * Call \p f for each surface whose bounds contain \p point, topmost first, until it returns true
+     *
+     * \returns The surface \p f returned true for, if any
+     */
+    auto find_at(
+        geometry::Point point,
+        std::function<bool(std::shared_ptr<Surface> const&)> const& f) const -> std::shared_ptr<Surface>;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Surface> surface;
+        geometry::Rectangle bounds;
+        uint64_t z;
+    };
+    using CellKey = uint64_t;
+
+    static auto cell_key(int32_t column, int32_t row) -> CellKey;
+    /// Call \p f with the key of each cell \p bounds overlaps; false if there are too many to index
+    static bool for_each_cell(geometry::Rectangle const& bounds, std::function<void(CellKey)> const& f);
+
+    void add_to_cells(Entry const& entry);
+    void remove_from_cells(Entry const& entry);
+    static void insert_sorted(std::vector<Entry const*>& list, Entry const* entry);
+
+    std::unordered_map<Surface const*, std::unique_ptr<Entry>> entries;
+    /// Surfaces overlapping each (non-empty) cell, topmost first
+    std::unordered_map<CellKey, std::vector<Entry const*>> cells;
+    /// Surfaces with bounds too large to usefully index, topmost first; checked for every point
+    std::vector<Entry const*> unindexed;
+};
+
+}
+}
+
+#endif /* MIR_SCENE_SURFACE_SPATIAL_INDEX_H_ */
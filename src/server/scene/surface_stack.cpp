@@ -16,6 +16,7 @@
 
 #include "surface_stack.h"
 #include "rendering_tracker.h"
+#include "mir/recycling_pool.h"
 #include "mir/scene/surface.h"
 #include "mir/scene/null_surface_observer.h"
 #include "mir/scene/scene_report.h"
@@ -23,6 +24,7 @@
 #include "mir/graphics/renderable.h"
 #include "mir/depth_layer.h"
 #include "mir/executor.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/log.h"
 
 #include <boost/throw_exception.hpp>
@@ -47,14 +49,12 @@ class SurfaceSceneElement : public mc::SceneElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
-        std::shared_ptr<mg::Renderable> const& renderable,
+        std::shared_ptr<mg::Renderable> renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
         mc::CompositorID id)
-        : renderable_{renderable},
+        : renderable_{std::move(renderable)},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
+          cid{id}
     {
     }
 
@@ -65,19 +65,20 @@ public:
 
     void rendered() override
     {
-        tracker->rendered_in(cid);
+        if (tracker)
+            tracker->rendered_in(cid);
     }
 
     void occluded() override
     {
-        tracker->occluded_in(cid);
+        if (tracker)
+            tracker->occluded_in(cid);
     }
 
 private:
     std::shared_ptr<mg::Renderable> const renderable_;
     std::shared_ptr<ms::RenderingTracker> const tracker;
     mc::CompositorID cid;
-    std::string const surface_name;
 };
 
 //note: something different than a 2D/HWC overlay
@@ -107,12 +108,35 @@ private:
     std::shared_ptr<mg::Renderable> const renderable_;
 };
 
+template<typename Element, typename... Args>
+auto make_element(mir::RecyclingPool* pool, Args&&... args) -> std::shared_ptr<mc::SceneElement>
+{
+    if (pool)
+    {
+        return std::allocate_shared<Element>(pool->allocator<Element>(), std::forward<Args>(args)...);
+    }
+    return std::make_shared<Element>(std::forward<Args>(args)...);
+}
+
+/// The area in which \p surface might accept input: its content area, plus any of its input region that reaches
+/// outside that (client-side resize margins, or subsurfaces sticking out of the window geometry)
+auto input_index_bounds(ms::Surface const& surface) -> geom::Rectangle
+{
+    auto const content = surface.input_bounds();
+    geom::Rectangles bounds{content};
+    for (auto const& rect : surface.get_input_region())
+    {
+        bounds.add({rect.top_left + as_displacement(content.top_left), rect.size});
+    }
+    return bounds.bounding_rectangle();
+}
+
 /**
- * A SurfaceDepthLayerObserver must not outlive the SurfaceStack it was created for
+ * A SurfaceStackObserver must not outlive the SurfaceStack it was created for
  */
-struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
+struct SurfaceStackObserver : ms::NullSurfaceObserver
 {
-    SurfaceDepthLayerObserver(ms::SurfaceStack* stack)
+    SurfaceStackObserver(ms::SurfaceStack* stack)
         : stack{stack}
     {
     }
@@ -123,6 +147,26 @@ struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
         stack->raise(surface);
     }
 
+    void moved_to(ms::Surface const* surface, geom::Point const& /*top_left*/) override
+    {
+        stack->update_input_bounds(surface);
+    }
+
+    void window_resized_to(ms::Surface const* surface, geom::Size const& /*window_size*/) override
+    {
+        stack->update_input_bounds(surface);
+    }
+
+    void content_resized_to(ms::Surface const* surface, geom::Size const& /*content_size*/) override
+    {
+        stack->update_input_bounds(surface);
+    }
+
+    void input_region_set_to(ms::Surface const* surface, std::vector<geom::Rectangle> const& /*region*/) override
+    {
+        stack->update_input_bounds(surface);
+    }
+
 private:
     ms::SurfaceStack* stack;
 };
@@ -132,7 +176,7 @@ private:
 ms::SurfaceStack::SurfaceStack(std::shared_ptr<SceneReport> const& report) :
     report{report},
     scene_changed{false},
-    surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)},
+    surface_observer{std::make_shared<SurfaceStackObserver>(this)},
     multiplexer(linearising_executor)
 {
 }
@@ -154,29 +198,41 @@ mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID i
     RecursiveReadLock lg(guard);
 
     scene_changed = false;
+
+    // Registered compositors reuse the storage of their previous frames' elements
+    auto const registered = element_storage.find(id);
+    auto const storage = registered != element_storage.end() ? &registered->second : nullptr;
+    auto const pool = storage ? storage->pool.get() : nullptr;
+
     mc::SceneElementSequence elements;
+    if (storage)
+        elements.reserve(storage->elements_per_frame.load(std::memory_order_relaxed));
+
     for (auto const& layer : surface_layers)
     {
         for (auto const& surface : layer)
         {
             if (surface_can_be_shown(surface) && surface->visible())
             {
+                // Don't use operator[]: we only hold a read lock
+                auto const found = rendering_trackers.find(surface.get());
+                auto const tracker = found != rendering_trackers.end() ? found->second : nullptr;
+
                 for (auto& renderable : surface->generate_renderables(id))
                 {
                     elements.emplace_back(
-                        std::make_shared<SurfaceSceneElement>(
-                            surface->name(),
-                            renderable,
-                            rendering_trackers[surface.get()],
-                            id));
+                        make_element<SurfaceSceneElement>(pool, std::move(renderable), tracker, id));
                 }
             }
         }
     }
     for (auto const& renderable : overlays)
     {
-        elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
+        elements.emplace_back(make_element<OverlaySceneElement>(pool, renderable));
     }
+
+    if (storage)
+        storage->elements_per_frame.store(elements.size(), std::memory_order_relaxed);
     return elements;
 }
 
@@ -185,6 +241,7 @@ void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
     RecursiveWriteLock lg(guard);
 
     registered_compositors.insert(cid);
+    element_storage[cid].pool = std::make_shared<RecyclingPool>();
 
     update_rendering_tracker_compositors();
 }
@@ -194,6 +251,7 @@ void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
     RecursiveWriteLock lg(guard);
 
     registered_compositors.erase(cid);
+    element_storage.erase(cid);
 
     update_rendering_tracker_compositors();
 }
@@ -234,6 +292,15 @@ void ms::SurfaceStack::emit_scene_changed()
     observers.scene_changed();
 }
 
+void ms::SurfaceStack::emit_scene_damaged(geometry::Rectangles const& damage)
+{
+    {
+        RecursiveWriteLock lg(guard);
+        scene_changed = true;
+    }
+    observers.scene_damaged(damage);
+}
+
 void ms::SurfaceStack::add_surface(
     std::shared_ptr<Surface> const& surface,
     mi::InputReceptionMode input_mode)
@@ -241,6 +308,7 @@ void ms::SurfaceStack::add_surface(
     {
         RecursiveWriteLock lg(guard);
         insert_surface_at_top_of_depth_layer(surface);
+        reindex_input_bounds();
         create_rendering_tracker_for(surface);
         surface->register_interest(surface_observer, immediate_executor);
     }
@@ -265,6 +333,7 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
             if (surface != layer.end())
             {
                 layer.erase(surface);
+                reindex_input_bounds();
                 rendering_trackers.erase(keep_alive.get());
                 keep_alive->unregister_interest(*surface_observer);
                 found_surface = true;
@@ -281,37 +350,21 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     // TODO: error logging when surface not found
 }
 
-namespace
-{
-template <typename Container>
-struct InReverse {
-    Container& container;
-    auto begin() -> decltype(container.rbegin()) { return container.rbegin(); }
-    auto end() -> decltype(container.rend()) { return container.rend(); }
-};
-
-template <typename Container>
-InReverse<Container> in_reverse(Container& container) { return InReverse<Container>{container}; }
-}
-
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
     RecursiveReadLock lg(guard);
-    for (auto const& layer : in_reverse(surface_layers))
-    {
-        for (auto const& surface : in_reverse(layer))
-        {
-            // TODO There's a lack of clarity about how the input area will
-            // TODO be maintained and whether this test will detect clicks on
-            // TODO decorations (it should) as these may be outside the area
-            // TODO known to the client.  But it works for now.
-            if (surface_can_be_shown(surface) && surface->input_area_contains(cursor))
-                    return surface;
-        }
-    }
 
-    return {};
+    // TODO There's a lack of clarity about how the input area will
+    // TODO be maintained and whether this test will detect clicks on
+    // TODO decorations (it should) as these may be outside the area
+    // TODO known to the client.  But it works for now.
+    return input_index.find_at(
+        cursor,
+        [&](std::shared_ptr<Surface> const& surface)
+        {
+            return surface_can_be_shown(surface) && surface->input_area_contains(cursor);
+        });
 }
 
 auto ms::SurfaceStack::input_surface_at(geometry::Point point) const -> std::shared_ptr<input::Surface>
@@ -340,6 +393,7 @@ void ms::SurfaceStack::raise(Surface const* surface)
                 std::shared_ptr<Surface> surface_shared = *p;
                 layer.erase(p);
                 insert_surface_at_top_of_depth_layer(surface_shared);
+                reindex_input_bounds();
                 affected_surfaces.insert(surface_shared);
                 break;
             }
@@ -391,6 +445,9 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             if (old_layer != layer)
                 surfaces_reordered = true;
         }
+
+        if (surfaces_reordered)
+            reindex_input_bounds();
     }
 
     if (surfaces_reordered)
@@ -457,6 +514,8 @@ void ms::SurfaceStack::swap_z_order(SurfaceSet const& first, SurfaceSet const& s
                     return to_back.count(s2) == 0;
             });
         }
+
+        reindex_input_bounds();
     }
 
     observers.surfaces_reordered(first);
@@ -491,6 +550,9 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
                 surfaces_reordered = true;
             }
         }
+
+        if (surfaces_reordered)
+            reindex_input_bounds();
     }
 
     if (surfaces_reordered)
@@ -524,6 +586,26 @@ void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(std::shared_ptr<Surf
     surface_layers[depth_index].push_back(surface);
 }
 
+void ms::SurfaceStack::update_input_bounds(Surface const* surface)
+{
+    RecursiveWriteLock lg(guard);
+    input_index.update(surface, input_index_bounds(*surface));
+}
+
+void ms::SurfaceStack::reindex_input_bounds()
+{
+    input_index.clear();
+
+    uint64_t z = 0;
+    for (auto const& layer : surface_layers)
+    {
+        for (auto const& surface : layer)
+        {
+            input_index.insert(surface, input_index_bounds(*surface), z++);
+        }
+    }
+}
+
 auto ms::SurfaceStack::surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool
 {
     return !is_locked || surface->visible_on_lock_screen();
@@ -656,6 +738,12 @@ void ms::Observers::scene_changed()
         { observer->scene_changed(); });
 }
 
+void ms::Observers::scene_damaged(geometry::Rectangles const& damage)
+{
+   for_each([&](std::shared_ptr<Observer> const& observer)
+        { observer->scene_damaged(damage); });
+}
+
 void ms::Observers::surface_exists(std::shared_ptr<Surface> const& surface)
 {
     for_each([&](std::shared_ptr<Observer> const& observer)
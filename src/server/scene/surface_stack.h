@@ -29,6 +29,7 @@
 #include "mir/basic_observers.h"
 #include "mir/scene/surface_observer.h"
 #include "mir/observer_multiplexer.h"
+#include "surface_spatial_index.h"
 
 #include <atomic>
 #include <map>
@@ -39,6 +40,7 @@
 namespace mir
 {
 class Executor;
+class RecyclingPool;
 namespace graphics
 {
 class Renderable;
@@ -59,6 +61,7 @@ public:
    void surface_removed(std::shared_ptr<Surface> const& surface) override;
    void surfaces_reordered(SurfaceSet const& affected_surfaces) override;
    void scene_changed() override;
+   void scene_damaged(geometry::Rectangles const& damage) override;
    void surface_exists(std::shared_ptr<Surface> const& surface) override;
    void end_observation() override;
 
@@ -101,6 +104,8 @@ public:
     void raise(SurfaceSet const& surfaces) override;
     void swap_z_order(SurfaceSet const& first, SurfaceSet const& second) override;
     void send_to_back(SurfaceSet const& surfaces) override;
+    /// Re-read the input bounds of \p surface after it has moved, resized or changed its input region
+    void update_input_bounds(Surface const* surface);
 
     void add_surface(
         std::shared_ptr<Surface> const& surface,
@@ -119,6 +124,7 @@ public:
     void remove_input_visualization(std::weak_ptr<graphics::Renderable> const& overlay) override;
 
     void emit_scene_changed() override;
+    void emit_scene_damaged(geometry::Rectangles const& damage) override;
     void lock() override;
     void unlock() override;
 
@@ -139,6 +145,8 @@ private:
     void update_rendering_tracker_compositors();
     void insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface);
     auto surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool;
+    /// Rebuild input_index after surface_layers has changed; requires the write lock
+    void reindex_input_bounds();
 
     RecursiveReadWriteMutex mutable guard;
 
@@ -152,8 +160,18 @@ private:
      * The inner vectors contain the list of surfaces on each layer (bottom to top)
      */
     std::vector<std::vector<std::shared_ptr<Surface>>> surface_layers;
+    /// The surfaces of surface_layers, indexed by input bounds for surface_at()
+    SurfaceSpatialIndex input_index;
     std::map<Surface*,std::shared_ptr<RenderingTracker>> rendering_trackers;
     std::set<compositor::CompositorID> registered_compositors;
+    struct ElementStorage
+    {
+        std::shared_ptr<RecyclingPool> pool;
+        /// The number of elements in the last frame, to size the next one
+        std::atomic<std::size_t> elements_per_frame{0};
+    };
+    /// Storage for the scene elements of each registered compositor
+    std::map<compositor::CompositorID, ElementStorage> element_storage;
 
     std::vector<std::shared_ptr<graphics::Renderable>> overlays;
 
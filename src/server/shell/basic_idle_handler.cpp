@@ -85,6 +85,16 @@ public:
         return false;
     }
 
+    auto damage() const -> std::optional<mir::geometry::Rectangles> override
+    {
+        return std::nullopt;
+    }
+
+    auto opaque_region() const -> mir::geometry::Rectangles override
+    {
+        return {};
+    }
+
     auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> override
     {
@@ -380,22 +380,31 @@ void msd::BasicDecoration::update(
         renderer->update_state(*window_state, *input_state);
     }
 
-    std::vector<std::pair<
-        std::shared_ptr<mc::BufferStream>,
-        std::optional<std::shared_ptr<mg::Buffer>>>> new_buffers;
-
+    struct NewBuffer
+    {
+        std::shared_ptr<mc::BufferStream> stream;
+        std::optional<std::shared_ptr<mg::Buffer>> buffer;
+        geom::Size dest_size;
+    };
+    std::vector<NewBuffer> new_buffers;
+
+    // The borders are a single pixel stretched over the border, the titlebar is drawn at the window's scale
+    // (frame-posted damage is the buffer's size, so a stretched border only damages its first pixel. The borders are
+    // only re-submitted alongside the titlebar or a change of geometry, which damage the window in their own right.)
     if (window_updated({
             &WindowState::focused_state,
             &WindowState::side_border_width,
             &WindowState::side_border_height,
             &WindowState::scale}))
     {
-        new_buffers.emplace_back(
+        new_buffers.push_back({
             buffer_streams->left_border,
-            renderer->render_left_border());
-        new_buffers.emplace_back(
+            renderer->render_left_border(),
+            window_state->left_border_rect().size});
+        new_buffers.push_back({
             buffer_streams->right_border,
-            renderer->render_right_border());
+            renderer->render_right_border(),
+            window_state->right_border_rect().size});
     }
 
     if (window_updated({
@@ -404,9 +413,10 @@ void msd::BasicDecoration::update(
             &WindowState::bottom_border_height,
             &WindowState::scale}))
     {
-        new_buffers.emplace_back(
+        new_buffers.push_back({
             buffer_streams->bottom_border,
-            renderer->render_bottom_border());
+            renderer->render_bottom_border(),
+            window_state->bottom_border_rect().size});
     }
 
     if (window_updated({
@@ -417,18 +427,20 @@ void msd::BasicDecoration::update(
         input_updated({
             &InputState::buttons}))
     {
-        new_buffers.emplace_back(
+        float const inv_scale = 1.0f / window_state->scale();
+        auto const titlebar = renderer->render_titlebar();
+        new_buffers.push_back({
             buffer_streams->titlebar,
-            renderer->render_titlebar());
+            titlebar,
+            titlebar ? titlebar.value()->size() * inv_scale : geom::Size{}});
     }
 
-    float inv_scale = 1.0f / window_state->scale();
-    for (auto const& pair : new_buffers)
+    for (auto const& new_buffer : new_buffers)
     {
-        if (pair.second)
-            pair.first->submit_buffer(
-                pair.second.value(),
-                pair.second.value()->size() * inv_scale,
-                {{0, 0}, geom::SizeD{pair.second.value()->size()}});
+        if (new_buffer.buffer)
+            new_buffer.stream->submit_buffer(
+                new_buffer.buffer.value(),
+                new_buffer.dest_size,
+                {{0, 0}, geom::SizeD{new_buffer.buffer.value()->size()}});
     }
 }
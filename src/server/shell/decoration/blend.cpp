@@ -0,0 +1,155 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "blend.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(MIR_DECORATION_NEON_BLEND)
+#include <arm_neon.h>
+#endif
+
+namespace msd = mir::shell::decoration;
+
+namespace
+{
+/// x / 255 (rounded down) for x <= 255 * 255, without a division
+inline auto div255(unsigned x) -> unsigned
+{
+    return (x + 1 + (x >> 8)) >> 8;
+}
+}
+
+void msd::blend_span(uint32_t* row, unsigned char const* coverage, int count, uint32_t color)
+{
+#if defined(__SSE2__)
+    blend_span_sse2(row, coverage, count, color);
+#elif defined(__ARM_NEON) && defined(MIR_DECORATION_NEON_BLEND)
+    blend_span_neon(row, coverage, count, color);
+#else
+    blend_span_scalar(row, coverage, count, color);
+#endif
+}
+
+void msd::blend_span_scalar(uint32_t* row, unsigned char const* coverage, int count, uint32_t color)
+{
+    auto const color_alpha = color >> 24;
+
+    for (int i = 0; i < count; ++i)
+    {
+        auto const weight = div255(coverage[i] * color_alpha);
+        uint32_t result = row[i] & 0xFF000000;
+        for (int shift = 0; shift != 24; shift += 8)
+        {
+            auto const pixel_channel = (row[i] >> shift) & 0xFF;
+            auto const color_channel = (color >> shift) & 0xFF;
+            result |= (div255(pixel_channel * (255 - weight)) + div255(color_channel * weight)) << shift;
+        }
+        row[i] = result;
+    }
+}
+
+#if defined(__SSE2__)
+void msd::blend_span_sse2(uint32_t* row, unsigned char const* coverage, int count, uint32_t color)
+{
+    auto const color_alpha = color >> 24;
+    int i = 0;
+
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const one = _mm_set1_epi16(1);
+    __m128i const max = _mm_set1_epi16(255);
+    __m128i const alpha16 = _mm_set1_epi16(color_alpha);
+    // The color of two pixels, one channel per 16-bit lane, with a zero weight for the alpha channel
+    __m128i const color16 = _mm_unpacklo_epi8(_mm_set1_epi32(color & 0x00FFFFFF), zero);
+    __m128i const rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+    auto const div255x8 = [&](__m128i x)
+        {
+            return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8);
+        };
+
+    auto const blend_two = [&](__m128i pixels16, __m128i weight16)
+        {
+            return _mm_add_epi16(
+                div255x8(_mm_mullo_epi16(pixels16, _mm_sub_epi16(max, weight16))),
+                div255x8(_mm_mullo_epi16(color16, weight16)));
+        };
+
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32_t four_coverages;
+        memcpy(&four_coverages, coverage + i, sizeof four_coverages);
+        if (!four_coverages)
+        {
+            continue;
+        }
+
+        // The weight of each pixel, repeated for each of its channels
+        __m128i const weights = div255x8(_mm_mullo_epi16(
+            _mm_unpacklo_epi8(_mm_cvtsi32_si128(four_coverages), zero), alpha16));
+        __m128i const paired_weights = _mm_unpacklo_epi16(weights, weights);
+        __m128i const weights01 = _mm_and_si128(_mm_unpacklo_epi32(paired_weights, paired_weights), rgb_mask);
+        __m128i const weights23 = _mm_and_si128(_mm_unpackhi_epi32(paired_weights, paired_weights), rgb_mask);
+
+        __m128i const pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + i));
+        __m128i const blended = _mm_packus_epi16(
+            blend_two(_mm_unpacklo_epi8(pixels, zero), weights01),
+            blend_two(_mm_unpackhi_epi8(pixels, zero), weights23));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), blended);
+    }
+
+    blend_span_scalar(row + i, coverage + i, count - i, color);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(MIR_DECORATION_NEON_BLEND)
+void msd::blend_span_neon(uint32_t* row, unsigned char const* coverage, int count, uint32_t color)
+{
+    auto const color_alpha = color >> 24;
+    int i = 0;
+
+    uint8x8_t const alpha8 = vdup_n_u8(color_alpha);
+    uint16x8_t const one = vdupq_n_u16(1);
+
+    auto const div255x8 = [&](uint16x8_t x)
+        {
+            return vshrn_n_u16(vaddq_u16(vaddq_u16(x, one), vshrq_n_u16(x, 8)), 8);
+        };
+
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x8_t const weights = div255x8(vmull_u8(vld1_u8(coverage + i), alpha8));
+        uint8x8_t const inverse_weights = vmvn_u8(weights);
+
+        // Deinterleave eight pixels into a vector per channel; the alpha channel is stored back unchanged
+        uint8x8x4_t pixels = vld4_u8(reinterpret_cast<uint8_t const*>(row + i));
+        for (int channel = 0; channel != 3; ++channel)
+        {
+            uint8x8_t const color_channel = vdup_n_u8((color >> (8 * channel)) & 0xFF);
+            pixels.val[channel] = vadd_u8(
+                div255x8(vmull_u8(pixels.val[channel], inverse_weights)),
+                div255x8(vmull_u8(color_channel, weights)));
+        }
+        vst4_u8(reinterpret_cast<uint8_t*>(row + i), pixels);
+    }
+
+    blend_span_scalar(row + i, coverage + i, count - i, color);
+}
+#endif
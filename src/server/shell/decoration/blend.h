@@ -0,0 +1,48 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_SHELL_DECORATION_BLEND_H_
+#define MIR_SHELL_DECORATION_BLEND_H_
+
+#include <cstdint>
+
+namespace mir
+{
+namespace shell
+{
+namespace decoration
+{
+/// Blends \p color into \p count pixels of \p row, weighted by \p coverage (one byte per pixel)
+///
+/// The alpha channel of \p row is left unchanged. Uses the fastest of the implementations below that is built in.
+void blend_span(uint32_t* row, unsigned char const* coverage, int count, uint32_t color);
+
+/// The reference implementation, used where there is no vector one and for the tail of a span
+void blend_span_scalar(uint32_t* row, unsigned char const* coverage, int count, uint32_t color);
+
+#if defined(__SSE2__)
+void blend_span_sse2(uint32_t* row, unsigned char const* coverage, int count, uint32_t color);
+#endif
+
+#if defined(__ARM_NEON) && defined(MIR_DECORATION_NEON_BLEND)
+void blend_span_neon(uint32_t* row, unsigned char const* coverage, int count, uint32_t color);
+#endif
+}
+}
+}
+
+#endif // MIR_SHELL_DECORATION_BLEND_H_
@@ -16,6 +16,7 @@
 
 
 #include "renderer.h"
+#include "blend.h"
 #include "window.h"
 #include "input.h"
 
@@ -29,8 +30,10 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <cstring>
 #include <locale>
 #include <codecvt>
+#include <unordered_map>
 
 namespace ms = mir::scene;
 namespace mg = mir::graphics;
@@ -213,16 +216,44 @@ public:
         Pixel color) override;
 
 private:
+    /// A rasterized glyph
+    struct Glyph
+    {
+        std::vector<unsigned char> coverage;    ///< One byte per pixel, row by row
+        int width;
+        int rows;
+        geom::Displacement offset;  ///< From the pen position to the top left of the bitmap
+        geom::Displacement advance;
+    };
+
+    /// A glyph, positioned relative to the top left of the text
+    struct PlacedGlyph
+    {
+        std::shared_ptr<Glyph const> glyph;
+        geom::Displacement offset;
+    };
+
+    using ShapedText = std::vector<PlacedGlyph>;
+
+    /// The caches are dropped when they grow beyond these
+    static size_t const max_cached_glyphs = 4096;
+    static size_t const max_cached_texts = 256;
+
     std::mutex mutex;
     FT_Library library;
     FT_Face face;
+    int char_size{0};
+    std::unordered_map<uint64_t, std::shared_ptr<Glyph const>> glyphs;    ///< By pixel size and codepoint
+    std::unordered_map<std::string, std::shared_ptr<ShapedText const>> shaped_texts;
 
+    auto shape(std::string const& text, geom::Height height) -> std::shared_ptr<ShapedText const>;
+    auto glyph_for(char32_t glyph, geom::Height height) -> std::shared_ptr<Glyph const>;
     void set_char_size(geom::Height height);
     void rasterize_glyph(char32_t glyph);
     void render_glyph(
         Pixel* buf,
         geom::Size buf_size,
-        FT_Bitmap const* glyph,
+        Glyph const& glyph,
         geom::Point top_left,
         Pixel color);
 
@@ -310,55 +341,106 @@ void msd::Renderer::Text::Impl::render(
     if (!area(buf_size) || height_pixels <= geom::Height{})
         return;
 
-    std::lock_guard lock{mutex};
+    std::shared_ptr<ShapedText const> shaped;
+    {
+        std::lock_guard lock{mutex};
 
-    if (!library || !face)
+        if (!library || !face)
+        {
+            log_warning("FreeType not initialized");
+            return;
+        }
+
+        shaped = shape(text, height_pixels);
+    }
+
+    // The glyphs are immutable, so there's no need to hold the lock while drawing them
+    for (auto const& placed : *shaped)
     {
-        log_warning("FreeType not initialized");
-        return;
+        render_glyph(buf, buf_size, *placed.glyph, top_left + placed.offset, color);
+    }
+}
+
+auto msd::Renderer::Text::Impl::shape(std::string const& text, geom::Height height)
+    -> std::shared_ptr<ShapedText const>
+{
+    auto key = std::to_string(height.as_int()) + ':' + text;
+    if (auto const found = shaped_texts.find(key); found != shaped_texts.end())
+    {
+        return found->second;
+    }
+
+    auto shaped = std::make_shared<ShapedText>();
+    geom::Displacement pen{};
+    for (char32_t const codepoint : utf8_to_utf32(text))
+    {
+        if (auto const glyph = glyph_for(codepoint, height))
+        {
+            shaped->push_back({glyph, pen + glyph->offset});
+            pen = pen + glyph->advance;
+        }
+    }
+
+    if (shaped_texts.size() >= max_cached_texts)
+    {
+        shaped_texts.clear();
+    }
+    shaped_texts.emplace(std::move(key), shaped);
+    return shaped;
+}
+
+auto msd::Renderer::Text::Impl::glyph_for(char32_t codepoint, geom::Height height) -> std::shared_ptr<Glyph const>
+{
+    auto const key = (uint64_t(height.as_int()) << 32) | codepoint;
+    if (auto const found = glyphs.find(key); found != glyphs.end())
+    {
+        return found->second;
     }
 
     try
     {
-        set_char_size(height_pixels);
+        set_char_size(height);
+        rasterize_glyph(codepoint);
     }
     catch (std::runtime_error const& error)
     {
         log_warning("%s", error.what());
-        return;
+        return nullptr;
     }
 
-    auto const utf32 = utf8_to_utf32(text);
+    auto const& slot = *face->glyph;
+    auto glyph = std::make_shared<Glyph>();
+    glyph->width = slot.bitmap.width;
+    glyph->rows = slot.bitmap.rows;
+    glyph->offset = {slot.bitmap_left, height.as_int() - slot.bitmap_top};
+    glyph->advance = {slot.advance.x / 64, slot.advance.y / 64};
+    glyph->coverage.resize(glyph->width * glyph->rows);
+    for (int y = 0; y != glyph->rows; ++y)
+    {
+        memcpy(
+            glyph->coverage.data() + y * glyph->width,
+            slot.bitmap.buffer + y * slot.bitmap.pitch,
+            glyph->width);
+    }
 
-    for (char32_t const glyph : utf32)
+    if (glyphs.size() >= max_cached_glyphs)
     {
-        try
-        {
-            rasterize_glyph(glyph);
-
-            geom::Point glyph_top_left =
-                top_left +
-                geom::Displacement{
-                    face->glyph->bitmap_left,
-                    height_pixels.as_int() - face->glyph->bitmap_top};
-            render_glyph(buf, buf_size, &face->glyph->bitmap, glyph_top_left, color);
-
-            top_left += geom::Displacement{
-                face->glyph->advance.x / 64,
-                face->glyph->advance.y / 64};
-        }
-        catch (std::runtime_error const& error)
-        {
-            log_warning("%s", error.what());
-        }
+        glyphs.clear();
     }
+    glyphs.emplace(key, glyph);
+    return glyph;
 }
 
 void msd::Renderer::Text::Impl::set_char_size(geom::Height height)
 {
+    if (char_size == height.as_int())
+        return;
+
     if (auto const error = FT_Set_Pixel_Sizes(face, 0, height.as_int()))
         BOOST_THROW_EXCEPTION(std::runtime_error(
             "Setting char size failed with error " + std::to_string(error)));
+
+    char_size = height.as_int();
 }
 
 namespace
@@ -397,40 +479,30 @@ void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
 void msd::Renderer::Text::Impl::render_glyph(
     Pixel* buf,
     geom::Size buf_size,
-    FT_Bitmap const* glyph,
+    Glyph const& glyph,
     geom::Point top_left,
     Pixel color)
 {
     geom::X const buffer_left = std::max(top_left.x, geom::X{});
-    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph->width}, as_x(buf_size.width));
+    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph.width}, as_x(buf_size.width));
 
     geom::Y const buffer_top = std::max(top_left.y, geom::Y{});
-    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph->rows}, as_y(buf_size.height));
+    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph.rows}, as_y(buf_size.height));
 
-    geom::Displacement const glyph_offset = as_displacement(top_left);
+    if (buffer_left >= buffer_right)
+        return;
 
-    unsigned char* const color_pixels = (unsigned char *)&color;
-    unsigned char const color_alpha = color_pixels[3];
+    geom::Displacement const glyph_offset = as_displacement(top_left);
+    geom::X const glyph_left = buffer_left - glyph_offset.dx;
 
     for (geom::Y buffer_y = buffer_top; buffer_y < buffer_bottom; buffer_y += geom::DeltaY{1})
     {
         geom::Y const glyph_y = buffer_y - glyph_offset.dy;
-        unsigned char* const glyph_row = glyph->buffer + glyph_y.as_int() * glyph->pitch;
-        Pixel* const buffer_row = buf + buffer_y.as_int() * buf_size.width.as_int();
-
-        for (geom::X buffer_x = buffer_left; buffer_x < buffer_right; buffer_x += geom::DeltaX{1})
-        {
-            geom::X const glyph_x = buffer_x - glyph_offset.dx;
-            unsigned char const glyph_alpha = ((int)glyph_row[glyph_x.as_int()] * color_alpha) / 255;
-            unsigned char* const buffer_pixels = (unsigned char *)(buffer_row + buffer_x.as_int());
-            for (int i = 0; i < 3; i++)
-            {
-                // Blend color with the previous buffer color based on the glyph's alpha
-                buffer_pixels[i] =
-                    ((int)buffer_pixels[i] * (255 - glyph_alpha)) / 255 +
-                    ((int)color_pixels[i] * glyph_alpha) / 255;
-            }
-        }
+        blend_span(
+            buf + buffer_y.as_int() * buf_size.width.as_int() + buffer_left.as_int(),
+            glyph.coverage.data() + glyph_y.as_int() * glyph.width + glyph_left.as_int(),
+            (buffer_right - buffer_left).as_int(),
+            color);
     }
 }
 
@@ -503,9 +575,6 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     {
         scale = new_scale;
 
-        needs_solid_color_redraw = true;
-        solid_color_pixels.reset(); // force a reallocation next time it's needed
-
         needs_titlebar_redraw = true;
         titlebar_pixels.reset(); // force a reallocation next time it's needed
 
@@ -516,20 +585,6 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     right_border_size = window_state.right_border_rect().size;
     bottom_border_size = window_state.bottom_border_rect().size;
 
-    size_t length{0};
-    length = std::max(length, area(left_border_size));
-    length = std::max(length, area(right_border_size));
-    length = std::max(length, area(bottom_border_size));
-
-    if (auto const scaled_length{static_cast<size_t>(length * scale * scale)};
-        length != solid_color_pixels_length ||
-        scaled_length != scaled_solid_color_pixels_length)
-    {
-        solid_color_pixels_length = length;
-        scaled_solid_color_pixels_length = scaled_length;
-        solid_color_pixels.reset(); // force a reallocation next time it's needed
-    }
-
     if (window_state.titlebar_rect().size != titlebar_size)
     {
         titlebar_size = window_state.titlebar_rect().size;
@@ -544,7 +599,6 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     {
         current_theme = new_theme;
         needs_titlebar_redraw = true;
-        needs_solid_color_redraw = true;
     }
 
     if (window_state.window_name() != name)
@@ -658,48 +712,32 @@ auto msd::Renderer::render_titlebar() -> std::optional<std::shared_ptr<mg::Buffe
 
 auto msd::Renderer::render_left_border() -> std::optional<std::shared_ptr<mg::Buffer>>
 {
-    auto const scaled_left_border_size{left_border_size * scale};
-    if (!area(scaled_left_border_size))
-        return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), scaled_left_border_size);
+    return solid_color_buffer(left_border_size);
 }
 
 auto msd::Renderer::render_right_border() -> std::optional<std::shared_ptr<mg::Buffer>>
 {
-    auto const scaled_right_border_size{right_border_size * scale};
-    if (!area(scaled_right_border_size))
-        return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), scaled_right_border_size);
+    return solid_color_buffer(right_border_size);
 }
 
 auto msd::Renderer::render_bottom_border() -> std::optional<std::shared_ptr<mg::Buffer>>
 {
-    auto const scaled_bottom_border_size{bottom_border_size * scale};
-    if (!area(scaled_bottom_border_size))
-        return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), scaled_bottom_border_size);
+    return solid_color_buffer(bottom_border_size);
 }
 
-void msd::Renderer::update_solid_color_pixels()
+auto msd::Renderer::solid_color_buffer(geometry::Size border_size) -> std::optional<std::shared_ptr<mg::Buffer>>
 {
-    if (!solid_color_pixels)
-    {
-        solid_color_pixels = alloc_pixels(geom::Size{scaled_solid_color_pixels_length, 1});
-        needs_solid_color_redraw = true;
-    }
+    if (!area(border_size * scale))
+        return std::nullopt;
 
-    if (needs_solid_color_redraw)
-    {
-        render_row(
-            solid_color_pixels.get(), geom::Size{scaled_solid_color_pixels_length, 1},
-            geom::Point{}, geom::Width{scaled_solid_color_pixels_length},
-            current_theme->background_color);
-    }
+    auto const color = current_theme->background_color;
+    if (auto const cached = solid_color_buffers.find(color); cached != solid_color_buffers.end())
+        return cached->second;
 
-    needs_solid_color_redraw = false;
+    auto const buffer = make_buffer(&color, geom::Size{1, 1});
+    if (buffer)
+        solid_color_buffers.emplace(color, buffer.value());
+    return buffer;
 }
 
 auto msd::Renderer::make_buffer(
@@ -110,13 +110,12 @@ private:
     std::map<ButtonFunction, Icon const> button_icons;
     std::shared_ptr<StaticGeometry const> const static_geometry;
 
-    bool needs_solid_color_redraw{true};
     geometry::Size left_border_size;
     geometry::Size right_border_size;
     geometry::Size bottom_border_size;
-    size_t solid_color_pixels_length{0};
-    size_t scaled_solid_color_pixels_length{0};
-    std::unique_ptr<Pixel[]> solid_color_pixels; // can be nullptr
+    /// Single pixel buffers, stretched over the borders when drawn. They are never reallocated, so
+    /// resizing a window doesn't allocate or upload any border pixels.
+    std::map<Pixel, std::shared_ptr<graphics::Buffer>> solid_color_buffers;
 
     geometry::Size titlebar_size{};
     std::unique_ptr<Pixel[]> titlebar_pixels; // can be nullptr
@@ -130,7 +129,7 @@ private:
 
     float scale{1.0f};
 
-    void update_solid_color_pixels();
+    auto solid_color_buffer(geometry::Size border_size) -> std::optional<std::shared_ptr<graphics::Buffer>>;
     auto make_buffer(
         Pixel const* pixels,
         geometry::Size size) -> std::optional<std::shared_ptr<graphics::Buffer>>;
@@ -83,6 +83,26 @@ public:
         buf = b;
     }
 
+    void set_damage(std::optional<geometry::Rectangles> const& d)
+    {
+        damage_ = d;
+    }
+
+    auto damage() const -> std::optional<geometry::Rectangles> override
+    {
+        return damage_;
+    }
+
+    void set_opaque_region(geometry::Rectangles const& region)
+    {
+        opaque_region_ = region;
+    }
+
+    auto opaque_region() const -> geometry::Rectangles override
+    {
+        return opaque_region_;
+    }
+
     std::shared_ptr<graphics::Buffer> buffer() const override
     {
         return buf;
@@ -109,6 +129,8 @@ private:
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    std::optional<geometry::Rectangles> damage_;
+    geometry::Rectangles opaque_region_;
 };
 
 } // namespace doubles
@@ -37,6 +37,7 @@ struct MockBufferStream : public compositor::BufferStream
         MOCK_METHOD(geometry::Size, size, (), (const override));
         MOCK_METHOD(geometry::RectangleD, source_rect, (), (const override));
         MOCK_METHOD(graphics::DRMFormat, pixel_format, (), (const override));
+        MOCK_METHOD(std::optional<geometry::Rectangles>, damage, (), (const override));
     };
 
     int buffers_ready_{0};
@@ -78,6 +79,11 @@ struct MockBufferStream : public compositor::BufferStream
         submit_buffer,
         (std::shared_ptr<graphics::Buffer> const&, geometry::Size, geometry::RectangleD),
         (override));
+    MOCK_METHOD(
+        void,
+        submit_buffer,
+        (std::shared_ptr<graphics::Buffer> const&, geometry::Size, geometry::RectangleD, geometry::Rectangles const&),
+        (override));
     MOCK_METHOD(bool, has_submitted_buffer, (), (const override));
 };
 }
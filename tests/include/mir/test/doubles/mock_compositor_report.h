@@ -31,11 +31,14 @@ class MockCompositorReport : public compositor::CompositorReport
 {
 public:
     MOCK_METHOD(void, added_display, (int,int,int,int, compositor::CompositorReport::SubCompositorId), (override));
+    MOCK_METHOD(void, began_scene_snapshot, (compositor::CompositorReport::SubCompositorId), (override));
     MOCK_METHOD(void, began_frame, (compositor::CompositorReport::SubCompositorId), (override));
     MOCK_METHOD(void, renderables_in_frame,
                  (compositor::CompositorReport::SubCompositorId, graphics::RenderableList const&), (override));
     MOCK_METHOD(void, rendered_frame, (compositor::CompositorReport::SubCompositorId), (override));
+    MOCK_METHOD(void, overlaid_frame, (compositor::CompositorReport::SubCompositorId, size_t), (override));
     MOCK_METHOD(void, finished_frame, (compositor::CompositorReport::SubCompositorId), (override));
+    MOCK_METHOD(void, posted_frame, (compositor::CompositorReport::SubCompositorId), (override));
     MOCK_METHOD(void, started, (), (override));
     MOCK_METHOD(void, stopped, (), (override));
     MOCK_METHOD(void, scheduled, (), (override));
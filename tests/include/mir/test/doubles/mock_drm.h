@@ -97,6 +97,12 @@ public:
     MOCK_METHOD(drmModeEncoderPtr, drmModeGetEncoder, (int fd, uint32_t encoder_id));
     MOCK_METHOD(drmModePlaneResPtr, drmModeGetPlaneResources, (int fd));
     MOCK_METHOD(drmModePlanePtr, drmModeGetPlane, (int fd, uint32_t plane_id));
+    MOCK_METHOD(int, drmModeSetPlane, (int fd, uint32_t plane_id, uint32_t crtc_id,
+                                      uint32_t fb_id, uint32_t flags,
+                                      int32_t crtc_x, int32_t crtc_y,
+                                      uint32_t crtc_w, uint32_t crtc_h,
+                                      uint32_t src_x, uint32_t src_y,
+                                      uint32_t src_w, uint32_t src_h));
     MOCK_METHOD(drmModeObjectPropertiesPtr, drmModeObjectGetProperties, (int fd, uint32_t id, uint32_t type));
     MOCK_METHOD(drmModeCrtcPtr, drmModeGetCrtc, (int fd, uint32_t crtcId));
     MOCK_METHOD(int, drmModeSetCrtc, (int fd, uint32_t crtcId, uint32_t bufferId,
@@ -131,6 +137,11 @@ public:
     MOCK_METHOD(int, drmSetClientCap, (int fd, uint64_t capability, uint64_t value));
     MOCK_METHOD(drmModePropertyPtr, drmModeGetProperty, (int fd, uint32_t propertyId));
     MOCK_METHOD(void, drmModeFreeProperty, (drmModePropertyPtr));
+    MOCK_METHOD(drmModePropertyBlobPtr, drmModeGetPropertyBlob, (int fd, uint32_t blob_id));
+    MOCK_METHOD(void, drmModeFreePropertyBlob, (drmModePropertyBlobPtr));
+    MOCK_METHOD(int, drmModeCreatePropertyBlob, (int fd, void const* data, size_t size, uint32_t* id));
+    MOCK_METHOD(int, drmModeDestroyPropertyBlob, (int fd, uint32_t id));
+    MOCK_METHOD(int, drmModeAtomicCommit, (int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data));
     MOCK_METHOD(int, drmModeConnectorSetProperty, (int fd, uint32_t connector_id, uint32_t property_id, uint64_t value));
 
     MOCK_METHOD(int, drmGetMagic, (int fd, drm_magic_t *magic));
@@ -31,6 +31,7 @@ public:
     MOCK_METHOD(void, release_current, (), (override));
     MOCK_METHOD(std::unique_ptr<graphics::Framebuffer>, commit, (), (override));
     MOCK_METHOD(mir::geometry::Size, size, (), (const override));
+    MOCK_METHOD(unsigned, buffer_age, (), (const override));
     MOCK_METHOD(Layout, layout, (), (const override));
 };
 }
@@ -43,6 +43,8 @@ public:
 
     auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
+        std::shared_ptr<graphics::Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<graphics::Buffer>;
 };
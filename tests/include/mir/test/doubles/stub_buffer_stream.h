@@ -66,6 +66,11 @@ public:
             {
                 return graphics::DRMFormat::from_mir_format(mir_pixel_format_xbgr_8888);
             }
+
+            auto damage() const -> std::optional<geometry::Rectangles> override
+            {
+                return std::nullopt;
+            }
         private:
             std::shared_ptr<graphics::Buffer> const buf;
         };
@@ -81,6 +86,14 @@ public:
     {
         if (b) ++nready;
     }
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& b,
+        geometry::Size /*dst_size*/,
+        geometry::RectangleD /*src_bounds*/,
+        geometry::Rectangles const& /*damage*/) override
+    {
+        if (b) ++nready;
+    }
     void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
     bool has_submitted_buffer() const override { return true; }
 
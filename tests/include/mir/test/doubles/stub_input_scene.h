@@ -50,6 +50,10 @@ class StubInputScene : public input::Scene
     {
     }
 
+    void emit_scene_damaged(geometry::Rectangles const&) override
+    {
+    }
+
     bool screen_is_locked() const override
     {
         return false;
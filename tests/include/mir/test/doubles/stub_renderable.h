@@ -88,6 +88,15 @@ public:
     {
         return false;
     }
+    auto damage() const -> std::optional<geometry::Rectangles> override
+    {
+        return std::nullopt;
+    }
+
+    auto opaque_region() const -> geometry::Rectangles override
+    {
+        return {};
+    }
 
     auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> override
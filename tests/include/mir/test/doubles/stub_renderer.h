@@ -35,6 +35,8 @@ public:
     void set_viewport(geometry::Rectangle const&) override {}
     void set_output_transform(glm::mat2 const&) override {}
     void suspend() override {}
+    auto buffer_age() const -> unsigned override { return 0; }
+    void set_damage(std::optional<geometry::Rectangles> const&) override {}
 
     auto render(graphics::RenderableList const& renderables) const -> std::unique_ptr<graphics::Framebuffer> override
     {
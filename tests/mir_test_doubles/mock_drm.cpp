@@ -600,6 +600,19 @@ drmModePlanePtr drmModeGetPlane(int fd, uint32_t plane_id)
     return global_mock->drmModeGetPlane(fd, plane_id);
 }
 
+int drmModeSetPlane(int fd, uint32_t plane_id, uint32_t crtc_id,
+                    uint32_t fb_id, uint32_t flags,
+                    int32_t crtc_x, int32_t crtc_y,
+                    uint32_t crtc_w, uint32_t crtc_h,
+                    uint32_t src_x, uint32_t src_y,
+                    uint32_t src_w, uint32_t src_h)
+{
+    return global_mock->drmModeSetPlane(
+        fd, plane_id, crtc_id, fb_id, flags,
+        crtc_x, crtc_y, crtc_w, crtc_h,
+        src_x, src_y, src_w, src_h);
+}
+
 drmModeObjectPropertiesPtr drmModeObjectGetProperties(int fd, uint32_t id, uint32_t type)
 {
     return global_mock->drmModeObjectGetProperties(fd, id, type);
@@ -639,6 +652,31 @@ void drmModeFreeProperty(drmModePropertyPtr ptr)
     global_mock->drmModeFreeProperty(ptr);
 }
 
+drmModePropertyBlobPtr drmModeGetPropertyBlob(int fd, uint32_t blob_id)
+{
+    return global_mock->drmModeGetPropertyBlob(fd, blob_id);
+}
+
+void drmModeFreePropertyBlob(drmModePropertyBlobPtr ptr)
+{
+    global_mock->drmModeFreePropertyBlob(ptr);
+}
+
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
 int drmGetCap(int fd, uint64_t capability, uint64_t *value)
 {
     return global_mock->drmGetCap(fd, capability, value);
@@ -88,6 +88,8 @@ auto mtd::StubBufferAllocator::buffer_from_resource(wl_resource*, std::function<
 
 auto mtd::StubBufferAllocator::buffer_from_shm(
     std::shared_ptr<mir::renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<mg::Buffer> const&,
+    std::optional<mir::geometry::Rectangles> const&,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<mg::Buffer>
 {
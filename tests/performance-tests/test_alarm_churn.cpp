@@ -0,0 +1,135 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/glib_main_loop.h"
+#include "mir/glib_main_loop_sources.h"
+#include "mir/basic_callback.h"
+#include "mir/time/steady_clock.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+auto const reschedules = 200'000;
+
+/// Pushes each of \p alarms alarms back in turn, as the idle timeout is on every input event
+template<typename Reschedule>
+auto ns_per_reschedule(int alarms, Reschedule reschedule) -> double
+{
+    auto const start = std::chrono::steady_clock::now();
+    for (auto i = 0; i != reschedules; ++i)
+    {
+        reschedule(i % alarms, 1s + std::chrono::milliseconds{i % 7});
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>{elapsed}.count() / reschedules;
+}
+
+/// The main loop alarms, which share a single GSource
+auto alarm_queue(int alarms) -> double
+{
+    mir::GLibMainLoop main_loop{std::make_shared<mir::time::SteadyClock>()};
+    std::thread loop_thread{[&] { main_loop.run(); }};
+
+    std::vector<std::unique_ptr<mir::time::Alarm>> pending;
+    for (auto i = 0; i != alarms; ++i)
+    {
+        pending.push_back(main_loop.create_alarm([]{}));
+    }
+
+    auto const result = ns_per_reschedule(
+        alarms,
+        [&](int alarm, std::chrono::milliseconds delay)
+        {
+            pending[alarm]->reschedule_in(delay);
+        });
+
+    pending.clear();
+    main_loop.stop();
+    loop_thread.join();
+    return result;
+}
+
+/// A new GSource for every reschedule, as alarms used to be implemented
+auto gsource_per_reschedule(int alarms) -> double
+{
+    auto const clock = std::make_shared<mir::time::SteadyClock>();
+    mir::detail::GMainContextHandle const main_context;
+    std::atomic<bool> running{true};
+    std::thread loop_thread{
+        [&]
+        {
+            while (running)
+            {
+                g_main_context_iteration(main_context, TRUE);
+            }
+        }};
+
+    auto const callback = std::make_shared<mir::BasicCallback>([]{});
+    std::vector<mir::detail::GSourceHandle> pending(alarms);
+
+    auto const result = ns_per_reschedule(
+        alarms,
+        [&](int alarm, std::chrono::milliseconds delay)
+        {
+            pending[alarm] = mir::detail::add_timer_gsource(
+                main_context, clock, callback, []{}, clock->now() + delay);
+        });
+
+    pending.clear();
+    running = false;
+    g_main_context_wakeup(main_context);
+    loop_thread.join();
+    return result;
+}
+}
+
+TEST(AlarmChurnPerformance, alarm_queue_compared_with_a_gsource_per_reschedule)
+{
+    std::cout << std::setw(10) << "alarms"
+              << std::setw(23) << "gsource (ns/resched)" << std::setw(21) << "queue (ns/resched)"
+              << std::setw(10) << "speedup" << std::endl;
+
+    for (auto const alarms : {1, 16, 256})
+    {
+        auto const gsource = gsource_per_reschedule(alarms);
+        auto const queue = alarm_queue(alarms);
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(10) << alarms
+                  << std::setw(23) << gsource
+                  << std::setw(21) << queue
+                  << std::setw(9) << gsource / queue << "x"
+                  << std::endl;
+
+        auto const name = std::to_string(alarms) + "_alarms";
+        RecordProperty("gsource_ns_" + name, std::to_string(gsource));
+        RecordProperty("queue_ns_" + name, std::to_string(queue));
+
+        EXPECT_GT(queue, 0);
+    }
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/observer_multiplexer.h"
+#include "mir/snapshot_observer_multiplexer.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+class Observer
+{
+public:
+    virtual ~Observer() = default;
+
+    virtual void frame_posted(int frame) = 0;
+};
+
+class CountingObserver : public Observer
+{
+public:
+    void frame_posted(int) override
+    {
+        observations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<long> observations{0};
+};
+
+template<template<class> class Base>
+class Multiplexer : public Base<Observer>
+{
+public:
+    Multiplexer()
+        : Base<Observer>{mir::immediate_executor}
+    {
+    }
+
+    void frame_posted(int frame) override
+    {
+        this->for_each_observer(&Observer::frame_posted, frame);
+    }
+};
+
+struct Result
+{
+    double ns_per_observation;
+    long observations;
+};
+
+/// Has \p threads threads notify \p observers observers for \p duration, and measures how long each observation took
+template<template<class> class Base>
+auto run(int observers, int threads, std::chrono::milliseconds duration) -> Result
+{
+    Multiplexer<Base> multiplexer;
+    std::vector<std::shared_ptr<CountingObserver>> registered;
+    for (auto i = 0; i != observers; ++i)
+    {
+        registered.push_back(std::make_shared<CountingObserver>());
+        multiplexer.register_interest(registered.back());
+    }
+
+    std::atomic<bool> running{true};
+    std::atomic<long> notifications{0};
+    std::vector<std::thread> notifiers;
+    auto const start = std::chrono::steady_clock::now();
+    for (auto i = 0; i != threads; ++i)
+    {
+        notifiers.emplace_back([&]
+            {
+                long local_notifications{0};
+                while (running.load(std::memory_order_relaxed))
+                {
+                    multiplexer.frame_posted(local_notifications++);
+                }
+                notifications += local_notifications;
+            });
+    }
+
+    std::this_thread::sleep_for(duration);
+    running = false;
+    for (auto& notifier : notifiers)
+    {
+        notifier.join();
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    long observations{0};
+    for (auto const& observer : registered)
+    {
+        observations += observer->observations;
+    }
+    EXPECT_EQ(observations, notifications * observers);
+
+    // The threads run in parallel, so this is the wall-clock time each thread spent per observation
+    auto const thread_ns = std::chrono::duration<double, std::nano>{elapsed}.count() * threads;
+    return {observations ? thread_ns / observations : 0.0, observations};
+}
+}
+
+TEST(ObserverMultiplexerPerformance, snapshot_multiplexer_compared_with_observer_multiplexer)
+{
+    auto const duration = 200ms;
+
+    std::cout << std::setw(10) << "observers" << std::setw(10) << "threads"
+              << std::setw(18) << "current (ns/obs)" << std::setw(19) << "snapshot (ns/obs)"
+              << std::setw(10) << "speedup" << std::endl;
+
+    for (auto const observers : {1, 4, 16})
+    {
+        for (auto const threads : {1, 2, 4, 8})
+        {
+            auto const current = run<mir::ObserverMultiplexer>(observers, threads, duration);
+            auto const snapshot = run<mir::SnapshotObserverMultiplexer>(observers, threads, duration);
+
+            std::cout << std::fixed << std::setprecision(1)
+                      << std::setw(10) << observers << std::setw(10) << threads
+                      << std::setw(18) << current.ns_per_observation
+                      << std::setw(19) << snapshot.ns_per_observation
+                      << std::setw(9) << current.ns_per_observation / snapshot.ns_per_observation << "x"
+                      << std::endl;
+
+            auto const name = std::to_string(observers) + "_observers_" + std::to_string(threads) + "_threads";
+            RecordProperty("current_ns_" + name, std::to_string(current.ns_per_observation));
+            RecordProperty("snapshot_ns_" + name, std::to_string(snapshot.ns_per_observation));
+
+            EXPECT_GT(current.observations, 0);
+            EXPECT_GT(snapshot.observations, 0);
+        }
+    }
+}
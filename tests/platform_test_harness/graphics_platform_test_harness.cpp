@@ -441,6 +441,16 @@ void basic_software_buffer_drawing(
             return mg::contains_alpha(buffer_->pixel_format());
         }
 
+        auto damage() const -> std::optional<mir::geometry::Rectangles> override
+        {
+            return std::nullopt;
+        }
+
+        auto opaque_region() const -> mir::geometry::Rectangles override
+        {
+            return {};
+        }
+
         auto clip_area() const -> std::optional<mir::geometry::Rectangle> override
         {
             return std::optional<mir::geometry::Rectangle>{};
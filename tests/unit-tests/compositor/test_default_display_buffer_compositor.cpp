@@ -77,6 +77,67 @@ auto make_scene_elements(std::initializer_list<std::shared_ptr<mg::Renderable>>
     return elements;
 }
 
+struct StubFramebuffer : mg::Framebuffer
+{
+    explicit StubFramebuffer(geom::Size size) :
+        size_{size}
+    {
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+    geom::Size const size_;
+};
+
+/// A display sink that can be asked whether it would show overlays before the frame beneath them is rendered
+struct MockOverlayQuerySink : mtd::MockDisplaySink, mg::OverlayQuery
+{
+    MOCK_METHOD(bool, can_overlay, (std::vector<mg::DisplayElement> const&), (override));
+};
+
+struct TransformedRenderable : mtd::FakeRenderable
+{
+    using FakeRenderable::FakeRenderable;
+
+    glm::mat4 transformation() const override
+    {
+        return glm::mat4{2};
+    }
+};
+
+/// Can scan out only the buffers it has been told about
+struct SelectiveFramebufferProvider : mtd::StubGlRenderingProvider
+{
+    auto make_framebuffer_provider(mg::DisplaySink&) -> std::unique_ptr<FramebufferProvider> override
+    {
+        struct Provider : FramebufferProvider
+        {
+            Provider(std::vector<std::shared_ptr<mg::Buffer>> const& scanout_buffers) :
+                scanout_buffers{scanout_buffers}
+            {
+            }
+
+            auto buffer_to_framebuffer(std::shared_ptr<mg::Buffer> buffer)
+                -> std::unique_ptr<mg::Framebuffer> override
+            {
+                if (std::find(scanout_buffers.begin(), scanout_buffers.end(), buffer) != scanout_buffers.end())
+                {
+                    return std::make_unique<StubFramebuffer>(buffer->size());
+                }
+                return {};
+            }
+
+            std::vector<std::shared_ptr<mg::Buffer>> const& scanout_buffers;
+        };
+        return std::make_unique<Provider>(scanout_buffers);
+    }
+
+    std::vector<std::shared_ptr<mg::Buffer>> scanout_buffers;
+};
+
 struct DefaultDisplayBufferCompositor : public testing::Test
 {
     DefaultDisplayBufferCompositor()
@@ -91,11 +152,13 @@ struct DefaultDisplayBufferCompositor : public testing::Test
             .WillByDefault(Return(screen));
         ON_CALL(display_sink, overlay(_))
             .WillByDefault(Return(false));
+        ON_CALL(display_sink, can_overlay(_))
+            .WillByDefault(Return(true));
     }
 
     testing::NiceMock<mtd::MockRenderer> mock_renderer;
     geom::Rectangle screen{{0, 0}, {1366, 768}};
-    testing::NiceMock<mtd::MockDisplaySink> display_sink;
+    testing::NiceMock<MockOverlayQuerySink> display_sink;
     mtd::StubGlRenderingProvider gl_provider;
     std::shared_ptr<mtd::FakeRenderable> small;
     std::shared_ptr<mtd::FakeRenderable> big;
@@ -331,3 +394,294 @@ TEST_F(DefaultDisplayBufferCompositor, marks_occluded_scene_elements)
     compositor.composite({element0_occluded, element1_rendered, element2_occluded});
 }
 
+TEST_F(DefaultDisplayBufferCompositor, redraws_everything_when_buffer_age_is_unknown)
+{
+    using namespace testing;
+
+    ON_CALL(mock_renderer, buffer_age()).WillByDefault(Return(0));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({big}));
+
+    EXPECT_CALL(mock_renderer, set_damage(Eq(std::nullopt)));
+    compositor.composite(make_scene_elements({big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, redraws_nothing_when_scene_is_unchanged)
+{
+    using namespace testing;
+
+    ON_CALL(mock_renderer, buffer_age()).WillByDefault(Return(1));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({big, small}));
+
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{})));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, redraws_content_damage_reported_by_renderables)
+{
+    using namespace testing;
+
+    ON_CALL(mock_renderer, buffer_age()).WillByDefault(Return(1));
+    geom::Rectangle const cursor_cell{{12, 22}, {8, 16}};
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({big, small}));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+    small->set_damage(geom::Rectangles{cursor_cell});
+
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{cursor_cell})));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, redraws_whole_renderable_when_new_buffer_has_unknown_damage)
+{
+    using namespace testing;
+
+    ON_CALL(mock_renderer, buffer_age()).WillByDefault(Return(1));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({big, small}));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{small->screen_position()})));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, redraws_where_renderables_appear_and_disappear)
+{
+    using namespace testing;
+
+    ON_CALL(mock_renderer, buffer_age()).WillByDefault(Return(1));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({small}));
+
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{small->screen_position(), big->screen_position()})));
+    compositor.composite(make_scene_elements({big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, redraws_damage_of_every_frame_since_buffer_was_last_drawn)
+{
+    using namespace testing;
+
+    geom::Rectangle const first_damage{{10, 20}, {1, 1}};
+    geom::Rectangle const second_damage{{11, 21}, {1, 1}};
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({big, small}));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+    small->set_damage(geom::Rectangles{first_damage});
+    compositor.composite(make_scene_elements({big, small}));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+    small->set_damage(geom::Rectangles{second_damage});
+
+    EXPECT_CALL(mock_renderer, buffer_age()).WillOnce(Return(2));
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{first_damage, second_damage})));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, redraws_damage_from_frames_composited_with_overlays)
+{
+    using namespace testing;
+
+    ON_CALL(mock_renderer, buffer_age()).WillByDefault(Return(1));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({small}));
+
+    EXPECT_CALL(display_sink, overlay(_))
+        .WillOnce(Return(true))
+        .WillOnce(Return(false));
+    compositor.composite(make_scene_elements({}));
+
+    // The renderer's buffer still shows the renderable removed while we were using overlays
+    EXPECT_CALL(mock_renderer, set_damage(Eq(geom::Rectangles{small->screen_position()})));
+    compositor.composite(make_scene_elements({}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renders_only_what_is_below_renderables_shown_as_overlays)
+{
+    using namespace testing;
+
+    SelectiveFramebufferProvider scanout_provider;
+    scanout_provider.scanout_buffers.push_back(small->buffer());
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    EXPECT_CALL(mock_renderer, render(ElementsAre(big)));
+    EXPECT_CALL(display_sink, overlay(SizeIs(2))).WillOnce(Return(true));
+    EXPECT_CALL(display_sink, set_next_image(_)).Times(0);
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, reports_renderables_shown_as_overlays)
+{
+    using namespace testing;
+
+    SelectiveFramebufferProvider scanout_provider;
+    scanout_provider.scanout_buffers.push_back(small->buffer());
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        report);
+
+    EXPECT_CALL(display_sink, overlay(SizeIs(2))).WillOnce(Return(true));
+    EXPECT_CALL(*report, rendered_frame(_));
+    EXPECT_CALL(*report, overlaid_frame(_, 1));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renders_everything_when_overlays_are_rejected)
+{
+    using namespace testing;
+
+    SelectiveFramebufferProvider scanout_provider;
+    scanout_provider.scanout_buffers.push_back(small->buffer());
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_renderer, render(ElementsAre(big)));
+        EXPECT_CALL(display_sink, overlay(SizeIs(2))).WillOnce(Return(false));
+        EXPECT_CALL(mock_renderer, render(ElementsAre(big, small)));
+        EXPECT_CALL(display_sink, set_next_image(_));
+    }
+    compositor.composite(make_scene_elements({big, small}));
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+    Mock::VerifyAndClearExpectations(&display_sink);
+
+    // Nothing has changed, so there's no point in asking again
+    EXPECT_CALL(mock_renderer, render(ElementsAre(big, small)));
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renders_once_when_display_sink_cannot_show_overlays_above_the_frame)
+{
+    using namespace testing;
+
+    SelectiveFramebufferProvider scanout_provider;
+    scanout_provider.scanout_buffers.push_back(small->buffer());
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    EXPECT_CALL(display_sink, can_overlay(AllOf(SizeIs(2), Contains(Field(&mg::DisplayElement::buffer, IsNull())))))
+        .WillOnce(Return(false));
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    EXPECT_CALL(mock_renderer, render(ElementsAre(big, small))).Times(1);
+    EXPECT_CALL(display_sink, set_next_image(_));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, does_not_offer_translucent_renderables_as_overlays)
+{
+    using namespace testing;
+
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(small->screen_position(), 0.5f);
+    SelectiveFramebufferProvider scanout_provider;
+    scanout_provider.scanout_buffers.push_back(translucent->buffer());
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    EXPECT_CALL(mock_renderer, render(ElementsAre(big, translucent)));
+    compositor.composite(make_scene_elements({big, translucent}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, does_not_offer_transformed_renderables_as_overlays)
+{
+    using namespace testing;
+
+    auto const transformed = std::make_shared<TransformedRenderable>(small->screen_position());
+    SelectiveFramebufferProvider scanout_provider;
+    scanout_provider.scanout_buffers.push_back(transformed->buffer());
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    EXPECT_CALL(mock_renderer, render(ElementsAre(big, transformed)));
+    compositor.composite(make_scene_elements({big, transformed}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, offers_overlays_sampling_from_buffer_pixels)
+{
+    using namespace testing;
+
+    // A scale 2 client: 60x80 buffer pixels shown on 30x40 logical pixels
+    small->set_buffer(std::make_shared<mtd::StubBuffer>(geom::Size{60, 80}));
+    SelectiveFramebufferProvider scanout_provider;
+    scanout_provider.scanout_buffers.push_back(small->buffer());
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    mg::DisplayElement overlaid;
+    EXPECT_CALL(display_sink, overlay(SizeIs(2)))
+        .WillOnce([&](auto const& elements) { overlaid = elements[1]; return true; });
+    compositor.composite(make_scene_elements({big, small}));
+
+    EXPECT_THAT(overlaid.screen_positon, Eq(small->screen_position()));
+    EXPECT_THAT(overlaid.source_position, Eq(geom::RectangleF{{0, 0}, {60, 80}}));
+}
@@ -470,3 +470,72 @@ TEST_F(MultiMonitorArbiter, second_compositor_advances_schedule_after_both_aquir
     auto cbuffer4 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
     EXPECT_THAT(cbuffer1, Not(IsSameBufferAs(cbuffer4)));
 }
+
+TEST_F(MultiMonitorArbiter, submission_damage_is_given_to_compositor_that_claimed_previous_buffer)
+{
+    geom::Rectangles const damage{{{10, 10}, {5, 5}}};
+
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source);
+    arbiter->compositor_acquire(this)->claim_buffer();
+
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source, damage);
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage(), Eq(damage));
+}
+
+TEST_F(MultiMonitorArbiter, compositor_that_missed_previous_buffer_gets_unknown_damage)
+{
+    int comp_id1{0};
+    int comp_id2{1};
+
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source);
+    arbiter->compositor_acquire(&comp_id1)->claim_buffer();
+
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{{{10, 10}, {5, 5}}});
+
+    EXPECT_THAT(arbiter->compositor_acquire(&comp_id2)->damage(), Eq(std::nullopt));
+}
+
+TEST_F(MultiMonitorArbiter, compositor_reacquiring_claimed_buffer_gets_no_damage)
+{
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source);
+    arbiter->compositor_acquire(this)->claim_buffer();
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage(), Eq(geom::Rectangles{}));
+}
+
+TEST_F(MultiMonitorArbiter, damage_of_replaced_submission_is_carried_forward)
+{
+    geom::Rectangle const first_damage{{10, 10}, {5, 5}};
+    geom::Rectangle const second_damage{{100, 100}, {5, 5}};
+
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source);
+    arbiter->compositor_acquire(this)->claim_buffer();
+
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{first_damage});
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[2]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{second_damage});
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage(), Eq(geom::Rectangles{second_damage, first_damage}));
+}
+
+TEST_F(MultiMonitorArbiter, replacing_submission_with_unknown_damage_gives_unknown_damage)
+{
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source);
+    arbiter->compositor_acquire(this)->claim_buffer();
+
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source);
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[2]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{{{10, 10}, {5, 5}}});
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage(), Eq(std::nullopt));
+}
@@ -444,6 +444,10 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
         .Times(1);
     EXPECT_CALL(*mock_report, scheduled())
         .Times(2);
+    EXPECT_CALL(*mock_report, began_scene_snapshot(_))
+        .Times(AtLeast(1));
+    EXPECT_CALL(*mock_report, posted_frame(_))
+        .Times(AtLeast(1));
 
     EXPECT_CALL(*mock_report, stopped())
         .Times(AtLeast(1));
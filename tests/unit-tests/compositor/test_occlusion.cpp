@@ -200,3 +200,43 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_several_windows_occluded)
+{
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 200);
+    auto const right = std::make_shared<mtd::FakeRenderable>(100, 0, 100, 200);
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto elements = scene_elements_from({bottom, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_of_shaped_window_occludes)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {200, 200}}, 1.0f, false);
+    top->set_opaque_region({{{10, 10}, {180, 180}}});
+    auto const hidden = std::make_shared<mtd::FakeRenderable>(20, 20, 100, 100);
+    auto const peeking = std::make_shared<mtd::FakeRenderable>(5, 20, 100, 100);
+    auto elements = scene_elements_from({peeking, hidden, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(hidden));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(peeking, top));
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_of_translucent_window_occludes_nothing)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {200, 200}}, 0.5f, false);
+    top->set_opaque_region({{{0, 0}, {200, 200}}});
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(20, 20, 100, 100);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
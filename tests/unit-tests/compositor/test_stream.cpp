@@ -97,3 +97,15 @@ TEST_F(Stream, throws_on_nullptr_submissions)
     }, std::invalid_argument);
     EXPECT_FALSE(stream.has_submitted_buffer());
 }
+
+TEST_F(Stream, frame_callback_is_given_the_buffer_size_not_the_size_it_is_drawn_at)
+{
+    geom::Size const dest_size{440, 20};
+    geom::Size posted_size;
+    stream.set_frame_posted_callback([&posted_size](auto const& size) { posted_size = size; });
+    stream.submit_buffer(
+            buffers[0],
+            dest_size,
+            {{0, 0}, geom::SizeD{buffers[0]->size()}} );
+    EXPECT_THAT(posted_size, Eq(buffers[0]->size()));
+}
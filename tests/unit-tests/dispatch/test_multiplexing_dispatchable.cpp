@@ -485,3 +485,53 @@ TEST(MultiplexingDispatchableTest, automatic_removals_are_threadsafe)
     
     dispatchee->trigger();
 }
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_dispatches_every_ready_dispatchee)
+{
+    int dispatch_count{0};
+    auto const count_dispatch = [&dispatch_count]() { ++dispatch_count; };
+    auto dispatchee_a = std::make_shared<mt::TestDispatchable>(count_dispatch);
+    auto dispatchee_b = std::make_shared<mt::TestDispatchable>(count_dispatch);
+    auto dispatchee_c = std::make_shared<mt::TestDispatchable>(count_dispatch);
+
+    md::MultiplexingDispatchable dispatcher{dispatchee_a, dispatchee_b, dispatchee_c};
+    dispatcher.set_max_events_per_dispatch(md::MultiplexingDispatchable::max_batch_size);
+
+    dispatchee_a->trigger();
+    dispatchee_b->trigger();
+    dispatchee_c->trigger();
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatch_count, testing::Eq(3));
+    EXPECT_FALSE(mt::fd_is_readable(dispatcher.watch_fd()));
+
+    // The sequential dispatchees have been re-armed
+    dispatchee_b->trigger();
+    EXPECT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+}
+
+TEST(MultiplexingDispatchableTest, dispatchee_removed_earlier_in_a_batch_is_not_dispatched)
+{
+    auto const dispatcher = std::make_shared<md::MultiplexingDispatchable>();
+    dispatcher->set_max_events_per_dispatch(md::MultiplexingDispatchable::max_batch_size);
+
+    int dispatch_count{0};
+    std::shared_ptr<mt::TestDispatchable> dispatchee_a, dispatchee_b;
+    // Whichever is dispatched first removes the other
+    dispatchee_a = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatch_count; dispatcher->remove_watch(dispatchee_b); });
+    dispatchee_b = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatch_count; dispatcher->remove_watch(dispatchee_a); });
+
+    dispatcher->add_watch(dispatchee_a);
+    dispatcher->add_watch(dispatchee_b);
+
+    dispatchee_a->trigger();
+    dispatchee_b->trigger();
+
+    dispatcher->dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatch_count, testing::Eq(1));
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/pointer_motion_coalescer.h"
+#include "mir/events/event_builders.h"
+#include "mir/test/doubles/explicit_executor.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mev = mir::events;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+auto const deadline = 16ms;
+
+MATCHER_P4(MotionIs, timestamp, absolute, relative_x, relative_y, "")
+{
+    return arg.timestamp == uint32_t(timestamp) &&
+           arg.absolute == absolute &&
+           arg.relative_x == relative_x &&
+           arg.relative_y == relative_y;
+}
+
+auto pointer_event(MirPointerAction action, MirPointerButtons buttons = 0, float vscroll = 0) -> mir::EventUPtr
+{
+    return mev::make_pointer_event(
+        0, std::chrono::nanoseconds{0},
+        0, action, buttons,
+        1, 2,
+        0, vscroll,
+        0, 0);
+}
+
+auto can_hold(mir::EventUPtr const& event) -> bool
+{
+    return mf::PointerMotionCoalescer::can_hold(
+        *mir_input_event_get_pointer_event(mir_event_get_input_event(event.get())));
+}
+
+struct PointerMotionCoalescer : Test
+{
+    MOCK_METHOD(void, send, (mf::PointerMotionCoalescer::Motion const& motion));
+
+    mtd::FakeAlarmFactory alarm_factory;
+    mtd::ExplicitExecutor wayland_executor;
+    std::unique_ptr<mf::PointerMotionCoalescer> coalescer{std::make_unique<mf::PointerMotionCoalescer>(
+        alarm_factory,
+        wayland_executor,
+        deadline,
+        [this](auto const& motion) { send(motion); })};
+};
+}
+
+TEST_F(PointerMotionCoalescer, plain_motion_can_be_held)
+{
+    EXPECT_THAT(can_hold(pointer_event(mir_pointer_action_motion)), Eq(true));
+}
+
+TEST_F(PointerMotionCoalescer, buttons_enter_and_leave_can_not_be_held)
+{
+    EXPECT_THAT(can_hold(pointer_event(mir_pointer_action_button_down, mir_pointer_button_primary)), Eq(false));
+    EXPECT_THAT(can_hold(pointer_event(mir_pointer_action_button_up)), Eq(false));
+    EXPECT_THAT(can_hold(pointer_event(mir_pointer_action_enter)), Eq(false));
+    EXPECT_THAT(can_hold(pointer_event(mir_pointer_action_leave)), Eq(false));
+}
+
+TEST_F(PointerMotionCoalescer, motion_with_scroll_can_not_be_held)
+{
+    EXPECT_THAT(can_hold(pointer_event(mir_pointer_action_motion, 0, 3)), Eq(false));
+}
+
+TEST_F(PointerMotionCoalescer, held_motion_is_not_sent_until_flushed)
+{
+    EXPECT_CALL(*this, send(_)).Times(0);
+
+    coalescer->hold_position(1);
+    coalescer->hold_relative(2, 1, 1);
+
+    EXPECT_THAT(coalescer->holding(), Eq(true));
+}
+
+TEST_F(PointerMotionCoalescer, held_motion_is_sent_merged_on_flush)
+{
+    coalescer->hold_relative(1, 1, 2);
+    coalescer->hold_position(2);
+    coalescer->hold_relative(3, 3, -5);
+
+    EXPECT_CALL(*this, send(MotionIs(3, true, 4.0, -3.0)));
+
+    coalescer->flush();
+
+    EXPECT_THAT(coalescer->holding(), Eq(false));
+}
+
+TEST_F(PointerMotionCoalescer, flush_sends_nothing_when_nothing_is_held)
+{
+    EXPECT_CALL(*this, send(_)).Times(0);
+
+    coalescer->flush();
+}
+
+TEST_F(PointerMotionCoalescer, motion_held_after_a_flush_is_sent_separately)
+{
+    InSequence seq;
+    EXPECT_CALL(*this, send(MotionIs(1, true, 0.0, 0.0)));
+    EXPECT_CALL(*this, send(MotionIs(2, false, 1.0, 1.0)));
+
+    coalescer->hold_position(1);
+    coalescer->flush();
+    coalescer->hold_relative(2, 1, 1);
+    coalescer->flush();
+}
+
+TEST_F(PointerMotionCoalescer, held_motion_is_sent_on_the_wayland_thread_after_the_deadline)
+{
+    coalescer->hold_position(1);
+
+    EXPECT_CALL(*this, send(_)).Times(0);
+    alarm_factory.advance_by(deadline + 1ms);
+    Mock::VerifyAndClearExpectations(this);
+
+    EXPECT_CALL(*this, send(MotionIs(1, true, 0.0, 0.0)));
+    wayland_executor.execute();
+
+    EXPECT_THAT(coalescer->holding(), Eq(false));
+}
+
+TEST_F(PointerMotionCoalescer, held_motion_is_not_sent_before_the_deadline)
+{
+    EXPECT_CALL(*this, send(_)).Times(0);
+
+    coalescer->hold_position(1);
+    alarm_factory.advance_by(deadline - 1ms);
+    wayland_executor.execute();
+}
+
+TEST_F(PointerMotionCoalescer, deadline_runs_from_the_oldest_held_motion)
+{
+    coalescer->hold_position(1);
+    alarm_factory.advance_by(deadline / 2);
+    coalescer->hold_relative(2, 1, 1);
+
+    EXPECT_CALL(*this, send(MotionIs(2, true, 1.0, 1.0)));
+
+    alarm_factory.advance_by(deadline / 2 + 1ms);
+    wayland_executor.execute();
+}
+
+TEST_F(PointerMotionCoalescer, flush_cancels_the_deadline)
+{
+    EXPECT_CALL(*this, send(_)).Times(1);
+
+    coalescer->hold_position(1);
+    coalescer->flush();
+    alarm_factory.advance_by(deadline + 1ms);
+    wayland_executor.execute();
+}
+
+TEST_F(PointerMotionCoalescer, nothing_is_sent_after_destruction)
+{
+    EXPECT_CALL(*this, send(_)).Times(0);
+
+    coalescer->hold_position(1);
+    alarm_factory.advance_by(deadline + 1ms);
+    coalescer.reset();
+    wayland_executor.execute();
+}
@@ -351,3 +351,143 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 }
+
+namespace
+{
+auto make_successor(
+    std::shared_ptr<mgc::ShmBuffer> const& previous,
+    std::optional<geom::Rectangles> const& damage,
+    std::shared_ptr<mgc::EGLContextExecutor> const& egl_delegate)
+    -> std::shared_ptr<mgc::MappableBackedShmBuffer>
+{
+    auto const data = std::make_shared<PlatformlessShmBuffer>(
+        previous->size(),
+        previous->pixel_format(),
+        egl_delegate);
+    return std::make_shared<mgc::MappableBackedShmBuffer>(data, egl_delegate, previous, damage);
+}
+}
+
+TEST_F(ShmBufferTest, successor_uploads_only_its_damage)
+{
+    // Both buffers use the same texture
+    EXPECT_CALL(mock_gl, glGenTextures(1, _))
+        .WillOnce(SetArgPointee<1>(GLuint{7}));
+
+    auto const first = std::make_shared<mgc::MappableBackedShmBuffer>(
+        std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, egl_delegate),
+        egl_delegate);
+    first->bind();
+
+    geom::Rectangle const damage{{10, 20}, {30, 40}};
+    auto const second = make_successor(first, geom::Rectangles{damage}, egl_delegate);
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 10, 20, 30, 40, _, _, _));
+
+    second->bind();
+}
+
+TEST_F(ShmBufferTest, successor_with_unknown_damage_uploads_everything)
+{
+    auto const first = std::make_shared<mgc::MappableBackedShmBuffer>(
+        std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, egl_delegate),
+        egl_delegate);
+    first->bind();
+
+    auto const second = make_successor(first, std::nullopt, egl_delegate);
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, size.width.as_int(), size.height.as_int(), 0, _, _, _));
+
+    second->bind();
+}
+
+TEST_F(ShmBufferTest, successor_uploads_damage_of_buffers_that_were_never_bound)
+{
+    auto const first = std::make_shared<mgc::MappableBackedShmBuffer>(
+        std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, egl_delegate),
+        egl_delegate);
+    first->bind();
+
+    geom::Rectangle const first_damage{{0, 0}, {5, 5}};
+    geom::Rectangle const second_damage{{50, 50}, {5, 5}};
+    auto const skipped = make_successor(first, geom::Rectangles{first_damage}, egl_delegate);
+    auto const third = make_successor(skipped, geom::Rectangles{second_damage}, egl_delegate);
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 5, 5, _, _, _));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 50, 50, 5, 5, _, _, _));
+
+    third->bind();
+}
+
+TEST_F(ShmBufferTest, older_buffer_bound_after_successor_gets_its_own_texture)
+{
+    GLuint const shared_tex{7}, private_tex{11};
+    EXPECT_CALL(mock_gl, glGenTextures(1, _))
+        .WillOnce(SetArgPointee<1>(shared_tex))
+        .WillOnce(SetArgPointee<1>(private_tex));
+
+    auto const first = std::make_shared<mgc::MappableBackedShmBuffer>(
+        std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, egl_delegate),
+        egl_delegate);
+    first->bind();
+
+    auto const second = make_successor(first, geom::Rectangles{{{0, 0}, {1, 1}}}, egl_delegate);
+    second->bind();
+
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, private_tex));
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, size.width.as_int(), size.height.as_int(), 0, _, _, _));
+
+    first->bind();
+}
+
+TEST_F(ShmBufferTest, each_context_uploads_to_its_own_texture)
+{
+    EGLDisplay const dummy_dpy{reinterpret_cast<EGLDisplay>(0xaabbccdd)};
+    EGLContext const first_ctx{reinterpret_cast<EGLContext>(0x66221144)};
+    EGLContext const second_ctx{reinterpret_cast<EGLContext>(0x66221155)};
+    GLuint const first_tex{7}, second_tex{11};
+
+    EXPECT_CALL(mock_gl, glGenTextures(1, _))
+        .WillOnce(SetArgPointee<1>(first_tex))
+        .WillOnce(SetArgPointee<1>(second_tex));
+
+    auto const first = std::make_shared<mgc::MappableBackedShmBuffer>(
+        std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, egl_delegate),
+        egl_delegate);
+    eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, first_ctx);
+    first->bind();
+    eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, second_ctx);
+    first->bind();
+
+    geom::Rectangle const damage{{10, 20}, {30, 40}};
+    auto const second = make_successor(first, geom::Rectangles{damage}, egl_delegate);
+
+    // Each context brings its own texture up to date with just the damage
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, first_tex));
+        EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 10, 20, 30, 40, _, _, _));
+        EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, second_tex));
+        EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 10, 20, 30, 40, _, _, _));
+    }
+
+    eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, first_ctx);
+    second->bind();
+    eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, second_ctx);
+    second->bind();
+
+    eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+TEST_F(ShmBufferTest, upload_does_not_wait_for_gpu)
+{
+    PlatformlessShmBuffer buf(size, mir_pixel_format_argb_8888, egl_delegate);
+
+    EXPECT_CALL(mock_gl, glFinish()).Times(0);
+    EXPECT_CALL(mock_gl, glFlush()).Times(0);
+
+    buf.bind();
+}
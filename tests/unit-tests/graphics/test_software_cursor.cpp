@@ -46,6 +46,7 @@ struct MockInputScene : mtd::StubInputScene
                  void(std::weak_ptr<mg::Renderable> const&));
 
     MOCK_METHOD0(emit_scene_changed, void());
+    MOCK_METHOD1(emit_scene_damaged, void(geom::Rectangles const&));
 
     MOCK_CONST_METHOD0(screen_is_locked, bool());
 };
@@ -153,11 +154,6 @@ MATCHER_P(RenderableWithSize, s, "")
     return s == arg->screen_position().size;
 }
 
-MATCHER_P(WeakPtrEq, sp, "")
-{
-    return sp == arg.lock();
-}
-
 ACTION_TEMPLATE(SavePointerToArg,
                 HAS_1_TEMPLATE_PARAMS(int, k),
                 AND_1_VALUE_PARAMS(output))
@@ -288,11 +284,16 @@ TEST_F(SoftwareCursor, moves_scene_renderable_offset_by_hotspot_when_moved)
                 Eq(new_position - stub_cursor_image.hotspot()));
 }
 
-TEST_F(SoftwareCursor, notifies_scene_when_moving)
+TEST_F(SoftwareCursor, notifies_scene_of_old_and_new_cursor_areas_when_moving)
 {
     using namespace testing;
 
-    EXPECT_CALL(mock_input_scene, emit_scene_changed());
+    auto const size = stub_cursor_image.size();
+    auto const old_area = geom::Rectangle{geom::Point{0,0} - stub_cursor_image.hotspot(), size};
+    auto const new_area = geom::Rectangle{geom::Point{22,23} - stub_cursor_image.hotspot(), size};
+
+    EXPECT_CALL(mock_input_scene, emit_scene_damaged(geom::Rectangles{old_area, new_area}));
+    EXPECT_CALL(mock_input_scene, emit_scene_changed()).Times(0);
 
     cursor.show(stub_cursor_image);
     executor.execute();
@@ -328,6 +329,7 @@ TEST_F(SoftwareCursor, does_not_hide_or_move_when_already_hidden)
 
     EXPECT_CALL(mock_input_scene, remove_input_visualization(_)).Times(0);
     EXPECT_CALL(mock_input_scene, emit_scene_changed()).Times(0);
+    EXPECT_CALL(mock_input_scene, emit_scene_damaged(_)).Times(0);
 
     // Already hidden, nothing should happen
     cursor.hide();
@@ -336,53 +338,74 @@ TEST_F(SoftwareCursor, does_not_hide_or_move_when_already_hidden)
     cursor.move_to({3,4});
 }
 
-TEST_F(SoftwareCursor, creates_new_renderable_for_new_cursor_image)
+TEST_F(SoftwareCursor, reuses_renderable_in_scene_for_new_cursor_image)
 {
     using namespace testing;
 
-    std::shared_ptr<mg::Renderable> first_cursor_renderable;
+    std::shared_ptr<mg::Renderable> cursor_renderable;
 
     EXPECT_CALL(mock_input_scene, add_input_visualization(_)).
-        WillOnce(SaveArg<0>(&first_cursor_renderable));
+        WillOnce(SaveArg<0>(&cursor_renderable));
 
     cursor.show(stub_cursor_image);
     executor.execute();
 
     Mock::VerifyAndClearExpectations(&mock_input_scene);
 
-    EXPECT_CALL(mock_input_scene,
-                remove_input_visualization(WeakPtrEq(first_cursor_renderable)));
-    EXPECT_CALL(mock_input_scene, add_input_visualization(Ne(first_cursor_renderable)));
+    auto const first_buffer = cursor_renderable->buffer();
 
+    EXPECT_CALL(mock_input_scene, remove_input_visualization(_)).Times(0);
+    EXPECT_CALL(mock_input_scene, add_input_visualization(_)).Times(0);
+    EXPECT_CALL(mock_input_scene, emit_scene_damaged(_));
+
+    another_stub_cursor_image.fill_with(1, 2, 3, 4);
     cursor.show(another_stub_cursor_image);
     executor.execute();
 
     Mock::VerifyAndClearExpectations(&mock_input_scene);
+
+    EXPECT_THAT(cursor_renderable->buffer(), Ne(first_buffer));
 }
 
-TEST_F(SoftwareCursor, places_new_cursor_renderable_at_correct_position)
+TEST_F(SoftwareCursor, places_new_cursor_image_at_correct_position)
 {
     using namespace testing;
 
     auto const cursor_position = geom::Point{3, 4};
+    std::shared_ptr<mg::Renderable> cursor_renderable;
+
+    EXPECT_CALL(mock_input_scene, add_input_visualization(_)).
+        WillOnce(SaveArg<0>(&cursor_renderable));
 
     cursor.show(stub_cursor_image);
     executor.execute();
     cursor.move_to(cursor_position);
     executor.execute();
 
-    Mock::VerifyAndClearExpectations(&mock_input_scene);
+    cursor.show(another_stub_cursor_image);
+    executor.execute();
 
-    auto const renderable_position =
-        cursor_position - another_stub_cursor_image.hotspot();
-    EXPECT_CALL(mock_input_scene,
-                add_input_visualization(RenderableWithPosition(renderable_position)));
+    EXPECT_THAT(cursor_renderable->screen_position().top_left,
+                Eq(cursor_position - another_stub_cursor_image.hotspot()));
+}
 
+TEST_F(SoftwareCursor, reuses_buffer_when_cursor_image_is_shown_again)
+{
+    EXPECT_CALL(mock_buffer_allocator, alloc_software_buffer(testing::_, testing::_))
+        .Times(2);
+    mg::SoftwareCursor cursor{
+        mt::fake_shared(mock_buffer_allocator),
+        mt::fake_shared(executor),
+        mt::fake_shared(mock_input_scene)};
+    another_stub_cursor_image.fill_with(1, 2, 3, 4);
+    cursor.show(another_stub_cursor_image);
+    cursor.show(stub_cursor_image);
     cursor.show(another_stub_cursor_image);
+    cursor.show(stub_cursor_image);
 }
 
 //lp: #1413211
-TEST_F(SoftwareCursor, new_buffer_on_each_show)
+TEST_F(SoftwareCursor, new_buffer_on_each_show_of_changed_content)
 {
     EXPECT_CALL(mock_buffer_allocator, alloc_software_buffer(testing::_, testing::_))
         .Times(3);
@@ -391,8 +414,10 @@ TEST_F(SoftwareCursor, new_buffer_on_each_show)
         mt::fake_shared(executor),
         mt::fake_shared(mock_input_scene)};
     cursor.show(another_stub_cursor_image);
+    another_stub_cursor_image.fill_with(1, 2, 3, 4);
+    cursor.show(another_stub_cursor_image);
+    another_stub_cursor_image.fill_with(5, 6, 7, 8);
     cursor.show(another_stub_cursor_image);
-    cursor.show(stub_cursor_image);
 }
 
 //lp: 1483779
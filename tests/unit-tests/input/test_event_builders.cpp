@@ -225,3 +225,32 @@ TEST_F(InputEventBuilder, when_creating_input_device_state_event_it_has_supplied
     EXPECT_THAT(mir_input_device_state_event_device_pressed_keys_count(ids_event, 1), Eq(0));
     EXPECT_THAT(mir_input_device_state_event_device_pointer_buttons(ids_event, 1), Eq(button_state));
 }
+
+TEST_F(InputEventBuilder, input_events_reuse_the_storage_of_released_events)
+{
+    auto ev = mev::make_pointer_event(
+        device_id, timestamp, modifiers,
+        mir_pointer_action_motion, 0, 1.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    MirEvent const* const storage = ev.get();
+    ev.reset();
+
+    auto const key_ev = mev::make_key_event(
+        device_id, timestamp, mir_keyboard_action_down, 34, 17, modifiers);
+
+    EXPECT_THAT(key_ev.get(), Eq(storage));
+}
+
+TEST_F(InputEventBuilder, shared_events_are_released_with_their_last_reference)
+{
+    auto ev = mev::make_pointer_event(
+        device_id, timestamp, modifiers,
+        mir_pointer_action_motion, 0, 1.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    MirEvent const* const storage = ev.get();
+
+    auto shared = mev::share_event(std::move(ev));
+    auto const copy = shared;
+    shared.reset();
+
+    EXPECT_THAT(copy.get(), Eq(storage));
+    EXPECT_THAT(mir_event_get_type(copy.get()), Eq(mir_event_type_input));
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ml = mir::logging;
+
+using namespace testing;
+
+namespace
+{
+struct RecordingLogger : ml::Logger
+{
+    void log(ml::Severity, std::string const& message, std::string const&) override
+    {
+        if (on_log)
+        {
+            on_log(message);
+        }
+
+        std::lock_guard lock{mutex};
+        messages.push_back(message);
+    }
+
+    auto logged() -> std::vector<std::string>
+    {
+        std::lock_guard lock{mutex};
+        return messages;
+    }
+
+    std::function<void(std::string const&)> on_log;
+
+private:
+    std::mutex mutex;
+    std::vector<std::string> messages;
+};
+
+auto numbered(char const* prefix, int count) -> std::vector<std::string>
+{
+    std::vector<std::string> result;
+    for (auto i = 0; i != count; ++i)
+    {
+        result.push_back(prefix + std::to_string(i));
+    }
+    return result;
+}
+}
+
+TEST(AsyncLogger, messages_reach_the_sink_in_order)
+{
+    auto const sink = std::make_shared<RecordingLogger>();
+    ml::AsyncLogger logger{sink, ml::AsyncLogger::WhenFull::block, 4};
+    ml::Logger& as_logger = logger;
+
+    for (auto const& message : numbered("message ", 100))
+    {
+        as_logger.log(ml::Severity::informational, message, "test");
+    }
+    logger.flush();
+
+    EXPECT_THAT(sink->logged(), ElementsAreArray(numbered("message ", 100)));
+}
+
+TEST(AsyncLogger, messages_from_each_thread_keep_their_order)
+{
+    auto const sink = std::make_shared<RecordingLogger>();
+    ml::AsyncLogger logger{sink, ml::AsyncLogger::WhenFull::block, 4};
+    ml::Logger& as_logger = logger;
+
+    {
+        std::jthread a{[&] { for (auto const& m : numbered("a", 50)) as_logger.log(ml::Severity::debug, m, "test"); }};
+        std::jthread b{[&] { for (auto const& m : numbered("b", 50)) as_logger.log(ml::Severity::debug, m, "test"); }};
+    }
+    logger.flush();
+
+    std::vector<std::string> from_a, from_b;
+    for (auto const& message : sink->logged())
+    {
+        (message[0] == 'a' ? from_a : from_b).push_back(message);
+    }
+    EXPECT_THAT(from_a, ElementsAreArray(numbered("a", 50)));
+    EXPECT_THAT(from_b, ElementsAreArray(numbered("b", 50)));
+}
+
+TEST(AsyncLogger, message_reaches_the_sink_without_a_flush)
+{
+    using namespace std::chrono_literals;
+
+    std::promise<void> logged;
+    auto const sink = std::make_shared<RecordingLogger>();
+    sink->on_log = [&](std::string const&) { logged.set_value(); };
+    ml::AsyncLogger logger{sink, ml::AsyncLogger::WhenFull::drop};
+    ml::Logger& as_logger = logger;
+
+    as_logger.log(ml::Severity::debug, "message", "test");
+
+    EXPECT_THAT(logged.get_future().wait_for(60s), Eq(std::future_status::ready));
+}
+
+TEST(AsyncLogger, critical_message_is_written_before_log_returns)
+{
+    auto const sink = std::make_shared<RecordingLogger>();
+    ml::AsyncLogger logger{sink, ml::AsyncLogger::WhenFull::drop};
+    ml::Logger& as_logger = logger;
+
+    as_logger.log(ml::Severity::informational, "first", "test");
+    as_logger.log(ml::Severity::critical, "second", "test");
+
+    EXPECT_THAT(sink->logged(), ElementsAre("first", "second"));
+}
+
+TEST(AsyncLogger, drops_messages_when_full_and_reports_how_many)
+{
+    std::promise<void> sink_entered;
+    std::promise<void> release_sink;
+    auto const sink = std::make_shared<RecordingLogger>();
+    sink->on_log = [&, first = true](std::string const&) mutable
+        {
+            if (first)
+            {
+                first = false;
+                sink_entered.set_value();
+                release_sink.get_future().wait();
+            }
+        };
+
+    ml::AsyncLogger logger{sink, ml::AsyncLogger::WhenFull::drop, 1};
+    ml::Logger& as_logger = logger;
+
+    as_logger.log(ml::Severity::informational, "kept", "test");
+    sink_entered.get_future().wait();
+
+    // The writer is stuck writing "kept", so it still fills the queue
+    as_logger.log(ml::Severity::informational, "dropped", "test");
+    as_logger.log(ml::Severity::informational, "dropped", "test");
+
+    release_sink.set_value();
+    logger.flush();
+
+    EXPECT_THAT(sink->logged(), ElementsAre("kept", HasSubstr("2 log messages were dropped")));
+}
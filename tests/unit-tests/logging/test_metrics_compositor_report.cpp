@@ -0,0 +1,203 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/metrics/compositor_report.h"
+#include "src/server/report/null_report_factory.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/mock_compositor_report.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <string>
+
+namespace mtd = mir::test::doubles;
+namespace mrm = mir::report::metrics;
+namespace mr = mir::report;
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace
+{
+struct MetricsCompositorReport : Test
+{
+    std::shared_ptr<mtd::AdvanceableClock> const clock = std::make_shared<mtd::AdvanceableClock>();
+    mrm::CompositorReport report{mr::null_compositor_report(), clock, "/dev/null", std::chrono::hours{1}};
+    void const* const display_id = this;
+
+    MetricsCompositorReport()
+    {
+        report.added_display(1920, 1080, 0, 0, display_id);
+    }
+
+    void frame(std::chrono::microseconds render_time)
+    {
+        report.began_scene_snapshot(display_id);
+        report.began_frame(display_id);
+        clock->advance_by(render_time);
+        report.rendered_frame(display_id);
+        report.finished_frame(display_id);
+        report.posted_frame(display_id);
+    }
+
+    auto metrics() -> std::string
+    {
+        std::ostringstream out;
+        report.write_metrics(out);
+        return out.str();
+    }
+
+    /// The value of the first sample that starts with \p prefix and contains \p label
+    static auto value_of(std::string const& metrics, std::string const& prefix, std::string const& label = "") -> double
+    {
+        std::istringstream in{metrics};
+        for (std::string line; std::getline(in, line);)
+        {
+            if (line.starts_with(prefix) && line.find(label) != std::string::npos)
+            {
+                return std::stod(line.substr(line.rfind(' ') + 1));
+            }
+        }
+        ADD_FAILURE() << "No sample for " << prefix;
+        return 0;
+    }
+};
+}
+
+TEST_F(MetricsCompositorReport, percentiles_show_the_slowest_frames)
+{
+    for (auto i = 0; i != 98; ++i)
+    {
+        frame(1ms);
+    }
+    frame(50ms);
+    frame(50ms);
+
+    auto const text = metrics();
+    auto const quantile = [&](std::string const& q)
+        {
+            return value_of(text, "mir_compositor_render_time_seconds{", "quantile=\"" + q + "\"");
+        };
+
+    EXPECT_THAT(quantile("0.5"), AllOf(Ge(0.001), Le(0.001125)));
+    EXPECT_THAT(quantile("0.95"), AllOf(Ge(0.001), Le(0.001125)));
+    EXPECT_THAT(quantile("0.99"), DoubleNear(0.05, 1e-6));
+    EXPECT_THAT(value_of(text, "mir_compositor_render_time_max_seconds{"), DoubleNear(0.05, 1e-6));
+    EXPECT_THAT(value_of(text, "mir_compositor_render_time_seconds_count{"), Eq(100));
+    EXPECT_THAT(text, EndsWith("# EOF\n"));
+}
+
+TEST_F(MetricsCompositorReport, percentiles_are_of_frames_since_last_written)
+{
+    frame(50ms);
+    metrics();
+
+    frame(1ms);
+
+    auto const text = metrics();
+    EXPECT_THAT(value_of(text, "mir_compositor_render_time_max_seconds{"), DoubleNear(0.001, 1e-6));
+    EXPECT_THAT(value_of(text, "mir_compositor_render_time_seconds_count{"), Eq(2));
+}
+
+TEST_F(MetricsCompositorReport, counts_bypassed_and_overlaid_frames)
+{
+    frame(1ms);
+
+    report.began_scene_snapshot(display_id);
+    report.began_frame(display_id);
+    report.overlaid_frame(display_id, 1);
+    report.finished_frame(display_id);
+
+    report.began_scene_snapshot(display_id);
+    report.began_frame(display_id);
+    report.rendered_frame(display_id);
+    report.overlaid_frame(display_id, 1);
+    report.finished_frame(display_id);
+
+    auto const text = metrics();
+    EXPECT_THAT(value_of(text, "mir_compositor_frames_total{"), Eq(3));
+    EXPECT_THAT(value_of(text, "mir_compositor_bypassed_frames_total{"), Eq(1));
+    EXPECT_THAT(value_of(text, "mir_compositor_overlaid_frames_total{"), Eq(1));
+}
+
+TEST_F(MetricsCompositorReport, latency_is_from_scheduling_to_post)
+{
+    report.scheduled();
+    clock->advance_by(3ms);
+    frame(1ms);
+
+    // Not scheduled, so has no latency
+    frame(1ms);
+
+    auto const text = metrics();
+    EXPECT_THAT(value_of(text, "mir_compositor_latency_max_seconds{"), DoubleNear(0.004, 1e-6));
+    EXPECT_THAT(value_of(text, "mir_compositor_latency_seconds_count{"), Eq(1));
+}
+
+TEST_F(MetricsCompositorReport, outputs_added_after_stopping_start_from_zero)
+{
+    frame(50ms);
+    frame(50ms);
+    metrics();
+    frame(50ms);
+
+    report.stopped();
+    int const other_display{0};
+    report.added_display(1280, 1024, 1920, 0, &other_display);
+
+    report.began_scene_snapshot(&other_display);
+    report.began_frame(&other_display);
+    clock->advance_by(1ms);
+    report.rendered_frame(&other_display);
+    report.finished_frame(&other_display);
+    report.posted_frame(&other_display);
+
+    auto const text = metrics();
+    EXPECT_THAT(text, HasSubstr("geometry=\"1280x1024+1920+0\""));
+    EXPECT_THAT(text, Not(HasSubstr("geometry=\"1920x1080+0+0\"")));
+    EXPECT_THAT(value_of(text, "mir_compositor_frames_total{"), Eq(1));
+    EXPECT_THAT(value_of(text, "mir_compositor_render_time_seconds_count{"), Eq(1));
+    EXPECT_THAT(value_of(text, "mir_compositor_render_time_seconds_sum{"), DoubleNear(0.001, 1e-6));
+    EXPECT_THAT(value_of(text, "mir_compositor_render_time_max_seconds{"), DoubleNear(0.001, 1e-6));
+    EXPECT_THAT(
+        value_of(text, "mir_compositor_render_time_seconds{", "quantile=\"0.99\""),
+        AllOf(Ge(0.001), Le(0.001125)));
+}
+
+TEST_F(MetricsCompositorReport, passes_reports_on)
+{
+    auto const next = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    mrm::CompositorReport forwarding_report{next, clock, "/dev/null", std::chrono::hours{1}};
+
+    EXPECT_CALL(*next, began_frame(display_id));
+    EXPECT_CALL(*next, finished_frame(display_id));
+    EXPECT_CALL(*next, posted_frame(display_id));
+
+    forwarding_report.began_frame(display_id);
+    forwarding_report.finished_frame(display_id);
+    forwarding_report.posted_frame(display_id);
+}
+
+TEST(MetricsHistogram, buckets_are_no_wider_than_an_eighth_of_their_values)
+{
+    for (uint64_t us = 0; us < 10'000'000; us = us * 9 / 8 + 1)
+    {
+        auto const limit = mrm::Histogram::bucket_limit(mrm::Histogram::bucket_for(us));
+        EXPECT_THAT(limit, AllOf(Ge(us), Le(us + us / 8))) << "for " << us << "us";
+    }
+}
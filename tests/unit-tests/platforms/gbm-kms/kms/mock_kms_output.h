@@ -33,6 +33,7 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
     MOCK_METHOD2(configure, void(geometry::Displacement, size_t));
     MOCK_CONST_METHOD0(size, geometry::Size());
     MOCK_CONST_METHOD0(max_refresh_rate, int());
+    MOCK_CONST_METHOD0(frame_interval, std::chrono::nanoseconds());
 
     bool set_crtc(graphics::FBHandle const& fb) override
     {
@@ -48,10 +49,42 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
         return schedule_page_flip_thunk(&fb);
     }
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::FBHandle const*));
-    MOCK_METHOD0(wait_for_page_flip, void());
+    MOCK_METHOD0(wait_for_page_flip, graphics::Frame());
 
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
+    MOCK_METHOD0(planes, std::vector<graphics::gbm::PlaneInfo> const&());
+    bool set_plane(
+        uint32_t plane_id,
+        graphics::FBHandle const& fb,
+        geometry::Rectangle const& dest,
+        geometry::RectangleF const& source) override
+    {
+        return set_plane_thunk(plane_id, &fb, dest, source);
+    }
+    MOCK_METHOD4(
+        set_plane_thunk,
+        bool(uint32_t, graphics::FBHandle const*, geometry::Rectangle const&, geometry::RectangleF const&));
+    MOCK_METHOD1(clear_plane, void(uint32_t));
+
+    MOCK_CONST_METHOD0(supports_atomic, bool());
+    bool add_to_request(
+        graphics::gbm::AtomicRequest& request,
+        graphics::FBHandle const& fb,
+        std::vector<graphics::gbm::OverlayPlane> const& overlays,
+        bool modeset) override
+    {
+        return add_to_request_thunk(&request, &fb, overlays, modeset);
+    }
+    MOCK_METHOD4(
+        add_to_request_thunk,
+        bool(
+            graphics::gbm::AtomicRequest*,
+            graphics::FBHandle const*,
+            std::vector<graphics::gbm::OverlayPlane> const&,
+            bool));
+    MOCK_METHOD2(commit, bool(graphics::gbm::AtomicRequest const&, uint32_t));
+
     MOCK_METHOD1(set_cursor, bool(gbm_bo*));
     MOCK_METHOD1(move_cursor, void(geometry::Point));
     MOCK_METHOD0(clear_cursor, bool());
@@ -324,7 +324,7 @@ ACTION_P(InvokePageFlipHandler, param)
     int const dont_care{0};
     char dummy;
 
-    arg1->page_flip_handler(dont_care, dont_care, dont_care, dont_care, *param);
+    arg1->page_flip_handler2(dont_care, dont_care, dont_care, dont_care, dont_care, *param);
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
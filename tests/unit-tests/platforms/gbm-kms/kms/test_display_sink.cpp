@@ -34,6 +34,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <gbm.h>
+#include <drm_fourcc.h>
 
 using namespace testing;
 using namespace mir;
@@ -69,6 +70,8 @@ public:
     }
 
     MOCK_METHOD(mir::geometry::Size, size, (), (const override));
+    MOCK_METHOD(DRMFormat, drm_format, (), (const override));
+    MOCK_METHOD(std::optional<uint64_t>, modifier, (), (const override));
 };
 }
 
@@ -124,6 +127,8 @@ public:
             .WillByDefault(Return(true));
         ON_CALL(*mock_kms_output, max_refresh_rate())
             .WillByDefault(Return(mock_refresh_rate));
+        ON_CALL(*mock_kms_output, frame_interval())
+            .WillByDefault(Return(std::chrono::nanoseconds{std::chrono::seconds{1}} / mock_refresh_rate));
         ON_CALL(*mock_kms_output, fb_for(A<gbm_bo*>()))
             .WillByDefault(Return(
                 std::shared_ptr<FBHandle const>{
@@ -136,6 +141,13 @@ public:
                     [](auto) {}}));
         ON_CALL(*mock_kms_output, buffer_requires_migration(_))
             .WillByDefault(Return(false));
+        ON_CALL(*mock_kms_output, planes())
+            .WillByDefault(ReturnRef(planes));
+
+        ON_CALL(*bypass_framebuffer, size())
+            .WillByDefault(Return(display_area.size));
+        ON_CALL(*bypass_framebuffer, drm_format())
+            .WillByDefault(Return(DRMFormat{DRM_FORMAT_XRGB8888}));
 
         ON_CALL(*mock_bypassable_buffer, size())
             .WillByDefault(Return(display_area.size));
@@ -171,7 +183,8 @@ protected:
     UdevEnvironment   fake_devices;
     std::shared_ptr<MockKMSOutput> mock_kms_output;
     StubGLConfig gl_config;
-    std::shared_ptr<mir::graphics::Framebuffer> const bypass_framebuffer;
+    std::vector<PlaneInfo> const planes{{31, PlaneInfo::Type::primary, 0, {{DRM_FORMAT_XRGB8888, {}}}}};
+    std::shared_ptr<NiceMock<MockKMSFramebuffer>> const bypass_framebuffer;
     std::vector<mir::graphics::DisplayElement> const bypassable_list;
     std::shared_ptr<struct gbm_device> const gbm;
 };
@@ -233,6 +246,38 @@ TEST_F(MesaDisplaySinkTest, untransformed_with_bypassable_list_can_bypass)
     EXPECT_TRUE(sink.overlay(bypassable_list));
 }
 
+TEST_F(MesaDisplaySinkTest, compositor_is_woken_just_before_the_next_vblank_once_frames_are_measured)
+{
+    int64_t msc{0};
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Invoke(
+            [&msc]
+            {
+                return Frame{++msc, mir::time::PosixTimestamp::now(CLOCK_MONOTONIC)};
+            }));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        ASSERT_TRUE(sink.overlay(bypassable_list));
+        sink.post();
+    }
+
+    // These frames take no time at all, so we can sleep for most of the next one...
+    auto const frame_interval = std::chrono::milliseconds{1000} / mock_refresh_rate;
+    EXPECT_THAT(sink.recommended_sleep(), Gt(frame_interval / 2));
+    // ...but must still wake in time for its vblank
+    EXPECT_THAT(sink.recommended_sleep(), Lt(frame_interval));
+}
+
 namespace
 {
 template<typename T>
@@ -258,3 +303,162 @@ TEST_F(MesaDisplaySinkTest, transformation_not_implemented_internally)
     EXPECT_EQ(rotate_left, sink.transformation());
 }
 
+
+namespace
+{
+auto make_framebuffer(mir::geometry::Size size, uint32_t format) -> std::shared_ptr<NiceMock<MockKMSFramebuffer>>
+{
+    auto fb = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*fb, size()).WillByDefault(Return(size));
+    ON_CALL(*fb, drm_format()).WillByDefault(Return(DRMFormat{format}));
+    return fb;
+}
+
+auto whole_of(mir::geometry::Size size) -> mir::geometry::RectangleF
+{
+    return mir::geometry::RectangleF{{0, 0}, {size.width.as_value(), size.height.as_value()}};
+}
+
+std::vector<PlaneInfo> const overlay_planes{
+    {31, PlaneInfo::Type::primary, 0, {{DRM_FORMAT_XRGB8888, {}}}},
+    {41, PlaneInfo::Type::overlay, 1, {{DRM_FORMAT_ARGB8888, {}}}}};
+}
+
+TEST_F(MesaDisplaySinkTest, shows_elements_above_primary_on_overlay_planes)
+{
+    ON_CALL(*mock_kms_output, planes())
+        .WillByDefault(ReturnRef(overlay_planes));
+
+    mir::geometry::Rectangle const popup_area{{22, 44}, {10, 10}};
+    auto const primary_fb = make_framebuffer(display_area.size, DRM_FORMAT_XRGB8888);
+    auto const popup_fb = make_framebuffer(popup_area.size, DRM_FORMAT_ARGB8888);
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay({
+        {display_area, whole_of(display_area.size), primary_fb},
+        {popup_area, whole_of(popup_area.size), popup_fb}}));
+
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(primary_fb.get()))
+        .WillOnce(Return(true));
+    // Planes are positioned relative to the output
+    EXPECT_CALL(*mock_kms_output, set_plane_thunk(41, popup_fb.get(), mir::geometry::Rectangle{{10, 10}, {10, 10}}, _))
+        .WillOnce(Return(true));
+    sink.post();
+    Mock::VerifyAndClearExpectations(mock_kms_output.get());
+
+    // Once the popup is gone, so is its plane
+    EXPECT_CALL(*mock_kms_output, clear_plane(41));
+    ASSERT_TRUE(sink.overlay({{display_area, whole_of(display_area.size), primary_fb}}));
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, flips_clones_together_in_one_atomic_commit)
+{
+    auto const clone = std::make_shared<NiceMock<MockKMSOutput>>();
+    for (auto const& output : {mock_kms_output, std::shared_ptr<MockKMSOutput>{clone}})
+    {
+        ON_CALL(*output, supports_atomic())
+            .WillByDefault(Return(true));
+        ON_CALL(*output, add_to_request_thunk(_, _, _, _))
+            .WillByDefault(Return(true));
+    }
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, clone},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+
+    AtomicRequest* request{nullptr};
+    AtomicRequest* clone_request{nullptr};
+    EXPECT_CALL(*mock_kms_output, add_to_request_thunk(_, bypass_framebuffer.get(), IsEmpty(), false))
+        .WillOnce(DoAll(SaveArg<0>(&request), Return(true)));
+    EXPECT_CALL(*clone, add_to_request_thunk(_, bypass_framebuffer.get(), IsEmpty(), false))
+        .WillOnce(DoAll(SaveArg<0>(&clone_request), Return(true)));
+    EXPECT_CALL(*mock_kms_output, commit(_, 0))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_)).Times(0);
+    EXPECT_CALL(*clone, schedule_page_flip_thunk(_)).Times(0);
+
+    sink.post();
+
+    EXPECT_THAT(clone_request, Eq(request));
+}
+
+TEST_F(MesaDisplaySinkTest, atomic_frames_carry_their_overlay_planes)
+{
+    ON_CALL(*mock_kms_output, planes())
+        .WillByDefault(ReturnRef(overlay_planes));
+    ON_CALL(*mock_kms_output, supports_atomic())
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, add_to_request_thunk(_, _, _, _))
+        .WillByDefault(Return(true));
+
+    // With a TEST_ONLY commit to check, planes may scale
+    mir::geometry::Rectangle const popup_area{{22, 44}, {20, 20}};
+    auto const primary_fb = make_framebuffer(display_area.size, DRM_FORMAT_XRGB8888);
+    auto const popup_fb = make_framebuffer({10, 10}, DRM_FORMAT_ARGB8888);
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, commit(_, DRM_MODE_ATOMIC_TEST_ONLY))
+        .WillOnce(Return(true));
+    ASSERT_TRUE(sink.overlay({
+        {display_area, whole_of(display_area.size), primary_fb},
+        {popup_area, whole_of(popup_fb->size()), popup_fb}}));
+
+    EXPECT_CALL(*mock_kms_output, add_to_request_thunk(_, primary_fb.get(), SizeIs(1), false));
+    EXPECT_CALL(*mock_kms_output, commit(_, 0))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, set_plane_thunk(_, _, _, _)).Times(0);
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, overlays_rejected_by_test_commit_are_not_used)
+{
+    ON_CALL(*mock_kms_output, planes())
+        .WillByDefault(ReturnRef(overlay_planes));
+    ON_CALL(*mock_kms_output, supports_atomic())
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, add_to_request_thunk(_, _, _, _))
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, commit(_, DRM_MODE_ATOMIC_TEST_ONLY))
+        .WillByDefault(Return(false));
+
+    mir::geometry::Rectangle const popup_area{{22, 44}, {10, 10}};
+    auto const primary_fb = make_framebuffer(display_area.size, DRM_FORMAT_XRGB8888);
+    auto const popup_fb = make_framebuffer(popup_area.size, DRM_FORMAT_ARGB8888);
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_FALSE(sink.overlay({
+        {display_area, whole_of(display_area.size), primary_fb},
+        {popup_area, whole_of(popup_area.size), popup_fb}}));
+}
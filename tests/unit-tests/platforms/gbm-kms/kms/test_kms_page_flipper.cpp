@@ -15,6 +15,7 @@
  */
 
 #include "src/platforms/gbm-kms/server/kms/kms_page_flipper.h"
+#include "src/platforms/gbm-kms/server/kms/atomic_request.h"
 
 #include "mir/test/doubles/mock_drm.h"
 #include "mir/test/doubles/mock_display_report.h"
@@ -63,7 +64,16 @@ ACTION_P(InvokePageFlipHandler, param)
     int const dont_care{0};
     char dummy;
 
-    arg1->page_flip_handler(dont_care, dont_care, dont_care, dont_care, *param);
+    arg1->page_flip_handler2(dont_care, dont_care, dont_care, dont_care, dont_care, *param);
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
+ACTION_P2(InvokePageFlipHandlerForCrtc, param, crtc_id)
+{
+    int const dont_care{0};
+    char dummy;
+
+    arg1->page_flip_handler2(dont_care, dont_care, dont_care, dont_care, crtc_id, *param);
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
@@ -101,6 +111,40 @@ TEST_F(KMSPageFlipperTest, double_schedule_flip_throws)
     }, std::logic_error);
 }
 
+TEST_F(KMSPageFlipperTest, atomic_flip_is_pending_on_each_crtc_until_its_event_arrives)
+{
+    using namespace testing;
+
+    ON_CALL(mock_drm, drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(1), Return(0)));
+    mgg::KMSPageFlipper atomic_flipper{drm_fd, mt::fake_shared(report)};
+    ASSERT_TRUE(atomic_flipper.supports_atomic());
+
+    uint32_t const crtc_id{10};
+    uint32_t const clone_crtc_id{11};
+    mgg::AtomicRequest request;
+    request.add_target(crtc_id, 345);
+    request.add_target(clone_crtc_id, 346);
+    void* user_data{nullptr};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, request.get(), DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, _))
+        .WillOnce(DoAll(SaveArg<3>(&user_data), Return(0)));
+
+    EXPECT_TRUE(atomic_flipper.schedule_atomic_flip(request));
+    EXPECT_THROW({
+        atomic_flipper.schedule_flip(clone_crtc_id, 101, 346);
+    }, std::logic_error);
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandlerForCrtc(&user_data, crtc_id), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandlerForCrtc(&user_data, clone_crtc_id), Return(0)));
+
+    mock_drm.generate_event_on(drm_device);
+    atomic_flipper.wait_for_flip(crtc_id);
+    mock_drm.generate_event_on(drm_device);
+    atomic_flipper.wait_for_flip(clone_crtc_id);
+}
+
 TEST_F(KMSPageFlipperTest, wait_for_flip_handles_drm_event)
 {
     using namespace testing;
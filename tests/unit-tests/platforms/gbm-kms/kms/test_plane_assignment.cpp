@@ -0,0 +1,498 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kms_framebuffer.h"
+#include "src/platforms/gbm-kms/server/kms/plane_assignment.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <drm_fourcc.h>
+
+#include <cstring>
+#include <deque>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace ::testing;
+
+namespace
+{
+class StubKMSFramebuffer : public mg::FBHandle
+{
+public:
+    StubKMSFramebuffer(geom::Size size, uint32_t format, std::optional<uint64_t> modifier = std::nullopt)
+        : size_{size},
+          format{format},
+          modifier_{modifier}
+    {
+    }
+
+    operator uint32_t() const override
+    {
+        return 1;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+    auto drm_format() const -> mg::DRMFormat override
+    {
+        return mg::DRMFormat{format};
+    }
+
+    auto modifier() const -> std::optional<uint64_t> override
+    {
+        return modifier_;
+    }
+
+private:
+    geom::Size const size_;
+    uint32_t const format;
+    std::optional<uint64_t> const modifier_;
+};
+
+class StubFramebuffer : public mg::Framebuffer
+{
+public:
+    auto size() const -> geom::Size override
+    {
+        return {};
+    }
+};
+
+auto element_for(geom::Rectangle const& position, std::shared_ptr<mg::Framebuffer> fb) -> mg::DisplayElement
+{
+    return mg::DisplayElement{
+        position,
+        geom::RectangleF{
+            {0, 0},
+            {position.size.width.as_value(), position.size.height.as_value()}},
+        std::move(fb)};
+}
+
+auto plane(uint32_t id, mgg::PlaneInfo::Type type, uint64_t zpos, std::vector<uint32_t> const& formats)
+    -> mgg::PlaneInfo
+{
+    mgg::PlaneInfo info{id, type, zpos, {}};
+    for (auto format : formats)
+    {
+        info.formats[format];
+    }
+    return info;
+}
+
+geom::Rectangle const view_area{{0, 0}, {1920, 1080}};
+geom::Rectangle const video_area{{100, 100}, {640, 480}};
+
+class PlaneAssignment : public ::testing::Test
+{
+public:
+    std::vector<mgg::PlaneInfo> const planes{
+        plane(31, mgg::PlaneInfo::Type::primary, 0, {DRM_FORMAT_XRGB8888, DRM_FORMAT_ARGB8888}),
+        plane(41, mgg::PlaneInfo::Type::overlay, 1, {DRM_FORMAT_NV12}),
+        plane(51, mgg::PlaneInfo::Type::overlay, 2, {DRM_FORMAT_XRGB8888, DRM_FORMAT_ARGB8888}),
+        plane(61, mgg::PlaneInfo::Type::cursor, 3, {DRM_FORMAT_ARGB8888})};
+
+    std::shared_ptr<mg::FBHandle> const desktop{
+        std::make_shared<StubKMSFramebuffer>(view_area.size, DRM_FORMAT_XRGB8888)};
+};
+
+/// Enough of a fake KMS device to enumerate planes from
+class PlaneEnumeration : public ::testing::Test
+{
+public:
+    enum PropertyId : uint32_t
+    {
+        type_property = 1,
+        zpos_property,
+        in_formats_property
+    };
+
+    PlaneEnumeration()
+    {
+        ON_CALL(mock_drm, drmModeGetPlaneResources(_))
+            .WillByDefault(Invoke(
+                [this](int)
+                {
+                    plane_resources.count_planes = plane_ids.size();
+                    plane_resources.planes = plane_ids.data();
+                    return &plane_resources;
+                }));
+        ON_CALL(mock_drm, drmModeGetPlane(_, _))
+            .WillByDefault(Invoke(
+                [this](int, uint32_t id) -> drmModePlanePtr
+                {
+                    for (auto& plane : planes)
+                    {
+                        if (plane.plane.plane_id == id)
+                        {
+                            return &plane.plane;
+                        }
+                    }
+                    return nullptr;
+                }));
+        ON_CALL(mock_drm, drmModeObjectGetProperties(_, _, DRM_MODE_OBJECT_PLANE))
+            .WillByDefault(Invoke(
+                [this](int, uint32_t id, uint32_t) -> drmModeObjectPropertiesPtr
+                {
+                    for (auto& plane : planes)
+                    {
+                        if (plane.plane.plane_id == id)
+                        {
+                            return &plane.properties;
+                        }
+                    }
+                    return nullptr;
+                }));
+        ON_CALL(mock_drm, drmModeGetProperty(_, _))
+            .WillByDefault(Invoke(
+                [this](int, uint32_t id) -> drmModePropertyPtr
+                {
+                    auto& property = properties.emplace_back();
+                    property.prop_id = id;
+                    switch (id)
+                    {
+                    case type_property:
+                        strcpy(property.name, "type");
+                        break;
+                    case zpos_property:
+                        strcpy(property.name, "zpos");
+                        break;
+                    case in_formats_property:
+                        strcpy(property.name, "IN_FORMATS");
+                        break;
+                    }
+                    return &property;
+                }));
+    }
+
+    void add_plane(
+        uint32_t id,
+        uint32_t possible_crtcs,
+        std::vector<uint32_t> const& formats,
+        std::vector<std::pair<uint32_t, uint64_t>> const& properties)
+    {
+        auto& plane = planes.emplace_back();
+        plane.formats = formats;
+        plane.plane = drmModePlane{};
+        plane.plane.plane_id = id;
+        plane.plane.possible_crtcs = possible_crtcs;
+        plane.plane.count_formats = plane.formats.size();
+        plane.plane.formats = plane.formats.data();
+        for (auto const& [property_id, value] : properties)
+        {
+            plane.property_ids.push_back(property_id);
+            plane.property_values.push_back(value);
+        }
+        plane.properties = drmModeObjectProperties{
+            static_cast<uint32_t>(plane.property_ids.size()),
+            plane.property_ids.data(),
+            plane.property_values.data()};
+        plane_ids.push_back(id);
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    int const drm_fd{42};
+
+private:
+    struct FakePlane
+    {
+        drmModePlane plane;
+        std::vector<uint32_t> formats;
+        std::vector<uint32_t> property_ids;
+        std::vector<uint64_t> property_values;
+        drmModeObjectProperties properties;
+    };
+
+    // Deques, so what we hand out stays put
+    std::deque<FakePlane> planes;
+    std::deque<drmModePropertyRes> properties;
+    std::vector<uint32_t> plane_ids;
+    drmModePlaneRes plane_resources;
+};
+}
+
+TEST_F(PlaneAssignment, puts_single_fullscreen_buffer_on_primary_plane)
+{
+    auto const assignment = mgg::assign_planes({element_for(view_area, desktop)}, planes, view_area, false);
+
+    ASSERT_TRUE(assignment);
+    ASSERT_THAT(*assignment, SizeIs(1));
+    EXPECT_THAT((*assignment)[0]->id, Eq(31u));
+}
+
+TEST_F(PlaneAssignment, puts_elements_above_primary_on_overlay_planes_supporting_their_format)
+{
+    auto const video = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_NV12);
+    auto const popup = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_ARGB8888);
+
+    auto const assignment = mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, video), element_for(video_area, popup)},
+        planes,
+        view_area,
+        false);
+
+    ASSERT_TRUE(assignment);
+    ASSERT_THAT(*assignment, SizeIs(3));
+    EXPECT_THAT((*assignment)[0]->id, Eq(31u));
+    EXPECT_THAT((*assignment)[1]->id, Eq(41u));
+    EXPECT_THAT((*assignment)[2]->id, Eq(51u));
+}
+
+TEST_F(PlaneAssignment, skips_planes_that_cannot_show_a_format)
+{
+    auto const popup = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_ARGB8888);
+
+    auto const assignment = mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, popup)},
+        planes,
+        view_area,
+        false);
+
+    ASSERT_TRUE(assignment);
+    EXPECT_THAT((*assignment)[1]->id, Eq(51u));
+}
+
+TEST_F(PlaneAssignment, preserves_stacking_order)
+{
+    auto const popup = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_ARGB8888);
+    auto const video = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_NV12);
+
+    // The only plane for the video is below the only plane for the popup
+    EXPECT_FALSE(mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, popup), element_for(video_area, video)},
+        planes,
+        view_area,
+        false));
+}
+
+TEST_F(PlaneAssignment, does_not_use_cursor_plane)
+{
+    auto const popup = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_ARGB8888);
+
+    EXPECT_FALSE(mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, popup), element_for(video_area, popup)},
+        planes,
+        view_area,
+        false));
+}
+
+TEST_F(PlaneAssignment, requires_bottom_element_to_cover_primary_plane)
+{
+    auto const popup = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_ARGB8888);
+
+    EXPECT_FALSE(mgg::assign_planes({element_for(video_area, popup)}, planes, view_area, false));
+}
+
+TEST_F(PlaneAssignment, rejects_scaled_elements)
+{
+    auto const popup = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_ARGB8888);
+    auto scaled = element_for(video_area, popup);
+    scaled.source_position.size = geom::SizeF{320, 240};
+
+    EXPECT_FALSE(mgg::assign_planes({element_for(view_area, desktop), scaled}, planes, view_area, false));
+}
+
+TEST_F(PlaneAssignment, places_scaled_elements_on_overlays_when_allowed)
+{
+    auto const popup = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_ARGB8888);
+    auto scaled = element_for(video_area, popup);
+    scaled.source_position.size = geom::SizeF{320, 240};
+    auto scaled_desktop = element_for(view_area, desktop);
+    scaled_desktop.source_position.size = geom::SizeF{960, 540};
+
+    EXPECT_TRUE(mgg::assign_planes({element_for(view_area, desktop), scaled}, planes, view_area, true));
+    // The primary plane is page-flipped, which never scales
+    EXPECT_FALSE(mgg::assign_planes({scaled_desktop}, planes, view_area, true));
+}
+
+TEST_F(PlaneAssignment, treats_elements_showing_more_buffer_pixels_than_screen_pixels_as_scaled)
+{
+    // As from a scale 2 client: twice as many buffer pixels as it covers on screen
+    auto const hidpi = std::make_shared<StubKMSFramebuffer>(video_area.size * 2, DRM_FORMAT_ARGB8888);
+    mg::DisplayElement const element{
+        video_area,
+        geom::RectangleF{{0, 0}, {1280, 960}},
+        hidpi};
+
+    EXPECT_FALSE(mgg::assign_planes({element_for(view_area, desktop), element}, planes, view_area, false));
+    EXPECT_TRUE(mgg::assign_planes({element_for(view_area, desktop), element}, planes, view_area, true));
+}
+
+TEST_F(PlaneAssignment, rejects_elements_sampling_outside_their_buffer)
+{
+    auto const small_popup = std::make_shared<StubKMSFramebuffer>(video_area.size / 2, DRM_FORMAT_ARGB8888);
+
+    EXPECT_FALSE(mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, small_popup)},
+        planes,
+        view_area,
+        true));
+}
+
+TEST_F(PlaneAssignment, rejects_elements_outside_output)
+{
+    auto const popup = std::make_shared<StubKMSFramebuffer>(video_area.size, DRM_FORMAT_ARGB8888);
+
+    EXPECT_FALSE(mgg::assign_planes(
+        {element_for(view_area, desktop), element_for({{1800, 100}, video_area.size}, popup)},
+        planes,
+        view_area,
+        false));
+}
+
+TEST_F(PlaneAssignment, rejects_buffers_that_are_not_kms_framebuffers)
+{
+    EXPECT_FALSE(mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, std::make_shared<StubFramebuffer>())},
+        planes,
+        view_area,
+        false));
+}
+
+TEST_F(PlaneAssignment, matches_explicit_modifiers_against_those_advertised)
+{
+    auto with_modifiers = planes;
+    with_modifiers[2].formats[DRM_FORMAT_ARGB8888] = {DRM_FORMAT_MOD_LINEAR, I915_FORMAT_MOD_X_TILED};
+
+    auto const tiled = std::make_shared<StubKMSFramebuffer>(
+        video_area.size, DRM_FORMAT_ARGB8888, I915_FORMAT_MOD_X_TILED);
+    auto const y_tiled = std::make_shared<StubKMSFramebuffer>(
+        video_area.size, DRM_FORMAT_ARGB8888, I915_FORMAT_MOD_Y_TILED);
+
+    EXPECT_TRUE(mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, tiled)},
+        with_modifiers,
+        view_area,
+        false));
+    EXPECT_FALSE(mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, y_tiled)},
+        with_modifiers,
+        view_area,
+        false));
+    // Without an advertised list we only trust linear buffers
+    EXPECT_FALSE(mgg::assign_planes(
+        {element_for(view_area, desktop), element_for(video_area, tiled)},
+        planes,
+        view_area,
+        false));
+}
+
+TEST_F(PlaneEnumeration, lists_planes_of_crtc_in_stacking_order)
+{
+    add_plane(31, 0b01, {DRM_FORMAT_ARGB8888}, {{type_property, DRM_PLANE_TYPE_OVERLAY}, {zpos_property, 3}});
+    add_plane(32, 0b10, {DRM_FORMAT_XRGB8888}, {{type_property, DRM_PLANE_TYPE_PRIMARY}, {zpos_property, 0}});
+    add_plane(33, 0b11, {DRM_FORMAT_ARGB8888}, {{type_property, DRM_PLANE_TYPE_CURSOR}, {zpos_property, 5}});
+    add_plane(34, 0b01, {DRM_FORMAT_XRGB8888}, {{type_property, DRM_PLANE_TYPE_PRIMARY}, {zpos_property, 0}});
+    add_plane(35, 0b01, {DRM_FORMAT_NV12}, {{type_property, DRM_PLANE_TYPE_OVERLAY}, {zpos_property, 1}});
+
+    auto const planes = mgg::planes_for_crtc(drm_fd, 0);
+
+    ASSERT_THAT(planes, SizeIs(4));
+    EXPECT_THAT(planes[0].id, Eq(34u));
+    EXPECT_THAT(planes[0].type, Eq(mgg::PlaneInfo::Type::primary));
+    EXPECT_THAT(planes[1].id, Eq(35u));
+    EXPECT_THAT(planes[1].type, Eq(mgg::PlaneInfo::Type::overlay));
+    EXPECT_THAT(planes[1].formats.count(DRM_FORMAT_NV12), Eq(1u));
+    EXPECT_THAT(planes[2].id, Eq(31u));
+    EXPECT_THAT(planes[3].id, Eq(33u));
+    EXPECT_THAT(planes[3].type, Eq(mgg::PlaneInfo::Type::cursor));
+}
+
+TEST_F(PlaneEnumeration, leaves_out_overlay_planes_shared_with_other_crtcs)
+{
+    add_plane(31, 0b01, {DRM_FORMAT_XRGB8888}, {{type_property, DRM_PLANE_TYPE_PRIMARY}});
+    add_plane(32, 0b11, {DRM_FORMAT_ARGB8888}, {{type_property, DRM_PLANE_TYPE_OVERLAY}});
+    add_plane(33, 0b01, {DRM_FORMAT_ARGB8888}, {{type_property, DRM_PLANE_TYPE_OVERLAY}});
+
+    auto const planes = mgg::planes_for_crtc(drm_fd, 0);
+
+    ASSERT_THAT(planes, SizeIs(2));
+    EXPECT_THAT(planes[0].id, Eq(31u));
+    EXPECT_THAT(planes[1].id, Eq(33u));
+}
+
+TEST_F(PlaneEnumeration, orders_planes_without_zpos_by_type)
+{
+    add_plane(31, 0b1, {DRM_FORMAT_ARGB8888}, {{type_property, DRM_PLANE_TYPE_CURSOR}});
+    add_plane(32, 0b1, {DRM_FORMAT_ARGB8888}, {{type_property, DRM_PLANE_TYPE_OVERLAY}});
+    add_plane(33, 0b1, {DRM_FORMAT_XRGB8888}, {{type_property, DRM_PLANE_TYPE_PRIMARY}});
+
+    auto const planes = mgg::planes_for_crtc(drm_fd, 0);
+
+    ASSERT_THAT(planes, SizeIs(3));
+    EXPECT_THAT(planes[0].id, Eq(33u));
+    EXPECT_THAT(planes[1].id, Eq(32u));
+    EXPECT_THAT(planes[2].id, Eq(31u));
+}
+
+TEST_F(PlaneEnumeration, includes_primary_plane_when_kernel_does_not_expose_it)
+{
+    add_plane(31, 0b1, {DRM_FORMAT_NV12}, {});
+
+    auto const planes = mgg::planes_for_crtc(drm_fd, 0);
+
+    ASSERT_THAT(planes, SizeIs(2));
+    EXPECT_THAT(planes[0].type, Eq(mgg::PlaneInfo::Type::primary));
+    EXPECT_THAT(planes[0].id, Eq(0u));
+    EXPECT_THAT(planes[1].id, Eq(31u));
+    EXPECT_THAT(planes[1].type, Eq(mgg::PlaneInfo::Type::overlay));
+}
+
+TEST_F(PlaneEnumeration, reads_supported_modifiers_from_in_formats)
+{
+    uint32_t const blob_id{77};
+    add_plane(
+        31,
+        0b1,
+        {DRM_FORMAT_XRGB8888, DRM_FORMAT_NV12},
+        {{type_property, DRM_PLANE_TYPE_PRIMARY}, {in_formats_property, blob_id}});
+
+    struct
+    {
+        drm_format_modifier_blob header;
+        uint32_t formats[2];
+        drm_format_modifier modifiers[2];
+    } in_formats{};
+    in_formats.header.version = FORMAT_BLOB_CURRENT;
+    in_formats.header.count_formats = 2;
+    in_formats.header.formats_offset = offsetof(decltype(in_formats), formats);
+    in_formats.header.count_modifiers = 2;
+    in_formats.header.modifiers_offset = offsetof(decltype(in_formats), modifiers);
+    in_formats.formats[0] = DRM_FORMAT_XRGB8888;
+    in_formats.formats[1] = DRM_FORMAT_NV12;
+    in_formats.modifiers[0] = drm_format_modifier{0b11, 0, 0, DRM_FORMAT_MOD_LINEAR};
+    in_formats.modifiers[1] = drm_format_modifier{0b01, 0, 0, I915_FORMAT_MOD_X_TILED};
+
+    drmModePropertyBlobRes blob{blob_id, sizeof(in_formats), &in_formats};
+    ON_CALL(mock_drm, drmModeGetPropertyBlob(_, blob_id))
+        .WillByDefault(Return(&blob));
+
+    auto const planes = mgg::planes_for_crtc(drm_fd, 0);
+
+    ASSERT_THAT(planes, SizeIs(1));
+    EXPECT_THAT(
+        planes[0].formats.at(DRM_FORMAT_XRGB8888),
+        ElementsAre(DRM_FORMAT_MOD_LINEAR, I915_FORMAT_MOD_X_TILED));
+    EXPECT_THAT(planes[0].formats.at(DRM_FORMAT_NV12), ElementsAre(DRM_FORMAT_MOD_LINEAR));
+}
@@ -29,6 +29,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <fcntl.h>
+#include <drm_fourcc.h>
 
 namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
@@ -46,6 +47,8 @@ class NullPageFlipper : public mgg::PageFlipper
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
+    bool supports_atomic() const override { return false; }
+    bool schedule_atomic_flip(mgg::AtomicRequest const&) override { return false; }
 };
 
 class MockPageFlipper : public mgg::PageFlipper
@@ -53,6 +56,8 @@ class MockPageFlipper : public mgg::PageFlipper
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
+    MOCK_CONST_METHOD0(supports_atomic, bool());
+    MOCK_METHOD1(schedule_atomic_flip, bool(mgg::AtomicRequest const&));
 };
 
 class MockKMSFramebuffer : public mg::FBHandle
@@ -72,6 +77,16 @@ public:
     {
         return {};
     }    
+
+    auto drm_format() const -> mg::DRMFormat override
+    {
+        return mg::DRMFormat{DRM_FORMAT_XRGB8888};
+    }
+
+    auto modifier() const -> std::optional<uint64_t> override
+    {
+        return std::nullopt;
+    }
 private:
     uint32_t const fb_id;
 };
@@ -555,3 +570,39 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+TEST_F(RealKMSOutputTest, frame_interval_is_not_rounded_to_whole_hz)
+{
+    using namespace testing;
+
+    // 1080p at 59.94Hz: 2200×1125 pixels (including blanking) at 148.352MHz
+    drmModeModeInfo mode{};
+    mode.clock = 148352;
+    mode.hdisplay = 1920;
+    mode.htotal = 2200;
+    mode.vdisplay = 1080;
+    mode.vtotal = 1125;
+    mode.vrefresh = 60;
+    std::vector<drmModeModeInfo> modes{mode};
+
+    mock_drm.reset(drm_device);
+    mock_drm.add_crtc(drm_device, crtc_ids[0], mode);
+    mock_drm.add_encoder(drm_device, encoder_ids[0], crtc_ids[0], 0x1);
+    mock_drm.add_connector(
+        drm_device,
+        connector_ids[0],
+        DRM_MODE_CONNECTOR_VGA,
+        DRM_MODE_CONNECTED,
+        encoder_ids[0],
+        modes,
+        possible_encoder_ids1,
+        geom::Size());
+    mock_drm.prepare(drm_device);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper)};
+
+    EXPECT_THAT(output.frame_interval(), Eq(std::chrono::nanoseconds{16'683'293}));
+}
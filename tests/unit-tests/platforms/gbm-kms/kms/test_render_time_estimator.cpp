@@ -0,0 +1,101 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/kms/render_time_estimator.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mgg = mir::graphics::gbm;
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+TEST(RenderTimeEstimator, has_no_estimate_until_several_frames_are_recorded)
+{
+    mgg::RenderTimeEstimator estimator;
+
+    EXPECT_THAT(estimator.estimate(), Eq(std::nullopt));
+
+    for (int i = 0; i != 3; ++i)
+    {
+        estimator.record(4ms);
+    }
+
+    EXPECT_THAT(estimator.estimate(), Eq(std::nullopt));
+}
+
+TEST(RenderTimeEstimator, estimate_allows_for_recent_frames_with_a_margin)
+{
+    mgg::RenderTimeEstimator estimator;
+
+    for (int i = 0; i != 20; ++i)
+    {
+        estimator.record(4ms);
+    }
+
+    ASSERT_TRUE(estimator.estimate());
+    EXPECT_THAT(*estimator.estimate(), Gt(4ms));
+    EXPECT_THAT(*estimator.estimate(), Lt(8ms));
+}
+
+TEST(RenderTimeEstimator, a_single_slow_frame_does_not_inflate_the_estimate)
+{
+    mgg::RenderTimeEstimator estimator;
+
+    for (int i = 0; i != 63; ++i)
+    {
+        estimator.record(4ms);
+    }
+    estimator.record(40ms);
+
+    ASSERT_TRUE(estimator.estimate());
+    EXPECT_THAT(*estimator.estimate(), Lt(8ms));
+}
+
+TEST(RenderTimeEstimator, a_run_of_slow_frames_raises_the_estimate)
+{
+    mgg::RenderTimeEstimator estimator;
+
+    for (int i = 0; i != 56; ++i)
+    {
+        estimator.record(4ms);
+    }
+    for (int i = 0; i != 8; ++i)
+    {
+        estimator.record(12ms);
+    }
+
+    ASSERT_TRUE(estimator.estimate());
+    EXPECT_THAT(*estimator.estimate(), Ge(12ms));
+}
+
+TEST(RenderTimeEstimator, old_frames_are_forgotten)
+{
+    mgg::RenderTimeEstimator estimator;
+
+    for (int i = 0; i != 64; ++i)
+    {
+        estimator.record(30ms);
+    }
+    for (int i = 0; i != 64; ++i)
+    {
+        estimator.record(4ms);
+    }
+
+    ASSERT_TRUE(estimator.estimate());
+    EXPECT_THAT(*estimator.estimate(), Lt(8ms));
+}
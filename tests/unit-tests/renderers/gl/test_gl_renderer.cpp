@@ -230,6 +230,30 @@ TEST_F(GLRenderer, avoids_src_alpha_for_rgbx_blending)  // LP: #1423462
     renderer.render(renderable_list);
 }
 
+TEST_F(GLRenderer, uploads_vertices_of_all_renderables_at_once)
+{
+    renderable_list.push_back(renderable);
+    renderable_list.push_back(renderable);
+
+    EXPECT_CALL(mock_gl, glBufferData(GL_ARRAY_BUFFER, 3 * 4 * sizeof(mir::gl::Vertex), _, GL_STREAM_DRAW))
+        .Times(1);
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, does_not_repeat_unchanged_state_between_renderables)
+{
+    renderable_list.push_back(renderable);
+    renderable_list.push_back(renderable);
+
+    EXPECT_CALL(mock_gl, glUseProgram(_)).Times(1);
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND)).Times(1);
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+}
+
 TEST_F(GLRenderer, clears_to_opaque_black)
 {
     InSequence seq;
@@ -245,15 +269,36 @@ TEST_F(GLRenderer, clears_to_opaque_black)
 TEST_F(GLRenderer, makes_display_buffer_current_when_created)
 {
     auto mock_output_surface = make_output_surface();
+    auto const output_surface = mock_output_surface.get();
 
     EXPECT_CALL(*mock_output_surface, make_current());
 
     mrg::Renderer renderer(gl_platform, std::move(mock_output_surface));
+    testing::Mock::VerifyAndClearExpectations(output_surface);
+}
+
+TEST_F(GLRenderer, makes_display_buffer_current_before_deleting_gl_objects)
+{
+    GLuint const stub_vertex_buffer{7};
+    auto mock_output_surface = make_output_surface();
+    auto const output_surface = mock_output_surface.get();
+    ON_CALL(mock_gl, glGenBuffers(1, _))
+        .WillByDefault(SetArgPointee<1>(stub_vertex_buffer));
+
+    auto renderer = std::make_unique<mrg::Renderer>(gl_platform, std::move(mock_output_surface));
+    renderer->render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(output_surface);
+
+    InSequence seq;
+    EXPECT_CALL(*output_surface, make_current());
+    EXPECT_CALL(mock_gl, glDeleteBuffers(1, Pointee(stub_vertex_buffer)));
+    renderer.reset();
 }
 
 TEST_F(GLRenderer, makes_display_buffer_current_before_rendering)
 {
     auto mock_output_surface = make_output_surface();
+    auto const output_surface = mock_output_surface.get();
 
     InSequence seq;
     EXPECT_CALL(*mock_output_surface, make_current()).Times(AnyNumber());
@@ -262,6 +307,9 @@ TEST_F(GLRenderer, makes_display_buffer_current_before_rendering)
     mrg::Renderer renderer(gl_platform, std::move(mock_output_surface));
 
     renderer.render(renderable_list);
+
+    // ...and again to clean up
+    EXPECT_CALL(*output_surface, make_current()).Times(AnyNumber());
 }
 
 TEST_F(GLRenderer, swaps_buffers_after_rendering)
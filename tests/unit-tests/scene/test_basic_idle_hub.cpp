@@ -103,6 +103,45 @@ TEST_F(BasicIdleHub, observer_marked_active_after_poke)
     executor.execute();
 }
 
+TEST_F(BasicIdleHub, observer_marked_idle_at_timeout_after_poke_while_active)
+{
+    auto const observer = std::make_shared<StrictMock<MockObserver>>();
+    EXPECT_CALL(*observer, active()).Times(AnyNumber());
+    hub->register_interest(observer, executor, 5s);
+    advance_by(3s);
+    hub->poke();
+    advance_by(4s);
+    executor.execute();
+    Mock::VerifyAndClearExpectations(observer.get());
+    EXPECT_CALL(*observer, idle());
+    advance_by(2s);
+    executor.execute();
+}
+
+TEST_F(BasicIdleHub, observers_with_different_timeouts_marked_idle_at_correct_time_after_pokes_while_active)
+{
+    auto const short_observer = std::make_shared<StrictMock<MockObserver>>();
+    auto const long_observer = std::make_shared<StrictMock<MockObserver>>();
+    EXPECT_CALL(*short_observer, active()).Times(AnyNumber());
+    EXPECT_CALL(*long_observer, active()).Times(AnyNumber());
+    hub->register_interest(short_observer, executor, 5s);
+    hub->register_interest(long_observer, executor, 10s);
+    for (auto i = 0; i != 4; ++i)
+    {
+        advance_by(4s);
+        hub->poke();
+    }
+    executor.execute();
+    Mock::VerifyAndClearExpectations(short_observer.get());
+    EXPECT_CALL(*short_observer, idle());
+    advance_by(6s);
+    executor.execute();
+    Mock::VerifyAndClearExpectations(long_observer.get());
+    EXPECT_CALL(*long_observer, idle());
+    advance_by(5s);
+    executor.execute();
+}
+
 TEST_F(BasicIdleHub, observer_can_remove_itself_in_idle_notification)
 {
     auto const observer = std::make_shared<StrictMock<MockObserver>>();
@@ -78,6 +78,7 @@ public:
     MOCK_METHOD(void, application_id_set_to, (ms::Surface const*, std::string const&), (override));
     MOCK_METHOD(void, entered_output, (ms::Surface const*, mg::DisplayConfigurationOutputId const&), (override));
     MOCK_METHOD(void, left_output, (ms::Surface const*, mg::DisplayConfigurationOutputId const&), (override));
+    MOCK_METHOD(void, input_region_set_to, (ms::Surface const*, std::vector<geom::Rectangle> const&), (override));
 };
 
 struct BasicSurfaceTest : public testing::Test
@@ -608,6 +609,30 @@ TEST_F(BasicSurfaceTest, set_input_region)
     }
 }
 
+TEST_F(BasicSurfaceTest, input_region_can_reach_outside_the_window_geometry)
+{
+    // Like a client-side decorated window, whose geometry excludes the margin it takes resize input in
+    surface.set_window_margins(geom::DeltaY{4}, geom::DeltaX{4}, geom::DeltaY{4}, geom::DeltaX{4});
+    surface.set_input_region({{{-2, -2}, {8, 8}}});
+
+    auto const content_top_left = rect.top_left + geom::Displacement{4, 4};
+    EXPECT_TRUE(surface.input_area_contains(content_top_left + geom::Displacement{-1, -1}));
+    EXPECT_FALSE(surface.input_area_contains(content_top_left + geom::Displacement{-3, -3}));
+}
+
+TEST_F(BasicSurfaceTest, notifies_observers_of_input_region)
+{
+    using namespace testing;
+
+    std::vector<geom::Rectangle> const rectangles{{{-2, -2}, {8, 8}}};
+
+    EXPECT_CALL(*mock_surface_observer, input_region_set_to(&surface, rectangles));
+
+    surface.register_interest(mock_surface_observer, executor);
+    surface.set_input_region(rectangles);
+    executor.execute();
+}
+
 TEST_F(BasicSurfaceTest, updates_default_input_region_when_surface_is_resized_to_larger_size)
 {
     geom::Rectangle const new_rect{rect.top_left,{20,20}};
@@ -1288,6 +1313,23 @@ TEST_F(BasicSurfaceTest, moving_surface_repositions_all_associated_streams)
     EXPECT_THAT(renderables[1], IsRenderableOfPosition(pt + d));
 }
 
+TEST_F(BasicSurfaceTest, renderable_opaque_region_is_stream_opaque_region_on_screen)
+{
+    using namespace testing;
+    geom::Displacement const d{3, 5};
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream->submission, size()).WillByDefault(Return(geom::Size{10, 10}));
+
+    surface.set_streams({ms::StreamInfo{buffer_stream, d, {{{1, 2}, {4, 4}}, {{8, 8}, {4, 4}}}}});
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    auto const stream_top_left = rect.top_left + d;
+    EXPECT_THAT(renderables[0]->opaque_region(), Eq(geom::Rectangles{
+        {stream_top_left + geom::Displacement{1, 2}, {4, 4}},
+        {stream_top_left + geom::Displacement{8, 8}, {2, 2}}}));
+}
+
 TEST_F(BasicSurfaceTest, can_remove_all_streams)
 {
     using namespace testing;
@@ -1471,6 +1513,20 @@ TEST_F(BasicSurfaceTest, buffer_streams_produce_correctly_sized_renderables)
     EXPECT_THAT(renderables[1], IsRenderableOfSize(size1));
 }
 
+TEST_F(BasicSurfaceTest, renderables_reuse_storage_of_released_ones)
+{
+    using namespace testing;
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    auto const first_frame = renderables[0].get();
+    renderables.clear();
+
+    renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0].get(), Eq(first_frame));
+}
+
 TEST_F(BasicSurfaceTest, renderables_of_transparent_buffer_streams_are_shaped)
 {
     using namespace testing;
@@ -37,6 +37,7 @@
 #include <stdexcept>
 #include <atomic>
 #include <future>
+#include <set>
 
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
@@ -79,6 +80,7 @@ struct MockSceneObserver : public ms::Observer
     MOCK_METHOD1(surface_removed, void(std::shared_ptr<ms::Surface> const&));
     MOCK_METHOD1(surfaces_reordered, void(ms::SurfaceSet const&));
     MOCK_METHOD0(scene_changed, void());
+    MOCK_METHOD1(scene_damaged, void(geom::Rectangles const&));
 
     MOCK_METHOD1(surface_exists, void(std::shared_ptr<ms::Surface> const&));
     MOCK_METHOD0(end_observation, void());
@@ -348,6 +350,43 @@ TEST_F(SurfaceStack, generate_elementelements)
         stack.remove_surface(surface);
 }
 
+TEST_F(SurfaceStack, registered_compositor_reuses_storage_of_released_elements)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    for(auto i = 0; i < 3; i++)
+    {
+        stack.add_surface(
+            std::make_shared<ms::BasicSurface>(
+                nullptr /* session */,
+                mw::Weak<mf::WlSurface>{},
+                std::string("stub"),
+                geom::Rectangle{{i, i}, {10, 10}},
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo> { { std::make_shared<mtd::StubBufferStream>(), {}} },
+                std::shared_ptr<mg::CursorImage>(),
+                report,
+                display_config_registrar),
+            mi::InputReceptionMode::normal);
+    }
+
+    auto const addresses_of = [](mc::SceneElementSequence const& elements)
+        {
+            std::set<mc::SceneElement const*> addresses;
+            for (auto const& element : elements)
+                addresses.insert(element.get());
+            return addresses;
+        };
+
+    auto elements = stack.scene_elements_for(compositor_id);
+    ASSERT_THAT(elements.size(), Eq(3u));
+    auto const first_frame = addresses_of(elements);
+    elements.clear();
+
+    EXPECT_THAT(addresses_of(stack.scene_elements_for(compositor_id)), Eq(first_frame));
+}
+
 TEST_F(SurfaceStack, scene_observer_notified_of_add_and_remove)
 {
     using namespace ::testing;
@@ -851,6 +890,22 @@ TEST_F(SurfaceStack, scene_observers_notified_of_generic_scene_change)
     stack.emit_scene_changed();
 }
 
+TEST_F(SurfaceStack, scene_observers_notified_of_scene_damage)
+{
+    MockSceneObserver o1, o2;
+    geom::Rectangles const damage{{{1, 2}, {3, 4}}, {{5, 6}, {7, 8}}};
+
+    EXPECT_CALL(o1, scene_damaged(damage)).Times(1);
+    EXPECT_CALL(o2, scene_damaged(damage)).Times(1);
+    EXPECT_CALL(o1, scene_changed()).Times(0);
+    EXPECT_CALL(o2, scene_changed()).Times(0);
+
+    stack.add_observer(mt::fake_shared(o1));
+    stack.add_observer(mt::fake_shared(o2));
+
+    stack.emit_scene_damaged(damage);
+}
+
 TEST_F(SurfaceStack, input_surface_at_finds_top_surface)
 {
     using namespace ::testing;
@@ -878,6 +933,7 @@ TEST_F(SurfaceStack, surface_at_returns_top_surface_under_cursor)
     stub_surface1->resize({900, 900});
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -899,6 +955,7 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_surface_under_cursor)
     stub_surface1->resize({900, 900});
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -922,6 +979,7 @@ TEST_F(SurfaceStack, surface_at_returns_top_visible_surface_under_cursor)
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
     invisible_stub_surface->resize({999, 999});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -945,6 +1003,7 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_visible_surface_under_cursor)
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
     invisible_stub_surface->resize({999, 999});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -952,6 +1011,57 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_visible_surface_under_cursor)
     EXPECT_THAT(stack.surface_at(cursor_over_none).get(), IsNull());
 }
 
+TEST_F(SurfaceStack, surface_at_follows_surfaces_as_they_move_and_resize)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    stub_surface1->resize({4000, 4000});
+    stub_surface2->resize({100, 100});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({1050, 1050}), Eq(stub_surface1));
+
+    stub_surface2->move_to({1000, 1000});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({1050, 1050}), Eq(stub_surface2));
+
+    stub_surface2->resize({1000, 1000});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({1950, 1950}), Eq(stub_surface2));
+
+    stack.raise(stub_surface1);
+
+    EXPECT_THAT(stack.surface_at({1950, 1950}), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_at_finds_input_regions_outside_the_window_geometry)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+
+    stub_surface1->move_to({1000, 1000});
+    stub_surface1->resize({100, 100});
+    // The window geometry (the content area) is {1020, 1020} to {1080, 1080}. The input region takes in a resize
+    // margin around it, and a subsurface that sticks out well past it.
+    stub_surface1->set_window_margins(geom::DeltaY{20}, geom::DeltaX{20}, geom::DeltaY{20}, geom::DeltaX{20});
+    stub_surface1->set_input_region({{{-10, -10}, {80, 80}}, {{40, 40}, {500, 500}}});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({1015, 1015}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({1500, 1500}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({1005, 1005}).get(), IsNull());
+
+    // And after the index is rebuilt
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    EXPECT_THAT(stack.surface_at({1015, 1015}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({1500, 1500}), Eq(stub_surface1));
+}
+
 TEST_F(SurfaceStack, raise_surfaces_to_top)
 {
     stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
@@ -1232,6 +1342,7 @@ TEST_F(SurfaceStack, when_screen_is_locked_surface_ignores_surface)
     geom::Point const cursor_position{100, 100};
     stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
     stub_surface1->resize({200, 200});
+    executor.execute();
     EXPECT_THAT(stack.surface_at(cursor_position), Eq(stub_surface1));
 
     stack.lock();
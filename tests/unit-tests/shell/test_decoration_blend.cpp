@@ -0,0 +1,147 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/shell/decoration/blend.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace msd = mir::shell::decoration;
+
+using namespace testing;
+
+namespace
+{
+using BlendSpan = void(uint32_t* row, unsigned char const* coverage, int count, uint32_t color);
+
+struct Implementation
+{
+    char const* name;
+    BlendSpan* blend;
+};
+
+auto operator<<(std::ostream& out, Implementation const& implementation) -> std::ostream&
+{
+    return out << implementation.name;
+}
+
+/// The straightforward blend, with real divisions, that every implementation must match exactly
+void reference_blend(uint32_t* row, unsigned char const* coverage, int count, uint32_t color)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        unsigned const weight = coverage[i] * (color >> 24) / 255;
+        uint32_t result = row[i] & 0xFF000000;
+        for (int shift = 0; shift != 24; shift += 8)
+        {
+            unsigned const pixel_channel = (row[i] >> shift) & 0xFF;
+            unsigned const color_channel = (color >> shift) & 0xFF;
+            result |= (pixel_channel * (255 - weight) / 255 + color_channel * weight / 255) << shift;
+        }
+        row[i] = result;
+    }
+}
+
+struct DecorationBlend : TestWithParam<Implementation>
+{
+    std::mt19937 random{1234};
+
+    auto random_byte() -> unsigned char
+    {
+        return std::uniform_int_distribution<unsigned>{0, 255}(random);
+    }
+
+    auto random_coverage() -> unsigned char
+    {
+        // Glyphs are mostly empty or solid, so make sure those (and runs of them) are well represented
+        switch (std::uniform_int_distribution<int>{0, 3}(random))
+        {
+        case 0: return 0;
+        case 1: return 255;
+        default: return random_byte();
+        }
+    }
+
+    auto random_pixel() -> uint32_t
+    {
+        return std::uniform_int_distribution<uint32_t>{}(random);
+    }
+};
+}
+
+TEST_P(DecorationBlend, matches_the_reference_blend_on_random_spans)
+{
+    auto const implementation = GetParam();
+
+    for (int span = 0; span != 2000; ++span)
+    {
+        int const count = std::uniform_int_distribution<int>{0, 40}(random);
+        uint32_t const color = random_pixel();
+
+        std::vector<unsigned char> coverage(count);
+        std::vector<uint32_t> row(count);
+        for (int i = 0; i != count; ++i)
+        {
+            coverage[i] = random_coverage();
+            row[i] = random_pixel();
+        }
+
+        auto expected = row;
+        reference_blend(expected.data(), coverage.data(), count, color);
+        implementation.blend(row.data(), coverage.data(), count, color);
+
+        ASSERT_THAT(row, ElementsAreArray(expected)) << "span " << span << " of " << count << " pixels";
+    }
+}
+
+TEST_P(DecorationBlend, matches_the_reference_blend_at_the_extremes)
+{
+    auto const implementation = GetParam();
+    unsigned char const coverages[]{0, 1, 127, 128, 254, 255, 255, 0, 255};
+    int const count = std::size(coverages);
+
+    for (uint32_t const color : {0x00000000u, 0xFFFFFFFFu, 0x80FF0000u, 0xFF00FF00u, 0x010000FFu})
+    {
+        for (uint32_t const pixel : {0x00000000u, 0xFFFFFFFFu, 0x12345678u})
+        {
+            std::vector<uint32_t> row(count, pixel);
+            auto expected = row;
+            reference_blend(expected.data(), coverages, count, color);
+            implementation.blend(row.data(), coverages, count, color);
+
+            EXPECT_THAT(row, ElementsAreArray(expected)) << std::hex << "color " << color << ", pixel " << pixel;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DecorationBlend,
+    DecorationBlend,
+    Values(
+        Implementation{"default", &msd::blend_span},
+#if defined(__SSE2__)
+        Implementation{"sse2", &msd::blend_span_sse2},
+#endif
+#if defined(__ARM_NEON) && defined(MIR_DECORATION_NEON_BLEND)
+        Implementation{"neon", &msd::blend_span_neon},
+#endif
+        Implementation{"scalar", &msd::blend_span_scalar}),
+    [](auto const& info) { return std::string{info.param.name}; });
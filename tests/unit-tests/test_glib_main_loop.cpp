@@ -711,6 +711,39 @@ TEST_F(GLibMainLoopTest, dispatches_actions_resumed_from_within_another_action)
     EXPECT_THAT(actions, ElementsAre(1, 0));
 }
 
+TEST_F(GLibMainLoopTest, resumed_actions_are_dispatched_in_the_order_they_were_enqueued)
+{
+    using namespace testing;
+
+    std::vector<int> actions;
+    void const* const owner1_ptr{&actions};
+    int const owner2{0};
+
+    ml.enqueue(owner1_ptr, [&] { actions.push_back(0); });
+
+    ml.enqueue(
+        &owner2,
+        [&]
+        {
+            actions.push_back(1);
+            ml.resume_processing_for(owner1_ptr);
+        });
+
+    ml.enqueue(
+        owner1_ptr,
+        [&]
+        {
+            actions.push_back(2);
+            ml.stop();
+        });
+
+    ml.pause_processing_for(owner1_ptr);
+
+    ml.run();
+
+    EXPECT_THAT(actions, ElementsAre(1, 0, 2));
+}
+
 TEST_F(GLibMainLoopTest, handles_enqueue_from_within_action)
 {
     using namespace testing;
@@ -1168,6 +1201,42 @@ TEST_F(GLibMainLoopAlarmTest, alarm_fires_at_correct_time_point)
     EXPECT_EQ(mir::time::Alarm::triggered, alarm->state());
 }
 
+TEST_F(GLibMainLoopAlarmTest, alarm_rescheduled_earlier_fires_at_the_earlier_time)
+{
+    auto alarm = ml.create_alarm([]{});
+    alarm->reschedule_in(std::chrono::milliseconds{1000});
+
+    UnblockMainLoop unblocker(ml);
+
+    EXPECT_TRUE(alarm->reschedule_in(std::chrono::milliseconds{100}));
+
+    clock->advance_by(std::chrono::milliseconds{99}, ml);
+    EXPECT_EQ(mir::time::Alarm::pending, alarm->state());
+
+    clock->advance_by(std::chrono::milliseconds{1}, ml);
+    EXPECT_EQ(mir::time::Alarm::triggered, alarm->state());
+}
+
+TEST_F(GLibMainLoopAlarmTest, alarms_fire_in_the_order_they_are_due)
+{
+    std::vector<int> fired;
+    std::array<std::unique_ptr<mir::time::Alarm>, 3> alarms;
+
+    for (auto i = 0u; i != alarms.size(); ++i)
+    {
+        alarms[i] = ml.create_alarm([&fired, i] { fired.push_back(i); });
+    }
+
+    alarms[0]->reschedule_in(std::chrono::milliseconds{30});
+    alarms[1]->reschedule_in(std::chrono::milliseconds{10});
+    alarms[2]->reschedule_in(std::chrono::milliseconds{20});
+
+    UnblockMainLoop unblocker(ml);
+    clock->advance_by(std::chrono::milliseconds{30}, ml);
+
+    EXPECT_THAT(fired, testing::ElementsAre(1, 2, 0));
+}
+
 TEST_F(GLibMainLoopAlarmTest, propagates_exception_from_alarm)
 {
     // Execute in forked process to work around
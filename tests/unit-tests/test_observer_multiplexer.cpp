@@ -15,6 +15,7 @@
  */
 
 #include "mir/observer_multiplexer.h"
+#include "mir/snapshot_observer_multiplexer.h"
 
 #include "mir/test/barrier.h"
 #include "mir/test/auto_unblock_thread.h"
@@ -157,36 +158,47 @@ private:
     std::queue<std::function<void()>> work_queue;
 };
 
-class TestObserverMultiplexer : public mir::ObserverMultiplexer<TestObserver>
+template<template<class> class Multiplexer>
+class TestObserverMultiplexer : public Multiplexer<TestObserver>
 {
 public:
     TestObserverMultiplexer(mir::Executor& executor)
-        : ObserverMultiplexer(executor)
+        : Multiplexer<TestObserver>(executor)
     {
     }
 
     void observation_made(std::string const& arg) override
     {
-        for_each_observer(&TestObserver::observation_made, arg);
+        this->for_each_observer(&TestObserver::observation_made, arg);
     }
 
     void single_observer_observation(TestObserver const& observer, std::string const& arg)
     {
-        for_single_observer(observer, &TestObserver::observation_made, arg);
+        this->for_single_observer(observer, &TestObserver::observation_made, arg);
     }
 
     void multi_argument_observation(std::string const& arg, int another_one, float third) override
     {
-        for_each_observer(&TestObserver::multi_argument_observation, arg, another_one, third);
+        this->for_each_observer(&TestObserver::multi_argument_observation, arg, another_one, third);
     }
 };
+
+template<typename Multiplexer>
+struct ObserverMultiplexer : testing::Test
+{
+};
+
+using Multiplexers = testing::Types<
+    TestObserverMultiplexer<mir::ObserverMultiplexer>,
+    TestObserverMultiplexer<mir::SnapshotObserverMultiplexer>>;
+TYPED_TEST_SUITE(ObserverMultiplexer, Multiplexers);
 }
 
-TEST(ObserverMultiplexer, each_added_observer_recieves_observations)
+TYPED_TEST(ObserverMultiplexer, each_added_observer_recieves_observations)
 {
     using namespace testing;
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
     std::string const value = "Hello, my name is Inigo Montoya.";
 
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
@@ -205,10 +217,10 @@ TEST(ObserverMultiplexer, each_added_observer_recieves_observations)
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, observer_recieves_multiple_observations)
+TYPED_TEST(ObserverMultiplexer, observer_recieves_multiple_observations)
 {
     using namespace testing;
-    TestObserverMultiplexer multiplexer{mir::immediate_executor};
+    TypeParam multiplexer{mir::immediate_executor};
     std::string const value0 = "Hello, my name is Inigo Montoya.";
     std::string const value1 = "You killed my father. Prepare to die.";
 
@@ -222,14 +234,14 @@ TEST(ObserverMultiplexer, observer_recieves_multiple_observations)
     multiplexer.observation_made(value1);
 }
 
-TEST(ObserverMultiplexer, can_remove_observer)
+TYPED_TEST(ObserverMultiplexer, can_remove_observer)
 {
     using namespace testing;
     std::string const value = "Goldfinger";
 
     auto observer = std::make_shared<NiceMock<MockObserver>>();
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
     multiplexer.register_interest(observer);
 
     EXPECT_CALL(*observer, observation_made(StrEq(value))).Times(1);
@@ -241,14 +253,14 @@ TEST(ObserverMultiplexer, can_remove_observer)
     multiplexer.observation_made(value);
 }
 
-TEST(ObserverMultiplexer, can_remove_observer_on_different_thread_than_it_was_added_on)
+TYPED_TEST(ObserverMultiplexer, can_remove_observer_on_different_thread_than_it_was_added_on)
 {
     using namespace testing;
     std::string const value = "Goldfinger";
 
     auto observer = std::make_shared<NiceMock<MockObserver>>();
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
     multiplexer.register_interest(observer);
 
     EXPECT_CALL(*observer, observation_made(StrEq(value))).Times(1);
@@ -265,13 +277,13 @@ TEST(ObserverMultiplexer, can_remove_observer_on_different_thread_than_it_was_ad
     multiplexer.observation_made(value);
 }
 
-TEST(ObserverMultiplexer, removed_observers_do_not_recieve_observations)
+TYPED_TEST(ObserverMultiplexer, removed_observers_do_not_recieve_observations)
 {
     using namespace testing;
     std::string const value = "The girl of my dreams is giving me nightmares";
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
@@ -291,7 +303,7 @@ TEST(ObserverMultiplexer, removed_observers_do_not_recieve_observations)
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, can_remove_observer_from_callback_with_threaded_executor)
+TYPED_TEST(ObserverMultiplexer, can_remove_observer_from_callback_with_threaded_executor)
 {
     using namespace testing;
     std::string const value = "Goldfinger";
@@ -300,7 +312,7 @@ TEST(ObserverMultiplexer, can_remove_observer_from_callback_with_threaded_execut
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     EXPECT_CALL(*observer_one, observation_made(StrEq(value)))
         .WillOnce(Invoke(
@@ -320,7 +332,7 @@ TEST(ObserverMultiplexer, can_remove_observer_from_callback_with_threaded_execut
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, can_remove_observer_from_callback_with_immediate_executor)
+TYPED_TEST(ObserverMultiplexer, can_remove_observer_from_callback_with_immediate_executor)
 {
     using namespace testing;
     std::string const value = "Goldfinger";
@@ -328,7 +340,7 @@ TEST(ObserverMultiplexer, can_remove_observer_from_callback_with_immediate_execu
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
 
-    TestObserverMultiplexer multiplexer{mir::immediate_executor};
+    TypeParam multiplexer{mir::immediate_executor};
 
     EXPECT_CALL(*observer_one, observation_made(StrEq(value)))
         .WillOnce(Invoke(
@@ -346,7 +358,7 @@ TEST(ObserverMultiplexer, can_remove_observer_from_callback_with_immediate_execu
     multiplexer.observation_made(value);
 }
 
-TEST(ObserverMultiplexer, can_remove_observer_from_recursive_callback_with_immediate_executor)
+TYPED_TEST(ObserverMultiplexer, can_remove_observer_from_recursive_callback_with_immediate_executor)
 {
     using namespace testing;
     std::string const value = "Goldfinger";
@@ -354,7 +366,7 @@ TEST(ObserverMultiplexer, can_remove_observer_from_recursive_callback_with_immed
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
 
-    TestObserverMultiplexer multiplexer{mir::immediate_executor};
+    TypeParam multiplexer{mir::immediate_executor};
 
     EXPECT_CALL(*observer_one, observation_made(StrEq(value)))
         .WillOnce(Invoke(
@@ -377,7 +389,7 @@ TEST(ObserverMultiplexer, can_remove_observer_from_recursive_callback_with_immed
     multiplexer.observation_made(value);
 }
 
-TEST(ObserverMultiplexer, observer_not_called_after_unregistered_from_other_observer)
+TYPED_TEST(ObserverMultiplexer, observer_not_called_after_unregistered_from_other_observer)
 {
     using namespace testing;
     std::string const value = "Goldfinger";
@@ -385,7 +397,7 @@ TEST(ObserverMultiplexer, observer_not_called_after_unregistered_from_other_obse
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
 
-    TestObserverMultiplexer multiplexer{mir::immediate_executor};
+    TypeParam multiplexer{mir::immediate_executor};
 
     EXPECT_CALL(*observer_one, observation_made(StrEq(value)))
         .WillOnce(Invoke(
@@ -402,7 +414,7 @@ TEST(ObserverMultiplexer, observer_not_called_after_unregistered_from_other_obse
     multiplexer.observation_made(value);
 }
 
-TEST(ObserverMultiplexer, multiple_threads_can_simultaneously_make_observations)
+TYPED_TEST(ObserverMultiplexer, multiple_threads_can_simultaneously_make_observations)
 {
     using namespace testing;
 
@@ -429,7 +441,7 @@ TEST(ObserverMultiplexer, multiple_threads_can_simultaneously_make_observations)
                 }));
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
     multiplexer.register_interest(observer);
 
     mt::Barrier threads_ready(values.size());
@@ -455,7 +467,7 @@ TEST(ObserverMultiplexer, multiple_threads_can_simultaneously_make_observations)
         ContainerEq(std::vector<bool>(values_seen.size(), true)));
 }
 
-TEST(ObserverMultiplexer, multiple_threads_registering_unregistering_and_observing)
+TYPED_TEST(ObserverMultiplexer, multiple_threads_registering_unregistering_and_observing)
 {
     using namespace testing;
 
@@ -463,7 +475,7 @@ TEST(ObserverMultiplexer, multiple_threads_registering_unregistering_and_observi
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     ON_CALL(*observer_one, observation_made(_))
         .WillByDefault(
@@ -516,12 +528,12 @@ TEST(ObserverMultiplexer, multiple_threads_registering_unregistering_and_observi
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, multiple_threads_unregistering_same_observer_is_safe)
+TYPED_TEST(ObserverMultiplexer, multiple_threads_unregistering_same_observer_is_safe)
 {
     using namespace testing;
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
@@ -567,7 +579,7 @@ TEST(ObserverMultiplexer, multiple_threads_unregistering_same_observer_is_safe)
     EXPECT_THAT(call_count, Eq(precount + 1));
 }
 
-TEST(ObserverMultiplexer, registering_is_threadsafe)
+TYPED_TEST(ObserverMultiplexer, registering_is_threadsafe)
 {
     using namespace testing;
 
@@ -584,7 +596,7 @@ TEST(ObserverMultiplexer, registering_is_threadsafe)
     mt::Barrier threads_done(threads.size() + 1);
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     for (auto i = 0u; i < threads.size(); ++i)
     {
@@ -606,7 +618,7 @@ TEST(ObserverMultiplexer, registering_is_threadsafe)
         ContainerEq(std::vector<bool>(observer_notified.size(), true)));
 }
 
-TEST(ObserverMultiplexer, unregistering_is_threadsafe)
+TYPED_TEST(ObserverMultiplexer, unregistering_is_threadsafe)
 {
     using namespace testing;
 
@@ -628,7 +640,7 @@ TEST(ObserverMultiplexer, unregistering_is_threadsafe)
     mt::Barrier threads_done(threads.size() + 1);
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     for (auto observer : observers)
     {
@@ -655,7 +667,7 @@ TEST(ObserverMultiplexer, unregistering_is_threadsafe)
         ContainerEq(std::vector<bool>(observer_notified.size(), false)));
 }
 
-TEST(ObserverMultiplexer, can_trigger_observers_from_observers)
+TYPED_TEST(ObserverMultiplexer, can_trigger_observers_from_observers)
 {
     using namespace testing;
     constexpr char const* first_observation = "Elementary, my dear Watson";
@@ -664,7 +676,7 @@ TEST(ObserverMultiplexer, can_trigger_observers_from_observers)
     auto observer = std::make_shared<NiceMock<MockObserver>>();
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     EXPECT_CALL(*observer, observation_made(StrEq(first_observation)))
         .WillOnce(InvokeWithoutArgs([&multiplexer]() { multiplexer.observation_made(second_observation); }));
@@ -677,7 +689,7 @@ TEST(ObserverMultiplexer, can_trigger_observers_from_observers)
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, can_trigger_observer_during_observation_from_other_thread)
+TYPED_TEST(ObserverMultiplexer, can_trigger_observer_during_observation_from_other_thread)
 {
     using namespace testing;
     constexpr char const* first_observation = "Elementary, my dear Watson";
@@ -686,7 +698,7 @@ TEST(ObserverMultiplexer, can_trigger_observer_during_observation_from_other_thr
     auto observer = std::make_shared<NiceMock<MockObserver>>();
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     EXPECT_CALL(*observer, observation_made(StrEq(first_observation)))
         .WillOnce(InvokeWithoutArgs([&]()
@@ -705,7 +717,7 @@ TEST(ObserverMultiplexer, can_trigger_observer_during_observation_from_other_thr
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, can_trigger_observer_during_observation_from_other_thread_with_immediate_executor)
+TYPED_TEST(ObserverMultiplexer, can_trigger_observer_during_observation_from_other_thread_with_immediate_executor)
 {
     using namespace testing;
     constexpr char const* first_observation = "Elementary, my dear Watson";
@@ -713,7 +725,7 @@ TEST(ObserverMultiplexer, can_trigger_observer_during_observation_from_other_thr
 
     auto observer = std::make_shared<NiceMock<MockObserver>>();
 
-    TestObserverMultiplexer multiplexer{mir::immediate_executor};
+    TypeParam multiplexer{mir::immediate_executor};
 
     EXPECT_CALL(*observer, observation_made(StrEq(first_observation)))
         .WillOnce(InvokeWithoutArgs([&]()
@@ -730,7 +742,7 @@ TEST(ObserverMultiplexer, can_trigger_observer_during_observation_from_other_thr
     multiplexer.observation_made(first_observation);
 }
 
-TEST(ObserverMultiplexer, can_trigger_single_observer_during_single_observer_observation_from_other_thread)
+TYPED_TEST(ObserverMultiplexer, can_trigger_single_observer_during_single_observer_observation_from_other_thread)
 {
     using namespace testing;
     constexpr char const* first_observation = "Elementary, my dear Watson";
@@ -739,7 +751,7 @@ TEST(ObserverMultiplexer, can_trigger_single_observer_during_single_observer_obs
     auto observer = std::make_shared<NiceMock<MockObserver>>();
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     EXPECT_CALL(*observer, observation_made(StrEq(first_observation)))
         .WillOnce(InvokeWithoutArgs([&]()
@@ -758,7 +770,7 @@ TEST(ObserverMultiplexer, can_trigger_single_observer_during_single_observer_obs
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, can_remove_observer_during_other_observers_observation_from_other_thread)
+TYPED_TEST(ObserverMultiplexer, can_remove_observer_during_other_observers_observation_from_other_thread)
 {
     using namespace testing;
     constexpr char const* first_observation = "Elementary, my dear Watson";
@@ -768,7 +780,7 @@ TEST(ObserverMultiplexer, can_remove_observer_during_other_observers_observation
     auto observer_b = std::make_shared<NiceMock<MockObserver>>();
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     EXPECT_CALL(*observer_a, observation_made(StrEq(first_observation)))
         .WillOnce(InvokeWithoutArgs([&]()
@@ -793,14 +805,14 @@ TEST(ObserverMultiplexer, can_remove_observer_during_other_observers_observation
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, addition_takes_effect_immediately_even_in_callback)
+TYPED_TEST(ObserverMultiplexer, addition_takes_effect_immediately_even_in_callback)
 {
     using namespace testing;
     constexpr char const* first_observation = "Rhythm & Blues Alibi";
     constexpr char const* second_observation = "Blue Moon Rising";
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
@@ -824,13 +836,13 @@ TEST(ObserverMultiplexer, addition_takes_effect_immediately_even_in_callback)
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, observations_can_be_delegated_to_specified_executor)
+TYPED_TEST(ObserverMultiplexer, observations_can_be_delegated_to_specified_executor)
 {
     using namespace testing;
 
     CountingExecutor counting_executor;
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
@@ -851,7 +863,7 @@ TEST(ObserverMultiplexer, observations_can_be_delegated_to_specified_executor)
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, multi_argument_observations_work)
+TYPED_TEST(ObserverMultiplexer, multi_argument_observations_work)
 {
     using namespace testing;
 
@@ -860,7 +872,7 @@ TEST(ObserverMultiplexer, multi_argument_observations_work)
     constexpr float c{3.1415f};
 
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto observer = std::make_shared<NiceMock<MockObserver>>();
 
@@ -873,12 +885,12 @@ TEST(ObserverMultiplexer, multi_argument_observations_work)
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, destroyed_observer_is_not_called)
+TYPED_TEST(ObserverMultiplexer, destroyed_observer_is_not_called)
 {
     using namespace testing;
 
     mtd::ExplicitExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto observer_owner = std::make_unique<NiceMock<MockObserver>>();
     // We need a shared_ptr that we can release, but we also need the observer to remain live.
@@ -898,12 +910,12 @@ TEST(ObserverMultiplexer, destroyed_observer_is_not_called)
     executor.execute();
 }
 
-TEST(ObserverMultiplexer, unregister_interest_prevents_dispatch_of_already_queued_observations)
+TYPED_TEST(ObserverMultiplexer, unregister_interest_prevents_dispatch_of_already_queued_observations)
 {
     using namespace testing;
 
     mtd::ExplicitExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto const observer = std::make_shared<NiceMock<MockObserver>>();
     multiplexer.register_interest(observer);
@@ -935,11 +947,11 @@ TEST(ObserverMultiplexer, unregister_interest_prevents_dispatch_of_already_queue
     EXPECT_THAT(call_count, Eq(1));
 }
 
-TEST(ObserverMultiplexer, reports_if_empty)
+TYPED_TEST(ObserverMultiplexer, reports_if_empty)
 {
     using namespace testing;
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
@@ -957,11 +969,11 @@ TEST(ObserverMultiplexer, reports_if_empty)
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, can_send_observation_to_single_observer)
+TYPED_TEST(ObserverMultiplexer, can_send_observation_to_single_observer)
 {
     using namespace testing;
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
     auto observer_one = std::make_shared<StrictMock<MockObserver>>();
     auto observer_two = std::make_shared<StrictMock<MockObserver>>();
 
@@ -982,13 +994,13 @@ TEST(ObserverMultiplexer, can_send_observation_to_single_observer)
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, single_observer_observation_can_be_delegated_to_specified_executor)
+TYPED_TEST(ObserverMultiplexer, single_observer_observation_can_be_delegated_to_specified_executor)
 {
     using namespace testing;
 
     ThreadedExecutor executor;
     CountingExecutor counting_executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
 
     auto observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto observer_two = std::make_shared<NiceMock<MockObserver>>();
@@ -1010,11 +1022,11 @@ TEST(ObserverMultiplexer, single_observer_observation_can_be_delegated_to_specif
     executor.drain_work();
 }
 
-TEST(ObserverMultiplexer, sending_to_single_observer_does_nothing_if_executor_deleted)
+TYPED_TEST(ObserverMultiplexer, sending_to_single_observer_does_nothing_if_executor_deleted)
 {
     using namespace testing;
     ThreadedExecutor executor;
-    TestObserverMultiplexer multiplexer{executor};
+    TypeParam multiplexer{executor};
     auto observer_one = std::make_shared<StrictMock<MockObserver>>();
     auto observer_two = std::make_shared<StrictMock<MockObserver>>();
 
@@ -1026,10 +1038,10 @@ TEST(ObserverMultiplexer, sending_to_single_observer_does_nothing_if_executor_de
     multiplexer.single_observer_observation(*observer_one, "one!");
 }
 
-TEST(ObserverMultiplexer, early_observers_are_triggered_first)
+TYPED_TEST(ObserverMultiplexer, early_observers_are_triggered_first)
 {
     using namespace testing;
-    TestObserverMultiplexer multiplexer{mir::immediate_executor};
+    TypeParam multiplexer{mir::immediate_executor};
 
     auto early_observer_one = std::make_shared<NiceMock<MockObserver>>();
     auto early_observer_two = std::make_shared<NiceMock<MockObserver>>();
@@ -164,3 +164,65 @@ TEST_F(WaylandExecutorTest, spawning_is_threadsafe)
 
     EXPECT_THAT(counter, Eq(thread_count));
 }
+
+TEST_F(WaylandExecutorTest, work_spawned_between_dispatches_runs_in_order_from_one_dispatch)
+{
+    mf::WaylandExecutor executor{the_event_loop};
+
+    std::vector<int> order;
+    {
+        // Spawn from another thread, so the work is queued rather than run inline
+        mt::AutoJoinThread spawner{
+            [&executor, &order]()
+            {
+                for (auto i = 0; i != 3; ++i)
+                {
+                    executor.spawn([&order, i]() { order.push_back(i); });
+                }
+            }};
+    }
+
+    wl_event_loop_dispatch(the_event_loop, 0);
+
+    EXPECT_THAT(order, ElementsAre(0, 1, 2));
+    EXPECT_THAT(executor.statistics().queue_depth, Eq(0u));
+    EXPECT_THAT(executor.statistics().max_queue_depth, Ge(3u));
+}
+
+TEST_F(WaylandExecutorTest, work_is_released_once_it_has_run)
+{
+    mf::WaylandExecutor executor{the_event_loop};
+
+    auto const captured = std::make_shared<int>(0);
+    {
+        mt::AutoJoinThread spawner{
+            [&executor, captured]()
+            {
+                executor.spawn([captured]() { ++*captured; });
+            }};
+    }
+
+    wl_event_loop_dispatch(the_event_loop, 0);
+
+    EXPECT_THAT(*captured, Eq(1));
+    EXPECT_THAT(captured.use_count(), Eq(1));
+}
+
+TEST(WaylandExecutor, work_spawned_after_the_event_loop_is_destroyed_is_released)
+{
+    auto const loop = wl_event_loop_create();
+    mf::WaylandExecutor executor{loop};
+    wl_event_loop_destroy(loop);
+
+    auto const captured = std::make_shared<int>(0);
+    {
+        mt::AutoJoinThread spawner{
+            [&executor, captured]()
+            {
+                executor.spawn([captured]() { ++*captured; });
+            }};
+    }
+
+    EXPECT_THAT(*captured, Eq(0));
+    EXPECT_THAT(captured.use_count(), Eq(1));
+}